@@ -98,11 +98,19 @@
 
 const char blink_module_name_string[] PROGMEM = "DweetBlinkApp";
 
-const char dweet_blinkinterval_string[] PROGMEM = "BLINKINTERVAL";
+#define BLINK_COMMANDS(X) \
+    X(dweet_blinkinterval_string, "BLINKINTERVAL")
+
+BLINK_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const blink_string_table[] PROGMEM =
 {
-    dweet_blinkinterval_string
+    BLINK_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t blink_hash_table[] =
+{
+    BLINK_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -203,6 +211,7 @@ DweetBlinkApp::Initialize(BlinkConfiguration* config)
     //
     parms.ModuleName = (PGM_P)blink_module_name_string;
     parms.stringTable = (PGM_P)blink_string_table;
+    parms.hashTable = blink_hash_table;
     parms.functionTable = (PGM_P)blink_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -313,6 +322,7 @@ DweetBlinkApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
     //
     parms.ModuleName = (PGM_P)blink_module_name_string;
     parms.stringTable = (PGM_P)blink_string_table;
+    parms.hashTable = blink_hash_table;
     parms.functionTable = (PGM_P)blink_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
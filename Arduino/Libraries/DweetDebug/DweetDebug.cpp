@@ -32,6 +32,7 @@
 #include "MenloMemoryMonitor.h"
 #include "MenloNMEA0183.h"
 #include "MenloDweet.h"
+#include "MenloUtility.h"
 
 #include "DweetDebug.h"
 
@@ -128,6 +129,19 @@ DweetDebug::DweetEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs)
 // see MEMWRITE for details
 // SETSTATE=MEMWRITE:0000.0000
 //
+// When built with MENLO_DISPATCH_PROFILE
+//
+// SETSTATE=PROFILE:01 - reset and start profiling
+// SETSTATE=PROFILE:00 - stop profiling
+//
+//              loops    passes   drains   entries overflows
+// GETSTATE=PROFILE
+//   GETSTATE_REPLY=PROFILE:00000000.00000000.00000000.00.00000000
+//
+//                  index type key      count    total us max us
+// GETSTATE=PROFILE:00
+//   GETSTATE_REPLY=PROFILE:00.01.00000000.00000000.00000000.00000000
+//
 
 
 //
@@ -681,6 +695,11 @@ DweetDebug::ProcessDebugCommands(MenloDweet* dweet, char* name, char* value) {
       //
       return 0;
     }
+#if MENLO_DISPATCH_PROFILE
+    else if (ProcessProfileCommands(dweet, name, value)) {
+        // handled
+    }
+#endif
     else {
 
         // Continue looking for a handler
@@ -689,3 +708,156 @@ DweetDebug::ProcessDebugCommands(MenloDweet* dweet, char* name, char* value) {
 
     return 1;
 }
+
+#if MENLO_DISPATCH_PROFILE
+
+int
+DweetDebug::ProcessProfileCommands(MenloDweet* dweet, char* name, char* value)
+{
+    bool isSet;
+    bool error;
+    unsigned long data;
+    char* action;
+    char* p;
+    MenloDispatchProfileEntry* entry;
+
+    // loops.passes.drains.entries.overflows, or an entry which is longer
+    char buf[2 + 1 + 2 + (4 * (8 + 1)) + 1];
+
+    if (strncmp_P(name, dweet_getstate_string, 8) == 0) {
+        isSet = false;
+    }
+    else if (strncmp_P(name, dweet_setstate_string, 8) == 0) {
+        isSet = true;
+    }
+    else {
+        return 0;
+    }
+
+    // PROFILE or PROFILE:xx
+    if (strncmp_P(value, PSTR("PROFILE"), 7) != 0) {
+        return 0;
+    }
+
+    if (value[7] == ':') {
+        action = &value[8];
+    }
+    else if (value[7] == '\0') {
+        action = NULL;
+    }
+    else {
+        return 0;
+    }
+
+    if (action != NULL) {
+        data = MenloUtility::HexToULong(action, &error);
+    }
+    else {
+        error = isSet;
+    }
+
+    if (error) {
+        dweet->SendDweetItemReplyType(
+            name,
+            dweet_error_string,
+            value
+            );
+
+        return 1;
+    }
+
+    if (isSet) {
+
+        if (data != 0) {
+            MenloDispatchProfile::Reset();
+            MenloDispatchProfile::Enable(true);
+        }
+        else {
+            MenloDispatchProfile::Enable(false);
+        }
+
+        dweet->SendDweetItemValueReplyType(
+            dweet_setstate_string,
+            dweet_reply_string,
+            (char*)"PROFILE",
+            action
+            );
+
+        return 1;
+    }
+
+    p = &buf[0];
+
+    if (action == NULL) {
+
+        // Summary
+        MenloUtility::UInt32ToHexBuffer(MenloDispatchProfile::GetLoopCount(), p);
+        p += 8;
+        *p++ = '.';
+
+        MenloUtility::UInt32ToHexBuffer(MenloDispatchProfile::GetPassCount(), p);
+        p += 8;
+        *p++ = '.';
+
+        MenloUtility::UInt32ToHexBuffer(MenloDispatchProfile::GetDrainPassCount(), p);
+        p += 8;
+        *p++ = '.';
+
+        MenloUtility::UInt8ToHexBuffer((uint8_t)MenloDispatchProfile::GetEntryCount(), p);
+        p += 2;
+        *p++ = '.';
+
+        MenloUtility::UInt32ToHexBuffer(MenloDispatchProfile::GetOverflowCount(), p);
+        p += 8;
+    }
+    else {
+
+        entry = MenloDispatchProfile::GetEntry((int)data);
+        if (entry == NULL) {
+            dweet->SendDweetItemReplyType(
+                name,
+                dweet_error_string,
+                value
+                );
+
+            return 1;
+        }
+
+        MenloUtility::UInt8ToHexBuffer((uint8_t)data, p);
+        p += 2;
+        *p++ = '.';
+
+        MenloUtility::UInt8ToHexBuffer(entry->type, p);
+        p += 2;
+        *p++ = '.';
+
+        // Consult the linker map for the object or registration
+        MenloUtility::UInt32ToHexBuffer((unsigned long)(uintptr_t)entry->key, p);
+        p += 8;
+        *p++ = '.';
+
+        MenloUtility::UInt32ToHexBuffer(entry->count, p);
+        p += 8;
+        *p++ = '.';
+
+        MenloUtility::UInt32ToHexBuffer(entry->totalMicros, p);
+        p += 8;
+        *p++ = '.';
+
+        MenloUtility::UInt32ToHexBuffer(entry->maxMicros, p);
+        p += 8;
+    }
+
+    *p = '\0';
+
+    dweet->SendDweetItemValueReplyType(
+        dweet_getstate_string,
+        dweet_reply_string,
+        (char*)"PROFILE",
+        buf
+        );
+
+    return 1;
+}
+
+#endif // MENLO_DISPATCH_PROFILE
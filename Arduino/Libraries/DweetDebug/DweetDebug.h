@@ -29,6 +29,7 @@
 #define DweetDebug_h
 
 #include "MenloObject.h"
+#include "MenloDispatchProfile.h"
 
 //
 // This class takes 2792 bytes on an AtMega328
@@ -59,6 +60,16 @@ public:
 
 private:
 
+#if MENLO_DISPATCH_PROFILE
+    //
+    // Dispatch loop profiler, see MenloDispatchProfile.h
+    //
+    // Returns 1 if the command is recognized.
+    // Returns 0 if not.
+    //
+    int ProcessProfileCommands(MenloDweet* dweet, char* name, char* value);
+#endif
+
     MenloDweet* m_dweet;
 
     //
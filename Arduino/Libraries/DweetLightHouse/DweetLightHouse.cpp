@@ -129,15 +129,17 @@
 //
 const char lighthouse_module_name_string[] PROGMEM = "DweetLightHouse";
 
-extern const char dweet_lightperiod_string[] PROGMEM = "LIGHTPERIOD";  // index 0
-extern const char dweet_lighttick_string[] PROGMEM = "LIGHTTICK";
-extern const char dweet_lightcolor_string[] PROGMEM = "LIGHTCOLOR";
-extern const char dweet_lightramp_string[] PROGMEM = "LIGHTRAMP";
-extern const char dweet_lightonlevel_string[] PROGMEM = "LIGHTONLEVEL"; // index 4
-extern const char dweet_sensorrate_string[] PROGMEM = "SENSORRATE";
+// SENSORS is the sensor/environmental support
+#define LIGHTHOUSE_COMMANDS(X) \
+  X(dweet_lightperiod_string, "LIGHTPERIOD") \
+  X(dweet_lighttick_string, "LIGHTTICK") \
+  X(dweet_lightcolor_string, "LIGHTCOLOR") \
+  X(dweet_lightramp_string, "LIGHTRAMP") \
+  X(dweet_lightonlevel_string, "LIGHTONLEVEL") \
+  X(dweet_sensorrate_string, "SENSORRATE") \
+  X(dweet_sensors_string, "SENSORS")
 
-// Sensor/environmental support
-extern const char dweet_sensors_string[] PROGMEM = "SENSORS";
+LIGHTHOUSE_COMMANDS(DWEET_COMMAND_EXTERN_STRING)
 
 //
 // These try to keep the command short to maximize encoding of the sequence
@@ -157,13 +159,12 @@ DweetLightHouse::offState = "OFF";
 
 const char* const lighthouse_string_table[] PROGMEM =
 {
-  dweet_lightperiod_string,
-  dweet_lighttick_string,
-  dweet_lightcolor_string,
-  dweet_lightramp_string,
-  dweet_lightonlevel_string, // index 4
-  dweet_sensorrate_string,
-  dweet_sensors_string
+  LIGHTHOUSE_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t lighthouse_hash_table[] =
+{
+  LIGHTHOUSE_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -614,6 +615,7 @@ DweetLightHouse::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
 
         parms.ModuleName = (PGM_P)lighthouse_module_name_string;
         parms.stringTable = (PGM_P)lighthouse_string_table;
+        parms.hashTable = lighthouse_hash_table;
         parms.functionTable = (PGM_P)lighthouse_function_table;
         parms.defaultsTable = NULL;
         parms.object =  this;
@@ -684,6 +686,7 @@ DweetLightHouse::Initialize(
     //
     parms.ModuleName = (PGM_P)lighthouse_module_name_string;
     parms.stringTable = (PGM_P)lighthouse_string_table;
+    parms.hashTable = lighthouse_hash_table;
     parms.functionTable = (PGM_P)lighthouse_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -79,19 +79,16 @@
 
 const char radio_module_name_string[] PROGMEM = "DweetRadio";
 
-extern const char dweet_radio_channel_string[] PROGMEM = "RADIOCHANNEL";
+#define RADIO_COMMANDS(X) \
+  X(dweet_radio_channel_string, "RADIOCHANNEL") \
+  X(dweet_radio_txaddr_string, "RADIOTXADDR") \
+  X(dweet_radio_rxaddr_string, "RADIORXADDR") \
+  X(dweet_radio_power_timer_string, "RADIOPOWERTIMER") \
+  X(dweet_radio_attention_string, "RADIOATT") \
+  X(dweet_radio_options_string, "RADIOOPTIONS") \
+  X(dweet_radio_gateway_string, "RADIOGATEWAY")
 
-extern const char dweet_radio_txaddr_string[] PROGMEM = "RADIOTXADDR";
-
-extern const char dweet_radio_rxaddr_string[] PROGMEM = "RADIORXADDR";
-
-extern const char dweet_radio_power_timer_string[] PROGMEM = "RADIOPOWERTIMER";
-
-extern const char dweet_radio_attention_string[] PROGMEM = "RADIOATT";
-
-extern const char dweet_radio_options_string[] PROGMEM = "RADIOOPTIONS";
-
-extern const char dweet_radio_gateway_string[] PROGMEM = "RADIOGATEWAY";
+RADIO_COMMANDS(DWEET_COMMAND_EXTERN_STRING)
 
 //
 // DweetRadio provides an example of a common pattern used
@@ -132,13 +129,12 @@ extern const char dweet_radio_gateway_string[] PROGMEM = "RADIOGATEWAY";
 
 const char* const radio_string_table[] PROGMEM =
 {
-  dweet_radio_channel_string,
-  dweet_radio_txaddr_string,
-  dweet_radio_rxaddr_string,
-  dweet_radio_power_timer_string,
-  dweet_radio_attention_string,
-  dweet_radio_options_string,
-  dweet_radio_gateway_string
+  RADIO_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t radio_hash_table[] =
+{
+  RADIO_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -188,6 +184,37 @@ PROGMEM const int radio_size_table[] =
     GATEWAY_ENABLED_SIZE
 };
 
+//
+// Binary Dweet command codes.
+//
+// MENLO_RADIO_DWEET_GETCONFIG - 1 indexes this table.
+//
+const char* const radio_dweet_code_table[] PROGMEM =
+{
+  dweet_getconfig_string,
+  dweet_setconfig_string,
+  dweet_getstate_string,
+  dweet_setstate_string
+};
+
+#define RADIO_DWEET_CODE_ENTRIES \
+    (int)(sizeof(radio_dweet_code_table) / sizeof(char*))
+
+//
+// MenloRadioDweetReply.replyType indexes this table.
+//
+// These include the '=' separator.
+//
+const char* const radio_dweet_reply_table[] PROGMEM =
+{
+  dweet_reply_string,
+  dweet_error_string,
+  dweet_unsup_string
+};
+
+#define RADIO_DWEET_REPLY_ENTRIES \
+    (int)(sizeof(radio_dweet_reply_table) / sizeof(char*))
+
 //
 // Improve: Change the contracts to a single function per entry
 // passing isSet to the radio object itself.
@@ -305,7 +332,19 @@ DweetRadio::ProcessRadioCommands(MenloDweet* dweet, char* name, char* value)
     // function with the locally defined table pointers.
     //
 
-    if (strncmp_P(name, PSTR("T"), 1) == 0)  {
+    if (strcmp_P(name, PSTR("D")) == 0)  {
+
+        DBG_PRINT("DweetRadio: D command received");
+
+        //
+        // D=c:GETCONFIG=RADIOCHANNEL
+        //
+        // where c is channel
+        // followed by a Dweet command sent as a binary Dweet
+        //
+        return ProcessRadioDweet(dweet, name, value);
+    }
+    else if (strncmp_P(name, PSTR("T"), 1) == 0)  {
 
         DBG_PRINT("DweetRadio: T command received");
 
@@ -353,6 +392,7 @@ DweetRadio::ProcessRadioCommands(MenloDweet* dweet, char* name, char* value)
 
         parms.ModuleName = (PGM_P)radio_module_name_string;
         parms.stringTable = (PGM_P)radio_string_table;
+        parms.hashTable = radio_hash_table;
         parms.functionTable = (PGM_P)radio_function_table;
         parms.defaultsTable = NULL;
         parms.object =  this;
@@ -384,6 +424,16 @@ DweetRadio::ProcessRadioCommands(MenloDweet* dweet, char* name, char* value)
 //
 int
 DweetRadio::Initialize(MenloDweet* dweet, MenloRadio* radio)
+{
+  return Initialize(dweet, radio, NULL);
+}
+
+int
+DweetRadio::Initialize(
+    MenloDweet* dweet,
+    MenloRadio* radio,
+    MenloRadioReceiveScheduler* scheduler
+    )
 {
   int result;
   struct StateSettingsParameters parms;
@@ -393,6 +443,7 @@ DweetRadio::Initialize(MenloDweet* dweet, MenloRadio* radio)
 
   m_dweet = dweet;
   m_radio = radio;
+  m_scheduler = scheduler;
   m_receiveDweetStreamEnabled = false;
 
   //
@@ -422,6 +473,7 @@ DweetRadio::Initialize(MenloDweet* dweet, MenloRadio* radio)
 
   parms.ModuleName = (PGM_P)radio_module_name_string;
   parms.stringTable = (PGM_P)radio_string_table;
+  parms.hashTable = radio_hash_table;
   parms.functionTable = (PGM_P)radio_function_table;
   parms.defaultsTable = NULL;
   parms.object =  this;
@@ -472,7 +524,13 @@ DweetRadio::EnableReceiveDweetStream(bool value)
       //
       m_radioEvent.object = this;
       m_radioEvent.method = (MenloEventMethod)&DweetRadio::RadioEvent;
-      m_radio->RegisterReceiveEvent(&m_radioEvent);
+
+      if (m_scheduler != NULL) {
+          m_scheduler->RegisterReceiveEvent(&m_radioEvent);
+      }
+      else {
+          m_radio->RegisterReceiveEvent(&m_radioEvent);
+      }
 
       DBG_PRINT("DweetRadio ReceiveDweetStream enabled");
   }
@@ -482,7 +540,13 @@ DweetRadio::EnableReceiveDweetStream(bool value)
       }
 
       m_receiveDweetStreamEnabled = false;
-      m_radio->UnregisterReceiveEvent(&m_radioEvent);
+
+      if (m_scheduler != NULL) {
+          m_scheduler->UnregisterReceiveEvent(&m_radioEvent);
+      }
+      else {
+          m_radio->UnregisterReceiveEvent(&m_radioEvent);
+      }
 
       DBG_PRINT("DweetRadio ReceiveDweetStream +not+ enabled");
   }
@@ -542,7 +606,13 @@ DweetRadio::RadioEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs)
   MenloMemoryMonitor::CheckMemory(LineNumberBaseDweetRadio + __LINE__);
 
   // Process incoming radio packet
-  SendRadioReceiveDweet('0', radioArgs->data, radioArgs->dataLength);
+  if ((radioArgs->data[0] == MENLO_RADIO_DWEET_REPLY) ||
+      (radioArgs->data[0] == MENLO_RADIO_DWEET)) {
+      SendRadioDweet('0', radioArgs->data, radioArgs->dataLength);
+  }
+  else {
+      SendRadioReceiveDweet('0', radioArgs->data, radioArgs->dataLength);
+  }
 
   return MAX_POLL_TIME;
 }
@@ -737,3 +807,257 @@ DweetRadio::SendRadioReceiveDweet(
         buf
         );
 }
+
+//
+// Binary Dweets
+//
+// Sent with:
+//
+// $PDWT,D=0:GETCONFIG=RADIOCHANNEL*00
+//
+// which is acknowledged with D_REPLY=0 when it has been sent.
+// The sensor's reply arrives as:
+//
+// $PDWT,D=0:GETCONFIG_REPLY=RADIOCHANNEL:00*00
+//
+// The command is one packet on the radio rather than the
+// two needed for its NMEA 0183 sentence over RadioSerial,
+// or 64 ASCII hex characters as R= and T= Dweets.
+//
+
+uint8_t
+DweetRadio::EncodeRadioDweet(uint8_t type, char* command, uint8_t* packet)
+{
+    MenloRadioDweetReply* pk = (MenloRadioDweetReply*)packet;
+    char* separator;
+    PGM_P p;
+    int index;
+    int length;
+    int nameLength;
+    uint8_t replyType = MENLO_RADIO_DWEET_REPLY_OK;
+
+    memset(packet, 0, MENLO_RADIO_PACKET_SIZE);
+
+    pk->type = type;
+    pk->dweetSubsystem = MENLO_RADIO_DWEET_SUBSYSTEM_ALL;
+    pk->dweetCode = MENLO_RADIO_DWEET_COMMAND;
+
+    separator = strchr(command, '=');
+    if (separator != NULL) {
+
+        // Including the '='
+        nameLength = (separator - command) + 1;
+
+        if (type == MENLO_RADIO_DWEET_REPLY) {
+
+            // GETCONFIG_REPLY=, the reply strings include the '='
+            for (index = 0; index < RADIO_DWEET_REPLY_ENTRIES; index++) {
+
+                p = (PGM_P)MenloPlatform::GetStringPointerFromStringArray(
+                    (char**)radio_dweet_reply_table, index);
+
+                length = strlen_P(p);
+
+                if ((nameLength > length) &&
+                    (strncmp_P(&command[nameLength - length], p, length) == 0)) {
+                    replyType = index;
+                    break;
+                }
+            }
+
+            // Not a reply we can encode, send it as text
+            nameLength = (index < RADIO_DWEET_REPLY_ENTRIES) ? (nameLength - length) : 0;
+        }
+        else {
+            nameLength--;
+        }
+
+        for (index = 0; index < RADIO_DWEET_CODE_ENTRIES; index++) {
+
+            p = (PGM_P)MenloPlatform::GetStringPointerFromStringArray(
+                (char**)radio_dweet_code_table, index);
+
+            if (((int)strlen_P(p) == nameLength) &&
+                (strncmp_P(command, p, nameLength) == 0)) {
+
+                pk->dweetCode = MENLO_RADIO_DWEET_GETCONFIG + index;
+
+                if (type == MENLO_RADIO_DWEET_REPLY) {
+                    pk->replyType = replyType;
+                }
+
+                // Only the value is sent
+                command = separator + 1;
+                break;
+            }
+        }
+    }
+
+    length = strlen(command);
+    if (length > MENLO_RADIO_DWEET_DATA_SIZE) {
+        return 0;
+    }
+
+    memcpy(&pk->parameter0, command, length);
+
+    return MENLO_RADIO_DWEET_HEADER_SIZE + length;
+}
+
+bool
+DweetRadio::DecodeRadioDweet(uint8_t* packet, uint8_t length, char* buf, int bufSize)
+{
+    MenloRadioDweetReply* pk = (MenloRadioDweetReply*)packet;
+    char* data = (char*)&pk->parameter0;
+    PGM_P p;
+    int index;
+    int dataLength;
+
+    if (length < MENLO_RADIO_DWEET_HEADER_SIZE) {
+        return false;
+    }
+
+    length -= MENLO_RADIO_DWEET_HEADER_SIZE;
+    if (length > MENLO_RADIO_DWEET_DATA_SIZE) {
+        length = MENLO_RADIO_DWEET_DATA_SIZE;
+    }
+
+    // Short frames and unused parameters are '\0' padded
+    dataLength = 0;
+    while ((dataLength < length) && (data[dataLength] != '\0')) {
+        dataLength++;
+    }
+
+    index = 0;
+
+    if (pk->dweetCode != MENLO_RADIO_DWEET_COMMAND) {
+
+        if (pk->dweetCode > (MENLO_RADIO_DWEET_GETCONFIG + RADIO_DWEET_CODE_ENTRIES - 1)) {
+            return false;
+        }
+
+        if ((pk->type == MENLO_RADIO_DWEET_REPLY) &&
+            (pk->replyType >= RADIO_DWEET_REPLY_ENTRIES)) {
+            return false;
+        }
+
+        p = (PGM_P)MenloPlatform::GetStringPointerFromStringArray(
+            (char**)radio_dweet_code_table,
+            pk->dweetCode - MENLO_RADIO_DWEET_GETCONFIG);
+
+        if (bufSize < DWEET_RADIO_TEXT_SIZE) {
+            return false;
+        }
+
+        strcpy_P(buf, p);
+
+        if (pk->type == MENLO_RADIO_DWEET_REPLY) {
+            p = (PGM_P)MenloPlatform::GetStringPointerFromStringArray(
+                (char**)radio_dweet_reply_table, pk->replyType);
+
+            strcat_P(buf, p);
+        }
+        else {
+            strcat_P(buf, PSTR("="));
+        }
+
+        index = strlen(buf);
+    }
+
+    if ((index + dataLength + 1) > bufSize) {
+        return false;
+    }
+
+    memcpy(&buf[index], data, dataLength);
+    buf[index + dataLength] = '\0';
+
+    return true;
+}
+
+int
+DweetRadio::ProcessRadioDweet(MenloDweet* dweet, char* name, char* value)
+{
+    int size;
+    uint8_t length;
+    uint8_t channel;
+    uint8_t radioBuffer[RADIO_PACKET_SIZE];
+    char buf[2];
+    PGM_P command = PSTR("D");
+
+    DBG_PRINT("ProcessRadioDweet");
+
+    //
+    // D=0:GETCONFIG=RADIOCHANNEL
+    //
+    length = 0;
+
+    if ((value[0] != '\0') && (value[1] == ':')) {
+        channel = value[0];
+        length = EncodeRadioDweet(MENLO_RADIO_DWEET, &value[2], radioBuffer);
+    }
+
+    if (length == 0) {
+
+        DBG_PRINT("ProcessRadioDweet error in Dweet");
+
+        size = dweet->CalculateMaximumValueReply(command, dweet_error_string, value);
+        if ((int)strlen(value) > size) {
+            value[size] = '\0';
+        }
+
+        dweet->SendDweetItemReplyType_P(
+            command,
+            dweet_error_string,
+            value
+            );
+
+        return 1;
+    }
+
+    m_radio->Write(
+        NULL,
+        radioBuffer,
+        m_radio->IsVariableLength() ? length : RADIO_PACKET_SIZE,
+        RADIO_SEND_TIMEOUT
+     );
+
+    buf[0] = channel;
+    buf[1] = '\0';
+
+    dweet->SendDweetItemReplyType_P(
+        command,
+        dweet_reply_string,
+        buf
+        );
+
+    return 1;
+}
+
+//
+// Send a received binary Dweet to the host as D=c:COMMAND=VALUE
+//
+void
+DweetRadio::SendRadioDweet(
+    uint8_t channel,
+    uint8_t* radioBuffer,
+    uint8_t radioBufferLength
+    )
+{
+    char buf[2 + DWEET_RADIO_TEXT_SIZE];
+
+    buf[0] = channel;
+    buf[1] = ':';
+
+    if (!DecodeRadioDweet(radioBuffer, radioBufferLength, &buf[2], sizeof(buf) - 2)) {
+
+        // The host still sees the packet
+        SendRadioReceiveDweet(channel, radioBuffer, radioBufferLength);
+        return;
+    }
+
+    // Format is: D=0:GETCONFIG_REPLY=RADIOCHANNEL:00
+    m_dweet->SendDweetItemReplyType_P(
+	PSTR("D"),
+	PSTR("="), // Not a _REPLY to the host
+        buf
+        );
+}
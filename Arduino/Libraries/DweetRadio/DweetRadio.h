@@ -31,6 +31,15 @@
 #include "MenloObject.h"
 #include "DweetStrings.h"
 #include "MenloRadio.h"
+#include "MenloRadioReceiveScheduler.h"
+
+//
+// Largest Dweet command text carried by a MenloRadioDweet or
+// MenloRadioDweetReply packet including the '\0'.
+//
+// "GETCONFIG_ERROR=" + 28 data bytes + '\0'
+//
+#define DWEET_RADIO_TEXT_SIZE (16 + MENLO_RADIO_DWEET_DATA_SIZE + 1)
 
 class DweetRadio : public MenloObject {
 
@@ -39,10 +48,23 @@ class DweetRadio : public MenloObject {
   DweetRadio() {
     m_dweet = NULL;
     m_radio = NULL;
+    m_scheduler = NULL;
   }
 
   int Initialize(MenloDweet* dweet, MenloRadio* radio);
 
+  //
+  // Gateways serving many sensor nodes receive through scheduler
+  // so the radio is drained while earlier packets are forwarded.
+  //
+  // See MenloRadioReceiveScheduler.
+  //
+  int Initialize(
+      MenloDweet* dweet,
+      MenloRadio* radio,
+      MenloRadioReceiveScheduler* scheduler
+      );
+
   //
   // By default received radio packets are not forwarded
   // as unsolicited Dweet's. This enables the Dweet stream
@@ -50,6 +72,34 @@ class DweetRadio : public MenloObject {
   //
   void EnableReceiveDweetStream(bool value);
 
+  //
+  // Binary Dweets over the radio, see MenloRadioDweet in MenloRadio.h
+  //
+  // The ASCII form is only used at the gateway's serial edge, and
+  // on the sensor to dispatch to the existing Dweet handlers.
+  //
+
+  //
+  // Encode a single Dweet command "GETCONFIG=RADIOCHANNEL" for
+  // MENLO_RADIO_DWEET, or its reply "GETCONFIG_REPLY=RADIOCHANNEL:00"
+  // for MENLO_RADIO_DWEET_REPLY into a MENLO_RADIO_PACKET_SIZE
+  // packet.
+  //
+  // Returns the length of the valid data in the packet, which
+  // is zero padded. Returns 0 if the command does not fit.
+  //
+  static uint8_t EncodeRadioDweet(uint8_t type, char* command, uint8_t* packet);
+
+  //
+  // Decode a MENLO_RADIO_DWEET or MENLO_RADIO_DWEET_REPLY packet
+  // back to its Dweet command text.
+  //
+  // buf should be DWEET_RADIO_TEXT_SIZE.
+  //
+  // Returns false if the packet is not valid.
+  //
+  static bool DecodeRadioDweet(uint8_t* packet, uint8_t length, char* buf, int bufSize);
+
   // Handlers for each DWEET message
   int ChannelHandler(char* buf, int size, bool isSet);
   int TxAddrHandler(char* buf, int size, bool isSet);
@@ -81,6 +131,15 @@ class DweetRadio : public MenloObject {
 
   int ProcessRadioTransmit(MenloDweet* dweet, char* name, char* value);
 
+  int ProcessRadioDweet(MenloDweet* dweet, char* name, char* value);
+
+  void
+  SendRadioDweet(
+      uint8_t channel,
+      uint8_t* radioBuffer,
+      uint8_t radioBufferLength
+      );
+
   void
   SendRadioReceiveDweet(
       uint8_t channel,
@@ -92,6 +151,9 @@ class DweetRadio : public MenloObject {
 
   MenloRadio* m_radio;
 
+  // Optional, received packets are forwarded from here
+  MenloRadioReceiveScheduler* m_scheduler;
+
   MenloDweet* m_dweet;
 
   bool m_receiveDweetStreamEnabled;
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/20/2016
+ *  File: DweetRadioChannel.cpp
+ *
+ *  Dweet channel for binary Dweets over packet radios.
+ *
+ * Used for Smartpux DWEET's.
+ */
+
+//
+// MenloFramework
+//
+// Note: All these includes are required together due
+// to Arduino #include behavior.
+//
+#include <MenloPlatform.h>
+#include <MenloObject.h>
+#include <MenloMemoryMonitor.h>
+#include <MenloUtility.h>
+#include <MenloNMEA0183Stream.h>
+#include <MenloDebug.h>
+
+// NMEA 0183 support
+#include <MenloNMEA0183.h>
+
+// Dweet Support
+#include <MenloDweet.h>
+#include <DweetChannel.h>
+
+// MenloRadio support
+#include <MenloRadio.h>
+
+// Binary Dweet codec
+#include <DweetRadio.h>
+
+//
+// This must be "", not <>
+// if the file is local to the .ino file and not in the libraries.
+//
+#include "DweetRadioChannel.h"
+
+#define DBG_PRINT_ENABLED 0
+
+#if DBG_PRINT_ENABLED
+#define DBG_PRINT(x)         (MenloDebug::Print(F(x)))
+#define DBG_PRINT_STRING(x)  (MenloDebug::Print(x))
+#define DBG_PRINT_NNL(x)     (MenloDebug::PrintNoNewline(F(x)))
+#define DBG_PRINT_INT(x)     (MenloDebug::PrintHex(x))
+#define DBG_PRINT_INT_NNL(x) (MenloDebug::PrintHexNoNewline(x))
+#else
+#define DBG_PRINT(x)
+#define DBG_PRINT_STRING(x)
+#define DBG_PRINT_NNL(x)
+#define DBG_PRINT_INT(x)
+#define DBG_PRINT_INT_NNL(x)
+#endif
+
+//
+// called by application.
+//
+int
+DweetRadioChannel::Initialize(
+    MenloRadio* radio,
+    char* prefix,
+    unsigned long sendTimeout
+    )
+{
+    int result;
+
+    m_radio = radio;
+    m_sendTimeout = sendTimeout;
+
+    result = m_nmea.Initialize(
+        prefix,
+        (char*)m_outputBuffer,
+        sizeof(m_outputBuffer)
+        );
+
+    // Initialize base class, replies go to WritePort()
+    MenloDweet::Initialize(
+        &m_nmea,
+        NULL
+    );
+
+    //
+    // Register for radio receive packets
+    //
+    m_radioEvent.object = this;
+    m_radioEvent.method = (MenloEventMethod)&DweetRadioChannel::RadioEvent;
+
+    m_radio->RegisterReceiveEvent(&m_radioEvent);
+
+    return result;
+}
+
+//
+// This event occurs when a radio packet is available
+//
+unsigned long
+DweetRadioChannel::RadioEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs)
+{
+    MenloRadioEventArgs* radioArgs = (MenloRadioEventArgs*)eventArgs;
+    char command[DWEET_RADIO_TEXT_SIZE];
+
+    if (radioArgs->data[0] != MENLO_RADIO_DWEET) {
+        return MAX_POLL_TIME;
+    }
+
+    //
+    // Decoded into our own buffer since handlers modify the
+    // command in place and the radio receive buffer is shared.
+    //
+    if (!DweetRadio::DecodeRadioDweet(
+            radioArgs->data,
+            radioArgs->dataLength,
+            command,
+            sizeof(command))) {
+        DBG_PRINT("DweetRadioChannel invalid packet");
+        return MAX_POLL_TIME;
+    }
+
+    DBG_PRINT_NNL("DweetRadioChannel ");
+    DBG_PRINT_STRING(command);
+
+    // Replies are sent by WritePort()
+    ProcessDweetCommand(command);
+
+    return MAX_POLL_TIME;
+}
+
+//
+// This is an override of MenloDweet for an alternate port write implementation.
+//
+// buffer is a complete sentence $PDWT,GETCONFIG_REPLY=RADIOCHANNEL:00*00\r\n
+// and each of its commands is sent as a MENLO_RADIO_DWEET_REPLY packet.
+//
+size_t
+DweetRadioChannel::WritePort(const uint8_t *buffer, size_t size)
+{
+    char command[DWEET_RADIO_TEXT_SIZE];
+    uint8_t packet[MENLO_RADIO_PACKET_SIZE];
+    const char* ptr;
+    const char* end;
+    char* separator;
+    int length;
+    uint8_t packetLength;
+
+    // Skip the prefix
+    ptr = (const char*)memchr(buffer, ',', size);
+    if (ptr == NULL) {
+        return 0;
+    }
+
+    while (*ptr == ',') {
+
+        ptr++;
+
+        // Commands end at the next ',' or the checksum
+        end = ptr;
+        while ((*end != ',') && (*end != '*') && (*end != '\0')) {
+            end++;
+        }
+
+        length = end - ptr;
+        if (length > (int)(sizeof(command) - 1)) {
+            length = sizeof(command) - 1;
+        }
+
+        memcpy(command, ptr, length);
+        command[length] = '\0';
+
+        packetLength = DweetRadio::EncodeRadioDweet(MENLO_RADIO_DWEET_REPLY, command, packet);
+
+        if (packetLength == 0) {
+
+            //
+            // The value does not fit, reply with the item as an error
+            // GETCONFIG_ERROR=LIGHTSEQUENCE
+            //
+            DBG_PRINT("DweetRadioChannel reply too long");
+
+            separator = strchr(command, '=');
+            if (separator != NULL) {
+                separator = strchr(separator, ':');
+            }
+
+            if (separator != NULL) {
+                *separator = '\0';
+            }
+
+            packetLength = DweetRadio::EncodeRadioDweet(MENLO_RADIO_DWEET_REPLY, command, packet);
+            if (packetLength == 0) {
+                return 0;
+            }
+
+            if (((MenloRadioDweetReply*)packet)->dweetCode != MENLO_RADIO_DWEET_COMMAND) {
+                ((MenloRadioDweetReply*)packet)->replyType = MENLO_RADIO_DWEET_REPLY_ERROR;
+            }
+        }
+
+        m_radio->Write(
+            NULL,
+            packet,
+            m_radio->IsVariableLength() ? packetLength : MENLO_RADIO_PACKET_SIZE,
+            m_sendTimeout
+            );
+
+        ptr = end;
+    }
+
+    return size;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/20/2016
+ *  File: DweetRadioChannel.h
+ *
+ *  Dweet channel for binary Dweets over packet radios.
+ *
+ * Used for Smartpux DWEET's.
+ */
+
+#ifndef DweetRadioChannel_h
+#define DweetRadioChannel_h
+
+#include <MenloPlatform.h>
+#include <MenloObject.h>
+#include <MenloMemoryMonitor.h>
+#include <MenloUtility.h>
+#include <MenloNMEA0183Stream.h>
+#include <MenloDebug.h>
+
+// NMEA 0183 support
+#include <MenloNMEA0183.h>
+
+// Dweet Support
+#include <MenloDweet.h>
+#include <DweetChannel.h>
+
+// MenloRadio support
+#include <MenloRadio.h>
+
+// Binary Dweet codec
+#include <DweetRadio.h>
+
+//
+// This class DweetRadioChannel handles binary Dweets received
+// from the gateway as MENLO_RADIO_DWEET packets, see MenloRadio.h.
+//
+// Each packet is a single GETCONFIG/SETCONFIG/GETSTATE/SETSTATE
+// command and is dispatched to the same handlers as the serial
+// and radioserial Dweet channels without NMEA 0183 framing or
+// checksum processing.
+//
+// The reply formatted by the handler is returned to the gateway
+// as a MENLO_RADIO_DWEET_REPLY packet. The gateway translates
+// it to ASCII for the host. See DweetRadio.
+//
+// A reply whose value does not fit in a packet is returned
+// as _ERROR with the item name. Those items should be
+// retrieved over the radioserial channel.
+//
+// This channel may be used alongside a DweetSerialChannel over
+// MenloRadioSerial on the same radio as MenloRadioSerial ignores
+// these packet types.
+//
+
+class DweetRadioChannel : public DweetChannel {
+
+public:
+
+    DweetRadioChannel() {
+        m_radio = NULL;
+    }
+
+    int
+    Initialize(
+        MenloRadio* radio,
+        char* prefix,
+        unsigned long sendTimeout
+        );
+
+    //
+    // Replies are sent on the radio rather than a Stream* port.
+    //
+    virtual size_t WritePort(const uint8_t *buffer, size_t size);
+
+private:
+
+    MenloRadio* m_radio;
+
+    unsigned long m_sendTimeout;
+
+    //
+    // output buffer is used by NMEA0183 to format sentences before send
+    // This is passed to DweetChannel::m_nmea.Initialize()
+    //
+    // It is full size so a reply too long for a packet is detected
+    // rather than truncated.
+    //
+    uint8_t m_outputBuffer[84];
+
+    //
+    // DweetRadioChannel is a client of MenloRadio for receive packets
+    //
+
+    // Event registration
+    MenloRadioEventRegistration m_radioEvent;
+
+    // RadioEvent function
+    unsigned long RadioEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs);
+};
+
+#endif // DweetRadioChannel_h
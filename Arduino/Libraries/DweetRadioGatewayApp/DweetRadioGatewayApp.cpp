@@ -42,6 +42,7 @@
 // MenloRadio support for small packet radios
 //
 #include <MenloRadio.h>
+#include <MenloRadioReceiveScheduler.h>
 
 //
 // Libraries used by the Nordic nRF24L01 radio
@@ -149,11 +150,24 @@ DweetRadioGatewayApp::Initialize(DweetRadioGatewayAppConfiguration* config)
 
     ResetWatchdog();
 
+    //
+    // Receive packets from the radio's IRQ pin when it has an
+    // interrupt and a receive ring is supplied, otherwise the
+    // radio is polled.
+    //
+    m_nordic.AttachReceiveInterrupt(config->irqPin, config->receiveRing);
+
+    ResetWatchdog();
+
+    m_receiveScheduler.Initialize(&m_nordic, MENLO_RADIO_RECEIVE_SCHEDULER_BATCH);
+
     //
     // Initialize Dweet Radio on the serial interface for configuration and
     // optional gateway usage.
     //
-    m_dweetRadio.Initialize(&m_dweetSerialChannel, &m_nordic);
+    // Received packets are forwarded through the receive scheduler.
+    //
+    m_dweetRadio.Initialize(&m_dweetSerialChannel, &m_nordic, &m_receiveScheduler);
 
     ResetWatchdog();
 
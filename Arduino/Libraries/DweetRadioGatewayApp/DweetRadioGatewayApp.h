@@ -44,6 +44,7 @@
 // MenloRadio support for small packet radios
 //
 #include <MenloRadio.h>
+#include <MenloRadioReceiveScheduler.h>
 
 //
 // Libraries used by the Nordic nRF24L01 radio
@@ -88,6 +89,10 @@ struct DweetRadioGatewayAppConfiguration {
     uint8_t cePin;
     uint8_t irqPin;
     uint8_t payLoadSize;
+
+    // Holds packets received from irqPin's interrupt, NULL polls the radio
+    MenloRadioReceiveRing* receiveRing;
+
     bool forceDefaults;
     char* defaultChannel;
     char* defaultReceiveAddress;
@@ -128,6 +133,12 @@ private:
     OS_nRF24L01 m_nordic;
     MirfHardwareSpiDriver m_MirfHardwareSpi;
 
+    //
+    // Queues packets from each sensor node so bursts from many
+    // nodes reporting at once are not lost while forwarding.
+    //
+    MenloRadioReceiveScheduler m_receiveScheduler;
+
     //
     // Radio Dweet support
     //
@@ -171,6 +171,15 @@ DweetRadioSerialApp::Initialize(DweetRadioSerialAppConfiguration* config)
 
     ResetWatchdog();
 
+    //
+    // Receive packets from the radio's IRQ pin when it has an
+    // interrupt and a receive ring is supplied, otherwise the
+    // radio is polled.
+    //
+    m_nordic.AttachReceiveInterrupt(config->irqPin, config->receiveRing);
+
+    ResetWatchdog();
+
     //
     // Initialize Radio Serial
     //
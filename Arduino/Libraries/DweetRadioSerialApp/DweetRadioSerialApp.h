@@ -102,6 +102,10 @@ struct DweetRadioSerialAppConfiguration {
     uint8_t cePin;
     uint8_t irqPin;
     uint8_t payLoadSize;
+
+    // Holds packets received from irqPin's interrupt, NULL polls the radio
+    MenloRadioReceiveRing* receiveRing;
+
     bool forceDefaults;
     char* defaultChannel;
     char* defaultReceiveAddress;
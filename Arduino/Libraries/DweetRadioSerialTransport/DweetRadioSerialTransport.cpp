@@ -56,6 +56,7 @@
 
 // Dweet Radio
 #include <DweetRadio.h>
+#include <DweetRadioChannel.h>
 
 #include <MenloDispatchObject.h>
 #include <MenloTimer.h>
@@ -167,6 +168,11 @@ DweetRadioSerialTransport::Initialize(DweetRadioSerialTransportConfiguration* co
         // Initialize the Dweet channel over radio serial
         m_dweetRadioSerialChannel.Initialize(&m_radioSerial, m_dweetPrefix);
 
+#if DWEET_RADIO_SERIAL_TRANSPORT_BINARY_DWEETS
+        // Binary Dweets from the gateway
+        m_dweetRadioChannel.Initialize(m_radio, m_dweetPrefix, config->sendTimeout);
+#endif
+
         //
         // Register our Dweet event handler on serial
         //
@@ -61,6 +61,20 @@
 // Dweet Radio
 #include <DweetRadio.h>
 
+//
+// Binary Dweets from the gateway in single radio packets in
+// addition to the NMEA 0183 Dweets over radio serial.
+//
+// See DweetRadioChannel.h. This adds about 136 bytes of data
+// on the Atmega328 and may be set to 0 for applications
+// that are short on memory.
+//
+#define DWEET_RADIO_SERIAL_TRANSPORT_BINARY_DWEETS 1
+
+#if DWEET_RADIO_SERIAL_TRANSPORT_BINARY_DWEETS
+#include <DweetRadioChannel.h>
+#endif
+
 // Dispatch + Timers
 #include <MenloDispatchObject.h>
 #include <MenloTimer.h>
@@ -192,6 +206,13 @@ private:
     // Dweet channel support over radio serial.
     //
     DweetSerialChannel m_dweetRadioSerialChannel;
+
+#if DWEET_RADIO_SERIAL_TRANSPORT_BINARY_DWEETS
+    //
+    // Dweet channel support for binary Dweets on the radio.
+    //
+    DweetRadioChannel m_dweetRadioChannel;
+#endif
 };
 
 #endif // DweetRadioSerialTransport_h
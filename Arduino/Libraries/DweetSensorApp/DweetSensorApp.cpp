@@ -97,11 +97,19 @@
 //
 const char sensorapp_module_name_string[] PROGMEM = "DweetSensorApp";
 
-extern const char dweet_sensorrate_string[] PROGMEM = "SENSORRATE";
+#define SENSORAPP_COMMANDS(X) \
+  X(dweet_sensorrate_string, "SENSORRATE")
+
+SENSORAPP_COMMANDS(DWEET_COMMAND_EXTERN_STRING)
 
 const char* const sensorapp_string_table[] PROGMEM =
 {
-  dweet_sensorrate_string
+  SENSORAPP_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t sensorapp_hash_table[] =
+{
+  SENSORAPP_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -179,6 +187,7 @@ DweetSensorApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
     //
     parms.ModuleName = (PGM_P)sensorapp_module_name_string;
     parms.stringTable = (PGM_P)sensorapp_string_table;
+    parms.hashTable = sensorapp_hash_table;
     parms.functionTable = (PGM_P)sensorapp_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -331,6 +340,7 @@ DweetSensorApp::InitializeStateFromStoredConfig()
 
     parms.ModuleName = (PGM_P)sensorapp_module_name_string;
     parms.stringTable = (PGM_P)sensorapp_string_table;
+    parms.hashTable = sensorapp_hash_table;
     parms.functionTable = (PGM_P)sensorapp_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
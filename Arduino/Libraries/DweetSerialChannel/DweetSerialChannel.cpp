@@ -110,8 +110,7 @@ DweetSerialChannel::Initialize(
 
     m_port = port;
 
-    m_inputBufferIndex = 0;
-    m_inputBufferMaxIndex = sizeof(m_inputBuffer) - 1;
+    m_decoder.Initialize((char*)&m_inputBuffer[0], sizeof(m_inputBuffer));
 
     result = m_nmea.Initialize(
         prefix,
@@ -166,87 +165,54 @@ DweetSerialChannel::PollEvent(MenloDispatchObject* sender, MenloEventArgs* event
 // This receives data until a whole line is received delimited
 // by '\n'.
 //
+// The NMEA 0183 checksum, prefix, and command positions are
+// decoded as each character arrives so the sentence is dispatched
+// as soon as the '\n' is received without being parsed again.
+//
+// Lines longer than the buffer, or without a valid prefix, are
+// dropped by the decoder up to the next '\n' which re-syncs the
+// channel on a message boundary.
+//
 void
 DweetSerialChannel::ProcessSerialInput()
 {
-    char c;
+    int result;
+    char prefix[MenloNMEA0183::MaxPrefixSize + 1];
 
     while(m_port->available()) {
 
-        c = m_port->read();
-        m_inputBuffer[m_inputBufferIndex++] = c;
+        result = m_decoder.encode(m_port->read());
+
+        if (result == NMEA0183_DECODE_MORE) {
+            continue;
+        }
 
         //
-        // receiving '\n' terminates a line
+        // A single '\n' message is used to perform a channel sync
         //
-        if (c == '\n') {
-
-	    //
-	    // If there is no character in the buffer this
-            // is a single '\n' message to perform a channel sync
-            //
-  	    if (m_inputBufferIndex == 1) {
-                xDBG_PRINT("Dweet got sync packet");
-                m_inputBufferIndex = 0;
-                return;
-            }
-
-            m_inputBuffer[m_inputBufferIndex] = '\0';
-
-            xDBG_PRINT("Dweet DispatchMessage");
-
-            // MenloDweet.cpp
-            DispatchMessage((char*)&m_inputBuffer[0], m_inputBufferIndex);
+        if (result == NMEA0183_DECODE_SYNC) {
+            xDBG_PRINT("Dweet got sync packet");
+            return;
+        }
 
-            ResetWatchdog();
+        xDBG_PRINT("Dweet DispatchMessage");
 
-            xDBG_PRINT("Dweet Return DispatchMessage");
+        m_decoder.getPrefix(&prefix[0]);
 
-            // Reset the buffer
-            m_inputBufferIndex = 0;
-            return;
-        }
+        // MenloDweet.cpp
+        DispatchTokenizedMessage(
+            m_decoder.getBuffer(),
+            &prefix[0],
+            m_decoder.getCommandsString(),
+            m_decoder.getChecksumOK(),
+            m_decoder.getCommands()
+            );
 
-        //
-        // Getting to the end of the buffer without a '\n' means
-        // an overflow or lost data. Drop all data and let the next
-        // received '\n' re-sync the buffer.
-        //
-        // Buffer re-sync is tricky since we don't know if we have
-        // an almost complete message. But the following rules apply
-        // here:
-        //
-        //  All '\n''s terminate the current buffer and start at index 0
-	//    - So there are no '\n''s seen since the last line termination.
-        //
-        //  Lines can not exceed the buffer length. If they do its either
-        //
-        //  1) An incorrect line, drop it.
-        //
-        //  2) A '\n' was dropped and we have two (or more) messages now
-        //     scrambled inside the buffer with no markers.
-        //
-        // So re-sync is basically to drop all future input data until
-        // a '\n' is seen again resyncing on a good message boundary.
-        //
-	// By just reseting the buffer here, re-sync is accomplished by
-        // the above logic by:
-        //
-        // 1) Filling the buffer till the next '\n'
-        //
-        // 2) Attempting to deliver it to DispatchMessage() above
-        //    which will validate the checksum, which is incorrect.
-	//    
-	//    The buffer is now positioned for the next new valid message.
-        //
-        if (m_inputBufferIndex >= m_inputBufferMaxIndex) {
+        ResetWatchdog();
 
-	    xDBG_PRINT("DweetSerialChannel input buffer overflow resyncing");
+        xDBG_PRINT("Dweet Return DispatchMessage");
 
-            // Reset the buffer
-            m_inputBufferIndex = 0;
-            return;
-        }
+        return;
     }
 
     return;
@@ -109,11 +109,14 @@ private:
     // input buffer is used as data arrives until the NMEA 0183 end of
     // delimiters are received.
     //
-    int m_inputBufferIndex;
-    int m_inputBufferMaxIndex;
-
     uint8_t m_inputBuffer[84];
 
+    //
+    // Decodes the sentence into m_inputBuffer as each character
+    // arrives so it is ready to dispatch on the '\n'.
+    //
+    MenloNMEA0183Decoder m_decoder;
+
     //
     // output buffer is used by NMEA0183 to format sentences before send
     // This is passed to DweetChannel::m_nmea.Initialize()
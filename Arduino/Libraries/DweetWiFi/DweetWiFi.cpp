@@ -72,17 +72,15 @@
 
 const char wifi_module_name_string[] PROGMEM = "DweetWiFi";
 
-extern const char dweet_wifi_ssid_string[] PROGMEM = "WIFISSID";
+#define WIFI_COMMANDS(X) \
+  X(dweet_wifi_ssid_string, "WIFISSID") \
+  X(dweet_wifi_password_string, "WIFIPASSWORD") \
+  X(dweet_wifi_channel_string, "WIFICHANNEL") \
+  X(dweet_wifi_power_timer_string, "WIFIPOWERTIMER") \
+  X(dweet_wifi_attention_string, "WIFIATT") \
+  X(dweet_wifi_options_string, "WIFIOPTIONS")
 
-extern const char dweet_wifi_password_string[] PROGMEM = "WIFIPASSWORD";
-
-extern const char dweet_wifi_channel_string[] PROGMEM = "WIFICHANNEL";
-
-extern const char dweet_wifi_power_timer_string[] PROGMEM = "WIFIPOWERTIMER";
-
-extern const char dweet_wifi_attention_string[] PROGMEM = "WIFIATT";
-
-extern const char dweet_wifi_options_string[] PROGMEM = "WIFIOPTIONS";
+WIFI_COMMANDS(DWEET_COMMAND_EXTERN_STRING)
 
 //
 // DweetWiFi provides an example of a common pattern used
@@ -123,12 +121,12 @@ extern const char dweet_wifi_options_string[] PROGMEM = "WIFIOPTIONS";
 
 const char* const wifi_string_table[] PROGMEM =
 {
-  dweet_wifi_ssid_string,
-  dweet_wifi_password_string,
-  dweet_wifi_channel_string,
-  dweet_wifi_power_timer_string,
-  dweet_wifi_attention_string,
-  dweet_wifi_options_string
+  WIFI_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t wifi_hash_table[] =
+{
+  WIFI_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -260,6 +258,7 @@ DweetWiFi::ProcessWiFiCommands(MenloDweet* dweet, char* name, char* value)
 
     parms.ModuleName = (PGM_P)wifi_module_name_string;
     parms.stringTable = (PGM_P)wifi_string_table;
+    parms.hashTable = wifi_hash_table;
     parms.functionTable = (PGM_P)wifi_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -317,6 +316,7 @@ DweetWiFi::Initialize(MenloDweet* dweet, MenloWiFi* wifi)
 
   parms.ModuleName = (PGM_P)wifi_module_name_string;
   parms.stringTable = (PGM_P)wifi_string_table;
+  parms.hashTable = wifi_hash_table;
   parms.functionTable = (PGM_P)wifi_function_table;
   parms.defaultsTable = NULL;
   parms.object =  this;
@@ -74,8 +74,20 @@
 #define xDBG_PRINT_INT_NNL(x)
 #endif
 
+//
+// PIN handling is compiled out here until ReadAndValidatePin() is
+// fixed, see Initialize(). MenloConfigStore.h still declares the
+// PIN members so the class layout is the same in every file.
+//
+#undef CONFIG_PIN_SUPPORT
 #define CONFIG_PIN_SUPPORT 0
 
+//
+// EEPROM indexes are ints. Going through uintptr_t keeps 64 bit
+// hosts from warning on the int to pointer conversion.
+//
+#define EEPROM_ADDRESS(index) ((uint8_t*)(uintptr_t)(index))
+
 MenloConfigStore ConfigStore;
 
 // Constructor
@@ -307,8 +319,8 @@ MenloConfigStore::CalculateAndStoreCheckSumRange(
   DBG_PRINT_NNL(" buf[1] ");
   DBG_PRINT_INT(buf[1]);
 
-  eeprom_write_byte((uint8_t*)checkSumStoreIndex, buf[0]);
-  eeprom_write_byte((uint8_t*)checkSumStoreIndex + 1, buf[1]);
+  eeprom_write_byte(EEPROM_ADDRESS(checkSumStoreIndex), buf[0]);
+  eeprom_write_byte(EEPROM_ADDRESS(checkSumStoreIndex + 1), buf[1]);
 
   return true;
 }
@@ -344,8 +356,8 @@ MenloConfigStore::CalculateAndValidateCheckSumRange(
       return false;
   }
 
-  checksumBuf[0] = eeprom_read_byte((const uint8_t*)checkSumStoreIndex);
-  checksumBuf[1] = eeprom_read_byte((const uint8_t*)checkSumStoreIndex + 1);
+  checksumBuf[0] = eeprom_read_byte(EEPROM_ADDRESS(checkSumStoreIndex));
+  checksumBuf[1] = eeprom_read_byte(EEPROM_ADDRESS(checkSumStoreIndex + 1));
 
   //DBG_PRINT_NNL("config read checksum [0] ");
   //DBG_PRINT_INT_NNL(checksumBuf[0]);
@@ -400,7 +412,7 @@ MenloConfigStore::CalculateCheckSumRange(int configIndex, int length)
     index = configIndex;
     for (; index < configEnd; index++) {
 
-        buf = eeprom_read_byte((const uint8_t*)index);
+        buf = eeprom_read_byte(EEPROM_ADDRESS(index));
 
         chksum = (chksum ^ buf);
     }
@@ -516,7 +528,7 @@ MenloConfigStore::ReadConfig(int configIndex, uint8_t* buffer, uint8_t length)
   eepromIndex = configIndex;
 
   for (; bufferIndex < length;) {
-        buf = eeprom_read_byte((const uint8_t*)eepromIndex);
+        buf = eeprom_read_byte(EEPROM_ADDRESS(eepromIndex));
 
         buffer[bufferIndex] = buf;
 
@@ -550,7 +562,7 @@ MenloConfigStore::WriteConfig(int configIndex, uint8_t* buffer, uint8_t length)
 
         buf = buffer[bufferIndex];
 
-        eeprom_write_byte((uint8_t*)eepromIndex, buf);
+        eeprom_write_byte(EEPROM_ADDRESS(eepromIndex), buf);
 
 	bufferIndex++;
         eepromIndex++;
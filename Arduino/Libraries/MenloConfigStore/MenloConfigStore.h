@@ -36,7 +36,9 @@
 //#include <inttypes.h>
 
 // Platforms with more space, or applications that make the tradeoffs
+#ifndef CONFIG_PIN_SUPPORT
 #define CONFIG_PIN_SUPPORT 1
+#endif
 
 //
 // Each configuration store entry is an ASCII string terminated
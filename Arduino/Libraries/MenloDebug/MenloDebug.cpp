@@ -245,6 +245,9 @@ MenloDebug::PrintHexPtrNoNewline(void* ptr)
 #if defined(MENLO_BOARD_RFDUINO) || (MENLO_ESP8266) || (MENLO_ARM32)
     // 32 bit architecture
     MenloDebug::PrintHex32NoNewline((uint32_t)ptr);
+#elif MENLO_X86
+    // 32 or 64 bit architecture, low 32 bits
+    MenloDebug::PrintHex32NoNewline((uint32_t)(uintptr_t)ptr);
 #else
     // 16 bit architecture
     MenloDebug::PrintHexNoNewline((uint16_t)ptr);
@@ -334,7 +337,7 @@ MenloDebug::Print(const char* string)
 size_t
 MenloDebug::EscapePrintChar(char c)
 {
-  char* buf;
+  const char* buf;
 
   // If we are not NMEA, just output it now
   if (MenloDebug::Prefix == NULL) {
@@ -865,8 +868,8 @@ MenloDebug::Trace(uint8_t level, uint8_t code, uint8_t size, uint8_t* data)
     PrintHex(code);
 
     PrintNoNewline(F("D ptr "));
-    PrintHex(((int)data) >> 16);
-    PrintHex((int)data);
+    PrintHex(((int)(uintptr_t)data) >> 16);
+    PrintHex((int)(uintptr_t)data);
 
     PrintNoNewline(F("D size "));
     PrintHex(size);
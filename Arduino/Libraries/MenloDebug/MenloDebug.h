@@ -280,6 +280,10 @@ class MenloDebug : MenloObject {
   static size_t Print_P(PGM_P s) {
       return MenloDebug::Print(s);
   }
+
+  static void TraceString(uint8_t level, uint8_t code, PGM_P string) {
+      MenloDebug::TraceString(level, code, (char*)string);
+  }
 #endif
 
   //
@@ -26,6 +26,7 @@
 #include <MenloDebug.h>
 #include <MenloMemoryMonitor.h>
 #include <MenloDispatchObject.h>
+#include <MenloDispatchProfile.h>
 #include <MenloPower.h>
 
 //
@@ -44,6 +45,8 @@ MenloDispatchObject::s_pollList = (MenloDispatchObject*)NULL;
 //
 MenloEvent MenloDispatchObject::s_pollEventList;
 
+volatile bool MenloDispatchObject::s_wakeupPending = false;
+
 //
 // Loop is a static invoked from the Arduino-style loop().
 //
@@ -66,6 +69,11 @@ MenloDispatchObject::loop(unsigned long maxSleepTime)
         waitTime = maxSleepTime;
     }
 
+    // An object was woken after it was visited
+    if (s_wakeupPending) {
+        waitTime = 0;
+    }
+
     Power.Sleep(waitTime);
 
 #if DISPATCH_MEMORY_CHECKS
@@ -83,11 +91,14 @@ MenloDispatchObject::LoopInternal()
     MenloDispatchObject* tmp;
     unsigned long newPollTime;
     unsigned long pollInterval;
+    unsigned long currentTime;
 
 #if DISPATCH_MEMORY_CHECKS
     MenloMemoryMonitor::CheckMemory(LineNumberBaseDispatch + __LINE__);
 #endif
 
+    DISPATCH_PROFILE_LOOP();
+
     //
     // This first pass invokes all objects which are subclasses
     // of MenloDispatchObject() and their constructors have
@@ -112,13 +123,30 @@ MenloDispatchObject::LoopInternal()
     // processing events are drained by an indication
     // of a non zero pollInterval.
     //
+    // Objects which have enabled wakeups are skipped unless they
+    // have been woken or their deadline has expired. So a single
+    // busy object does not cause them to be polled on each pass.
+    //
 
     do {
         tmp = s_pollList;
         pollInterval = MAX_POLL_TIME;
 
+        // Wakeups from here on are seen by this pass or loop()
+        s_wakeupPending = false;
+
+        currentTime = GET_MILLISECONDS();
+
+        DISPATCH_PROFILE_PASS();
+
         while (tmp != NULL) {
 
+            if (tmp->m_wakeupEnabled &&
+                !tmp->WakeupReady(currentTime, &pollInterval)) {
+                tmp = tmp->m_link;
+                continue;
+            }
+
 #if DISPATCH_MEMORY_CHECKS
             MenloMemoryMonitor::CheckMemory(LineNumberBaseDispatch + __LINE__);
 
@@ -132,11 +160,19 @@ MenloDispatchObject::LoopInternal()
             //MenloDebug::Print((int)tmp);
 #endif
 
+            DISPATCH_PROFILE_START(startTime);
+
             newPollTime = tmp->Poll();
 
+            DISPATCH_PROFILE_END(DISPATCH_PROFILE_OBJECT, tmp, startTime);
+
             // Check memory after each callback in case stack overflowed
             MenloMemoryMonitor::CheckMemory(LineNumberBaseDispatch + __LINE__);
 
+            if (tmp->m_wakeupEnabled) {
+                tmp->SetWakeupDeadline(currentTime, newPollTime);
+            }
+
             if (newPollTime < pollInterval) {
                 pollInterval = newPollTime;
             }
@@ -218,6 +254,15 @@ MenloDispatchObject::MenloDispatchObject()
   //
   this->m_link = s_pollList;
   s_pollList = this;
+
+  // Legacy objects are polled on every pass
+  m_wakeupEnabled = false;
+
+  // An object enabling wakeups receives its first Poll()
+  m_runnable = true;
+
+  m_deadlineValid = false;
+  m_deadline = 0;
 }
 
 MenloDispatchObject::~MenloDispatchObject()
@@ -259,3 +304,49 @@ MenloDispatchObject::Poll()
 {
   return  MAX_POLL_TIME;
 }
+
+bool
+MenloDispatchObject::WakeupReady(unsigned long currentTime, unsigned long* pollInterval)
+{
+  unsigned long difference;
+
+  if (m_runnable) {
+
+      //
+      // Cleared before Poll() so a Wakeup() from an interrupt
+      // during Poll() is not lost.
+      //
+      m_runnable = false;
+      return true;
+  }
+
+  if (!m_deadlineValid) {
+      return false;
+  }
+
+  // See MenloTimer::Poll() on wrap around
+  if ((long)(currentTime - m_deadline) >= 0) {
+      return true;
+  }
+
+  // Ensure the pollInterval does not exceed the time till the deadline
+  difference = m_deadline - currentTime;
+  if (*pollInterval > difference) {
+      *pollInterval = difference;
+  }
+
+  return false;
+}
+
+void
+MenloDispatchObject::SetWakeupDeadline(unsigned long currentTime, unsigned long interval)
+{
+  // MAX_POLL_TIME waits for a Wakeup()
+  if (interval == MAX_POLL_TIME) {
+      m_deadlineValid = false;
+      return;
+  }
+
+  m_deadline = currentTime + interval;
+  m_deadlineValid = true;
+}
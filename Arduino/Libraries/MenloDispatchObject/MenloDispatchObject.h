@@ -169,6 +169,14 @@ public:
 
     static void UnregisterPollEvent(MenloEventRegistration* callback);
 
+    //
+    // Returns true if a Wakeup() has occurred since the start of
+    // the last pass over the poll list.
+    //
+    static bool IsWakeupPending() {
+        return s_wakeupPending;
+    }
+
 private:
 
     //
@@ -195,6 +203,12 @@ private:
     //
     static MenloEvent s_pollEventList;
 
+    //
+    // Set by Wakeup() so loop() does not sleep past a wakeup that
+    // arrives after an object was visited.
+    //
+    static volatile bool s_wakeupPending;
+
 public:
 
     //
@@ -215,8 +229,54 @@ public:
     //
     virtual unsigned long Poll();
 
+    //
+    // Mark the object runnable so its Poll() is invoked on the
+    // next pass of the dispatch loop.
+    //
+    // This may be called from an interrupt handler, a stream
+    // channel, or an event handler of another object.
+    //
+    // It has no effect for objects that have not enabled wakeups
+    // since those are polled on every pass.
+    //
+    void Wakeup() {
+        m_runnable = true;
+        s_wakeupPending = true;
+    }
+
+protected:
+
+    //
+    // Opt in to wakeup driven dispatch.
+    //
+    // Legacy objects have Poll() invoked on every pass of the
+    // dispatch loop. An object that enables wakeups is only polled
+    // after Wakeup() is called, or when the interval returned from
+    // its last Poll() has expired. It is skipped otherwise, even
+    // when another object returns 0 and the poll list is run again.
+    //
+    // Such an object must call Wakeup() for any state change that
+    // its Poll() must observe that did not arrive through its
+    // own Poll() interval.
+    //
+    void EnableWakeup() {
+        m_wakeupEnabled = true;
+    }
+
 private:
 
+    //
+    // Returns true if a wakeup enabled object should be polled
+    // on this pass. Otherwise pollInterval is limited to the time
+    // until its deadline.
+    //
+    bool WakeupReady(unsigned long currentTime, unsigned long* pollInterval);
+
+    //
+    // Record the interval returned from Poll() as a deadline
+    //
+    void SetWakeupDeadline(unsigned long currentTime, unsigned long interval);
+
     //
     // Link for per object m_pollList
     //
@@ -224,6 +284,18 @@ private:
     // their own copy of this link.
     //
     MenloDispatchObject* m_link;
+
+    //
+    // Wakeup driven dispatch state
+    //
+    bool m_wakeupEnabled;
+
+    // Set from interrupt handlers
+    volatile bool m_runnable;
+
+    bool m_deadlineValid;
+
+    unsigned long m_deadline;
 };
 
 //
@@ -295,6 +367,11 @@ private:
 //
 // See the Event definition and handling code for details.
 //
+// Objects which call EnableWakeup() are not polled on every
+// pass. The returned interval becomes a deadline, and Wakeup()
+// makes the object runnable before its deadline. A 0 return
+// still causes the object to be polled on the next pass.
+//
 // return value:
 //
 //  Time in milliseconds before the next Poll() is desired.
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+//
+// MenloDispatchProfile.cpp
+// 06/20/2016
+//
+
+#include <MenloPlatform.h>
+#include <MenloDispatchProfile.h>
+
+#if MENLO_DISPATCH_PROFILE
+
+bool MenloDispatchProfile::s_enabled = false;
+
+unsigned long MenloDispatchProfile::s_loopCount = 0;
+unsigned long MenloDispatchProfile::s_passCount = 0;
+unsigned long MenloDispatchProfile::s_overflowCount = 0;
+
+int MenloDispatchProfile::s_entryCount = 0;
+
+MenloDispatchProfileEntry
+MenloDispatchProfile::s_entries[MENLO_DISPATCH_PROFILE_ENTRIES];
+
+void
+MenloDispatchProfile::Reset()
+{
+    s_loopCount = 0;
+    s_passCount = 0;
+    s_overflowCount = 0;
+
+    s_entryCount = 0;
+
+    memset(&s_entries[0], 0, sizeof(s_entries));
+}
+
+void
+MenloDispatchProfile::Record(uint8_t type, const void* key, unsigned long elapsedMicros)
+{
+    MenloDispatchProfileEntry* entry;
+    int index;
+
+    //
+    // The set of objects and handlers is small and stable so
+    // a linear search is used. Entries are never removed until
+    // Reset() so their index is stable for GETSTATE=PROFILE:nn.
+    //
+    for (index = 0; index < s_entryCount; index++) {
+        if ((s_entries[index].key == key) && (s_entries[index].type == type)) {
+            break;
+        }
+    }
+
+    if (index == s_entryCount) {
+
+        if (s_entryCount == MENLO_DISPATCH_PROFILE_ENTRIES) {
+            s_overflowCount++;
+            return;
+        }
+
+        s_entries[index].key = key;
+        s_entries[index].type = type;
+        s_entries[index].count = 0;
+        s_entries[index].totalMicros = 0;
+        s_entries[index].maxMicros = 0;
+
+        s_entryCount++;
+    }
+
+    entry = &s_entries[index];
+
+    entry->count++;
+    entry->totalMicros += elapsedMicros;
+
+    if (elapsedMicros > entry->maxMicros) {
+        entry->maxMicros = elapsedMicros;
+    }
+}
+
+MenloDispatchProfileEntry*
+MenloDispatchProfile::GetEntry(int index)
+{
+    if ((index < 0) || (index >= s_entryCount)) {
+        return NULL;
+    }
+
+    return &s_entries[index];
+}
+
+#endif // MENLO_DISPATCH_PROFILE
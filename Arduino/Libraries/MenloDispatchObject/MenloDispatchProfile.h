@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+//
+// MenloDispatchProfile.h
+// 06/20/2016
+//
+// Dispatch loop profiler.
+//
+// Records the call count, cumulative and maximum elapsed
+// microseconds for each MenloDispatchObject::Poll(), event
+// handler and timer handler invoked by the dispatch loop, and
+// the number of extra passes over the poll list caused by
+// objects returning a 0 poll interval.
+//
+// This is compiled in when MENLO_DISPATCH_PROFILE is set and
+// is then off until Enable(true) is called so it costs a single
+// test per dispatch when not in use.
+//
+// The results are available through the DweetDebug
+// GETSTATE=PROFILE command, and from the accessors below.
+//
+
+#ifndef MenloDispatchProfile_h
+#define MenloDispatchProfile_h
+
+#include "MenloPlatform.h"
+
+#ifndef MENLO_DISPATCH_PROFILE
+#define MENLO_DISPATCH_PROFILE 0
+#endif
+
+//
+// Number of distinct objects/handlers tracked. Dispatches to
+// objects beyond this are counted in GetOverflowCount().
+//
+#ifndef MENLO_DISPATCH_PROFILE_ENTRIES
+#if MENLO_X86
+#define MENLO_DISPATCH_PROFILE_ENTRIES 64
+#else
+#define MENLO_DISPATCH_PROFILE_ENTRIES 16
+#endif
+#endif
+
+//
+// What the entry key points to
+//
+#define DISPATCH_PROFILE_OBJECT 0x01 // MenloDispatchObject, Poll()
+#define DISPATCH_PROFILE_EVENT  0x02 // MenloEventRegistration, event handler
+#define DISPATCH_PROFILE_TIMER  0x03 // MenloTimerEventRegistration, timer handler
+
+struct MenloDispatchProfileEntry {
+    const void* key;
+    uint8_t type;
+    unsigned long count;
+    unsigned long totalMicros;
+    unsigned long maxMicros;
+};
+
+class MenloDispatchProfile {
+
+public:
+
+    static void Enable(bool enable) {
+        s_enabled = enable;
+    }
+
+    static bool IsEnabled() {
+        return s_enabled;
+    }
+
+    // Clear all entries and counters
+    static void Reset();
+
+    //
+    // Start time for End(), 0 when not enabled
+    //
+    static unsigned long Start() {
+        if (!s_enabled) return 0;
+        return micros();
+    }
+
+    //
+    // A 0 startTime is a dispatch which began before profiling was
+    // enabled, such as the Dweet that enables it, and is ignored.
+    //
+    static void End(uint8_t type, const void* key, unsigned long startTime) {
+        if (!s_enabled || (startTime == 0)) return;
+        Record(type, key, micros() - startTime);
+    }
+
+    static void Record(uint8_t type, const void* key, unsigned long elapsedMicros);
+
+    //
+    // Loop statistics maintained by MenloDispatchObject::LoopInternal()
+    //
+    static void RecordLoop() {
+        if (s_enabled) s_loopCount++;
+    }
+
+    static void RecordPass() {
+        if (s_enabled) s_passCount++;
+    }
+
+    static unsigned long GetLoopCount() {
+        return s_loopCount;
+    }
+
+    static unsigned long GetPassCount() {
+        return s_passCount;
+    }
+
+    // Extra passes due to a 0 poll interval
+    static unsigned long GetDrainPassCount() {
+        return s_passCount - s_loopCount;
+    }
+
+    static unsigned long GetOverflowCount() {
+        return s_overflowCount;
+    }
+
+    static int GetEntryCount() {
+        return s_entryCount;
+    }
+
+    // Returns NULL if index is out of range
+    static MenloDispatchProfileEntry* GetEntry(int index);
+
+private:
+
+    static bool s_enabled;
+
+    static unsigned long s_loopCount;
+    static unsigned long s_passCount;
+    static unsigned long s_overflowCount;
+
+    static int s_entryCount;
+
+    static MenloDispatchProfileEntry s_entries[MENLO_DISPATCH_PROFILE_ENTRIES];
+};
+
+//
+// Instrumentation points
+//
+#if MENLO_DISPATCH_PROFILE
+#define DISPATCH_PROFILE_START(t)          unsigned long t = MenloDispatchProfile::Start()
+#define DISPATCH_PROFILE_END(type, key, t) MenloDispatchProfile::End(type, key, t)
+#define DISPATCH_PROFILE_LOOP()            MenloDispatchProfile::RecordLoop()
+#define DISPATCH_PROFILE_PASS()            MenloDispatchProfile::RecordPass()
+#else
+#define DISPATCH_PROFILE_START(t)
+#define DISPATCH_PROFILE_END(type, key, t)
+#define DISPATCH_PROFILE_LOOP()
+#define DISPATCH_PROFILE_PASS()
+#endif
+
+#endif // MenloDispatchProfile_h
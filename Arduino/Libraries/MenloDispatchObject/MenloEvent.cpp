@@ -30,6 +30,7 @@
 #include <MenloDebug.h>
 #include <MenloMemoryMonitor.h>
 #include <MenloDispatchObject.h>
+#include <MenloDispatchProfile.h>
 #include <MenloPower.h>
 
 #define DBG_PRINT_ENABLED 0
@@ -257,8 +258,12 @@ MenloEvent::DispatchEvents(MenloDispatchObject* sender, MenloEventArgs* eventArg
         //
         next = tmp->m_link;
 
+        DISPATCH_PROFILE_START(startTime);
+
         newPollTime = ((tmp->object)->*(tmp->method))(sender, eventArgs);
 
+        DISPATCH_PROFILE_END(DISPATCH_PROFILE_EVENT, tmp, startTime);
+
         // Check memory, esp. stack for overflows
         MenloMemoryMonitor::CheckMemory(LineNumberBaseEvent + __LINE__);
 
@@ -98,25 +98,29 @@
 //
 const char config_module_name_string[] PROGMEM = "DweetConfig";
 
-const char dweet_model_string[] PROGMEM = "MODEL";
-const char dweet_name_string[] PROGMEM = "NAME";
-const char dweet_serial_string[] PROGMEM = "SERIAL";
-const char dweet_version_string[] PROGMEM = "VERSION";
-const char dweet_firmwareversion_string[] PROGMEM = "FIRMWAREVERSION";
-
-// CPU Power Support
-const char dweet_sleepmode_string[] PROGMEM = "SLEEPMODE";
-const char dweet_cpuspeed_string[] PROGMEM = "CPUSPEED";
-const char dweet_sleeptime_string[] PROGMEM = "SLEEPTIME";
-const char dweet_awaketime_string[] PROGMEM = "AWAKETIME";
-
 //
-// State commands
+// TRACELEVEL and NOCHECKSUM are state commands.
 //
-const char dweet_tracelevel_string[] PROGMEM = "TRACELEVEL";
-
-// Ignore NMEA 0183 checksum errors (allows easy command console input)
-const char dweet_nochecksum_string[] PROGMEM = "NOCHECKSUM";
+// NOCHECKSUM ignores NMEA 0183 checksum errors (allows easy
+// command console input)
+//
+// SLEEPMODE, CPUSPEED, SLEEPTIME and AWAKETIME are the CPU
+// Power Support.
+//
+#define CONFIG_COMMANDS(X) \
+  X(dweet_model_string, "MODEL") \
+  X(dweet_name_string, "NAME") \
+  X(dweet_serial_string, "SERIAL") \
+  X(dweet_version_string, "VERSION") \
+  X(dweet_firmwareversion_string, "FIRMWAREVERSION") \
+  X(dweet_tracelevel_string, "TRACELEVEL") \
+  X(dweet_nochecksum_string, "NOCHECKSUM") \
+  X(dweet_sleepmode_string, "SLEEPMODE") \
+  X(dweet_cpuspeed_string, "CPUSPEED") \
+  X(dweet_sleeptime_string, "SLEEPTIME") \
+  X(dweet_awaketime_string, "AWAKETIME")
+
+CONFIG_COMMANDS(DWEET_COMMAND_STRING)
 
 //
 // MenloDweet only deals with normal character
@@ -134,17 +138,12 @@ const char dweet_nochecksum_string[] PROGMEM = "NOCHECKSUM";
 
 const char* const config_string_table[] PROGMEM =
 {
-  dweet_model_string,
-  dweet_name_string,
-  dweet_serial_string,
-  dweet_version_string,
-  dweet_firmwareversion_string,
-  dweet_tracelevel_string,
-  dweet_nochecksum_string,
-  dweet_sleepmode_string,
-  dweet_cpuspeed_string,
-  dweet_sleeptime_string,
-  dweet_awaketime_string
+  CONFIG_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t config_hash_table[] =
+{
+  CONFIG_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -308,6 +307,7 @@ MenloDweet::ProcessBuiltInCommands(char* name, char* value)
 
     parms.ModuleName = (PGM_P)config_module_name_string;
     parms.stringTable = (PGM_P)config_string_table;
+    parms.hashTable = config_hash_table;
     parms.functionTable = (PGM_P)config_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -337,6 +337,7 @@ MenloDweet::ProcessBuiltInCommands(char* name, char* value)
 int
 MenloDweet::ProcessGetConfigCommandsTable(
     PGM_P configTable,         // table of PGM character strings
+    const uint16_t* hashTable, // table of PGM DWEET_HASH()'s, or NULL
     const int* indexTable,     // table of PGM int's
     const int* sizeTable,      // table of PGM int's
     int tableEntries,          // number of entries in the above tables
@@ -359,7 +360,7 @@ MenloDweet::ProcessGetConfigCommandsTable(
 
     // Look for the entry
     // MenloDweet.cpp
-    index = LookupStringPrefixTableIndex(configTable, tableEntries, value);
+    index = LookupStringPrefixTableIndex(configTable, hashTable, tableEntries, value);
     if (index == (-1)) {
         // No matching entry, continue looking for a handler
         return 0;
@@ -417,6 +418,7 @@ MenloDweet::ProcessGetConfigCommandsTable(
 int
 MenloDweet::ProcessSetConfigCommandsTable(
     PGM_P configTable,         // table of PGM character strings
+    const uint16_t* hashTable, // table of PGM DWEET_HASH()'s, or NULL
     const int* indexTable,     // table of PGM int's
     const int* sizeTable,      // table of PGM int's
     int tableEntries,          // number of entries in the above tables
@@ -451,7 +453,7 @@ MenloDweet::ProcessSetConfigCommandsTable(
     xDBG_PRINT_STRING(item);
 
     // Look for the entry
-    index = LookupStringPrefixTableIndex(configTable, tableEntries, item);
+    index = LookupStringPrefixTableIndex(configTable, hashTable, tableEntries, item);
     if (index == (-1)) {
         xDBG_PRINT("SETCONFIG no table entry");
         // No matching entry, continue looking for a handler
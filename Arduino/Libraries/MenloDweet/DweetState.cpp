@@ -151,6 +151,12 @@ MenloDweet::DispatchFunctionFromTable(
     // MenloPlatform.h
     //
 
+    //
+    // On ARM and x86 a method pointer is two words and p only sets
+    // the function address. Clear the this adjustment first.
+    //
+    method.m = NULL;
+
     method.p = MenloPlatform::GetMethodPointerFromMethodArray(
         (char**)functionTable, index);
 
@@ -158,7 +164,7 @@ MenloDweet::DispatchFunctionFromTable(
     DBG_PRINT_INT((uint16_t)method.p);
 
     // If the entry is null, return not implemented code
-    if (method.p == NULL) {
+    if (method.p == 0) {
         xDBG_PRINT("DispatchFunction from table entry is null");
         return DWEET_NO_FUNCTION;
     }
@@ -239,6 +245,7 @@ MenloDweet::ProcessStateCommandsTable(
         // DweetConfig.cpp
         retVal = ProcessGetConfigCommandsTable(
             parms->stringTable,
+            parms->hashTable,
             parms->indexTable,
             parms->sizeTable,
             parms->tableEntries,
@@ -321,7 +328,12 @@ MenloDweet::ProcessStateCommandsTable(
     xDBG_PRINT_STRING(parms->value);
 
     // Look for the entry, in MenloDweet.cpp
-    index = LookupStringPrefixTableIndex(parms->stringTable, parms->tableEntries, parms->value);
+    index = LookupStringPrefixTableIndex(
+        parms->stringTable,
+        parms->hashTable,
+        parms->tableEntries,
+        parms->value
+        );
 
     if (index == (-1)) {
         // No matching entry, continue looking for a handler
@@ -415,6 +427,7 @@ MenloDweet::ProcessStateCommandsTable(
             //
             retVal = ProcessSetConfigCommandsTable(
                 parms->stringTable,
+                parms->hashTable,
                 parms->indexTable,
                 parms->sizeTable,
                 parms->tableEntries,
@@ -112,6 +112,8 @@ MenloDweet::MenloDweet()
   m_traceLevel = 0;
   m_port = NULL;
   m_nmea = NULL;
+  m_tokenValue = NULL;
+  m_tokenAction = NULL;
 }
 
 int
@@ -244,11 +246,11 @@ MenloDweet::RegisterGlobalNMEAMessageEvent(MenloNMEAMessageEventRegistration* ca
 int
 MenloDweet::DispatchMessage(char* buffer, int length)
 {
-    int retVal = 0;
     unsigned char checksum = 0;
     int checksumOK = 0;
     char* cmds = NULL;
     char prefix[MenloNMEA0183::MaxPrefixSize + 1];
+    struct MenloNMEA0183Commands commands;
 
     DBG_PRINT("DispatchMessage entered");
 
@@ -264,13 +266,28 @@ MenloDweet::DispatchMessage(char* buffer, int length)
     // Try and parse it as a valid NMEA 0183 message.
     //
     // This returns a char* to the first command following the ","
-    // character after the prefix.
+    // character after the prefix, and locates each command in
+    // the same pass.
     //
-    cmds = m_nmea->parse(buffer, &prefix[0], &checksum, &checksumOK);
+    cmds = m_nmea->tokenize(buffer, &prefix[0], &checksum, &checksumOK, &commands);
    
     //MenloDebug::PrintNoNewline("checksumOK ");
     //MenloDebug::PrintHex(checksumOK);
 
+    return DispatchTokenizedMessage(buffer, &prefix[0], cmds, checksumOK, &commands);
+}
+
+int
+MenloDweet::DispatchTokenizedMessage(
+    char* buffer,
+    char* prefix,
+    char* cmds,
+    int checksumOK,
+    struct MenloNMEA0183Commands* commands
+    )
+{
+    int retVal = 0;
+
     if (checksumOK || m_ignoreChecksumErrors) {
 
         //
@@ -283,12 +300,12 @@ MenloDweet::DispatchMessage(char* buffer, int length)
                 xDBG_PRINT("DispatchMessage cmds is NULL");
             }
             else {
-                retVal = ProcessDweetCommands(&prefix[0], cmds);
+                retVal = ProcessDweetCommands(commands);
             }
         }
         else {
             xDBG_PRINT("non Dweet NMEA 0183 message");
-            retVal = EmitNMEAMessageEvent(&prefix[0], cmds, buffer);
+            retVal = EmitNMEAMessageEvent(prefix, cmds, buffer);
         }
     }
     else {
@@ -488,6 +505,55 @@ MenloDweet::ProcessDweetCommands(char* prefix, char* cmds)
     return handled;
 }
 
+//
+// Process the Dweet commands located by MenloNMEA0183::tokenize()
+//
+int
+MenloDweet::ProcessDweetCommands(struct MenloNMEA0183Commands* commands)
+{
+    int index;
+    int handled = 0;
+    struct MenloNMEA0183Command* cmd;
+
+    for (index = 0; index < commands->count; index++) {
+
+        cmd = &commands->command[index];
+
+        // Split the command in place now that it is known to be a Dweet
+        MenloNMEA0183::TerminateCommand(commands, index);
+
+        // single value command with no '='
+        if (cmd->value == NULL) {
+            continue;
+        }
+
+        //
+        // Let ProcessItemAction() use the ':' already located
+        // rather than search for it again.
+        //
+        m_tokenValue = cmd->value;
+        m_tokenAction = cmd->action;
+
+        // Find a handler for the command
+        if (DispatchDweetCommand(cmd->name, cmd->value)) {
+            handled = 1;
+        }
+
+        m_tokenValue = NULL;
+    }
+
+    //
+    // Commands past NMEA0183_MAX_COMMANDS
+    //
+    if (commands->remainder != NULL) {
+        if (ProcessDweetCommands(NULL, commands->remainder)) {
+            handled = 1;
+        }
+    }
+
+    return handled;
+}
+
 //
 // Process a single Dweet command
 //
@@ -556,7 +622,18 @@ MenloDweet::ProcessItemAction(char* str, char** item, char** action) {
 
     char* ptr;
 
-    ptr = strchr(str, ':');
+    if ((str != NULL) && (str == m_tokenValue)) {
+
+        // Located by MenloNMEA0183::tokenize()
+        ptr = (m_tokenAction != NULL) ? (m_tokenAction - 1) : NULL;
+
+        // The string is split now
+        m_tokenValue = NULL;
+    }
+    else {
+        ptr = strchr(str, ':');
+    }
+
     if (ptr == NULL) {
 	// no ':'
 
@@ -1105,29 +1182,105 @@ MenloDweet::LookupStringPrefixTableIndex(
     int tableEntries,           // number of entries in the table
     char* compareString
     )
+{
+    return LookupStringPrefixTableIndex(
+        stringTable,
+        NULL,
+        tableEntries,
+        compareString
+        );
+}
+
+#if MENLO_DWEET_HASH_CHECK
+bool
+MenloDweet::CheckHashTable(
+    PGM_P stringTable,          // table of PGM character strings
+    const uint16_t* hashTable,  // table of PGM DWEET_HASH()'s
+    int tableEntries            // number of entries in the table
+    )
+{
+    PGM_P p;
+    int index;
+    uint16_t hash;
+    char c;
+    bool valid = true;
+
+    for (index = 0; index < tableEntries; index++) {
+
+        // MenloPlatform.h
+        p = (PGM_P)MenloPlatform::GetStringPointerFromStringArray((char**)stringTable, index);
+
+        // Same calculation as DweetCommandHash() from flash
+        hash = 0;
+
+        while (((c = pgm_read_byte(p)) != '\0') && (c != ':')) {
+            hash = (uint16_t)((hash * 31) + (uint8_t)c);
+            p++;
+        }
+
+        if (pgm_read_word(&hashTable[index]) != hash) {
+            MenloDebug::PrintNoNewline(F("Dweet hash table mismatch "));
+            MenloDebug::Print_P(
+                (PGM_P)MenloPlatform::GetStringPointerFromStringArray((char**)stringTable, index));
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+#endif
+
+//
+// If hashTable is supplied only entries whose DWEET_HASH()
+// matches compareString are read and compared from flash.
+//
+int
+MenloDweet::LookupStringPrefixTableIndex(
+    PGM_P stringTable,          // table of PGM character strings
+    const uint16_t* hashTable,  // table of PGM DWEET_HASH()'s, or NULL
+    int tableEntries,           // number of entries in the table
+    char* compareString
+    )
 {
     PGM_P p;
     int index;
     int length;
     int compareLength;
+    uint16_t hash;
     char* ptr;
 
     //
-    // Get the effective length for compareString
+    // Get the effective length and hash for compareString
+    // which is terminated by ':' or '\0'.
+    //
+    // This is the same calculation as DweetCommandHash() in
+    // MenloDweet.h in a single pass.
     //
-    ptr = strchr(compareString, ':');
-    if (ptr != NULL) {
-        // terminated by ':'
-        compareLength = ptr - compareString;
+    hash = 0;
+    ptr = compareString;
+
+    while ((*ptr != '\0') && (*ptr != ':')) {
+        hash = (uint16_t)((hash * 31) + (uint8_t)*ptr);
+        ptr++;
     }
-    else {
-        // terminated by '\0'
-        compareLength = strlen(compareString);
+
+    compareLength = ptr - compareString;
+
+#if MENLO_DWEET_HASH_CHECK
+    if ((hashTable != NULL) && !CheckHashTable(stringTable, hashTable, tableEntries)) {
+        hashTable = NULL;
     }
+#endif
 
     // Look for the entry
     for (index = 0; index < tableEntries; index++) {
 
+        if (hashTable != NULL) {
+            if (pgm_read_word(&hashTable[index]) != hash) {
+                continue;
+            }
+        }
+
         // MenloPlatform.h
         p = (PGM_P)MenloPlatform::GetStringPointerFromStringArray((char**)stringTable, index);
 
@@ -78,6 +78,70 @@
 // routines see model.txt
 //
 
+//
+// Command name hash used to speed up table lookups.
+//
+// Each module supplies a PROGMEM table of DWEET_HASH() values in
+// the same order as its string table. The lookup hashes the incoming
+// command name once, compares one word per entry, and only reads
+// and compares the string in flash on a hash match.
+//
+// The hash is computed by the compiler so the names are not
+// stored a second time in the image.
+//
+// The hash stops at '\0' or the ':' separator so "WINDSPEED" and
+// "WINDSPEED:0A" hash the same.
+//
+constexpr uint16_t
+DweetCommandHash(const char* s, uint16_t hash)
+{
+    return ((*s == '\0') || (*s == ':')) ? hash :
+        DweetCommandHash(s + 1, (uint16_t)((hash * 31) + (uint8_t)*s));
+}
+
+#define DWEET_HASH(s) DweetCommandHash(s, 0)
+
+//
+// A module lists its commands once as X(variable, "NAME") entries
+// and expands the list to define the PROGMEM strings, the string
+// table and the hash table. Each name is typed once and the tables
+// are always in the same order.
+//
+//   #define BLINK_COMMANDS(X) \
+//       X(dweet_blinkinterval_string, "BLINKINTERVAL")
+//
+//   BLINK_COMMANDS(DWEET_COMMAND_STRING)
+//
+//   const char* const blink_string_table[] PROGMEM =
+//   {
+//       BLINK_COMMANDS(DWEET_COMMAND_NAME)
+//   };
+//
+//   PROGMEM const uint16_t blink_hash_table[] =
+//   {
+//       BLINK_COMMANDS(DWEET_COMMAND_HASH)
+//   };
+//
+// DWEET_COMMAND_EXTERN_STRING is used instead of DWEET_COMMAND_STRING
+// when the strings are referenced from other modules.
+//
+#define DWEET_COMMAND_STRING(name, s) const char name[] PROGMEM = s;
+#define DWEET_COMMAND_EXTERN_STRING(name, s) extern const char name[] PROGMEM = s;
+#define DWEET_COMMAND_NAME(name, s) name,
+#define DWEET_COMMAND_HASH(name, s) DWEET_HASH(s),
+
+//
+// When set each lookup hashes the string table and compares it
+// with the hash table. A mismatch, such as a table written by hand
+// out of order, is reported on the debug port and the lookup falls
+// back to comparing the strings.
+//
+// This reads every entry on each lookup so is for debug builds.
+//
+#ifndef MENLO_DWEET_HASH_CHECK
+#define MENLO_DWEET_HASH_CHECK 0
+#endif
+
 //
 //
 // Default values table entry.
@@ -100,6 +164,10 @@ struct StateSettingsDefaultValue {
 //
 struct StateSettingsParameters {
     PGM_P stringTable;         // table of PGM character strings
+
+    // table of PGM DWEET_HASH()'s, or NULL to compare the strings
+    const uint16_t* hashTable = NULL;
+
     PGM_P functionTable;       // table of PGM function pointers
     PGM_P ModuleName;          // Dweet Module providing the parameters
     const int* indexTable;     // table of PGM int's for configIndex
@@ -241,6 +309,21 @@ protected:
   //
   int DispatchMessage(char* buffer, int length);
 
+  //
+  // Process a sentence already located by MenloNMEA0183::tokenize()
+  // or MenloNMEA0183Decoder.
+  //
+  // buffer is the raw sentence, cmds the start of the commands
+  // after the prefix.
+  //
+  int DispatchTokenizedMessage(
+      char* buffer,
+      char* prefix,
+      char* cmds,
+      int checksumOK,
+      struct MenloNMEA0183Commands* commands
+      );
+
   //
   // Send a Dweet Command
   //
@@ -327,9 +410,28 @@ protected:
       char* compareString
       );
 
+  int
+  LookupStringPrefixTableIndex(
+      PGM_P stringTable,          // table of PGM character strings
+      const uint16_t* hashTable,  // table of PGM DWEET_HASH()'s, or NULL
+      int tableEntries,           // number of entries in the table
+      char* compareString
+      );
+
+#if MENLO_DWEET_HASH_CHECK
+  // Returns false if an entry of hashTable does not match stringTable
+  bool
+  CheckHashTable(
+      PGM_P stringTable,          // table of PGM character strings
+      const uint16_t* hashTable,  // table of PGM DWEET_HASH()'s
+      int tableEntries            // number of entries in the table
+      );
+#endif
+
   int
   ProcessGetConfigCommandsTable(
       PGM_P configTable,         // table of PGM character strings
+      const uint16_t* hashTable, // table of PGM DWEET_HASH()'s, or NULL
       const int* indexTable,     // table of PGM int's
       const int* sizeTable,      // table of PGM int's
       int tableEntries,          // number of entries in the above tables
@@ -342,6 +444,7 @@ protected:
   int
   ProcessSetConfigCommandsTable(
       PGM_P configTable,         // table of PGM character strings
+      const uint16_t* hashTable, // table of PGM DWEET_HASH()'s, or NULL
       const int* indexTable,     // table of PGM int's
       const int* sizeTable,      // table of PGM int's
       int tableEntries,          // number of entries in the above tables
@@ -409,6 +512,9 @@ protected:
   //
   int ProcessDweetCommands(char* prefix, char* cmds);
 
+  // Commands located by MenloNMEA0183::tokenize()
+  int ProcessDweetCommands(struct MenloNMEA0183Commands* commands);
+
   //
   // Process a single Dweet command
   //
@@ -668,6 +774,13 @@ protected:
 
   bool m_ignoreChecksumErrors;
 
+  //
+  // Value of the command being dispatched and its ':' separator
+  // located by MenloNMEA0183::tokenize() for ProcessItemAction().
+  //
+  char* m_tokenValue;
+  char* m_tokenAction;
+
 }; // 4 bytes
 
 #endif // MenloDweet_h
@@ -97,11 +97,19 @@
 
 const char gateway_module_name_string[] PROGMEM = "Gateway";
 
-const char dweet_blinkinterval_string[] PROGMEM = "BLINKINTERVAL";
+#define GATEWAY_COMMANDS(X) \
+    X(dweet_blinkinterval_string, "BLINKINTERVAL")
+
+GATEWAY_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const gateway_string_table[] PROGMEM =
 {
-    dweet_blinkinterval_string
+    GATEWAY_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t gateway_hash_table[] =
+{
+    GATEWAY_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -202,6 +210,7 @@ MenloGatewayApp::Initialize(MenloGatewayConfiguration* config)
     //
     parms.ModuleName = (PGM_P)gateway_module_name_string;
     parms.stringTable = (PGM_P)gateway_string_table;
+    parms.hashTable = gateway_hash_table;
     parms.functionTable = (PGM_P)gateway_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -316,6 +325,7 @@ MenloGatewayApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
     //
     parms.ModuleName = (PGM_P)gateway_module_name_string;
     parms.stringTable = (PGM_P)gateway_string_table;
+    parms.hashTable = gateway_hash_table;
     parms.functionTable = (PGM_P)gateway_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
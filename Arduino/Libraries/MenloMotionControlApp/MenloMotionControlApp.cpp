@@ -111,23 +111,23 @@
 
 const char motioncontrol_module_name_string[] PROGMEM = "MotionControl";
 
-const char dweet_microstep_string[] PROGMEM = "MICROSTEP";
+#define MOTIONCONTROL_COMMANDS(X) \
+    X(dweet_microstep_string, "MICROSTEP") \
+    X(dweet_steprate_string, "STEPRATE") \
+    X(dweet_powermode_string, "POWERMODE") \
+    X(dweet_stepopenloop_string, "STEPOPENLOOP") \
+    X(dweet_stepclosedloop_string, "STEPCLOSEDLOOP")
 
-const char dweet_steprate_string[]  PROGMEM = "STEPRATE";
-
-const char dweet_powermode_string[] PROGMEM = "POWERMODE";
-
-const char dweet_stepopenloop_string[] PROGMEM = "STEPOPENLOOP";
-
-const char dweet_stepclosedloop_string[] PROGMEM = "STEPCLOSEDLOOP";
+MOTIONCONTROL_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const motioncontrol_string_table[] PROGMEM =
 {
-    dweet_microstep_string,
-    dweet_steprate_string,
-    dweet_powermode_string,
-    dweet_stepopenloop_string,
-    dweet_stepclosedloop_string
+    MOTIONCONTROL_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t motioncontrol_hash_table[] =
+{
+    MOTIONCONTROL_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -394,6 +394,7 @@ MenloMotionControlApp::Initialize(MotionControlConfiguration* config)
     //
     parms.ModuleName = (PGM_P)motioncontrol_module_name_string;
     parms.stringTable = (PGM_P)motioncontrol_string_table;
+    parms.hashTable = motioncontrol_hash_table;
     parms.functionTable = (PGM_P)motioncontrol_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -505,6 +506,7 @@ MenloMotionControlApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* v
     //
     parms.ModuleName = (PGM_P)motioncontrol_module_name_string;
     parms.stringTable = (PGM_P)motioncontrol_string_table;
+    parms.hashTable = motioncontrol_hash_table;
     parms.functionTable = (PGM_P)motioncontrol_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
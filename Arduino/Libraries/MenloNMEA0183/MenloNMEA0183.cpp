@@ -354,111 +354,132 @@ MenloNMEA0183::parse(
     unsigned char* checksumOut,
     int* checksumOKOut
     )
+{
+  return tokenize(buffer, prefixOut, checksumOut, checksumOKOut, NULL);
+}
+
+//
+// This is the receive hot path for every Dweet so the buffer
+// is only walked once. The previous implementation ran checksum(),
+// a prefix scan, a scan for '*', and then the Dweet dispatcher
+// scanned again for ',', '=', and ':'.
+//
+char*
+MenloNMEA0183::tokenize(
+    char* buffer,
+    char* prefixOut,
+    unsigned char* checksumOut,
+    int* checksumOKOut,
+    struct MenloNMEA0183Commands* commands
+    )
 {
   int index;
-  char *firstCommand = NULL;
-  unsigned char chksum;
+  char c;
+  char* ptr;
+  char* firstCommand;
+  struct MenloNMEA0183Command* cmd = NULL;
+  unsigned char chksum = 0;
   char checksumAscii[2];
 
-  // If string format is not valid error out now
-  if (!checksum(buffer, &chksum)) {
-      return NULL;
-  }
-
-  //
-  // Since NMEA 0183 is used by MenloDebug, we must perform
-  // direct writing to the serial port when debugging here.
-  //  
-  // This messes up the protocol, but at least allows low level
-  // infrastructure debugging.
-  //  
-  // Note: Must turn on traceerror for the dweet utility so that
-  //       bad checksum messages get reported.
-  //  
-  //Serial.print("$PDBG,checksum=");
-  //Serial.print(chksum);
-  //Serial.println("*00");
-
   prefixOut[0] = '\0';
   *checksumOKOut = 0;
 
+  if (commands != NULL) {
+    commands->count = 0;
+    commands->remainder = NULL;
+  }
+
   //
-  // Checksum may still be invalid, but at least the string
-  // was formatted correctly to be able to calculate it.
+  // String must start with $ which is not part of the checksum
   //
-  *checksumOut = chksum;
+  if (buffer[0] != '$') {
+    return NULL;
+  }
 
   //
-  // Convert the checksum binary byte to ASCII hex digits
-  // for comparison later. Cheaper than doing atoi with hex conversion
-  // or worse yet scanf()
+  // Load prefix through the first ','
   //
+  prefixOut[0] = '$';
 
-  MenloUtility::UInt8ToHexBuffer(chksum, &checksumAscii[0]);
+  for (index = 1; buffer[index] != ','; index++) {
 
-  //
-  // parse the buffer indexing by ',' characters
-  //
-  // return each word between each pair of ',' characters
-  //
-  // model in strtok which allows moving a cursor through
-  // to minimize buffering and complex callbacks.
-  //
-  if (buffer[0] != '$') {
-      return NULL;
-  }
-  
-  // Load prefix
-  for (index = 0;; index++) {
+    c = buffer[index];
 
-    // str to short
-    if (buffer[index] == '\0') {
+    // str to short, or no commands
+    if ((c == '\0') || (c == '*')) {
       prefixOut[0] = '\0';
       return NULL;
     }
 
-    if (buffer[index] == ',') break;
-
     if (index >= m_maxPrefixLength) {
       // prefix too long
       prefixOut[0] = '\0';
       return NULL;
     }
 
-    prefixOut[index] = buffer[index];
+    prefixOut[index] = c;
+    chksum = (chksum ^ c);
   }
 
   prefixOut[index] = '\0';
 
-  // skip ','
-  index++;
+  // ',' is part of the checksum
+  chksum = (chksum ^ ',');
 
-  // this points to the first command buffer[index]
-  firstCommand = &buffer[index];
+  // this points to the first command
+  ptr = &buffer[index + 1];
+  firstCommand = ptr;
 
-  // Now look for sentence end '*'
-  while(buffer[index] != '\0') {
-    if (buffer[index] == '*') break;
-    index++;
+  if (commands != NULL) {
+    cmd = StartCommands(commands, ptr);
   }
 
-  if (buffer[index] != '*') {
-    prefixOut[0] = '\0';
-    return NULL;
+  //
+  // Checksum the commands up to the sentence end '*' while
+  // locating the separators.
+  //
+  for (;; ptr++) {
+
+    c = *ptr;
+
+    if (c == '*') break;
+
+    if (c == '\0') {
+      // No '*'
+      prefixOut[0] = '\0';
+      if (commands != NULL) commands->count = 0;
+      return NULL;
+    }
+
+    chksum = (chksum ^ c);
+
+    // NULL if not splitting, or past NMEA0183_MAX_COMMANDS
+    if (cmd != NULL) {
+      cmd = LocateSeparator(commands, cmd, ptr);
+    }
   }
 
   // Mark the end of the commands string
-  buffer[index] = '\0';
+  *ptr = '\0';
 
   // skip '*' entry
-  index++;
+  ptr++;
+
+  *checksumOut = chksum;
+
+  //
+  // Convert the checksum binary byte to ASCII hex digits
+  // for comparison. Cheaper than doing atoi with hex conversion
+  // or worse yet scanf()
+  //
+  MenloUtility::UInt8ToHexBuffer(chksum, &checksumAscii[0]);
 
   //
   // We could hit end of string '\0', but checksum digits
   // won't compare.
   //
-  if ((checksumAscii[0] == buffer[index]) &&
-      (checksumAscii[1] == buffer[index+1])) {
+  if ((checksumAscii[0] == ptr[0]) &&
+      (checksumAscii[1] == ptr[1])) {
     // Check sum is valid
     *checksumOKOut = 1;
   }
@@ -470,6 +491,77 @@ MenloNMEA0183::parse(
   return firstCommand;
 }
 
+struct MenloNMEA0183Command*
+MenloNMEA0183::StartCommands(struct MenloNMEA0183Commands* commands, char* ptr)
+{
+  struct MenloNMEA0183Command* cmd = &commands->command[0];
+
+  cmd->name = ptr;
+  cmd->value = NULL;
+  cmd->action = NULL;
+
+  commands->count = 1;
+  commands->remainder = NULL;
+
+  return cmd;
+}
+
+struct MenloNMEA0183Command*
+MenloNMEA0183::LocateSeparator(
+    struct MenloNMEA0183Commands* commands,
+    struct MenloNMEA0183Command* cmd,
+    char* ptr
+    )
+{
+  char c = *ptr;
+
+  if (c == ',') {
+
+    if (commands->count == NMEA0183_MAX_COMMANDS) {
+      commands->remainder = ptr + 1;
+      return NULL;
+    }
+
+    cmd = &commands->command[commands->count++];
+    cmd->name = ptr + 1;
+    cmd->value = NULL;
+    cmd->action = NULL;
+  }
+  else if (c == '=') {
+    if (cmd->value == NULL) {
+      cmd->value = ptr + 1;
+    }
+  }
+  else if (c == ':') {
+    if ((cmd->value != NULL) && (cmd->action == NULL)) {
+      cmd->action = ptr + 1;
+    }
+  }
+
+  return cmd;
+}
+
+void
+MenloNMEA0183::TerminateCommand(struct MenloNMEA0183Commands* commands, int index)
+{
+  struct MenloNMEA0183Command* cmd = &commands->command[index];
+
+  //
+  // The ',' ending this command is just before the start of
+  // the next one. The last command was terminated at the '*'.
+  //
+  if ((index + 1) < commands->count) {
+    commands->command[index + 1].name[-1] = '\0';
+  }
+  else if (commands->remainder != NULL) {
+    commands->remainder[-1] = '\0';
+  }
+
+  if (cmd->value != NULL) {
+    cmd->value[-1] = '\0';
+  }
+}
+
 //
 // Validate basic string format and calculate a checksum
 // for the data payload.
@@ -537,3 +629,189 @@ MenloNMEA0183::checksum(char* str, unsigned char* checksumOut)
 
   return true;
 }
+
+//
+// Streaming decoder
+//
+
+MenloNMEA0183Decoder::MenloNMEA0183Decoder()
+{
+  m_buffer = NULL;
+  m_bufferLength = 0;
+  reset();
+}
+
+void
+MenloNMEA0183Decoder::Initialize(char* buffer, int bufferLength)
+{
+  m_buffer = buffer;
+  m_bufferLength = bufferLength;
+  reset();
+}
+
+void
+MenloNMEA0183Decoder::reset()
+{
+  m_length = 0;
+  m_state = NMEA0183_DECODE_STATE_START;
+  m_checksum = 0;
+  m_checksumDigits = 0;
+  m_prefixLength = 0;
+  m_firstCommand = NULL;
+  m_cmd = NULL;
+  m_commands.count = 0;
+  m_commands.remainder = NULL;
+}
+
+int
+MenloNMEA0183Decoder::decode(char c)
+{
+  char* ptr;
+
+  //
+  // A previous sentence was returned, start a new one
+  //
+  if (m_state == NMEA0183_DECODE_STATE_START) {
+    m_length = 0;
+  }
+
+  if (c == '\n') {
+
+    if (m_state == NMEA0183_DECODE_STATE_CHECKSUM) {
+
+      //
+      // Missing or short checksum digits are allowed through
+      // as a checksum failure so the caller can apply its policy
+      // such as NOCHECKSUM for console input.
+      //
+      m_state = NMEA0183_DECODE_STATE_START;
+      return NMEA0183_DECODE_SENTENCE;
+    }
+
+    //
+    // A '\n' without a sentence is a channel sync. Anything
+    // else is an incomplete sentence which is dropped.
+    //
+    if (m_length == 0) {
+      reset();
+      return NMEA0183_DECODE_SYNC;
+    }
+
+    reset();
+    return NMEA0183_DECODE_MORE;
+  }
+
+  //
+  // Leave room for the '\0'
+  //
+  if (m_length >= (m_bufferLength - 1)) {
+    m_state = NMEA0183_DECODE_STATE_DISCARD;
+  }
+
+  switch (m_state) {
+
+  case NMEA0183_DECODE_STATE_START:
+
+    if (c != '$') {
+      // Noise such as a '\r' before a sync '\n'
+      return NMEA0183_DECODE_MORE;
+    }
+
+    reset();
+
+    m_buffer[m_length++] = c;
+    m_buffer[m_length] = '\0';
+    m_prefixLength = 1;
+    m_state = NMEA0183_DECODE_STATE_PREFIX;
+    break;
+
+  case NMEA0183_DECODE_STATE_PREFIX:
+
+    m_buffer[m_length++] = c;
+    m_buffer[m_length] = '\0';
+
+    m_checksum = (m_checksum ^ c);
+
+    if (c == ',') {
+      m_firstCommand = &m_buffer[m_length];
+      m_cmd = MenloNMEA0183::StartCommands(&m_commands, m_firstCommand);
+      m_state = NMEA0183_DECODE_STATE_COMMANDS;
+      break;
+    }
+
+    if ((c == '*') || (m_prefixLength >= MenloNMEA0183::MaxPrefixSize)) {
+      m_state = NMEA0183_DECODE_STATE_DISCARD;
+      break;
+    }
+
+    m_prefixLength++;
+    break;
+
+  case NMEA0183_DECODE_STATE_COMMANDS:
+
+    ptr = &m_buffer[m_length++];
+
+    if (c == '*') {
+
+      // Mark the end of the commands string
+      *ptr = '\0';
+
+      m_checksumDigits = 0;
+      m_state = NMEA0183_DECODE_STATE_CHECKSUM;
+      break;
+    }
+
+    *ptr = c;
+
+    m_checksum = (m_checksum ^ c);
+
+    if (m_cmd != NULL) {
+      m_cmd = MenloNMEA0183::LocateSeparator(&m_commands, m_cmd, ptr);
+    }
+    break;
+
+  case NMEA0183_DECODE_STATE_CHECKSUM:
+
+    // Keep the trailer in the buffer as the raw sentence
+    m_buffer[m_length++] = c;
+    m_buffer[m_length] = '\0';
+
+    if (m_checksumDigits < 2) {
+      m_checksumAscii[m_checksumDigits++] = c;
+    }
+    break;
+
+  case NMEA0183_DECODE_STATE_DISCARD:
+  default:
+    m_length++;
+    break;
+  }
+
+  return NMEA0183_DECODE_MORE;
+}
+
+int
+MenloNMEA0183Decoder::getChecksumOK()
+{
+  char checksumAscii[2];
+
+  if (m_checksumDigits < 2) {
+    return 0;
+  }
+
+  MenloUtility::UInt8ToHexBuffer(m_checksum, &checksumAscii[0]);
+
+  if ((checksumAscii[0] == m_checksumAscii[0]) &&
+      (checksumAscii[1] == m_checksumAscii[1])) {
+    return 1;
+  }
+
+  return 0;
+}
+
+void
+MenloNMEA0183Decoder::getPrefix(char* prefixOut)
+{
+  memcpy(prefixOut, m_buffer, m_prefixLength);
+  prefixOut[m_prefixLength] = '\0';
+}
@@ -30,6 +30,34 @@
 #ifndef MenloNMEA0183_h
 #define MenloNMEA0183_h
 
+//
+// Maximum number of ',' separated commands located by tokenize().
+//
+// Dweet sentences rarely carry more than a couple of commands. Any
+// commands past this are returned unsplit in remainder.
+//
+#define NMEA0183_MAX_COMMANDS 4
+
+//
+// A command located in place in the sentence buffer.
+//
+// "NAME=ITEM:ACTION"
+//
+// The buffer is not modified for the command so that non-Dweet
+// sentences are passed on intact. Use TerminateCommand() to split it.
+//
+struct MenloNMEA0183Command {
+  char* name;    // start of the command
+  char* value;   // after the first '=', NULL if none
+  char* action;  // after the first ':' in value, NULL if none
+};
+
+struct MenloNMEA0183Commands {
+  int count;
+  char* remainder; // commands past NMEA0183_MAX_COMMANDS, or NULL
+  struct MenloNMEA0183Command command[NMEA0183_MAX_COMMANDS];
+};
+
 class MenloNMEA0183 {
  public:
 
@@ -131,6 +159,51 @@ class MenloNMEA0183 {
       int* checksumOKOut
       );
 
+  //
+  // Single pass version of parse().
+  //
+  // Validates the format, loads the prefix, calculates and compares
+  // the checksum, and locates each command with its '=' and ':'
+  // separators in one scan of the buffer.
+  //
+  // commands may be NULL if only the parse() results are required.
+  //
+  char* tokenize(
+      char* buffer,
+      char* prefixOut,
+      unsigned char* checksumOut,
+      int* checksumOKOut,
+      struct MenloNMEA0183Commands* commands
+      );
+
+  //
+  // '\0' terminate the command at index located by tokenize()
+  // along with its name at the '='.
+  //
+  // The ':' in the value is not terminated since handlers that
+  // do not recognize the item expect the whole value.
+  //
+  static void TerminateCommand(struct MenloNMEA0183Commands* commands, int index);
+
+  //
+  // Start a new command list with the first command at ptr.
+  //
+  static struct MenloNMEA0183Command*
+  StartCommands(struct MenloNMEA0183Commands* commands, char* ptr);
+
+  //
+  // Record the separator at ptr if it is ',', '=', or ':'.
+  //
+  // Returns the command currently being located, or NULL once
+  // NMEA0183_MAX_COMMANDS have been located.
+  //
+  static struct MenloNMEA0183Command*
+  LocateSeparator(
+      struct MenloNMEA0183Commands* commands,
+      struct MenloNMEA0183Command* cmd,
+      char* ptr
+      );
+
   //
   // Calculate checksum for NMEA 0183 string.
   //
@@ -185,4 +258,145 @@ class MenloNMEA0183 {
 
 }; // 12 bytes
 
+//
+// MenloNMEA0183Decoder::encode() results
+//
+#define NMEA0183_DECODE_MORE     0
+#define NMEA0183_DECODE_SENTENCE 1
+#define NMEA0183_DECODE_SYNC     2
+
+//
+// MenloNMEA0183Decoder states
+//
+
+// Waiting for '$'
+#define NMEA0183_DECODE_STATE_START    0
+
+// Receiving the prefix up to the first ','
+#define NMEA0183_DECODE_STATE_PREFIX   1
+
+// Receiving commands up to '*'
+#define NMEA0183_DECODE_STATE_COMMANDS 2
+
+// Receiving the checksum digits and trailer up to '\n'
+#define NMEA0183_DECODE_STATE_CHECKSUM 3
+
+// Discarding a bad or overflowed line up to '\n'
+#define NMEA0183_DECODE_STATE_DISCARD  4
+
+//
+// Streaming NMEA 0183 sentence decoder.
+//
+// Bytes are supplied one at a time as they arrive from a UART
+// or other stream. The checksum, prefix, and command separators
+// are kept up to date with each byte so the sentence is ready to
+// dispatch when its '\n' arrives without being parsed again.
+//
+// Produces the same results as MenloNMEA0183::tokenize() on
+// the received line.
+//
+class MenloNMEA0183Decoder {
+ public:
+
+  MenloNMEA0183Decoder();
+
+  //
+  // buffer receives the sentence. It must be large enough for
+  // the maximum sentence the channel supports plus a '\0'.
+  //
+  void Initialize(char* buffer, int bufferLength);
+
+  //
+  // Discard any partial sentence.
+  //
+  void reset();
+
+  //
+  // Supply the next received byte.
+  //
+  // Returns NMEA0183_DECODE_SENTENCE when a sentence is complete,
+  // NMEA0183_DECODE_SYNC for a line with only a '\n' which
+  // senders use to synchronize the channel, or
+  // NMEA0183_DECODE_MORE otherwise.
+  //
+  // A complete sentence is valid until the next call to encode().
+  //
+  // The common case of a command character is handled inline
+  // since this is called for every byte received.
+  //
+  int encode(char c) {
+
+    if ((m_state == NMEA0183_DECODE_STATE_COMMANDS) &&
+        ((c > '=') || ((c >= '0') && (c <= '9'))) &&
+        (m_length < (m_bufferLength - 1))) {
+
+      m_buffer[m_length++] = c;
+      m_checksum = (m_checksum ^ c);
+      return NMEA0183_DECODE_MORE;
+    }
+
+    return decode(c);
+  }
+
+  //
+  // Results for a complete sentence
+  //
+
+  // Raw sentence as received, with '\0' at the '*'
+  char* getBuffer() {
+    return m_buffer;
+  }
+
+  int getLength() {
+    return m_length;
+  }
+
+  // Start of the commands after the prefix
+  char* getCommandsString() {
+    return m_firstCommand;
+  }
+
+  struct MenloNMEA0183Commands* getCommands() {
+    return &m_commands;
+  }
+
+  unsigned char getChecksum() {
+    return m_checksum;
+  }
+
+  int getChecksumOK();
+
+  // Copy out the prefix such as "$PDWT"
+  void getPrefix(char* prefixOut);
+
+ private:
+
+  // Handles the state changes and separators for encode()
+  int decode(char c);
+
+  char* m_buffer;
+  int m_bufferLength;
+
+  // Characters received for the current sentence
+  int m_length;
+
+  uint8_t m_state;
+
+  // Running checksum of the characters between '$' and '*'
+  unsigned char m_checksum;
+
+  // Received checksum digits
+  char m_checksumAscii[2];
+  uint8_t m_checksumDigits;
+
+  // Includes '$'
+  uint8_t m_prefixLength;
+
+  char* m_firstCommand;
+
+  struct MenloNMEA0183Command* m_cmd;
+
+  struct MenloNMEA0183Commands m_commands;
+};
+
 #endif // MenloNMEA0183_h
@@ -254,6 +254,38 @@ void ResetWatchdog();
 // Milliseconds timer function
 #define GET_MILLISECONDS() millis()
 
+#elif defined(MENLO_LINUX) // Host native build
+
+//
+// Host native Linux (x86-64) build.
+//
+// This is not a target board, but allows the protocol, parser,
+// and scheduler code to be compiled, benchmarked and profiled
+// at native speed with the standard Linux tools.
+//
+// There is no Arduino library on the host, so MenloPlatformLinux.h
+// supplies the small subset used by the framework: millis(),
+// Stream/Print, Serial, EEPROM and PROGMEM emulation.
+//
+// Built with the CMake project in Arduino/host which
+// defines MENLO_LINUX.
+//
+
+// 64 bit X86 processor
+#define MENLO_X86 1
+
+#define MENLO_BOARD_LINUX 1
+
+#define BIG_MEM 1
+
+// Arduino style runtime emulation
+#include "MenloPlatformLinux.h"
+
+#include "MenloPlatformX86.h"
+
+// Milliseconds timer function
+#define GET_MILLISECONDS() millis()
+
 #endif // SPARK/Particle/Photon/Electron
 
 //
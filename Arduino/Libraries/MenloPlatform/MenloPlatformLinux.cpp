@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2015 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/12/2016
+ *
+ *  Platform support for a host native Linux build.
+ *
+ */
+
+#include "MenloPlatform.h"
+
+#if MENLO_BOARD_LINUX
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+//
+// Time support
+//
+
+static uint64_t
+GetMonotonicMicros()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+// Captured at static init so millis() starts near 0 like a reset
+static uint64_t g_startMicros = GetMonotonicMicros();
+
+//
+// These are truncated to 32 bits so that rollover behaves
+// exactly as it does on the microcontrollers.
+//
+unsigned long
+millis()
+{
+    return (uint32_t)((GetMonotonicMicros() - g_startMicros) / 1000ULL);
+}
+
+unsigned long
+micros()
+{
+    return (uint32_t)(GetMonotonicMicros() - g_startMicros);
+}
+
+void
+delay(unsigned long ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+
+    nanosleep(&ts, NULL);
+}
+
+void
+delayMicroseconds(unsigned int us)
+{
+    struct timespec ts;
+
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000L;
+
+    nanosleep(&ts, NULL);
+}
+
+//
+// Pin emulation
+//
+
+static uint8_t g_pinState[256] = { 0 };
+
+void
+pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void
+digitalWrite(uint8_t pin, uint8_t value)
+{
+    g_pinState[pin] = value;
+}
+
+int
+digitalRead(uint8_t pin)
+{
+    return g_pinState[pin];
+}
+
+//
+// EEPROM emulation
+//
+
+// Note: This is zero init
+static uint8_t eeprom_emulation[MENLO_LINUX_EEPROM_SIZE] = { 0 };
+
+uint8_t
+eeprom_read_byte(const uint8_t* index)
+{
+    uintptr_t i = (uintptr_t)index;
+
+    if (i >= MENLO_LINUX_EEPROM_SIZE) return 0xFF;
+
+    return eeprom_emulation[i];
+}
+
+void
+eeprom_write_byte(const uint8_t* index, uint8_t value)
+{
+    uintptr_t i = (uintptr_t)index;
+
+    if (i >= MENLO_LINUX_EEPROM_SIZE) return;
+
+    eeprom_emulation[i] = value;
+}
+
+//
+// Print
+//
+
+size_t
+Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+
+    while (size-- > 0) {
+        n += write(*buffer++);
+    }
+
+    return n;
+}
+
+size_t
+Print::print(const char* str)
+{
+    return write(str);
+}
+
+size_t
+Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t
+Print::print(int n, int base)
+{
+    return print((long)n, base);
+}
+
+size_t
+Print::print(unsigned int n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t
+Print::print(long n, int base)
+{
+    char buf[24];
+
+    if (base == HEX) {
+        snprintf(buf, sizeof(buf), "%lX", (unsigned long)n);
+    }
+    else {
+        snprintf(buf, sizeof(buf), "%ld", n);
+    }
+
+    return write(buf);
+}
+
+size_t
+Print::print(unsigned long n, int base)
+{
+    char buf[24];
+
+    if (base == HEX) {
+        snprintf(buf, sizeof(buf), "%lX", n);
+    }
+    else {
+        snprintf(buf, sizeof(buf), "%lu", n);
+    }
+
+    return write(buf);
+}
+
+size_t
+Print::println()
+{
+    return write("\r\n");
+}
+
+size_t
+Print::println(const char* str)
+{
+    size_t n = print(str);
+    return n + println();
+}
+
+size_t
+Print::println(int n, int base)
+{
+    size_t count = print(n, base);
+    return count + println();
+}
+
+size_t
+Print::println(unsigned long n, int base)
+{
+    size_t count = print(n, base);
+    return count + println();
+}
+
+//
+// Serial on stdin/stdout
+//
+
+MenloHostSerial Serial;
+
+MenloHostSerial::MenloHostSerial()
+{
+    m_peekChar = -1;
+}
+
+int
+MenloHostSerial::available()
+{
+    int count = 0;
+
+    if (ioctl(STDIN_FILENO, FIONREAD, &count) != 0) {
+        count = 0;
+    }
+
+    if (m_peekChar != -1) {
+        count++;
+    }
+
+    return count;
+}
+
+int
+MenloHostSerial::read()
+{
+    int c;
+    uint8_t b;
+
+    if (m_peekChar != -1) {
+        c = m_peekChar;
+        m_peekChar = -1;
+        return c;
+    }
+
+    if (available() == 0) {
+        return -1;
+    }
+
+    if (::read(STDIN_FILENO, &b, 1) != 1) {
+        return -1;
+    }
+
+    return b;
+}
+
+int
+MenloHostSerial::peek()
+{
+    if (m_peekChar == -1) {
+        m_peekChar = read();
+    }
+
+    return m_peekChar;
+}
+
+size_t
+MenloHostSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t
+MenloHostSerial::write(const uint8_t* buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void
+MenloHostSerial::flush()
+{
+    fflush(stdout);
+}
+
+//
+// Memory backed Stream
+//
+
+MenloHostStream::MenloHostStream()
+{
+    m_input = NULL;
+    m_inputSize = 0;
+    m_inputIndex = 0;
+
+    m_output = NULL;
+    m_outputSize = 0;
+    m_outputCount = 0;
+}
+
+void
+MenloHostStream::SetInput(const uint8_t* buffer, size_t size)
+{
+    m_input = buffer;
+    m_inputSize = size;
+    m_inputIndex = 0;
+}
+
+void
+MenloHostStream::SetOutput(uint8_t* buffer, size_t size)
+{
+    m_output = buffer;
+    m_outputSize = size;
+    m_outputCount = 0;
+}
+
+int
+MenloHostStream::available()
+{
+    return (int)(m_inputSize - m_inputIndex);
+}
+
+int
+MenloHostStream::read()
+{
+    if (m_inputIndex >= m_inputSize) return -1;
+
+    return m_input[m_inputIndex++];
+}
+
+int
+MenloHostStream::peek()
+{
+    if (m_inputIndex >= m_inputSize) return -1;
+
+    return m_input[m_inputIndex];
+}
+
+size_t
+MenloHostStream::write(uint8_t c)
+{
+    if ((m_output != NULL) && (m_outputCount < m_outputSize)) {
+        m_output[m_outputCount] = c;
+    }
+
+    m_outputCount++;
+
+    return 1;
+}
+
+size_t
+MenloHostStream::write(const uint8_t* buffer, size_t size)
+{
+    size_t toCopy;
+
+    if ((m_output != NULL) && (m_outputCount < m_outputSize)) {
+
+        toCopy = m_outputSize - m_outputCount;
+        if (toCopy > size) {
+            toCopy = size;
+        }
+
+        memcpy(&m_output[m_outputCount], buffer, toCopy);
+    }
+
+    m_outputCount += size;
+
+    return size;
+}
+
+#endif // MENLO_BOARD_LINUX
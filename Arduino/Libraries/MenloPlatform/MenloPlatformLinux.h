@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2015 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/12/2016
+ *
+ *  Platform support for a host native Linux build.
+ *
+ */
+
+#ifndef MenloPlatformLinux_h
+#define MenloPlatformLinux_h
+
+#if MENLO_BOARD_LINUX
+
+//
+// There is no Arduino.h on the host, so the basic types and
+// headers it normally brings in are supplied here.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+//
+// Time support
+//
+// millis() and micros() start at 0 at first use just as they
+// do at reset on the microcontrollers.
+//
+
+unsigned long millis();
+
+unsigned long micros();
+
+void delay(unsigned long ms);
+
+void delayMicroseconds(unsigned int us);
+
+//
+// Pin I/O is a no-op on the host. The pin state is
+// remembered so that a test program can read it back.
+//
+void pinMode(uint8_t pin, uint8_t mode);
+
+void digitalWrite(uint8_t pin, uint8_t value);
+
+int digitalRead(uint8_t pin);
+
+//
+// Code space strings
+//
+// The host has a uniform address space so the program space
+// routines map to their regular C library versions.
+//
+
+#define PROGMEM
+
+#define PGM_P const char *
+
+#define PSTR(s) (s)
+
+//
+// As with avr-libc addr may be a pointer or an integer address.
+//
+#define pgm_read_byte(addr)  (*(const uint8_t*)(uintptr_t)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word(addr)  (*(const uint16_t*)(uintptr_t)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(uintptr_t)(addr))
+#define pgm_read_ptr(addr)   (*(void* const*)(uintptr_t)(addr))
+
+#define strlen_P  strlen
+#define strcmp_P  strcmp
+#define strncmp_P strncmp
+#define strcpy_P  strcpy
+#define strncpy_P strncpy
+#define strcat_P  strcat
+#define memcpy_P  memcpy
+
+//
+// EEPROM emulation functions
+//
+// Same 1024 byte layout as the ARM emulation.
+//
+
+#define MENLO_LINUX_EEPROM_SIZE 1024
+
+uint8_t eeprom_read_byte(const uint8_t*);
+void eeprom_write_byte(const uint8_t*, uint8_t);
+
+//
+// Arduino Print.h/Stream.h contracts.
+//
+// Only what the framework uses is provided.
+//
+
+class Print {
+
+public:
+
+    virtual ~Print() {
+    }
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    size_t write(const char* str) {
+        if (str == NULL) return 0;
+        return write((const uint8_t*)str, strlen(str));
+    }
+
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+
+    size_t println();
+    size_t println(const char* str);
+    size_t println(int n, int base = DEC);
+    size_t println(unsigned long n, int base = DEC);
+
+    virtual void flush() {
+    }
+};
+
+class Stream : public Print {
+
+public:
+
+    virtual int available() = 0;
+
+    virtual int read() = 0;
+
+    virtual int peek() = 0;
+};
+
+//
+// Serial on the host is the process stdin/stdout.
+//
+// Reads do not block, available() reports what is
+// currently queued on stdin.
+//
+class MenloHostSerial : public Stream {
+
+public:
+
+    MenloHostSerial();
+
+    void begin(unsigned long baud) {
+    }
+
+    virtual int available();
+
+    virtual int read();
+
+    virtual int peek();
+
+    virtual size_t write(uint8_t c);
+
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    virtual void flush();
+
+private:
+
+    int m_peekChar;
+};
+
+extern MenloHostSerial Serial;
+
+//
+// Memory backed Stream.
+//
+// Input is supplied by the caller with SetInput() and is
+// consumed by read(). Output is either captured into a caller
+// supplied buffer, or just counted when no buffer is supplied.
+//
+// Used by host programs to drive a DweetSerialChannel, etc.
+// without real I/O in the measurement.
+//
+class MenloHostStream : public Stream {
+
+public:
+
+    MenloHostStream();
+
+    void SetInput(const uint8_t* buffer, size_t size);
+
+    void SetOutput(uint8_t* buffer, size_t size);
+
+    // Output bytes written since last ResetOutput()
+    size_t GetOutputCount() {
+        return m_outputCount;
+    }
+
+    void ResetOutput() {
+        m_outputCount = 0;
+    }
+
+    virtual int available();
+
+    virtual int read();
+
+    virtual int peek();
+
+    virtual size_t write(uint8_t c);
+
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+private:
+
+    const uint8_t* m_input;
+    size_t m_inputSize;
+    size_t m_inputIndex;
+
+    uint8_t* m_output;
+    size_t m_outputSize;
+    size_t m_outputCount;
+};
+
+#endif // MENLO_BOARD_LINUX
+
+#endif // MenloPlatformLinux_h
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/12/2016
+ *
+ *  Platform support for x86 Processors.
+ *
+ */
+
+#include "MenloPlatform.h"
+
+#if MENLO_X86
+
+//
+// The x86 platforms run a full OS which supplies its own
+// watchdog, so these are no-ops.
+//
+
+void EnableWatchdog()
+{
+}
+
+void ResetWatchdog()
+{
+}
+
+char*
+MenloPlatform::GetStringPointerFromStringArray(char** array, int index)
+{
+    // Uniform address space
+    return array[index];
+}
+
+unsigned long
+MenloPlatform::GetMethodPointerFromMethodArray(char** array, int index)
+{
+    //
+    // GCC on x86 uses the same two pointer sized entry method
+    // pointer encoding as ARM. The first is the function address,
+    // the second the this adjustment which is 0 for the non-virtual
+    // methods used in the state tables.
+    //
+    // See MenloPlatformArm.cpp for details.
+    //
+
+    // Multiply index by 2 to skip the adjustment entries
+    return (unsigned long)array[index*2];
+}
+
+#endif // MENLO_X86
@@ -154,6 +154,8 @@ unsigned long
 MenloRadio::Poll()
 {
   int retVal;
+  uint8_t count;
+  unsigned long interval;
   MenloRadioEventArgs eventArgs;
   unsigned long pollInterval = MAX_POLL_TIME;
 
@@ -173,20 +175,40 @@ MenloRadio::Poll()
 
   m_receiveEventSignaled = false;
 
-  // 0 timeout since we only read when data is ready
-  retVal = Read(0);
-  if (retVal > 0) {
-      eventArgs.data = GetReceiveBuffer();
-      eventArgs.dataLength = GetPacketSize();
+  //
+  // Drain the receiver rather than reading one packet per pass.
+  //
+  // Several nodes reporting at once fill the radio's FIFO faster
+  // than the dispatch loop comes back around, and packets
+  // arriving at a full FIFO are lost.
+  //
+  for (count = 0; count < MENLO_RADIO_RECEIVE_DRAIN_MAX; count++) {
+
+      // 0 timeout since we only read when data is ready
+      retVal = Read(0);
+      if (retVal > 0) {
+          eventArgs.data = GetReceiveBuffer();
+          eventArgs.dataLength = GetPacketSize();
+          eventArgs.source = GetReceiveSource();
+
+          // Send event to listeners
+          interval = m_eventList.DispatchEvents(this, &eventArgs);
+          if (interval < pollInterval) {
+              pollInterval = interval;
+          }
+      }
+      else {
+          DBG_PRINT("MenloRadio No data on read!");
+      }
 
-      // Send event to listeners
-      pollInterval = m_eventList.DispatchEvents(this, &eventArgs);
-  }
-  else {
-      DBG_PRINT("MenloRadio No data on read!");
+      // A listener may have unregistered
+      if (!m_eventList.HasListeners() || !ReceiveDataPending()) {
+          return pollInterval;
+      }
   }
 
-  return pollInterval;
+  // Still more, come back on the next pass
+  return 0;
 }
 
 void
@@ -194,9 +216,33 @@ MenloRadio::RegisterReceiveEvent(MenloRadioEventRegistration* callback)
 {
   // Add to event list
   m_eventList.Register(callback);
+
+  // Deliver anything already received while there were no listeners
+  Wakeup();
+
   return;
 }
 
+void
+MenloRadio::EnableReceiveInterrupt()
+{
+  EnableWakeup();
+
+  // Packets may have arrived before the interrupt was attached
+  Wakeup();
+}
+
+//
+// This runs at interrupt time.
+//
+void
+MenloRadio::ReceiveInterrupt()
+{
+  m_radioActivity = true; // Indicate activity to the power timer
+
+  Wakeup();
+}
+
 void
 MenloRadio::UnregisterReceiveEvent(MenloRadioEventRegistration* callback)
 {
@@ -281,6 +281,14 @@ struct MenloRadioLinkControlAttention {
   uint8_t data[26];
 };
 
+//
+// Window negotiates the windowed transport of MenloRadioSerial
+// between two ends that support it.
+//
+// See MenloRadioSerial.h for the format.
+//
+#define RADIO_LINKCONTROL_WINDOW 0x04
+
 //
 // Some common application scenarios define their extended packet
 // types here to avoid conflicts.
@@ -730,6 +738,40 @@ struct MenloRadioSensorConfigurationGeneric {
 // $PDWT,GETCONFIG=RADIOPOWER
 // $PDWT,SETCONFIG=RADIOPOWER:00
 //
+// The command is carried as dweetCode and the parameters
+// carry its value "RADIOPOWER:00" as ASCII, '\0' terminated
+// unless it fills all 28 bytes. There is no prefix, checksum,
+// or hex encoding since the radio link has its own CRC.
+//
+// Commands other than the four below are sent as
+// MENLO_RADIO_DWEET_COMMAND with the whole "NAME=VALUE"
+// in the parameters.
+//
+// Item and values remain ASCII so the receiver dispatches them
+// through the same table driven handlers as any other channel,
+// and the gateway translates replies without knowing the
+// sensor's tables. See DweetRadio and DweetRadioChannel.
+//
+
+#define MENLO_RADIO_DWEET_HEADER_SIZE 4
+#define MENLO_RADIO_DWEET_DATA_SIZE   28
+
+// dweetCode
+#define MENLO_RADIO_DWEET_COMMAND   0
+#define MENLO_RADIO_DWEET_GETCONFIG 1
+#define MENLO_RADIO_DWEET_SETCONFIG 2
+#define MENLO_RADIO_DWEET_GETSTATE  3
+#define MENLO_RADIO_DWEET_SETSTATE  4
+
+//
+// dweetSubsystem
+//
+// All is dispatched to every Dweet handler on the sensor as
+// if the command arrived on a channel. Other values are
+// reserved for routing to a single subsystem.
+//
+#define MENLO_RADIO_DWEET_SUBSYSTEM_ALL 0
+
 struct MenloRadioDweet {
 
   uint8_t  type;           // 0xC7
@@ -757,12 +799,17 @@ struct MenloRadioDweet {
 
 #define MENLO_RADIO_DWEET_REPLY 0xC8
 
+// replyType, _REPLY, _ERROR, _UNSUP
+#define MENLO_RADIO_DWEET_REPLY_OK    0
+#define MENLO_RADIO_DWEET_REPLY_ERROR 1
+#define MENLO_RADIO_DWEET_REPLY_UNSUP 2
+
 struct MenloRadioDweetReply {
 
   uint8_t  type;           // 0xC8
   uint8_t  dweetSubsystem; // target MenloRadio, MenloPower, etc.
   uint8_t  dweetCode;      // SETCONFIG, GETCONFIG, GETSTATE, SETSTATE
-  uint8_t  pad0;
+  uint8_t  replyType;      // MENLO_RADIO_DWEET_REPLY_OK, etc.
 
   //
   // 28 bytes
@@ -778,11 +825,35 @@ struct MenloRadioDweetReply {
   uint32_t parameter6;
 };
 
+//
+// 0xC9, 0xCA - RadioSerial windowed transport
+//
+// Sequenced data and selective acknowledge packets used by
+// MenloRadioSerial once both ends have negotiated it with
+// RADIO_LINKCONTROL_WINDOW.
+//
+// See MenloRadioSerial.h for the format.
+//
+
+#define MENLO_RADIO_SERIAL_WINDOW_DATA 0xC9
+
+#define MENLO_RADIO_SERIAL_WINDOW_ACK  0xCA
+
 //
 // Default Radio Power interval
 //
 #define RADIO_DEFAULT_POWER_INTERVAL (0L) // 0 means always on
 
+//
+// Most packets read and dispatched by one Poll() when draining
+// the receiver. The nRF24L01+ has a 3 entry FIFO, this leaves
+// room for packets arriving while the listeners run.
+//
+// A bound keeps a busy channel from holding off the other
+// objects in the dispatch loop.
+//
+#define MENLO_RADIO_RECEIVE_DRAIN_MAX 8
+
 //
 // MenloRadio raises an Event when a receive packet is available.
 //
@@ -801,7 +872,97 @@ class MenloRadioEventArgs : public MenloEventArgs {
  public:
   uint8_t* data;
   uint8_t  dataLength;
-  // FUTURE: Pointer to receive address structure for multiple client support
+
+  // Sending node as reported by GetReceiveSource(), 0 if unknown
+  uint8_t  source;
+};
+
+//
+// Packets in the receive ring of an interrupt driven radio.
+//
+// Must be a power of 2.
+//
+#ifndef MENLO_RADIO_INTERRUPT_RING_SIZE
+#if MENLO_ATMEGA
+#define MENLO_RADIO_INTERRUPT_RING_SIZE 4
+#else
+#define MENLO_RADIO_INTERRUPT_RING_SIZE 8
+#endif
+#endif
+
+//
+// Packets copied out of the radio by its receive interrupt
+// handler for OnRead() on the dispatch loop.
+//
+// There is a single producer, the interrupt handler, and a single
+// consumer. Each only writes its own index so neither has to
+// disable interrupts. The indexes run freely and wrap at 256.
+//
+// The barrier keeps the compiler from moving the packet copy
+// past the index update.
+//
+#define MENLO_RADIO_RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+class MenloRadioReceiveRing {
+ public:
+
+  MenloRadioReceiveRing() {
+    m_head = 0;
+    m_tail = 0;
+  }
+
+  bool IsEmpty() {
+    return (m_head == m_tail);
+  }
+
+  //
+  // Interrupt handler
+  //
+
+  // Returns NULL if the ring is full
+  uint8_t* GetWriteSlot() {
+    if ((uint8_t)(m_head - m_tail) == MENLO_RADIO_INTERRUPT_RING_SIZE) {
+      return NULL;
+    }
+
+    return &m_packets[m_head & (MENLO_RADIO_INTERRUPT_RING_SIZE - 1)][0];
+  }
+
+  void CommitWrite(uint8_t source) {
+    m_source[m_head & (MENLO_RADIO_INTERRUPT_RING_SIZE - 1)] = source;
+    MENLO_RADIO_RING_BARRIER();
+    m_head++;
+  }
+
+  //
+  // Dispatch loop
+  //
+
+  // Returns NULL if the ring is empty
+  uint8_t* GetReadSlot(uint8_t* source) {
+    if (m_head == m_tail) {
+      return NULL;
+    }
+
+    MENLO_RADIO_RING_BARRIER();
+
+    *source = m_source[m_tail & (MENLO_RADIO_INTERRUPT_RING_SIZE - 1)];
+
+    return &m_packets[m_tail & (MENLO_RADIO_INTERRUPT_RING_SIZE - 1)][0];
+  }
+
+  void CommitRead() {
+    MENLO_RADIO_RING_BARRIER();
+    m_tail++;
+  }
+
+ private:
+
+  uint8_t m_packets[MENLO_RADIO_INTERRUPT_RING_SIZE][MENLO_RADIO_PACKET_SIZE];
+  uint8_t m_source[MENLO_RADIO_INTERRUPT_RING_SIZE];
+
+  volatile uint8_t m_head;
+  volatile uint8_t m_tail;
 };
 
 // Introduce the proper type name. Could be used for additional parameters.
@@ -827,6 +988,14 @@ public:
 
     void UnregisterReceiveEvent(MenloRadioEventRegistration* callback);
 
+    //
+    // Clients of the radio such as MenloRadioSerial register their
+    // timers here rather than each carrying a MenloTimer.
+    //
+    MenloTimer* GetTimer() {
+        return &m_timer;
+    }
+
     //
     // Read data into buffer, wait for up to timeout.
     //
@@ -910,6 +1079,41 @@ public:
     //
     virtual uint8_t GetPacketSize() = 0;
 
+    //
+    // Returns true if the radio sends frames of the length given
+    // to Write() rather than always GetPacketSize(), which saves
+    // air time for short packets.
+    //
+    // A short frame is received zero padded to GetPacketSize().
+    //
+    virtual bool IsVariableLength() {
+        return false;
+    }
+
+    //
+    // Returns whether more packets remain in the receiver after
+    // a Read().
+    //
+    // Poll() uses this to drain the radio's receive FIFO in one
+    // pass so packets arriving back to back from several nodes
+    // are not lost while waiting for the next pass. A radio can
+    // override it with a cheaper check than ReceiveDataReady().
+    //
+    virtual bool ReceiveDataPending() {
+        return ReceiveDataReady();
+    }
+
+    //
+    // Returns the sending node of the packet returned by the
+    // last Read() for radios that can tell them apart.
+    //
+    // This is radio specific such as the receive pipe of the
+    // nRF24L01+. 0 if the radio can not tell.
+    //
+    virtual uint8_t GetReceiveSource() {
+        return 0;
+    }
+
     //
     // On board common buffer routines.
     //
@@ -999,6 +1203,27 @@ public:
 
 protected:
 
+    //
+    // Interrupt driven receive.
+    //
+    // A radio whose interrupt handler copies received packets into
+    // a MenloRadioReceiveRing calls EnableReceiveInterrupt() once
+    // the interrupt is attached. Poll() then only runs after the
+    // handler calls ReceiveInterrupt(), rather than on every pass of
+    // the dispatch loop, so the radio is not polled over SPI and the
+    // processor can sleep until a packet arrives.
+    //
+    // ReceiveDataReady() and OnRead() then work from the ring.
+    //
+    // Note: RFM69::isr0() already copies each packet into
+    // RFM69::DATA with the sender in RFM69::SENDERID. A MenloRadio
+    // for it would queue them here from its interruptHook().
+    //
+    void EnableReceiveInterrupt();
+
+    // Called from the radio's interrupt handler
+    void ReceiveInterrupt();
+
     void ProcessAttentionReceive(uint8_t* buf);
 
     void ProcessAttentionSend();
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/20/2016
+ *  File: MenloRadioReceiveScheduler.cpp
+ *
+ *  Receive queueing for gateways serving many sensor nodes.
+ */
+
+//
+// MenloFramework
+//
+#include <MenloPlatform.h>
+#include <MenloDebug.h>
+
+// This libraries header
+#include <MenloRadioReceiveScheduler.h>
+
+#define DBG_PRINT_ENABLED 0
+
+#if DBG_PRINT_ENABLED
+#define DBG_PRINT(x)         (MenloDebug::Print(F(x)))
+#define DBG_PRINT_NNL(x)     (MenloDebug::PrintNoNewline(F(x)))
+#define DBG_PRINT_INT(x)     (MenloDebug::PrintHex(x))
+#else
+#define DBG_PRINT(x)
+#define DBG_PRINT_NNL(x)
+#define DBG_PRINT_INT(x)
+#endif
+
+MenloRadioReceiveScheduler::MenloRadioReceiveScheduler()
+{
+    m_radio = NULL;
+    m_batchSize = MENLO_RADIO_RECEIVE_SCHEDULER_BATCH;
+
+    m_receiveCount = 0;
+    m_forwardCount = 0;
+    m_dropCount = 0;
+    m_maxQueuedCount = 0;
+
+    Flush();
+
+    for (uint8_t index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+        m_nodes[index].inUse = false;
+        m_nodes[index].dropCount = 0;
+    }
+
+    m_reuseNode = 0;
+}
+
+int
+MenloRadioReceiveScheduler::Initialize(MenloRadio* radio, uint8_t batchSize)
+{
+    // invoke base to initialize MenloDispatchObject
+    MenloDispatchObject::Initialize();
+
+    m_radio = radio;
+
+    if (batchSize == 0) {
+        batchSize = MENLO_RADIO_RECEIVE_SCHEDULER_BATCH;
+    }
+
+    m_batchSize = batchSize;
+
+    m_radioEvent.object = this;
+    m_radioEvent.method = (MenloEventMethod)&MenloRadioReceiveScheduler::RadioEvent;
+
+    // Only polled when packets are queued
+    EnableWakeup();
+
+    return 0;
+}
+
+void
+MenloRadioReceiveScheduler::RegisterReceiveEvent(MenloRadioEventRegistration* callback)
+{
+    //
+    // The radio is not read while nothing would consume the
+    // packets, as with a MenloRadio without listeners.
+    //
+    if (!m_eventList.HasListeners()) {
+        m_radio->RegisterReceiveEvent(&m_radioEvent);
+    }
+
+    m_eventList.Register(callback);
+}
+
+void
+MenloRadioReceiveScheduler::UnregisterReceiveEvent(MenloRadioEventRegistration* callback)
+{
+    m_eventList.Unregister(callback);
+
+    if (!m_eventList.HasListeners()) {
+        m_radio->UnregisterReceiveEvent(&m_radioEvent);
+        Flush();
+    }
+}
+
+void
+MenloRadioReceiveScheduler::Flush()
+{
+    uint8_t index;
+
+    for (index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS; index++) {
+        m_slotNext[index] = index + 1;
+    }
+
+    m_slotNext[MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS - 1] = MENLO_RADIO_RECEIVE_SLOT_NONE;
+    m_freeSlot = 0;
+
+    for (index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+        m_nodes[index].count = 0;
+        m_nodes[index].head = MENLO_RADIO_RECEIVE_SLOT_NONE;
+        m_nodes[index].tail = MENLO_RADIO_RECEIVE_SLOT_NONE;
+    }
+
+    m_nextNode = 0;
+    m_queuedCount = 0;
+}
+
+unsigned int
+MenloRadioReceiveScheduler::GetNodeDropCount(uint8_t source)
+{
+    for (uint8_t index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+        if (m_nodes[index].inUse && (m_nodes[index].source == source)) {
+            return m_nodes[index].dropCount;
+        }
+    }
+
+    return 0;
+}
+
+//
+// Returns the node table entry for source, taking over an
+// unused or idle entry for a new node.
+//
+// Returns NULL if every entry has packets queued.
+//
+MenloRadioReceiveNode*
+MenloRadioReceiveScheduler::FindNode(uint8_t source)
+{
+    uint8_t index;
+    MenloRadioReceiveNode* node;
+    MenloRadioReceiveNode* unused = NULL;
+
+    for (index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+
+        node = &m_nodes[index];
+
+        if (!node->inUse) {
+            if (unused == NULL) {
+                unused = node;
+            }
+        }
+        else if (node->source == source) {
+            return node;
+        }
+    }
+
+    if (unused == NULL) {
+
+        //
+        // Reuse idle entries in turn so a recently seen node
+        // keeps its drop count for longer.
+        //
+        for (index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+
+            node = &m_nodes[m_reuseNode];
+
+            m_reuseNode++;
+            if (m_reuseNode == MENLO_RADIO_RECEIVE_SCHEDULER_NODES) {
+                m_reuseNode = 0;
+            }
+
+            if (node->count == 0) {
+                unused = node;
+                break;
+            }
+        }
+
+        if (unused == NULL) {
+            return NULL;
+        }
+    }
+
+    unused->source = source;
+    unused->inUse = true;
+    unused->dropCount = 0;
+
+    return unused;
+}
+
+//
+// Returns the next node with packets queued in round robin order.
+//
+MenloRadioReceiveNode*
+MenloRadioReceiveScheduler::NextNode()
+{
+    uint8_t index;
+    MenloRadioReceiveNode* node;
+
+    if (m_queuedCount == 0) {
+        return NULL;
+    }
+
+    for (index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+
+        node = &m_nodes[m_nextNode];
+
+        m_nextNode++;
+        if (m_nextNode == MENLO_RADIO_RECEIVE_SCHEDULER_NODES) {
+            m_nextNode = 0;
+        }
+
+        if (node->count != 0) {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+uint8_t
+MenloRadioReceiveScheduler::RemoveHead(MenloRadioReceiveNode* node)
+{
+    uint8_t slot;
+
+    slot = node->head;
+
+    node->head = m_slotNext[slot];
+    node->count--;
+
+    if (node->count == 0) {
+        node->tail = MENLO_RADIO_RECEIVE_SLOT_NONE;
+    }
+
+    m_queuedCount--;
+
+    return slot;
+}
+
+void
+MenloRadioReceiveScheduler::Enqueue(uint8_t source, uint8_t* data, uint8_t length)
+{
+    uint8_t slot;
+    uint8_t index;
+    MenloRadioReceiveNode* node;
+    MenloRadioReceiveNode* victim;
+
+    node = FindNode(source);
+    if (node == NULL) {
+        DBG_PRINT("MenloRadioReceiveScheduler node table full");
+        m_dropCount++;
+        return;
+    }
+
+    slot = m_freeSlot;
+
+    if (slot != MENLO_RADIO_RECEIVE_SLOT_NONE) {
+        m_freeSlot = m_slotNext[slot];
+    }
+    else {
+
+        //
+        // The ring is full, take the slot from the node with the
+        // most packets queued.
+        //
+        victim = NULL;
+
+        for (index = 0; index < MENLO_RADIO_RECEIVE_SCHEDULER_NODES; index++) {
+            if ((victim == NULL) || (m_nodes[index].count > victim->count)) {
+                victim = &m_nodes[index];
+            }
+        }
+
+        //
+        // Another node only gives up a packet if it would still
+        // hold more than this node after this one is queued.
+        //
+        if (victim->count <= (node->count + 1)) {
+            victim = node;
+        }
+
+        m_dropCount++;
+        victim->dropCount++;
+
+        if (victim->count == 0) {
+            // Nothing of its own queued, the new packet is dropped
+            return;
+        }
+
+        DBG_PRINT_NNL("MenloRadioReceiveScheduler drop source ");
+        DBG_PRINT_INT(victim->source);
+
+        slot = RemoveHead(victim);
+    }
+
+    if (length > MENLO_RADIO_PACKET_SIZE) {
+        length = MENLO_RADIO_PACKET_SIZE;
+    }
+
+    memcpy(&m_slots[slot][0], data, length);
+    m_slotLength[slot] = length;
+    m_slotNext[slot] = MENLO_RADIO_RECEIVE_SLOT_NONE;
+
+    if (node->count == 0) {
+        node->head = slot;
+    }
+    else {
+        m_slotNext[node->tail] = slot;
+    }
+
+    node->tail = slot;
+    node->count++;
+
+    m_queuedCount++;
+
+    if (m_queuedCount > m_maxQueuedCount) {
+        m_maxQueuedCount = m_queuedCount;
+    }
+}
+
+//
+// This event occurs for each packet drained from the radio by
+// MenloRadio::Poll().
+//
+unsigned long
+MenloRadioReceiveScheduler::RadioEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs)
+{
+    MenloRadioEventArgs* radioArgs = (MenloRadioEventArgs*)eventArgs;
+
+    m_receiveCount++;
+
+    Enqueue(radioArgs->source, radioArgs->data, radioArgs->dataLength);
+
+    // Forward from our Poll()
+    Wakeup();
+
+    return MAX_POLL_TIME;
+}
+
+// Overridden from MenloDispatchObject
+unsigned long
+MenloRadioReceiveScheduler::Poll()
+{
+    uint8_t slot;
+    uint8_t count;
+    MenloRadioReceiveNode* node;
+    MenloRadioEventArgs eventArgs;
+
+    for (count = 0; count < m_batchSize; count++) {
+
+        //
+        // Forwarding takes longer than receiving a packet, so
+        // end the batch early to let the radio be drained.
+        //
+        if ((count != 0) && m_radio->ReceiveDataPending()) {
+            break;
+        }
+
+        node = NextNode();
+        if (node == NULL) {
+            // Wait for the next RadioEvent
+            return MAX_POLL_TIME;
+        }
+
+        slot = RemoveHead(node);
+
+        eventArgs.data = &m_slots[slot][0];
+        eventArgs.dataLength = m_slotLength[slot];
+        eventArgs.source = node->source;
+
+        m_eventList.DispatchEvents(this, &eventArgs);
+
+        m_forwardCount++;
+
+        // The listeners are done with the packet
+        m_slotNext[slot] = m_freeSlot;
+        m_freeSlot = slot;
+    }
+
+    //
+    // Return 0 so the dispatch loop polls the radio before
+    // the next batch.
+    //
+    if (m_queuedCount != 0) {
+        return 0;
+    }
+
+    return MAX_POLL_TIME;
+}
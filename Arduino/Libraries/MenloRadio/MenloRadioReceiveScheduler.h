@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/20/2016
+ *  File: MenloRadioReceiveScheduler.h
+ *
+ *  Receive queueing for gateways serving many sensor nodes.
+ */
+
+#ifndef MenloRadioReceiveScheduler_h
+#define MenloRadioReceiveScheduler_h
+
+#include "MenloPlatform.h"
+#include "MenloDispatchObject.h"
+#include "MenloRadio.h"
+
+//
+// A gateway forwards each received packet upstream, which takes
+// far longer than the radio takes to receive the next one. When
+// many sensor nodes report at the same time, packets are lost at
+// the radio's FIFO while the gateway is busy forwarding.
+//
+// MenloRadioReceiveScheduler is registered for the radio receive
+// event in place of the forwarding module. MenloRadio::Poll()
+// drains the radio into its receive ring which only copies the
+// packet, and the scheduler then raises the same receive event
+// to its own listeners from its Poll() a batch at a time.
+//
+// Packets are queued per source node as reported by
+// MenloRadio::GetReceiveSource() and forwarded round robin across
+// the nodes, so a node sending in bursts does not hold back the
+// others.
+//
+// When the ring is full the oldest packet of the node with the
+// most queued is dropped. A node is never dropped for a node
+// holding fewer packets than itself. Drops are counted in total
+// and for each node in the node table.
+//
+
+//
+// Packets held in the receive ring.
+//
+#ifndef MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS
+#if MENLO_ATMEGA
+#define MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS 8
+#else
+#define MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS 32
+#endif
+#endif
+
+//
+// Nodes with drop accounting.
+//
+// At most one node per slot has packets queued. Idle entries
+// are reused for new nodes, so the drop count of a node that
+// has been quiet for a while may be lost from the node table
+// though it remains in the total.
+//
+#ifndef MENLO_RADIO_RECEIVE_SCHEDULER_NODES
+#define MENLO_RADIO_RECEIVE_SCHEDULER_NODES MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS
+#endif
+
+//
+// Default packets forwarded for each Poll()
+//
+#define MENLO_RADIO_RECEIVE_SCHEDULER_BATCH 4
+
+// Marks the end of a slot list
+#define MENLO_RADIO_RECEIVE_SLOT_NONE 0xFF
+
+struct MenloRadioReceiveNode {
+    uint8_t source;
+    bool inUse;
+
+    // Packets queued, oldest first
+    uint8_t count;
+    uint8_t head;
+    uint8_t tail;
+
+    unsigned int dropCount;
+};
+
+class MenloRadioReceiveScheduler : public MenloDispatchObject {
+
+public:
+
+    MenloRadioReceiveScheduler();
+
+    //
+    // batchSize is the most packets raised to the listeners for
+    // each Poll(). A batch ends early when the radio has packets
+    // waiting so it is drained again in between.
+    //
+    int Initialize(MenloRadio* radio, uint8_t batchSize);
+
+    //
+    // Listeners receive a MenloRadioEventArgs as from
+    // MenloRadio::RegisterReceiveEvent().
+    //
+    // The scheduler only listens on the radio while it
+    // has listeners.
+    //
+    void RegisterReceiveEvent(MenloRadioEventRegistration* callback);
+
+    void UnregisterReceiveEvent(MenloRadioEventRegistration* callback);
+
+    //
+    // Statistics
+    //
+
+    uint8_t GetQueuedCount() {
+        return m_queuedCount;
+    }
+
+    // Most packets queued at once
+    uint8_t GetMaxQueuedCount() {
+        return m_maxQueuedCount;
+    }
+
+    unsigned long GetReceiveCount() {
+        return m_receiveCount;
+    }
+
+    unsigned long GetForwardCount() {
+        return m_forwardCount;
+    }
+
+    unsigned long GetDropCount() {
+        return m_dropCount;
+    }
+
+    // Returns 0 for a node not in the node table
+    unsigned int GetNodeDropCount(uint8_t source);
+
+    // Overridden from MenloDispatchObject
+    virtual unsigned long Poll();
+
+private:
+
+    MenloRadioReceiveNode* FindNode(uint8_t source);
+
+    MenloRadioReceiveNode* NextNode();
+
+    // Unlink the oldest packet of node returning its slot
+    uint8_t RemoveHead(MenloRadioReceiveNode* node);
+
+    void Enqueue(uint8_t source, uint8_t* data, uint8_t length);
+
+    void Flush();
+
+    MenloRadio* m_radio;
+
+    uint8_t m_batchSize;
+
+    //
+    // Receive ring. Slots are linked into each node's queue
+    // or the free list by m_slotNext.
+    //
+    uint8_t m_slots[MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS][MENLO_RADIO_PACKET_SIZE];
+    uint8_t m_slotLength[MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS];
+    uint8_t m_slotNext[MENLO_RADIO_RECEIVE_SCHEDULER_SLOTS];
+    uint8_t m_freeSlot;
+
+    MenloRadioReceiveNode m_nodes[MENLO_RADIO_RECEIVE_SCHEDULER_NODES];
+
+    // Round robin position for NextNode() and node reuse
+    uint8_t m_nextNode;
+    uint8_t m_reuseNode;
+
+    uint8_t m_queuedCount;
+    uint8_t m_maxQueuedCount;
+
+    unsigned long m_receiveCount;
+    unsigned long m_forwardCount;
+    unsigned long m_dropCount;
+
+    // Listeners for the scheduled receive event
+    MenloEvent m_eventList;
+
+    //
+    // MenloRadioReceiveScheduler is a client of MenloRadio for
+    // receive packets
+    //
+
+    // Event registration
+    MenloRadioEventRegistration m_radioEvent;
+
+    // RadioEvent function
+    unsigned long RadioEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs);
+};
+
+#endif // MenloRadioReceiveScheduler_h
@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/12/2016
+ *  File: MenloRadioLoopback.cpp
+ *
+ *  Software loopback radio implementing MenloRadio.
+ */
+
+//
+// MenloFramework
+//
+#include <MenloPlatform.h>
+#include <MenloDebug.h>
+
+// This libraries header
+#include <MenloRadioLoopback.h>
+
+MenloRadioLoopback::MenloRadioLoopback()
+{
+    m_peer = NULL;
+
+    m_queueDepth = MENLO_RADIO_LOOPBACK_QUEUE_SIZE;
+    m_queueHead = 0;
+    m_queueTail = 0;
+    m_queueCount = 0;
+
+    m_receiveSource = 0;
+    m_sourceAddress = 0;
+
+    m_receiveRing = NULL;
+
+    m_lossRate = 0;
+    m_randomState = 1;
+
+    m_airTime = 0;
+    m_acknowledgeTime = 0;
+    m_retries = 0;
+    m_variableLength = false;
+
+    m_transmitCount = 0;
+    m_transmitBytes = 0;
+    m_receiveCount = 0;
+    m_dropCount = 0;
+    m_overflowCount = 0;
+    m_readyCount = 0;
+}
+
+int
+MenloRadioLoopback::Initialize(MenloRadioLoopback* peer)
+{
+    // Initialize base class
+    MenloRadio::Initialize();
+
+    m_peer = peer;
+
+    // The loopback link is always powered on
+    PowerOn();
+
+    return 0;
+}
+
+void
+MenloRadioLoopback::SetLossRate(uint8_t percent, unsigned long seed)
+{
+    if (percent > 100) {
+        percent = 100;
+    }
+
+    m_lossRate = percent;
+
+    // 0 is a fixed point for the generator below
+    m_randomState = (seed == 0) ? 1 : seed;
+}
+
+void
+MenloRadioLoopback::SetLinkTiming(
+    unsigned long airTime,
+    unsigned long acknowledgeTime,
+    uint8_t retries
+    )
+{
+    m_airTime = airTime;
+    m_acknowledgeTime = acknowledgeTime;
+    m_retries = retries;
+}
+
+void
+MenloRadioLoopback::SetReceiveQueueDepth(uint8_t depth)
+{
+    if ((depth == 0) || (depth > MENLO_RADIO_LOOPBACK_QUEUE_SIZE)) {
+        depth = MENLO_RADIO_LOOPBACK_QUEUE_SIZE;
+    }
+
+    m_queueDepth = depth;
+}
+
+void
+MenloRadioLoopback::AttachReceiveInterrupt(MenloRadioReceiveRing* ring)
+{
+    m_receiveRing = ring;
+
+    DrainReceiveQueue();
+
+    EnableReceiveInterrupt();
+}
+
+//
+// As OS_nRF24L01::DrainReceiveFifo() packets stay in the receive
+// queue while the ring is full.
+//
+void
+MenloRadioLoopback::DrainReceiveQueue()
+{
+    uint8_t* slot;
+
+    while (m_queueCount != 0) {
+
+        slot = m_receiveRing->GetWriteSlot();
+        if (slot == NULL) {
+            break;
+        }
+
+        memcpy(slot, &m_queue[m_queueTail][0], MENLO_RADIO_PACKET_SIZE);
+
+        m_receiveRing->CommitWrite(m_queueSource[m_queueTail]);
+
+        m_queueTail = (m_queueTail + 1) % MENLO_RADIO_LOOPBACK_QUEUE_SIZE;
+        m_queueCount--;
+    }
+
+    ReceiveInterrupt();
+}
+
+//
+// Repeatable pseudo random loss so runs can be compared.
+//
+bool
+MenloRadioLoopback::DropPacket()
+{
+    if (m_lossRate == 0) {
+        return false;
+    }
+
+    // Numerical Recipes LCG, 32 bit
+    m_randomState = (m_randomState * 1664525UL + 1013904223UL) & 0xFFFFFFFFUL;
+
+    if (((m_randomState >> 16) % 100) < m_lossRate) {
+        return true;
+    }
+
+    return false;
+}
+
+bool
+MenloRadioLoopback::QueueReceive(uint8_t* buffer, uint8_t length, uint8_t source)
+{
+    if (m_queueCount >= m_queueDepth) {
+        m_overflowCount++;
+        return false;
+    }
+
+    if (length > MENLO_RADIO_PACKET_SIZE) {
+        length = MENLO_RADIO_PACKET_SIZE;
+    }
+
+    memset(&m_queue[m_queueHead][0], 0, MENLO_RADIO_PACKET_SIZE);
+    memcpy(&m_queue[m_queueHead][0], buffer, length);
+    m_queueSource[m_queueHead] = source;
+
+    m_queueHead = (m_queueHead + 1) % MENLO_RADIO_LOOPBACK_QUEUE_SIZE;
+    m_queueCount++;
+
+    if (m_receiveRing != NULL) {
+        DrainReceiveQueue();
+    }
+
+    return true;
+}
+
+bool
+MenloRadioLoopback::ReceiveDataReady()
+{
+    m_readyCount++;
+
+    if (m_receiveRing != NULL) {
+        return !m_receiveRing->IsEmpty();
+    }
+
+    return (m_queueCount != 0);
+}
+
+bool
+MenloRadioLoopback::TransmitBusy()
+{
+    return false;
+}
+
+uint8_t
+MenloRadioLoopback::GetPacketSize()
+{
+    return MENLO_RADIO_PACKET_SIZE;
+}
+
+bool
+MenloRadioLoopback::IsVariableLength()
+{
+    return m_variableLength;
+}
+
+uint8_t
+MenloRadioLoopback::GetReceiveSource()
+{
+    return m_receiveSource;
+}
+
+uint8_t*
+MenloRadioLoopback::GetReceiveBuffer()
+{
+    return &m_buffer[0];
+}
+
+int
+MenloRadioLoopback::OnRead(unsigned long timeout)
+{
+    uint8_t* slot;
+
+    //
+    // There is no other thread to deliver a packet while
+    // waiting, so timeout is not used.
+    //
+    if (m_receiveRing != NULL) {
+
+        slot = m_receiveRing->GetReadSlot(&m_receiveSource);
+        if (slot == NULL) {
+            return 0;
+        }
+
+        memcpy(&m_buffer[0], slot, MENLO_RADIO_PACKET_SIZE);
+
+        m_receiveRing->CommitRead();
+
+        m_receiveCount++;
+
+        SetActivity();
+
+        // Packets held in the receive queue while the ring was full
+        if (m_queueCount != 0) {
+            DrainReceiveQueue();
+        }
+
+        return MENLO_RADIO_PACKET_SIZE;
+    }
+
+    if (m_queueCount == 0) {
+        return 0;
+    }
+
+    memcpy(&m_buffer[0], &m_queue[m_queueTail][0], MENLO_RADIO_PACKET_SIZE);
+    m_receiveSource = m_queueSource[m_queueTail];
+
+    m_queueTail = (m_queueTail + 1) % MENLO_RADIO_LOOPBACK_QUEUE_SIZE;
+    m_queueCount--;
+
+    m_receiveCount++;
+
+    SetActivity();
+
+    return MENLO_RADIO_PACKET_SIZE;
+}
+
+int
+MenloRadioLoopback::OnWrite(
+    byte* targetAddress,
+    uint8_t* transmitBuffer,
+    uint8_t transmitBufferLength,
+    unsigned long timeout
+    )
+{
+    bool delivered;
+    uint8_t frameLength;
+    unsigned long airTime;
+
+    if (m_peer == NULL) {
+        return 0;
+    }
+
+    // Fixed size radios always send the full packet
+    frameLength = MENLO_RADIO_PACKET_SIZE;
+    airTime = m_airTime;
+
+    if (m_variableLength && (transmitBufferLength < MENLO_RADIO_PACKET_SIZE)) {
+
+        frameLength = transmitBufferLength;
+
+        airTime = (m_airTime * (frameLength + MENLO_RADIO_LOOPBACK_FRAME_OVERHEAD)) /
+            (MENLO_RADIO_PACKET_SIZE + MENLO_RADIO_LOOPBACK_FRAME_OVERHEAD);
+    }
+
+    m_transmitCount++;
+
+    SetActivity();
+
+    for (uint8_t attempt = 0; ; attempt++) {
+
+        m_transmitBytes += frameLength;
+
+        if (airTime != 0) {
+            delayMicroseconds(airTime);
+        }
+
+        if (DropPacket()) {
+            m_dropCount++;
+            delivered = false;
+        }
+        else {
+
+            //
+            // A full receive queue at the peer is a lost packet
+            // just as with a radio whose FIFO is full.
+            //
+            m_peer->QueueReceive(transmitBuffer, transmitBufferLength, m_sourceAddress);
+            delivered = true;
+        }
+
+        // Without acknowledge a lost packet still reports success
+        if (m_acknowledgeTime == 0) {
+            return transmitBufferLength;
+        }
+
+        delayMicroseconds(m_acknowledgeTime);
+
+        // The acknowledge crosses the same lossy link
+        if (delivered) {
+            if (!DropPacket()) {
+                return transmitBufferLength;
+            }
+
+            m_dropCount++;
+        }
+
+        if (attempt == m_retries) {
+            return 0;
+        }
+    }
+}
+
+int
+MenloRadioLoopback::EmptySetting(char* buf, int size, bool isSet)
+{
+    if (!isSet && (size > 0)) {
+        buf[0] = '\0';
+    }
+
+    return 0;
+}
+
+int
+MenloRadioLoopback::Channel(char* buf, int size, bool isSet)
+{
+    return EmptySetting(buf, size, isSet);
+}
+
+int
+MenloRadioLoopback::RxAddr(char* buf, int size, bool isSet)
+{
+    return EmptySetting(buf, size, isSet);
+}
+
+int
+MenloRadioLoopback::TxAddr(char* buf, int size, bool isSet)
+{
+    return EmptySetting(buf, size, isSet);
+}
+
+int
+MenloRadioLoopback::Power(char* buf, int size, bool isSet)
+{
+    return EmptySetting(buf, size, isSet);
+}
+
+int
+MenloRadioLoopback::Attention(char* buf, int size, bool isSet)
+{
+    return EmptySetting(buf, size, isSet);
+}
+
+int
+MenloRadioLoopback::Options(char* buf, int size, bool isSet)
+{
+    return EmptySetting(buf, size, isSet);
+}
+
+void
+MenloRadioLoopback::OnPowerOn()
+{
+}
+
+void
+MenloRadioLoopback::OnPowerOff()
+{
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/12/2016
+ *  File: MenloRadioLoopback.h
+ *
+ *  Software loopback radio implementing MenloRadio.
+ *
+ *  Two instances are connected as peers and packets written
+ *  on one are received on the other. Used by the host native
+ *  build to exercise MenloRadioSerial, DweetRadio, and gateway
+ *  code without radio hardware.
+ */
+
+#ifndef MenloRadioLoopback_h
+#define MenloRadioLoopback_h
+
+#include "MenloPlatform.h"
+#include "MenloRadio.h"
+
+//
+// Number of packets that can be queued at the receiver.
+//
+// Real radios such as the nRF24L01+ have a 3 entry FIFO, but
+// a slightly deeper queue keeps the host programs from dropping
+// back to back writes when they poll less often.
+// See SetReceiveQueueDepth().
+//
+#define MENLO_RADIO_LOOPBACK_QUEUE_SIZE 8
+
+//
+// Preamble, address, control and CRC bytes sent with each
+// frame as on the nRF24L01+.
+//
+#define MENLO_RADIO_LOOPBACK_FRAME_OVERHEAD 9
+
+class MenloRadioLoopback : public MenloRadio {
+
+public:
+
+    MenloRadioLoopback();
+
+    //
+    // peer is the radio that receives packets written to this one.
+    //
+    // Peers are connected in each direction to model a link:
+    //
+    // a.Initialize(&b);
+    // b.Initialize(&a);
+    //
+    int Initialize(MenloRadioLoopback* peer);
+
+    //
+    // Percentage of written packets dropped on the link, 0 - 100.
+    //
+    // A dropped packet still reports a successful write as a lost
+    // packet would on the air.
+    //
+    void SetLossRate(uint8_t percent, unsigned long seed);
+
+    //
+    // Model the air time of packets and the hardware auto acknowledge
+    // of radios such as the nRF24L01+.
+    //
+    // Write() blocks for airTime microseconds while the channel is
+    // busy sending. When acknowledgeTime is not 0 Write() then waits
+    // acknowledgeTime for the acknowledge, resends up to retries
+    // times when the packet or its acknowledge is lost, and returns
+    // 0 if no acknowledge arrived. A lost acknowledge delivers a
+    // duplicate packet as it does on the air.
+    //
+    // The default is no air time and no acknowledge.
+    //
+    void SetLinkTiming(
+        unsigned long airTime,
+        unsigned long acknowledgeTime,
+        uint8_t retries
+        );
+
+    //
+    // Send frames of the length written rather than the full
+    // packet size. The air time of a frame is then in proportion
+    // to its length plus MENLO_RADIO_LOOPBACK_FRAME_OVERHEAD.
+    //
+    void SetVariableLength(bool value) {
+        m_variableLength = value;
+    }
+
+    //
+    // Address reported by the peer's GetReceiveSource() for
+    // packets written by this radio.
+    //
+    // Several nodes may be initialized with the same peer to
+    // model sensors reporting to one gateway.
+    //
+    void SetSourceAddress(uint8_t address) {
+        m_sourceAddress = address;
+    }
+
+    //
+    // Limit the receive queue to depth packets, such as 3 to
+    // model the nRF24L01+ FIFO. At most
+    // MENLO_RADIO_LOOPBACK_QUEUE_SIZE.
+    //
+    void SetReceiveQueueDepth(uint8_t depth);
+
+    //
+    // Model an interrupt driven radio. Each packet arriving in the
+    // receive queue is moved to a MenloRadioReceiveRing at once as
+    // by the radio's interrupt handler, and MenloRadio is then only
+    // polled when woken by it.
+    //
+    // ring is supplied by the caller as for
+    // OS_nRF24L01::AttachReceiveInterrupt().
+    //
+    void AttachReceiveInterrupt(MenloRadioReceiveRing* ring);
+
+    //
+    // Link statistics
+    //
+    unsigned long GetTransmitCount() {
+        return m_transmitCount;
+    }
+
+    unsigned long GetReceiveCount() {
+        return m_receiveCount;
+    }
+
+    // Bytes sent on the air including resends
+    unsigned long GetTransmitBytes() {
+        return m_transmitBytes;
+    }
+
+    unsigned long GetDropCount() {
+        return m_dropCount;
+    }
+
+    unsigned long GetOverflowCount() {
+        return m_overflowCount;
+    }
+
+    // Calls to ReceiveDataReady(), an SPI status read on a radio
+    unsigned long GetReadyCount() {
+        return m_readyCount;
+    }
+
+    //
+    // MenloRadio required methods
+    //
+
+    virtual bool ReceiveDataReady();
+
+    virtual bool TransmitBusy();
+
+    virtual uint8_t GetPacketSize();
+
+    virtual bool IsVariableLength();
+
+    virtual uint8_t GetReceiveSource();
+
+    virtual int OnRead(unsigned long timeout);
+
+    virtual int OnWrite(
+        byte *targetAddress,
+        uint8_t* transmitBuffer,
+        uint8_t transmitBufferLength,
+        unsigned long timeout
+        );
+
+    virtual uint8_t* GetReceiveBuffer();
+
+    //
+    // Radio Settings
+    //
+    // The loopback link has no settings, they are accepted
+    // and return empty values.
+    //
+
+    virtual int Channel(char* buf, int size, bool isSet);
+
+    virtual int RxAddr(char* buf, int size, bool isSet);
+
+    virtual int TxAddr(char* buf, int size, bool isSet);
+
+    virtual int Power(char* buf, int size, bool isSet);
+
+    virtual int Attention(char* buf, int size, bool isSet);
+
+    virtual int Options(char* buf, int size, bool isSet);
+
+protected:
+
+    virtual void OnPowerOn();
+
+    virtual void OnPowerOff();
+
+private:
+
+    // Queue a packet arriving from the peer
+    bool QueueReceive(uint8_t* buffer, uint8_t length, uint8_t source);
+
+    // The receive interrupt handler
+    void DrainReceiveQueue();
+
+    // Decide whether the next written packet is lost
+    bool DropPacket();
+
+    int EmptySetting(char* buf, int size, bool isSet);
+
+    MenloRadioLoopback* m_peer;
+
+    // Receive buffer returned by GetReceiveBuffer()
+    uint8_t m_buffer[MENLO_RADIO_PACKET_SIZE];
+
+    //
+    // Packets received from the peer but not yet read.
+    //
+    uint8_t m_queue[MENLO_RADIO_LOOPBACK_QUEUE_SIZE][MENLO_RADIO_PACKET_SIZE];
+    uint8_t m_queueSource[MENLO_RADIO_LOOPBACK_QUEUE_SIZE];
+    uint8_t m_queueDepth;
+    uint8_t m_queueHead;
+    uint8_t m_queueTail;
+    uint8_t m_queueCount;
+
+    // Source of the packet in m_buffer
+    uint8_t m_receiveSource;
+
+    // NULL unless AttachReceiveInterrupt() was called
+    MenloRadioReceiveRing* m_receiveRing;
+
+    uint8_t m_sourceAddress;
+
+    uint8_t m_lossRate;
+
+    unsigned long m_airTime;
+    unsigned long m_acknowledgeTime;
+    uint8_t m_retries;
+    bool m_variableLength;
+    unsigned long m_randomState;
+
+    unsigned long m_transmitCount;
+    unsigned long m_transmitBytes;
+    unsigned long m_receiveCount;
+    unsigned long m_dropCount;
+    unsigned long m_overflowCount;
+    unsigned long m_readyCount;
+};
+
+#endif // MenloRadioLoopback_h
@@ -93,6 +93,9 @@ MenloRadioSerial::MenloRadioSerial()
   m_inputBufferHead = 0;
   m_inputBufferTail = 0;
   m_inputBufferSize = 0;
+
+  m_windowState = WindowStateOff;
+  m_window = NULL;
 }
 
 int
@@ -111,9 +114,21 @@ MenloRadioSerial::Initialize(
   m_sendTimeout = sendTimeout;
 
   m_radioBufferSize = m_radio->GetPacketSize();
+  m_variableLength = m_radio->IsVariableLength();
 
   m_transmitSize = 0;
 
+  // Output coalescing
+  m_flushThreshold = MENLO_RADIO_SERIAL_DEFAULT_FLUSH_THRESHOLD;
+  m_flushTimeout = MENLO_RADIO_SERIAL_DEFAULT_FLUSH_TIMEOUT;
+  m_lineComplete = false;
+  m_flushRequested = false;
+
+  m_flushEvent.object = (MenloObject*)this;
+  m_flushEvent.method = (MenloEventMethod)&MenloRadioSerial::FlushEvent;
+  m_flushEvent.m_interval = m_flushTimeout;
+  m_flushEvent.m_dueTime = 0L; // indicate not registered
+
   // Serial input buffer configuration
   m_inputBuffer = inputBuffer;
   m_inputBufferHead = 0;
@@ -126,6 +141,16 @@ MenloRadioSerial::Initialize(
   m_inputSequenceToggle = false;
   m_outputSequenceToggle = false;
 
+  //
+  // The toggle protocol is used until EnableWindow()
+  // negotiates the windowed transport.
+  //
+  m_windowState = WindowStateOff;
+  m_window = NULL;
+
+  // Flush and retransmit timers share the radio's timer
+  m_timer = m_radio->GetTimer();
+
   //
   // We don't register for radio receive packets
   // until the receive stream is enabled.
@@ -233,12 +258,41 @@ MenloRadioSerial::ProcessOutput()
     // MenloRadio Poll() loop.
     //
 
+    if (m_windowState == WindowStateActive) {
+
+      //
+      // The application may have read enough to make room
+      // for held packets.
+      //
+      if (m_window->receiveHeld != 0) {
+          ReceiveWindowDrain();
+      }
+
+      //
+      // In order packets are acknowledged every half window as
+      // they arrive, the remainder once a Poll() passes without
+      // new data so the radio is not turned around for every packet.
+      //
+      if ((m_window->ackPending != 0) && !m_window->receiveActivity) {
+          SendWindowAck();
+      }
+
+      m_window->receiveActivity = false;
+
+      // A full window leaves the data queued for the next Poll()
+      if ((m_transmitSize != 0) && OutputReady()) {
+          WindowPushOutput();
+      }
+
+      return MAX_POLL_TIME;
+    }
+
     //
     // Check to see if any outgoing data is still queued
     // in the radio buffer. This must be sent first
     // before we can use the buffer for receive.
     //
-    if (m_transmitSize != 0) {
+    if ((m_transmitSize != 0) && OutputReady()) {
 
       //
       // Output is from write() calls which are buffered. To minimize packets
@@ -247,7 +301,8 @@ MenloRadioSerial::ProcessOutput()
       //
       // A serial transaction which is writing response data will finish
       // writing its data before returning to the Poll() loop. So this is
-      // an indication we can flush now.
+      // an indication we can flush now if it completed a line. A partial
+      // line waits for the flush timer, see OutputReady().
       //
       if (PushOutput() == (-1)) {
 
@@ -289,6 +344,10 @@ MenloRadioSerial::PushOutput()
 {
   int retVal;
 
+  if (m_windowState == WindowStateActive) {
+      return WindowPushOutput();
+  }
+
   if (m_transmitSize == 0) {
       return 0;
   }
@@ -308,7 +367,7 @@ MenloRadioSerial::PushOutput()
       //m_targetAddress,
       NULL,
       m_transmitBuffer,
-      m_radioBufferSize, // Buffer must be the full radio packet
+      FrameLength(m_transmitSize), // Full radio packet unless variable length
       m_sendTimeout
       );
 
@@ -323,6 +382,8 @@ MenloRadioSerial::PushOutput()
 
   m_transmitSize = 0;
 
+  StopFlushTimer();
+
   RDBG_PRINT("radio write success");
 
   // pace the output
@@ -455,6 +516,10 @@ MenloRadioSerial::write(
   MenloRadioSerialData* pk = (MenloRadioSerialData*)m_transmitBuffer; 
   int dataCount;
 
+  if (m_windowState == WindowStateActive) {
+      return WindowWrite(c);
+  }
+
   //
   // If a previous send did not go out for a full buffer
   // attempt to push again. A failure here we don't accept
@@ -464,7 +529,7 @@ MenloRadioSerial::write(
   //
   if (m_transmitSize == m_radioBufferSize) {
     retVal = PushOutput();
-    if (retVal == 0) {
+    if (retVal <= 0) {
       return -1;
     }
   }
@@ -494,7 +559,11 @@ MenloRadioSerial::write(
 
     pk->data[0] = c;
 
+    OutputStarted();
+
     // We queue the data until either a full packet or the next Poll()
+    OutputQueued(c, 1);
+
     return 1;
   }
   
@@ -511,15 +580,12 @@ MenloRadioSerial::write(
   pk->type_and_size &= ~PACKET_SIZE;
   pk->type_and_size |= PACKET_SIZE_MASK(dataCount);
 
-  if (m_transmitSize == m_radioBufferSize) {
-
-    //
-    // Full buffer, attempt to push it out
-    // We don't look at the return value since we accepted the
-    // character in the queue anyway.
-    //
-    PushOutput();
-  }
+  //
+  // A full buffer, or one at the flush threshold is pushed
+  // out now. We don't look at the return value since we
+  // accepted the character in the queue anyway.
+  //
+  OutputQueued(c, dataCount);
 
   return 1;
 }
@@ -551,7 +617,7 @@ MenloRadioSerial::ReceiveDataIndication(uint8_t* buf, uint8_t bufSize)
       //
       // Lower 5 subtypes bits == 0x01 is link control
       //
-      if (PACKET_SUBTYPE_MASK(buf[0] == MENLO_RADIO_LINKCONTROL)) {
+      if (PACKET_SUBTYPE_MASK(buf[0]) == MENLO_RADIO_LINKCONTROL) {
 
           //
           // Link control packet
@@ -565,6 +631,16 @@ MenloRadioSerial::ReceiveDataIndication(uint8_t* buf, uint8_t bufSize)
               //
 	      RDBG_PRINT("Radio sync received");
           }
+
+          if (buf[1] & RADIO_LINKCONTROL_WINDOW) {
+              ReceiveWindowControl(buf);
+          }
+      }
+      else if (buf[0] == MENLO_RADIO_SERIAL_WINDOW_DATA) {
+          ReceiveWindowData(buf);
+      }
+      else if (buf[0] == MENLO_RADIO_SERIAL_WINDOW_ACK) {
+          ReceiveWindowAck(buf);
       }
       else {
           RDBG_PRINT("RS not packet");
@@ -650,3 +726,657 @@ MenloRadioSerial::ReceiveDataIndication(uint8_t* buf, uint8_t bufSize)
     return;
   }
 }
+
+//
+// Output coalescing
+//
+// See MENLO_RADIO_SERIAL_DEFAULT_FLUSH_TIMEOUT in MenloRadioSerial.h.
+//
+
+void
+MenloRadioSerial::SetFlushPolicy(uint8_t threshold, unsigned long flushTimeout)
+{
+  StopFlushTimer();
+
+  m_flushThreshold = threshold;
+  m_flushTimeout = flushTimeout;
+  m_flushEvent.m_interval = flushTimeout;
+
+  // Data already queued goes out on the next Poll()
+  m_flushRequested = true;
+}
+
+void
+MenloRadioSerial::OutputStarted()
+{
+  m_lineComplete = false;
+  m_flushRequested = false;
+
+  if ((m_flushTimeout != 0) && !m_timer->IsTimerRegistered(&m_flushEvent)) {
+      m_timer->RegisterIntervalTimer(&m_flushEvent);
+  }
+}
+
+void
+MenloRadioSerial::OutputQueued(uint8_t c, uint8_t dataCount)
+{
+  // Output after a newline is a partial line again
+  m_lineComplete = (c == '\n');
+
+  if ((m_transmitSize == m_radioBufferSize) || (dataCount >= m_flushThreshold)) {
+      PushOutput();
+  }
+}
+
+void
+MenloRadioSerial::StopFlushTimer()
+{
+  if (m_timer->IsTimerRegistered(&m_flushEvent)) {
+      m_timer->UnregisterIntervalTimer(&m_flushEvent);
+  }
+}
+
+//
+// The partial packet has waited the flush timeout, the next
+// Poll() sends it.
+//
+unsigned long
+MenloRadioSerial::FlushEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs)
+{
+  m_flushRequested = true;
+
+  StopFlushTimer();
+
+  return MAX_POLL_TIME;
+}
+
+//
+// Windowed transport
+//
+// See MenloRadioSerial.h for the protocol.
+//
+
+int
+MenloRadioSerial::EnableWindow(
+    MenloRadioSerialWindow* window,
+    uint8_t* transmitWindow,
+    uint8_t* receiveWindow,
+    uint8_t windowSize,
+    unsigned long retransmitTimeout
+    )
+{
+  if ((window == NULL) || (transmitWindow == NULL) || (receiveWindow == NULL)) {
+      return -1;
+  }
+
+  // Sequence numbers wrap at 256 so the slot is sequence & (windowSize - 1)
+  if ((windowSize < 2) || (windowSize > MENLO_RADIO_SERIAL_WINDOW_MAX) ||
+      ((windowSize & (windowSize - 1)) != 0)) {
+      return -1;
+  }
+
+  //
+  // A held packet is only delivered once all of its data fits in
+  // the input buffer, see ReceiveWindowDrain(). A smaller buffer
+  // would stall the window for good.
+  //
+  if ((m_inputBuffer == NULL) ||
+      ((m_inputBufferSize - 1) < WINDOW_DATA_PACKET_MAX_SIZE)) {
+      return -1;
+  }
+
+  if (m_windowState != WindowStateOff) {
+      return -1;
+  }
+
+  m_window = window;
+
+  m_window->transmitWindow = transmitWindow;
+  m_window->receiveWindow = receiveWindow;
+  m_window->windowMax = windowSize;
+  m_window->windowSize = windowSize;
+
+  m_window->sendBase = 0;
+  m_window->sendNext = 0;
+  m_window->transmitAcked = 0;
+  m_window->transmitResent = 0;
+  m_window->receiveNext = 0;
+  m_window->receiveHeld = 0;
+  m_window->ackPending = 0;
+  m_window->receiveActivity = false;
+  m_window->retransmitCount = 0;
+
+  m_window->retransmitEvent.object = (MenloObject*)this;
+  m_window->retransmitEvent.method = (MenloEventMethod)&MenloRadioSerial::RetransmitEvent;
+  m_window->retransmitEvent.m_interval = retransmitTimeout;
+  m_window->retransmitEvent.m_dueTime = 0L; // indicate not registered
+
+  m_windowState = WindowStateNegotiating;
+  m_window->negotiateRetries = MENLO_RADIO_SERIAL_WINDOW_NEGOTIATE_RETRIES;
+
+  SendWindowControl(RADIO_SERIAL_WINDOW_REQUEST);
+
+  StartRetransmitTimer();
+
+  return 0;
+}
+
+//
+// Switch to the windowed transport.
+//
+// peerWindow is the window size of the other end, peerSequence
+// the next sequence it will send.
+//
+void
+MenloRadioSerial::WindowStart(uint8_t peerWindow, uint8_t peerSequence)
+{
+  //
+  // A partial packet already formatted for the toggle
+  // protocol is sent first.
+  //
+  if (m_transmitSize != 0) {
+      if (PushOutput() == (-1)) {
+          FlushOutput();
+      }
+  }
+
+  m_window->windowSize = (peerWindow < m_window->windowMax) ? peerWindow : m_window->windowMax;
+
+  // Nothing is outstanding with the toggle protocol
+  m_window->sendBase = m_window->sendNext;
+  m_window->transmitAcked = 0;
+  m_window->transmitResent = 0;
+
+  m_window->receiveNext = peerSequence;
+  m_window->receiveHeld = 0;
+  m_window->ackPending = 0;
+  m_window->receiveActivity = false;
+
+  if (m_timer->IsTimerRegistered(&m_window->retransmitEvent)) {
+      m_timer->UnregisterIntervalTimer(&m_window->retransmitEvent);
+  }
+
+  m_windowState = WindowStateActive;
+
+  RDBG_PRINT("RS window active");
+}
+
+void
+MenloRadioSerial::SendWindowControl(uint8_t operation)
+{
+  uint8_t buf[MENLO_RADIO_PACKET_SIZE];
+  MenloRadioSerialLinkControlWindow* pk = (MenloRadioSerialLinkControlWindow*)buf;
+
+  memset(buf, 0, sizeof(buf));
+
+  pk->type = MENLO_RADIO_LINKCONTROL;
+  pk->control = RADIO_LINKCONTROL_WINDOW;
+  pk->operation = operation;
+  pk->windowSize = m_window->windowMax;
+  // Oldest outstanding, so a restarted other end receives it
+  pk->sequence = m_window->sendBase;
+
+  // A lost request or accept is covered by the retransmit timer
+  m_radio->Write(
+      NULL,
+      buf,
+      FrameLength(sizeof(MenloRadioSerialLinkControlWindow) - sizeof(pk->data)),
+      m_sendTimeout
+      );
+}
+
+void
+MenloRadioSerial::ReceiveWindowControl(uint8_t* buf)
+{
+  MenloRadioSerialLinkControlWindow* pk = (MenloRadioSerialLinkControlWindow*)buf;
+
+  //
+  // Without EnableWindow() no reply is sent and the other
+  // end continues with the toggle protocol.
+  //
+  if (m_window == NULL) {
+      return;
+  }
+
+  if ((pk->windowSize < 2) || (pk->windowSize > MENLO_RADIO_SERIAL_WINDOW_MAX) ||
+      ((pk->windowSize & (pk->windowSize - 1)) != 0)) {
+      return;
+  }
+
+  if (pk->operation == RADIO_SERIAL_WINDOW_REQUEST) {
+
+      //
+      // The other end does not send windowed data until it
+      // has an accept, so this is a new start of its transmit
+      // window, or a retry when our accept was lost.
+      //
+      if (m_windowState != WindowStateActive) {
+          WindowStart(pk->windowSize, pk->sequence);
+      }
+      else {
+          m_window->receiveNext = pk->sequence;
+          m_window->receiveHeld = 0;
+          m_window->ackPending = 0;
+      }
+
+      SendWindowControl(RADIO_SERIAL_WINDOW_ACCEPT);
+  }
+  else if (pk->operation == RADIO_SERIAL_WINDOW_ACCEPT) {
+
+      // Accepts for retried requests arrive after the first
+      if (m_windowState == WindowStateNegotiating) {
+          WindowStart(pk->windowSize, pk->sequence);
+      }
+  }
+}
+
+size_t
+MenloRadioSerial::WindowWrite(uint8_t c)
+{
+  MenloRadioSerialWindowData* pk = (MenloRadioSerialWindowData*)m_transmitBuffer;
+
+  //
+  // A full packet waiting on a full window is not
+  // replaced, the caller retries after Poll() has
+  // processed acknowledges.
+  //
+  if (m_transmitSize == m_radioBufferSize) {
+      if (WindowPushOutput() <= 0) {
+          return -1;
+      }
+  }
+
+  if (m_transmitSize == 0) {
+      pk->type = MENLO_RADIO_SERIAL_WINDOW_DATA;
+      pk->size = 0;
+      m_transmitSize = MENLO_RADIO_SERIAL_WINDOW_DATA_OVERHEAD;
+      OutputStarted();
+  }
+
+  pk->data[pk->size] = c;
+  pk->size++;
+  m_transmitSize++;
+
+  // Accepted either way, a full window sends it later
+  OutputQueued(c, pk->size);
+
+  return 1;
+}
+
+//
+// Assign the queued packet the next sequence and send it.
+//
+// Returns the data count sent, 0 if nothing was queued
+// or the window is full.
+//
+int
+MenloRadioSerial::WindowPushOutput()
+{
+  MenloRadioSerialWindowData* pk = (MenloRadioSerialWindowData*)m_transmitBuffer;
+  uint8_t slot;
+  int retVal;
+
+  if (m_transmitSize == 0) {
+      return 0;
+  }
+
+  if ((uint8_t)(m_window->sendNext - m_window->sendBase) >= m_window->windowSize) {
+      xDBG_PRINT("RS window full");
+      return 0;
+  }
+
+  pk->sequence = m_window->sendNext;
+
+  slot = m_window->sendNext & (m_window->windowSize - 1);
+
+  memcpy(
+      &m_window->transmitWindow[slot * MENLO_RADIO_PACKET_SIZE],
+      m_transmitBuffer,
+      MENLO_RADIO_PACKET_SIZE
+      );
+
+  m_window->transmitAcked &= ~(1UL << slot);
+  m_window->transmitResent &= ~(1UL << slot);
+
+  m_window->sendNext++;
+
+  retVal = pk->size;
+
+  m_transmitSize = 0;
+
+  StopFlushTimer();
+
+  //
+  // A failed radio write is not an error here, the packet
+  // is resent when the retransmit timer finds it unacknowledged.
+  //
+  WindowSend(pk->sequence);
+
+  if (!m_timer->IsTimerRegistered(&m_window->retransmitEvent)) {
+      m_timer->RegisterIntervalTimer(&m_window->retransmitEvent);
+  }
+
+  return retVal;
+}
+
+void
+MenloRadioSerial::WindowSend(uint8_t sequence)
+{
+  uint8_t slot = sequence & (m_window->windowSize - 1);
+  MenloRadioSerialWindowData* pk;
+
+  pk = (MenloRadioSerialWindowData*)&m_window->transmitWindow[slot * MENLO_RADIO_PACKET_SIZE];
+
+  m_radio->Write(
+      NULL,
+      (uint8_t*)pk,
+      FrameLength(MENLO_RADIO_SERIAL_WINDOW_DATA_OVERHEAD + pk->size),
+      m_sendTimeout
+      );
+}
+
+void
+MenloRadioSerial::ReceiveWindowAck(uint8_t* buf)
+{
+  MenloRadioSerialWindowAck* pk = (MenloRadioSerialWindowAck*)buf;
+  uint8_t advance;
+  uint8_t outstanding;
+  uint8_t offset;
+  uint8_t highest;
+  uint8_t slot;
+  uint8_t sequence;
+  uint32_t sack;
+
+  if (m_windowState != WindowStateActive) {
+      return;
+  }
+
+  advance = pk->sequence - m_window->sendBase;
+  outstanding = m_window->sendNext - m_window->sendBase;
+
+  // Acknowledge of packets already acknowledged
+  if (advance > outstanding) {
+      return;
+  }
+
+  m_window->sendBase = pk->sequence;
+  outstanding -= advance;
+
+  if (outstanding == 0) {
+
+      if (m_timer->IsTimerRegistered(&m_window->retransmitEvent)) {
+          m_timer->UnregisterIntervalTimer(&m_window->retransmitEvent);
+      }
+
+      return;
+  }
+
+  // Progress, allow the oldest outstanding packet a full timeout
+  if (advance != 0) {
+      StartRetransmitTimer();
+  }
+
+  sack = (uint32_t)pk->sack[0] |
+         ((uint32_t)pk->sack[1] << 8) |
+         ((uint32_t)pk->sack[2] << 16) |
+         ((uint32_t)pk->sack[3] << 24);
+
+  highest = 0;
+
+  for (offset = 1; offset < outstanding; offset++) {
+      if (sack & (1UL << (offset - 1))) {
+          slot = (m_window->sendBase + offset) & (m_window->windowSize - 1);
+          m_window->transmitAcked |= (1UL << slot);
+          highest = offset;
+      }
+  }
+
+  if ((pk->flags & RADIO_SERIAL_WINDOW_ACK_NAK) == 0) {
+      return;
+  }
+
+  //
+  // Resend the gaps before the last packet the receiver holds.
+  //
+  // Each is resent once until the retransmit timer fires so
+  // repeated acknowledges for the same gap do not resend it again.
+  //
+  for (offset = 0; offset < highest; offset++) {
+
+      sequence = m_window->sendBase + offset;
+      slot = sequence & (m_window->windowSize - 1);
+
+      if ((m_window->transmitAcked | m_window->transmitResent) & (1UL << slot)) {
+          continue;
+      }
+
+      m_window->transmitResent |= (1UL << slot);
+      m_window->retransmitCount++;
+
+      WindowSend(sequence);
+  }
+}
+
+void
+MenloRadioSerial::ReceiveWindowData(uint8_t* buf)
+{
+  MenloRadioSerialWindowData* pk = (MenloRadioSerialWindowData*)buf;
+  uint8_t offset;
+  uint8_t slot;
+
+  if ((m_inputBuffer == NULL) || (m_window == NULL)) {
+      return;
+  }
+
+  if (m_windowState != WindowStateActive) {
+
+      //
+      // The other end has the windowed transport active but we
+      // fell back to the toggle protocol after our requests were
+      // not answered. Negotiate again. Data received before then
+      // is not acknowledged so it is resent.
+      //
+      if (m_windowState == WindowStateOff) {
+          m_windowState = WindowStateNegotiating;
+          m_window->negotiateRetries = MENLO_RADIO_SERIAL_WINDOW_NEGOTIATE_RETRIES;
+          SendWindowControl(RADIO_SERIAL_WINDOW_REQUEST);
+          StartRetransmitTimer();
+      }
+
+      return;
+  }
+
+  if (pk->size > WINDOW_DATA_PACKET_MAX_SIZE) {
+      xDBG_PRINT("RS window bad size");
+      return;
+  }
+
+  m_window->receiveActivity = true;
+
+  offset = pk->sequence - m_window->receiveNext;
+
+  if (offset >= m_window->windowSize) {
+
+      // Already delivered, its acknowledge was lost
+      SendWindowAck();
+      return;
+  }
+
+  slot = pk->sequence & (m_window->windowSize - 1);
+
+  if ((m_window->receiveHeld & (1UL << slot)) == 0) {
+
+      memcpy(
+          &m_window->receiveWindow[slot * MENLO_RADIO_PACKET_SIZE],
+          buf,
+          MENLO_RADIO_PACKET_SIZE
+          );
+
+      m_window->receiveHeld |= (1UL << slot);
+  }
+
+  if (offset != 0) {
+
+      // Out of order, ask for the missing packets now
+      SendWindowAck();
+      return;
+  }
+
+  ReceiveWindowDrain();
+
+  //
+  // A gap remaining after the in order packets is reported
+  // right away, otherwise acknowledges wait for Poll() or
+  // half a window.
+  //
+  if ((m_window->receiveHeld != 0) || (m_window->ackPending >= (m_window->windowSize >> 1))) {
+      SendWindowAck();
+  }
+}
+
+//
+// Deliver held packets in sequence order to the serial input buffer.
+//
+// A packet that does not fit in the input buffer is held
+// unacknowledged until the application reads, so the sender
+// stalls rather than the input buffer overflowing.
+//
+bool
+MenloRadioSerial::ReceiveWindowDrain()
+{
+  MenloRadioSerialWindowData* pk;
+  uint8_t slot;
+  int space;
+  bool delivered = false;
+
+  for (;;) {
+
+      slot = m_window->receiveNext & (m_window->windowSize - 1);
+
+      if ((m_window->receiveHeld & (1UL << slot)) == 0) {
+          break;
+      }
+
+      pk = (MenloRadioSerialWindowData*)&m_window->receiveWindow[slot * MENLO_RADIO_PACKET_SIZE];
+
+      space = m_inputBufferSize - 1 - available();
+
+      if (pk->size > space) {
+          xDBG_PRINT("RS window input full");
+          break;
+      }
+
+      CopyToInputBuffer(&pk->data[0], pk->size);
+
+      m_window->receiveHeld &= ~(1UL << slot);
+      m_window->receiveNext++;
+      m_window->ackPending++;
+
+      delivered = true;
+  }
+
+  return delivered;
+}
+
+void
+MenloRadioSerial::SendWindowAck()
+{
+  uint8_t buf[MENLO_RADIO_PACKET_SIZE];
+  MenloRadioSerialWindowAck* pk = (MenloRadioSerialWindowAck*)buf;
+  uint32_t sack = 0;
+  uint8_t offset;
+  uint8_t slot;
+
+  for (offset = 1; offset < m_window->windowSize; offset++) {
+      slot = (m_window->receiveNext + offset) & (m_window->windowSize - 1);
+      if (m_window->receiveHeld & (1UL << slot)) {
+          sack |= (1UL << (offset - 1));
+      }
+  }
+
+  memset(buf, 0, sizeof(buf));
+
+  pk->type = MENLO_RADIO_SERIAL_WINDOW_ACK;
+  pk->flags = (sack != 0) ? RADIO_SERIAL_WINDOW_ACK_NAK : 0;
+  pk->sequence = m_window->receiveNext;
+  pk->sack[0] = (uint8_t)sack;
+  pk->sack[1] = (uint8_t)(sack >> 8);
+  pk->sack[2] = (uint8_t)(sack >> 16);
+  pk->sack[3] = (uint8_t)(sack >> 24);
+
+  m_window->ackPending = 0;
+
+  // A lost acknowledge is covered by the sender's retransmit timer
+  m_radio->Write(
+      NULL,
+      buf,
+      FrameLength(sizeof(MenloRadioSerialWindowAck) - sizeof(pk->data)),
+      m_sendTimeout
+      );
+}
+
+//
+// (Re)start the retransmit timer for a full interval.
+//
+void
+MenloRadioSerial::StartRetransmitTimer()
+{
+  if (m_timer->IsTimerRegistered(&m_window->retransmitEvent)) {
+      m_timer->UnregisterIntervalTimer(&m_window->retransmitEvent);
+  }
+
+  m_timer->RegisterIntervalTimer(&m_window->retransmitEvent);
+}
+
+unsigned long
+MenloRadioSerial::RetransmitEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs)
+{
+  uint8_t sequence;
+  uint8_t slot;
+
+  if (m_windowState == WindowStateNegotiating) {
+
+      if (m_window->negotiateRetries == 0) {
+
+          // No answer, the other end only supports the toggle protocol
+          RDBG_PRINT("RS window not supported");
+          m_windowState = WindowStateOff;
+          m_timer->UnregisterIntervalTimer(&m_window->retransmitEvent);
+          return MAX_POLL_TIME;
+      }
+
+      m_window->negotiateRetries--;
+
+      SendWindowControl(RADIO_SERIAL_WINDOW_REQUEST);
+
+      return MAX_POLL_TIME;
+  }
+
+  if ((m_windowState != WindowStateActive) || (m_window->sendBase == m_window->sendNext)) {
+      m_timer->UnregisterIntervalTimer(&m_window->retransmitEvent);
+      return MAX_POLL_TIME;
+  }
+
+  //
+  // Resend everything outstanding that has not been selectively
+  // acknowledged. The timer remains registered until the window
+  // is acknowledged.
+  //
+  m_window->transmitResent = 0;
+
+  for (sequence = m_window->sendBase; sequence != m_window->sendNext; sequence++) {
+
+      slot = sequence & (m_window->windowSize - 1);
+
+      if (m_window->transmitAcked & (1UL << slot)) {
+          continue;
+      }
+
+      m_window->transmitResent |= (1UL << slot);
+      m_window->retransmitCount++;
+
+      WindowSend(sequence);
+  }
+
+  return MAX_POLL_TIME;
+}
@@ -36,9 +36,27 @@
 
 #include "MenloPlatform.h"
 #include "MenloRadio.h"
+#include "MenloTimer.h"
 
 #define MENLO_RADIO_SERIAL_OUTPUT_PACE (0) // 0
 
+//
+// Output coalescing
+//
+// Full packets are sent as they fill. By default every partial
+// packet is sent at the next Poll().
+//
+// An application that builds its output across several Poll()
+// passes can set a flush timeout with SetFlushPolicy(). A partial
+// packet ending a line, such as a Dweet reply sentence, is still
+// sent at the next Poll(), but a partial line waits for more output
+// up to the flush timeout after its first byte was queued.
+//
+#define MENLO_RADIO_SERIAL_DEFAULT_FLUSH_TIMEOUT 0 // milliseconds
+
+// Data bytes at which a partial packet is sent right away
+#define MENLO_RADIO_SERIAL_DEFAULT_FLUSH_THRESHOLD MENLO_RADIO_PACKET_SIZE
+
 //
 // MenloRadio.h defines the basic packet type
 // and type space allocations.
@@ -141,6 +159,141 @@ struct MenloRadioSerialDataLineStatus {
 #define RADIO_SERIAL_CTS 0x02
 #define RADIO_SERIAL_RTS 0x04
 
+//
+// Windowed transport
+//
+// The toggle protocol above allows a single packet in flight and
+// relies on the radio hardware for retransmission, so throughput is
+// one packet per radio round trip and a packet lost after the
+// hardware retries is lost from the byte stream.
+//
+// When both ends call EnableWindow() they negotiate a sliding window
+// with RADIO_LINKCONTROL_WINDOW and then send data as
+// MENLO_RADIO_SERIAL_WINDOW_DATA packets with an 8 bit sequence
+// number. Up to the window size of packets may be in flight. The
+// receiver holds out of order packets and returns
+// MENLO_RADIO_SERIAL_WINDOW_ACK with the next in order sequence it
+// expects and a bitmap of the later packets it holds. A gap sets the
+// NAK flag and the sender resends the missing packets right away,
+// the retransmit timer covers a lost acknowledge or a lost last
+// packet.
+//
+// A packet is only acknowledged once it fits in the serial input
+// buffer, so a slow reader stalls the sender rather than dropping
+// data.
+//
+// If the other end does not answer the negotiation the toggle
+// protocol continues to be used.
+//
+// The windowed transport provides its own acknowledge so it is
+// intended for radios with hardware auto acknowledge turned off.
+//
+
+//
+// Window sizes are a power of 2 up to the selective acknowledge
+// bitmap width.
+//
+#define MENLO_RADIO_SERIAL_WINDOW_MAX 32
+
+#define MENLO_RADIO_SERIAL_DEFAULT_WINDOW 8
+
+#define MENLO_RADIO_SERIAL_DEFAULT_RETRANSMIT_TIMEOUT 50
+
+// Negotiation requests sent before falling back to the toggle protocol
+#define MENLO_RADIO_SERIAL_WINDOW_NEGOTIATE_RETRIES 3
+
+//
+// Sent as a MenloRadioLinkControl with control == RADIO_LINKCONTROL_WINDOW.
+//
+// sequence is the oldest sequence the sender has not had
+// acknowledged so the receiving end can start its receive
+// window there.
+//
+struct MenloRadioSerialLinkControlWindow {
+  uint8_t type;       // MENLO_RADIO_LINKCONTROL
+  uint8_t control;    // RADIO_LINKCONTROL_WINDOW
+  uint8_t operation;  // RADIO_SERIAL_WINDOW_REQUEST, RADIO_SERIAL_WINDOW_ACCEPT
+  uint8_t windowSize;
+  uint8_t sequence;
+  uint8_t data[27];
+};
+
+#define RADIO_SERIAL_WINDOW_REQUEST 0x01
+#define RADIO_SERIAL_WINDOW_ACCEPT  0x02
+
+#define MENLO_RADIO_SERIAL_WINDOW_DATA_OVERHEAD 3
+
+#define WINDOW_DATA_PACKET_MAX_SIZE 29
+
+struct MenloRadioSerialWindowData {
+  uint8_t type;       // MENLO_RADIO_SERIAL_WINDOW_DATA
+  uint8_t sequence;
+  uint8_t size;
+  uint8_t data[29];
+};
+
+//
+// sequence is the next in order packet expected, all before it
+// have been received.
+//
+// Bit n of sack (sack[0] bit 0 first) set indicates
+// sequence + 1 + n has been received.
+//
+struct MenloRadioSerialWindowAck {
+  uint8_t type;       // MENLO_RADIO_SERIAL_WINDOW_ACK
+  uint8_t flags;
+  uint8_t sequence;
+  uint8_t sack[4];
+  uint8_t data[25];
+};
+
+// The receiver has a gap, resend the missing packets now
+#define RADIO_SERIAL_WINDOW_ACK_NAK 0x01
+
+//
+// Windowed transport state.
+//
+// Supplied by the caller to EnableWindow() so a MenloRadioSerial
+// using the toggle protocol does not carry it. The contents are
+// private to MenloRadioSerial.
+//
+struct MenloRadioSerialWindow {
+
+  // Negotiated window, windowMax until then
+  uint8_t windowSize;
+  uint8_t windowMax;
+
+  uint8_t negotiateRetries;
+
+  // windowSize packets each, supplied by caller
+  uint8_t* transmitWindow;
+  uint8_t* receiveWindow;
+
+  //
+  // Oldest unacknowledged and next sequence to send.
+  //
+  // Bits are by window slot, sequence & (windowSize - 1).
+  //
+  uint8_t sendBase;
+  uint8_t sendNext;
+  uint32_t transmitAcked;
+  uint32_t transmitResent;
+
+  // Next in order sequence and the out of order packets held
+  uint8_t receiveNext;
+  uint32_t receiveHeld;
+
+  // In order packets received since the last acknowledge
+  uint8_t ackPending;
+
+  // Windowed data arrived since the last Poll()
+  bool receiveActivity;
+
+  unsigned long retransmitCount;
+
+  MenloTimerEventRegistration retransmitEvent;
+};
+
 //
 // This is a sensor defined packet
 //
@@ -263,6 +416,66 @@ public:
       m_inputBufferOverflow = false;
   }
 
+  //
+  // Set the output coalescing policy.
+  //
+  // threshold is the data byte count at which a partial packet is
+  // sent right away, MENLO_RADIO_PACKET_SIZE for only full packets.
+  //
+  // flushTimeout is in milliseconds, 0 sends every partial packet
+  // at the next Poll(). See MENLO_RADIO_SERIAL_DEFAULT_FLUSH_TIMEOUT.
+  //
+  void SetFlushPolicy(uint8_t threshold, unsigned long flushTimeout);
+
+  //
+  // Request the windowed transport.
+  //
+  // window, transmitWindow and receiveWindow are supplied by the
+  // caller and remain in use by MenloRadioSerial. transmitWindow and
+  // receiveWindow must each hold windowSize * MENLO_RADIO_PACKET_SIZE
+  // bytes.
+  // windowSize is a power of 2 from 2 to MENLO_RADIO_SERIAL_WINDOW_MAX.
+  // The window used is the smaller of the two ends.
+  //
+  // retransmitTimeout is in milliseconds and should cover the time
+  // to send a full window and receive its acknowledge.
+  //
+  // EnableReceive(true) must be called since acknowledges arrive
+  // as receive packets.
+  //
+  // The inputBuffer given to Initialize() must hold more than
+  // WINDOW_DATA_PACKET_MAX_SIZE bytes.
+  //
+  // Returns 0 if the negotiation was started, -1 on an invalid
+  // parameter or input buffer.
+  //
+  int EnableWindow(
+      MenloRadioSerialWindow* window,
+      uint8_t* transmitWindow,
+      uint8_t* receiveWindow,
+      uint8_t windowSize,
+      unsigned long retransmitTimeout
+      );
+
+  // True once negotiated, false for the toggle protocol
+  bool IsWindowActive() {
+    return (m_windowState == WindowStateActive);
+  }
+
+  //
+  // Packets written by the application not yet acknowledged
+  // by the other end. Always 0 for the toggle protocol.
+  //
+  uint8_t GetWindowOutstanding() {
+    if (m_window == NULL) return 0;
+    return (uint8_t)(m_window->sendNext - m_window->sendBase);
+  }
+
+  unsigned long GetRetransmitCount() {
+    if (m_window == NULL) return 0;
+    return m_window->retransmitCount;
+  }
+
  protected:
 
   //
@@ -293,6 +506,8 @@ public:
   //
   void FlushOutput() {
     m_transmitSize = 0;
+    m_flushRequested = false;
+    StopFlushTimer();
   }
 
   //
@@ -308,6 +523,90 @@ public:
   // Process output packets. Invoked from the PollEvent.
   unsigned long ProcessOutput();
 
+  //
+  // Output coalescing
+  //
+
+  // A new packet has been started in m_transmitBuffer
+  void OutputStarted();
+
+  // c has been added and the packet holds dataCount bytes
+  void OutputQueued(uint8_t c, uint8_t dataCount);
+
+  // Whether Poll() should send the partial packet
+  bool OutputReady() {
+    return (m_flushTimeout == 0) || m_lineComplete || m_flushRequested ||
+           (m_transmitSize == m_radioBufferSize);
+  }
+
+  void StopFlushTimer();
+
+  unsigned long FlushEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs);
+
+  uint8_t m_flushThreshold;
+  unsigned long m_flushTimeout;
+
+  // The partial packet ends with a newline
+  bool m_lineComplete;
+
+  // The flush timer expired for the partial packet
+  bool m_flushRequested;
+
+  MenloTimerEventRegistration m_flushEvent;
+
+  //
+  // Radios that send short frames are given the valid
+  // length rather than the full packet size.
+  //
+  bool m_variableLength;
+
+  uint8_t FrameLength(uint8_t length) {
+    return m_variableLength ? length : m_radioBufferSize;
+  }
+
+  //
+  // Windowed transport
+  //
+
+  size_t WindowWrite(uint8_t c);
+
+  int WindowPushOutput();
+
+  void WindowSend(uint8_t sequence);
+
+  void WindowStart(uint8_t peerWindow, uint8_t peerSequence);
+
+  void SendWindowControl(uint8_t operation);
+
+  void SendWindowAck();
+
+  void ReceiveWindowControl(uint8_t* buf);
+
+  void ReceiveWindowData(uint8_t* buf);
+
+  void ReceiveWindowAck(uint8_t* buf);
+
+  // Deliver held in order packets to the input buffer
+  bool ReceiveWindowDrain();
+
+  void StartRetransmitTimer();
+
+  unsigned long RetransmitEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs);
+
+  enum WindowState {
+    WindowStateOff,
+    WindowStateNegotiating,
+    WindowStateActive
+  };
+
+  uint8_t m_windowState;
+
+  // Supplied by EnableWindow(), NULL for the toggle protocol only
+  MenloRadioSerialWindow* m_window;
+
+  // The radio's timer, see MenloRadio::GetTimer()
+  MenloTimer* m_timer;
+
   MenloRadio* m_radio;
 
   //
@@ -148,36 +148,34 @@
 
 const char spx_module_name_string[] PROGMEM = "SpxCloud";
 
+//
 // SETCONFIG=SPXSERVER:www.smartpux.com
-extern const char dweet_spx_server_string[] PROGMEM = "SPXSERVER";
-
 // SETCONFIG=SPXURL:/data
-extern const char dweet_spx_url_string[] PROGMEM = "SPXURL";
-
 // SETCONFIG=SPXPORT:80
-extern const char dweet_spx_port_string[] PROGMEM = "SPXPORT";
-
 // SETCONFIG=SPXTOKEN:12345678
-extern const char dweet_spx_token_string[] PROGMEM = "SPXTOKEN";
-
 // SETCONFIG=SPXACCOUNT:12345678
-extern const char dweet_spx_account_string[] PROGMEM = "SPXACCOUNT";
-
 // SETCONFIG=SPXSENSOR:12345678
-extern const char dweet_spx_sensor_string[] PROGMEM = "SPXSENSOR";
-
 // SETCONFIG=SPXOPTIONS:00
-extern const char dweet_spx_options_string[] PROGMEM = "SPXOPTIONS";
+//
+#define SPX_COMMANDS(X) \
+  X(dweet_spx_server_string, "SPXSERVER") \
+  X(dweet_spx_url_string, "SPXURL") \
+  X(dweet_spx_port_string, "SPXPORT") \
+  X(dweet_spx_token_string, "SPXTOKEN") \
+  X(dweet_spx_account_string, "SPXACCOUNT") \
+  X(dweet_spx_sensor_string, "SPXSENSOR") \
+  X(dweet_spx_options_string, "SPXOPTIONS")
+
+SPX_COMMANDS(DWEET_COMMAND_EXTERN_STRING)
 
 const char* const spx_string_table[] PROGMEM =
 {
-  dweet_spx_server_string,
-  dweet_spx_url_string,
-  dweet_spx_port_string,
-  dweet_spx_token_string,
-  dweet_spx_account_string,
-  dweet_spx_sensor_string,
-  dweet_spx_options_string
+  SPX_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t spx_hash_table[] =
+{
+  SPX_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -628,6 +626,7 @@ MenloSmartpuxCloud::Initialize(
 
     parms.ModuleName = (PGM_P)spx_module_name_string;
     parms.stringTable = (PGM_P)spx_string_table;
+    parms.hashTable = spx_hash_table;
     parms.functionTable = (PGM_P)spx_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -1032,6 +1031,7 @@ MenloSmartpuxCloud::ProcessDweetCommands(MenloDweet* dweet, char* name, char* va
 
     parms.ModuleName = (PGM_P)spx_module_name_string;
     parms.stringTable = (PGM_P)spx_string_table;
+    parms.hashTable = spx_hash_table;
     parms.functionTable = (PGM_P)spx_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
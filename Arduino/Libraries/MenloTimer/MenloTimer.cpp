@@ -28,6 +28,7 @@
 #include <MenloPlatform.h>
 #include <MenloDebug.h>
 #include <MenloMemoryMonitor.h>
+#include <MenloDispatchProfile.h>
 #include <MenloTimer.h>
 
 #define DBG_PRINT_ENABLED 0
@@ -78,6 +79,18 @@ MenloTimer::MenloTimer()
 {
   // Default timer interval
   m_interval = TIMER_DEFAULT_INTERVAL;
+
+  // Default is the unordered timer list
+  m_heap = NULL;
+  m_heapSize = 0;
+  m_heapCount = 0;
+
+  //
+  // Poll() returns the time until the next timer is due so
+  // the timer only needs to be polled at its deadline, or
+  // when the set of registered timers changes.
+  //
+  EnableWakeup();
 }
 
 int
@@ -92,6 +105,26 @@ MenloTimer::Initialize()
   return 0;
 }
 
+int
+MenloTimer::InitializeHeap(MenloTimerEventRegistration** heap, uint16_t maxTimers)
+{
+  if ((heap == NULL) || (maxTimers == 0)) {
+      return -1;
+  }
+
+  // Timers already on the list would be lost
+  if ((m_timerList.GetHead() != NULL) || (m_heapCount != 0)) {
+      MenloDebug::Print(F("MenloTimer heap after timers registered"));
+      return -1;
+  }
+
+  m_heap = heap;
+  m_heapSize = maxTimers;
+  m_heapCount = 0;
+
+  return 0;
+}
+
 // Overridden from MenloDispatchObject
 unsigned long
 MenloTimer::DispatchSingleEvent(
@@ -109,6 +142,17 @@ MenloTimer::DispatchSingleEvent(
 // Overridden from MenloDispatchObject
 unsigned long
 MenloTimer::Poll()
+{
+  if (m_heap != NULL) {
+      return PollHeap();
+  }
+  else {
+      return PollList();
+  }
+}
+
+unsigned long
+MenloTimer::PollList()
 {
   MenloTimerEventArgs eventArgs;
   MenloTimerEventRegistration* tmp;
@@ -179,9 +223,13 @@ MenloTimer::Poll()
               tmp->m_dueTime = 1;
           }
 
+          DISPATCH_PROFILE_START(startTime);
+
           // If the timer has expired, execute the events
           newPollTime = DispatchSingleEvent(this, &eventArgs, tmp);
 
+          DISPATCH_PROFILE_END(DISPATCH_PROFILE_TIMER, tmp, startTime);
+
           // Check memory
           MenloMemoryMonitor::CheckMemory(LineNumberBaseTimer + __LINE__);
 
@@ -218,6 +266,185 @@ MenloTimer::Poll()
   return pollInterval;
 }
 
+//
+// Heap ordered Poll.
+//
+// Only the due timers and the head of the heap are visited.
+// Each due timer is rescheduled and sifted down before its
+// handler runs so the heap is consistent if the handler
+// registers or unregisters timers.
+//
+// A timer that has fallen more than an interval behind stays
+// at the head after being rescheduled. The number of dispatches
+// is limited to the number of timers registered on entry so a
+// zero or very short interval can not hold Poll() in a loop. The
+// list mode similarly fires each timer at most once per Poll().
+//
+unsigned long
+MenloTimer::PollHeap()
+{
+  MenloTimerEventArgs eventArgs;
+  MenloTimerEventRegistration* tmp;
+  unsigned long newPollTime;
+  unsigned long difference;
+  unsigned long pollInterval = MAX_POLL_TIME;
+  uint16_t dispatchLimit;
+
+  // read current time
+  unsigned long current_time = GET_MILLISECONDS();
+
+  dispatchLimit = m_heapCount;
+
+  while ((m_heapCount != 0) && (dispatchLimit != 0)) {
+
+      tmp = m_heap[0];
+
+      // Heap head is the earliest due time
+      if ((long)(current_time - tmp->m_dueTime) < 0) {
+          break;
+      }
+
+      dispatchLimit--;
+
+      // Provide the event handler the current time
+      eventArgs.m_currentTime = current_time;
+
+      // Update to the next internal using the entries interval
+      tmp->m_dueTime += tmp->m_interval;
+
+      // See PollList() on the 0 dueTime ambiguity
+      if (tmp->m_dueTime == 0) {
+          tmp->m_dueTime = 1;
+      }
+
+      HeapSiftDown(0);
+
+      DISPATCH_PROFILE_START(startTime);
+
+      newPollTime = DispatchSingleEvent(this, &eventArgs, tmp);
+
+      DISPATCH_PROFILE_END(DISPATCH_PROFILE_TIMER, tmp, startTime);
+
+      // Check memory
+      MenloMemoryMonitor::CheckMemory(LineNumberBaseTimer + __LINE__);
+
+      DISPATCH_PRINT2("MenloTimer::PollHeap DispatchSingleEvent: newPollTime=", newPollTime);
+
+      if (newPollTime < pollInterval) {
+          pollInterval = newPollTime;
+      }
+  }
+
+  // Ensure the pollInterval does not exceed the time till the head is due
+  if (m_heapCount != 0) {
+
+      tmp = m_heap[0];
+
+      if ((long)(current_time - tmp->m_dueTime) >= 0) {
+          difference = 0;
+      }
+      else {
+          difference = tmp->m_dueTime - current_time;
+      }
+
+      if (pollInterval > difference) {
+          pollInterval = difference;
+      }
+  }
+
+  if (pollInterval > m_interval) {
+    pollInterval = m_interval;
+  }
+
+  DISPATCH_PRINT2("MenloTimer::PollHeap return: pollInterval=", pollInterval);
+
+  return pollInterval;
+}
+
+void
+MenloTimer::HeapSiftUp(uint16_t index)
+{
+  MenloTimerEventRegistration* entry = m_heap[index];
+  uint16_t parent;
+
+  while (index != 0) {
+
+      parent = (index - 1) / 2;
+
+      if (!DueBefore(entry, m_heap[parent])) {
+          break;
+      }
+
+      HeapSet(index, m_heap[parent]);
+      index = parent;
+  }
+
+  HeapSet(index, entry);
+}
+
+void
+MenloTimer::HeapSiftDown(uint16_t index)
+{
+  MenloTimerEventRegistration* entry = m_heap[index];
+  uint16_t child;
+
+  for (;;) {
+
+      child = (index * 2) + 1;
+
+      if (child >= m_heapCount) {
+          break;
+      }
+
+      // Select the earlier of the two children
+      if (((child + 1) < m_heapCount) && DueBefore(m_heap[child + 1], m_heap[child])) {
+          child++;
+      }
+
+      if (!DueBefore(m_heap[child], entry)) {
+          break;
+      }
+
+      HeapSet(index, m_heap[child]);
+      index = child;
+  }
+
+  HeapSet(index, entry);
+}
+
+void
+MenloTimer::HeapInsert(MenloTimerEventRegistration* callback)
+{
+  HeapSet(m_heapCount, callback);
+
+  m_heapCount++;
+
+  HeapSiftUp(m_heapCount - 1);
+}
+
+void
+MenloTimer::HeapRemove(MenloTimerEventRegistration* callback)
+{
+  uint16_t index = callback->m_heapIndex;
+
+  m_heapCount--;
+
+  if (index == m_heapCount) {
+      // Was the last entry
+      return;
+  }
+
+  // Move the last entry into the hole and restore order
+  HeapSet(index, m_heap[m_heapCount]);
+
+  if ((index != 0) && DueBefore(m_heap[index], m_heap[(index - 1) / 2])) {
+      HeapSiftUp(index);
+  }
+  else {
+      HeapSiftDown(index);
+  }
+}
+
 void
 MenloTimer::RegisterIntervalTimer(MenloTimerEventRegistration* callback)
 {
@@ -232,6 +459,11 @@ MenloTimer::RegisterIntervalTimer(MenloTimerEventRegistration* callback)
       return;
   }
 
+  if ((m_heap != NULL) && (m_heapCount == m_heapSize)) {
+      MenloDebug::Print(F("MenloTimer heap full"));
+      return;
+  }
+
   // Register the shorter interval
   if (callback->m_interval < m_interval) {
     m_interval = callback->m_interval;
@@ -244,8 +476,21 @@ MenloTimer::RegisterIntervalTimer(MenloTimerEventRegistration* callback)
 
   callback->m_dueTime = GET_MILLISECONDS() + callback->m_interval;
 
-  // Add to event list
-  m_timerList.Register(callback);
+  // See PollList() on the 0 dueTime ambiguity
+  if (callback->m_dueTime == 0) {
+      callback->m_dueTime = 1;
+  }
+
+  if (m_heap != NULL) {
+      HeapInsert(callback);
+  }
+  else {
+      // Add to event list
+      m_timerList.Register(callback);
+  }
+
+  // Poll() calculates the new deadline
+  Wakeup();
 
   return;
 }
@@ -261,8 +506,13 @@ MenloTimer::UnregisterIntervalTimer(MenloTimerEventRegistration* callback)
       return;
   }
 
-  // Unregister from event list
-  m_timerList.Unregister(callback);
+  if (m_heap != NULL) {
+      HeapRemove(callback);
+  }
+  else {
+      // Unregister from event list
+      m_timerList.Unregister(callback);
+  }
 
   // A zero dueTime means not registered on a list
   callback->m_dueTime = 0L;
@@ -278,17 +528,32 @@ MenloTimer::UnregisterIntervalTimer(MenloTimerEventRegistration* callback)
   // the default timer interval is set.
   //
 
-  // Get head of timer list
-  tmp = (MenloTimerEventRegistration*)m_timerList.GetHead();
+  if (m_heap != NULL) {
 
-  while(tmp != NULL) {
+      for (uint16_t index = 0; index < m_heapCount; index++) {
 
-      if (tmp->m_interval < shortestInterval) {
-        shortestInterval = tmp->m_interval;
+          if (m_heap[index]->m_interval < shortestInterval) {
+            shortestInterval = m_heap[index]->m_interval;
+          }
       }
+  }
+  else {
+
+      // Get head of timer list
+      tmp = (MenloTimerEventRegistration*)m_timerList.GetHead();
+
+      while(tmp != NULL) {
 
-      tmp = (MenloTimerEventRegistration*)tmp->GetNext();
+          if (tmp->m_interval < shortestInterval) {
+            shortestInterval = tmp->m_interval;
+          }
+
+          tmp = (MenloTimerEventRegistration*)tmp->GetNext();
+      }
   }
 
   m_interval = shortestInterval;
+
+  // Poll() calculates the new deadline
+  Wakeup();
 }
@@ -46,6 +46,9 @@ class MenloTimerEventRegistration : public MenloEventRegistration {
  public:
   unsigned long m_dueTime;
   unsigned long m_interval;
+
+  // Position in the MenloTimer heap when heap ordered
+  uint16_t m_heapIndex;
 };
 
 //
@@ -73,6 +76,22 @@ class MenloTimer : public MenloDispatchObject {
 
   virtual int Initialize();
 
+  //
+  // Order timers in a binary heap by due time rather than
+  // walking the whole timer list on every Poll().
+  //
+  // Poll() then only visits the timers that are due plus the
+  // head of the heap for the next deadline. This is for builds
+  // that register many timers on a single MenloTimer such as
+  // gateways. The caller supplies the storage which must hold
+  // maxTimers entries.
+  //
+  // Must be called before any timers are registered.
+  //
+  // Returns 0 on success.
+  //
+  int InitializeHeap(MenloTimerEventRegistration** heap, uint16_t maxTimers);
+
   virtual unsigned long Poll();
 
   //
@@ -99,7 +118,41 @@ class MenloTimer : public MenloDispatchObject {
 
  private:
 
+  unsigned long PollList();
+
+  unsigned long PollHeap();
+
+  //
+  // Binary heap support
+  //
+
+  void HeapInsert(MenloTimerEventRegistration* callback);
+
+  void HeapRemove(MenloTimerEventRegistration* callback);
+
+  void HeapSiftUp(uint16_t index);
+
+  void HeapSiftDown(uint16_t index);
+
+  void HeapSet(uint16_t index, MenloTimerEventRegistration* callback) {
+      m_heap[index] = callback;
+      callback->m_heapIndex = index;
+  }
+
+  // Wrap around safe due time comparison
+  static bool DueBefore(
+      MenloTimerEventRegistration* a,
+      MenloTimerEventRegistration* b
+      ) {
+      return ((long)(a->m_dueTime - b->m_dueTime) < 0);
+  }
+
   MenloEvent m_timerList;
+
+  // NULL when timers are kept on m_timerList
+  MenloTimerEventRegistration** m_heap;
+  uint16_t m_heapSize;
+  uint16_t m_heapCount;
 };
 
 #endif // MenloTimer_h
@@ -107,16 +107,24 @@
 
 const char menlotrace_module_name_string[] PROGMEM = "MenloTrace";
 
+//
 // SETCONFIG=TRACEMASK:00000000
-const char menlotrace_setmask_string[] PROGMEM = "TRACESETMASK";
-
 // SETSTATE=TRACECAPTURE:00
-const char menlotrace_capture_string[] PROGMEM = "TRACECAPTURE";
+//
+#define MENLOTRACE_COMMANDS(X) \
+    X(menlotrace_setmask_string, "TRACESETMASK") \
+    X(menlotrace_capture_string, "TRACECAPTURE")
+
+MENLOTRACE_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const menlotrace_string_table[] PROGMEM =
 {
-    menlotrace_setmask_string,
-    menlotrace_capture_string
+    MENLOTRACE_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t menlotrace_hash_table[] =
+{
+    MENLOTRACE_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -214,6 +222,7 @@ MenloTrace::Initialize()
     //
     parms.ModuleName = (PGM_P)menlotrace_module_name_string;
     parms.stringTable = (PGM_P)menlotrace_string_table;
+    parms.hashTable = menlotrace_hash_table;
     parms.functionTable = (PGM_P)menlotrace_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -297,6 +306,7 @@ MenloTrace::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
     //
     parms.ModuleName = (PGM_P)menlotrace_module_name_string;
     parms.stringTable = (PGM_P)menlotrace_string_table;
+    parms.hashTable = menlotrace_hash_table;
     parms.functionTable = (PGM_P)menlotrace_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -74,6 +74,10 @@ Nrf24l::Nrf24l(){
 	channel = 1;
 	payload = 16;
 	spi = NULL;
+	irqMask = 0;
+	interruptSafe = false;
+	irqContext = false;
+	csnInterruptState = 0;
 }
 
 void Nrf24l::transferSync(uint8_t *dataout,uint8_t *datain,uint8_t len){
@@ -304,7 +308,7 @@ uint8_t Nrf24l::getStatus(){
 void Nrf24l::powerUpRx(){
 	PTX = 0;
 	ceLow();
-	configRegister(CONFIG, mirf_CONFIG | ( (1<<PWR_UP) | (1<<PRIM_RX) ) );
+	configRegister(CONFIG, mirf_CONFIG | irqMask | ( (1<<PWR_UP) | (1<<PRIM_RX) ) );
 	ceHi();
 	configRegister(STATUS,(1 << TX_DS) | (1 << MAX_RT)); 
 #if MENLO_ADD_DELAYS
@@ -321,7 +325,7 @@ void Nrf24l::flushRx(){
 
 void Nrf24l::powerUpTx(){
 	PTX = 1;
-	configRegister(CONFIG, mirf_CONFIG | ( (1<<PWR_UP) | (0<<PRIM_RX) ) );
+	configRegister(CONFIG, mirf_CONFIG | irqMask | ( (1<<PWR_UP) | (0<<PRIM_RX) ) );
 }
 
 void Nrf24l::ceHi(){
@@ -343,18 +347,58 @@ void Nrf24l::csnHi(){
 #if MENLO_ADD_DELAYS
         delay(10);
 #endif
+	if (interruptSafe && !irqContext) {
+		restoreInterrupts(csnInterruptState);
+	}
 }
 
 void Nrf24l::csnLow(){
+	if (interruptSafe && !irqContext) {
+		csnInterruptState = saveInterrupts();
+	}
 	digitalWrite(csnPin,LOW);
 #if MENLO_ADD_DELAYS
         delay(10);
 #endif
 }
 
+// MenloPark Innovation LLC 06/20/2016
+uint8_t Nrf24l::saveInterrupts(){
+	uint8_t state;
+#if MENLO_ATMEGA
+	state = SREG;
+	cli();
+#elif MENLO_ARM32
+	uint32_t primask;
+	__asm__ volatile ("mrs %0, primask" : "=r" (primask));
+	__asm__ volatile ("cpsid i" ::: "memory");
+	state = (uint8_t)primask;
+#else
+	// No portable way to read the state, assume enabled
+	state = 0;
+	noInterrupts();
+#endif
+	return state;
+}
+
+void Nrf24l::restoreInterrupts(uint8_t state){
+#if MENLO_ATMEGA
+	SREG = state;
+#elif MENLO_ARM32
+	// PRIMASK set means interrupts were already disabled
+	if ((state & 1) == 0) {
+		__asm__ volatile ("cpsie i" ::: "memory");
+	}
+#else
+	(void)state;
+	interrupts();
+#endif
+}
+// MenloPark Innovation LLC 06/20/2016
+
 void Nrf24l::powerDown(){
 	ceLow();
-	configRegister(CONFIG, mirf_CONFIG );
+	configRegister(CONFIG, mirf_CONFIG | irqMask );
 }
 
 /*
@@ -72,6 +72,16 @@ class Nrf24l {
 		void csnHi();
 		void csnLow();
 
+// MenloPark Innovation LLC 06/20/2016
+		/*
+		 * Disable interrupts returning the prior state for
+		 * restoreInterrupts(), so a caller already running with
+		 * interrupts disabled is left that way.
+		 */
+		uint8_t saveInterrupts();
+		void restoreInterrupts(uint8_t state);
+// MenloPark Innovation LLC 06/20/2016
+
 		void ceHi();
 		void ceLow();
 		void flushRx();
@@ -105,6 +115,29 @@ class Nrf24l {
 
 		uint8_t payload;
 
+// MenloPark Innovation LLC 06/20/2016
+		/*
+		 * Or'd into CONFIG, MASK_TX_DS | MASK_MAX_RT leaves the
+		 * IRQ pin for receive only.
+		 */
+
+		uint8_t irqMask;
+
+		/*
+		 * Set when a receive interrupt handler also uses the radio.
+		 * Each chip select then runs with interrupts disabled so the
+		 * handler can not come in part way through a transfer.
+		 * csnHi() restores the interrupt state csnLow() found.
+		 *
+		 * irqContext is set while in the handler, or with interrupts
+		 * already disabled, so the chip select leaves them alone.
+		 */
+
+		bool interruptSafe;
+		volatile bool irqContext;
+		uint8_t csnInterruptState;
+// MenloPark Innovation LLC 06/20/2016
+
 		/*
 		 * Spi interface (must extend spi).
 		 */
@@ -169,9 +169,9 @@
 #define PWR_UP      1 // 1 == power up
 #define CRCO        2 // 0 == 1 byte CRC, 1 == 2 byte CRC
 #define EN_CRC      3 // 1 == enable CRC. Forced 1 if EN_AA is 1
-//#define MASK_MAX_RT 4 // 0 == enable max retransmit interrupt
-//#define MASK_TX_DS  5 // 0 == enable transmit interrupt
-//#define MASK_RX_DR  6 // 0 == enable receive interrupt
+#define MASK_MAX_RT 4 // 0 == enable max retransmit interrupt
+#define MASK_TX_DS  5 // 0 == enable transmit interrupt
+#define MASK_RX_DR  6 // 0 == enable receive interrupt
 //#define CONFIG_RESERVED 7
 
 //
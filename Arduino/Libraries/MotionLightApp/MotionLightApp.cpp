@@ -129,12 +129,9 @@
 const char motionlight_module_name_string[] PROGMEM = "MotionLight";
 
 //
-// Time to remain on after a trigger
+// ONTIME - Time to remain on after a trigger
 //
-const char dweet_ontime_string[] PROGMEM = "ONTIME";
-
-//
-// Light Mode
+// LIGHTMODE - Light Mode
 //
 // Mode 0 - 
 //
@@ -165,36 +162,32 @@ const char dweet_ontime_string[] PROGMEM = "ONTIME";
 //  A LIGHTOFF command turns light off, but will turn back on again if
 //  another trigger occurs.
 //
-const char dweet_lightmode_string[] PROGMEM = "LIGHTMODE";
-
-//
-// Interval in ms that the light flashes when in blink mode
-//
-const char dweet_blinkrate_string[] PROGMEM = "BLINKRATE";
-
+// BLINKRATE - Interval in ms that the light flashes when in blink mode
 //
-// The interval that it will flash in blink mode
+// BLINKINTERVAL - The interval that it will flash in blink mode
 //
-const char dweet_blinkinterval_string[] PROGMEM = "BLINKINTERVAL";
-
+// LIGHTON - Time in ms to keep the light on
 //
-// Time in ms to keep the light on
+// LIGHTOFF - Time  in ms that the light will be off.
 //
-const char dweet_lighton_string[] PROGMEM = "LIGHTON";
+#define MOTIONLIGHT_COMMANDS(X) \
+    X(dweet_ontime_string, "ONTIME") \
+    X(dweet_lightmode_string, "LIGHTMODE") \
+    X(dweet_blinkrate_string, "BLINKRATE") \
+    X(dweet_blinkinterval_string, "BLINKINTERVAL") \
+    X(dweet_lighton_string, "LIGHTON") \
+    X(dweet_lightoff_string, "LIGHTOFF")
 
-//
-// Time  in ms that the light will be off.
-//
-const char dweet_lightoff_string[] PROGMEM = "LIGHTOFF";
+MOTIONLIGHT_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const motionlight_string_table[] PROGMEM =
 {
-    dweet_ontime_string,
-    dweet_lightmode_string,
-    dweet_blinkrate_string,
-    dweet_blinkinterval_string,
-    dweet_lighton_string,
-    dweet_lightoff_string
+    MOTIONLIGHT_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t motionlight_hash_table[] =
+{
+    MOTIONLIGHT_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -517,6 +510,7 @@ MotionLightApp::Initialize(MotionLightConfiguration* config)
     //
     parms.ModuleName = (PGM_P)motionlight_module_name_string;
     parms.stringTable = (PGM_P)motionlight_string_table;
+    parms.hashTable = motionlight_hash_table;
     parms.functionTable = (PGM_P)motionlight_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -638,6 +632,7 @@ MotionLightApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
     //
     parms.ModuleName = (PGM_P)motionlight_module_name_string;
     parms.stringTable = (PGM_P)motionlight_string_table;
+    parms.hashTable = motionlight_hash_table;
     parms.functionTable = (PGM_P)motionlight_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -137,6 +137,9 @@
 #define xDBG_PRINT_INT_NNL(x)
 #endif
 
+// Radio whose ReceiveIsr() is attached
+OS_nRF24L01* OS_nRF24L01::s_interruptRadio = NULL;
+
 //
 // Constructor
 //
@@ -145,6 +148,9 @@ OS_nRF24L01::OS_nRF24L01()
 {
   m_present = false;
   m_BufferLength = 0;
+  m_receivePipe = 0;
+  m_receiveRing = NULL;
+  m_receiveHeld = false;
 }
 
 void
@@ -552,16 +558,31 @@ OS_nRF24L01::Initialize(
 bool
 OS_nRF24L01::ReceiveDataReady()
 {
+  bool busy;
+
   if (!m_present) {
       xDBG_PRINT("OS_nRF24L01 RadioDataReady no device present");
       return false;
   }
 
+  //
+  // Mirf.isSending() in TransmitBusy() returns the radio to
+  // receive once a send completes. Nothing else does after a
+  // WaitForSendComplete() timeout, so this is checked before
+  // the receive ring as well.
+  //
+  busy = TransmitBusy();
+
+  // Received packets are already in the ring
+  if (m_receiveRing != NULL) {
+      return !m_receiveRing->IsEmpty();
+  }
+
   //
   // Don't attempt to switch to the receiver until
   // the transmitter is idle.
   //
-  if (TransmitBusy()) {
+  if (busy) {
       xDBG_PRINT("OS_nRF24L01 RadioDataReady tx sending");
       return false;
   }
@@ -586,6 +607,180 @@ OS_nRF24L01::ReceiveDataReady()
   return false;
 }
 
+//
+// ReceiveDataPending() is called by MenloRadio::Poll() after
+// each Read() to drain the radio's 3 entry receive FIFO.
+//
+// It only reads FIFO_STATUS without the settling delays of
+// ReceiveDataReady() since the receiver is known to be active.
+//
+bool
+OS_nRF24L01::ReceiveDataPending()
+{
+  bool busy;
+
+  if (!m_present) {
+      return false;
+  }
+
+  // Re-arms the receiver after a send, see ReceiveDataReady()
+  busy = TransmitBusy();
+
+  if (m_receiveRing != NULL) {
+      return !m_receiveRing->IsEmpty();
+  }
+
+  if (busy) {
+      return false;
+  }
+
+  return !Mirf.rxFifoEmpty();
+}
+
+//
+// Interrupt driven receive.
+//
+// The IRQ pin is unmasked for RX_DR only, TX_DS and MAX_RT are
+// still polled by TransmitBusy(). Each falling edge drains the
+// radio's 3 entry FIFO into the caller's ring and wakes MenloRadio
+// to raise the receive events from the dispatch loop.
+//
+// The ring is only referenced once the interrupt is attached, so
+// polled radios don't carry its buffers.
+//
+// Mirf.interruptSafe keeps the handler from using SPI while
+// the dispatch loop is part way through a radio transfer.
+//
+// It does not cover other devices on the same SPI bus. Where the
+// SPI library has transactions SPI.usingInterrupt() masks the IRQ
+// during their beginTransaction()/endTransaction(), so a shared
+// bus requires their drivers to use transactions. Devices driven
+// without them must not share the bus with an interrupt driven
+// radio, supply no ring and the radio is polled instead.
+//
+int
+OS_nRF24L01::AttachReceiveInterrupt(uint8_t irqPin, MenloRadioReceiveRing* ring)
+{
+  int interruptNumber;
+
+  if (!m_present || (ring == NULL)) {
+      return 1;
+  }
+
+#if defined(digitalPinToInterrupt) && defined(NOT_AN_INTERRUPT)
+  interruptNumber = digitalPinToInterrupt(irqPin);
+  if (interruptNumber == NOT_AN_INTERRUPT) {
+      DBG_PRINT("OS_nRF24L01 irqPin is not an interrupt, polling");
+      return 1;
+  }
+#else
+  // No pin to interrupt mapping on this platform
+  DBG_PRINT("OS_nRF24L01 no pin interrupts, polling");
+  return 1;
+#endif
+
+  s_interruptRadio = this;
+
+  Mirf.irqMask = (1 << MASK_TX_DS) | (1 << MASK_MAX_RT);
+  Mirf.interruptSafe = true;
+
+  // Apply the mask to CONFIG
+  Mirf.powerUpRx();
+
+  m_receiveRing = ring;
+
+  pinMode(irqPin, INPUT);
+
+#if defined(SPI_HAS_TRANSACTION) && (MENLO_ATMEGA || MENLO_ARM32)
+  // Keep the handler out of other devices' SPI transactions
+  SPI.usingInterrupt(interruptNumber);
+#endif
+
+  attachInterrupt(interruptNumber, OS_nRF24L01::ReceiveIsr, FALLING);
+
+  //
+  // A packet received before now holds the IRQ pin low without
+  // another falling edge.
+  //
+  RefillReceiveRing();
+
+  MenloRadio::EnableReceiveInterrupt();
+
+  DBG_PRINT("OS_nRF24L01 receive interrupt attached");
+
+  return 0;
+}
+
+void
+OS_nRF24L01::ReceiveIsr()
+{
+  if (s_interruptRadio == NULL) {
+      return;
+  }
+
+  Mirf.irqContext = true;
+
+  s_interruptRadio->DrainReceiveFifo();
+
+  Mirf.irqContext = false;
+}
+
+void
+OS_nRF24L01::RefillReceiveRing()
+{
+  uint8_t state;
+
+  state = Mirf.saveInterrupts();
+
+  Mirf.irqContext = true;
+
+  DrainReceiveFifo();
+
+  Mirf.irqContext = false;
+
+  Mirf.restoreInterrupts(state);
+}
+
+//
+// This runs at interrupt time, or with interrupts disabled.
+//
+// getData() clears RX_DR before FIFO_STATUS is checked again, so
+// a packet arriving during the drain raises a new interrupt.
+//
+void
+OS_nRF24L01::DrainReceiveFifo()
+{
+  uint8_t* slot;
+  uint8_t pipe;
+
+  m_receiveHeld = false;
+
+  while (!Mirf.rxFifoEmpty()) {
+
+      slot = m_receiveRing->GetWriteSlot();
+      if (slot == NULL) {
+          // Left in the FIFO until OnRead() makes room
+          m_receiveHeld = true;
+          break;
+      }
+
+      // See OnRead()
+      pipe = (Mirf.getStatus() >> 1) & 0x07;
+
+      Mirf.getData(slot);
+
+      m_receiveRing->CommitWrite(pipe);
+  }
+
+  ReceiveInterrupt();
+}
+
+uint8_t
+OS_nRF24L01::GetReceiveSource()
+{
+  return m_receivePipe;
+}
+
 int
 OS_nRF24L01::WaitForRadioDataReady(unsigned long timeout)
 {
@@ -656,7 +851,9 @@ OS_nRF24L01::WaitForSendComplete(unsigned long timeout)
 // be received quickly so that a future send does not overflow the
 // buffer.
 //
-// At the current time radio receive interrupts are not used.
+// When AttachReceiveInterrupt() has been called packets are copied
+// from the radio by the interrupt handler and ReceiveDataReady()
+// and OnRead() only use the receive ring.
 //
 // ReceiveDataReady() which is implemented by this function returns
 // if any receive data is available immediately for a zero wait Read().
@@ -681,6 +878,7 @@ int
 OS_nRF24L01::OnRead(unsigned long timeout)
 {
   int retVal;
+  uint8_t* slot;
 
   //
   // Callers can specify a timeout of 0 for zero wait reads.
@@ -693,10 +891,33 @@ OS_nRF24L01::OnRead(unsigned long timeout)
       return 0;
   } 
 
+  if (m_receiveRing != NULL) {
+
+      slot = m_receiveRing->GetReadSlot(&m_receivePipe);
+
+      memcpy(m_Buffer, slot, m_BufferLength);
+
+      m_receiveRing->CommitRead();
+
+      //
+      // Packets left in the FIFO while the ring was full raise
+      // no new interrupt.
+      //
+      if (m_receiveHeld) {
+          RefillReceiveRing();
+      }
+
+      return m_BufferLength;
+  }
+
+  //
+  // The packet carries no sender address, so the receive pipe
+  // (STATUS RX_P_NO bits 3:1) is what identifies its source.
   //
-  // FUTURE: Need to store the address received from to support
-  // multiple clients.
+  // This must be read before getData() since the status then
+  // moves on to the next packet in the FIFO.
   //
+  m_receivePipe = (Mirf.getStatus() >> 1) & 0x07;
 
   // The transfer size is fixed
   Mirf.getData(m_Buffer);
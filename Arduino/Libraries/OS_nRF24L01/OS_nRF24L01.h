@@ -136,6 +136,21 @@ public:
         uint8_t csnPin
         );
 
+    //
+    // Receive from the radio's IRQ pin interrupt rather than
+    // polling the radio over SPI on each pass of the dispatch loop.
+    //
+    // ring holds the received packets until they are read and is
+    // supplied by the caller so that polled radios don't carry it.
+    //
+    // Returns 1 if irqPin has no interrupt or ring is NULL, the
+    // radio is then polled as before.
+    //
+    // The handler uses SPI, so other devices on the bus must use
+    // SPI transactions, see AttachReceiveInterrupt() in the .cpp.
+    //
+    int AttachReceiveInterrupt(uint8_t irqPin, MenloRadioReceiveRing* ring);
+
     //
     // MenloRadio required methods
     //
@@ -148,6 +163,16 @@ public:
     //
     virtual bool ReceiveDataReady();
 
+    //
+    // Reads FIFO_STATUS directly to drain the receive FIFO.
+    //
+    virtual bool ReceiveDataPending();
+
+    //
+    // Returns the receive pipe of the last packet read.
+    //
+    virtual uint8_t GetReceiveSource();
+
     //
     // Indicates if the transmitter is busy sending a packet.
     //
@@ -223,6 +248,22 @@ private:
 
     int WaitForSendComplete(unsigned long timeout);
 
+    static void ReceiveIsr();
+
+    // Copies packets from the radio's FIFO into m_receiveRing
+    void DrainReceiveFifo();
+
+    // DrainReceiveFifo() from the dispatch loop
+    void RefillReceiveRing();
+
+    static OS_nRF24L01* s_interruptRadio;
+
+    // NULL unless AttachReceiveInterrupt() succeeded
+    MenloRadioReceiveRing* m_receiveRing;
+
+    // The ring was full, packets are left in the radio's FIFO
+    volatile bool m_receiveHeld;
+
     //
     // We place the buffer in this class since space
     // is tight. This buffer is used for receive.
@@ -231,6 +272,9 @@ private:
 
     uint8_t m_BufferLength;
 
+    // Pipe the packet in m_Buffer arrived on
+    uint8_t m_receivePipe;
+
     bool m_present;
 
     uint8_t m_receiveAddress[5];
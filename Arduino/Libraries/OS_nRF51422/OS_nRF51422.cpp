@@ -222,6 +222,17 @@ OS_nRF51422::DataReady()
   }
 }
 
+//
+// Called by MenloRadio::Poll() after each Read() to drain
+// the receiver. onReceive() fills m_receiveBuffer from the
+// BLE stack so there is no radio status to read.
+//
+bool
+OS_nRF51422::ReceiveDataPending()
+{
+  return DataReady();
+}
+
 int
 OS_nRF51422::WaitForDataReady(unsigned long timeout)
 {
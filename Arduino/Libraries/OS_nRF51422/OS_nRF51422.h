@@ -61,6 +61,12 @@ public:
 
   virtual void ResetReceiveBuffer();
 
+  //
+  // Receive data arrives from the BLE stack into a single
+  // buffer so MenloRadio::Poll() only needs to check it.
+  //
+  virtual bool ReceiveDataPending();
+
   //
   // MenloRadio general buffer implementation
   //
@@ -123,58 +123,47 @@
 
 const char weather_module_name_string[] PROGMEM = "WeatherStationApp";
 
-// Configure update send interval
-const char dweet_updateinterval_string[] PROGMEM = "UPDATEINTERVAL";
-
-// Configure sample interval
-const char dweet_sampleinterval_string[] PROGMEM = "SAMPLEINTERVAL";
-
-// Configure NMEA 0183 streaming
-const char dweet_nmeastream_string[] PROGMEM = "NMEASTREAM";
-
-// Configure GPS Power
-const char dweet_gpspower_string[] PROGMEM = "GPSPOWER";
-
-// Configure Status Light 1 and Status Light 2
-const char dweet_light1_string[] PROGMEM = "LIGHT1";
-const char dweet_light2_string[] PROGMEM = "LIGHT2";
-
 //
-// Sensor values that can be read individually
+// UPDATEINTERVAL - Configure update send interval
+// SAMPLEINTERVAL - Configure sample interval
+// NMEASTREAM     - Configure NMEA 0183 streaming
+// GPSPOWER       - Configure GPS Power
+// LIGHT1, LIGHT2 - Configure Status Light 1 and Status Light 2
+//
+// WINDSPEED through SENDREADINGS are sensor values that can be
+// read individually.
 //
 // These are dynamic values which don't have settings in EEPROM
 //
-const char dweet_windspeed_string[] PROGMEM = "WINDSPEED";
-const char dweet_winddir_string[] PROGMEM = "WINDDIR";
-const char dweet_temperature_string[] PROGMEM = "TEMPERATURE";
-const char dweet_barometer_string[] PROGMEM = "BAROMETER";
-const char dweet_humidity_string[] PROGMEM = "HUMIDITY";
-const char dweet_rainfall_string[] PROGMEM = "RAINFALL";
-const char dweet_gps_string[] PROGMEM = "GPS";
-const char dweet_battery_string[] PROGMEM = "BATTERY";
-const char dweet_solar_string[] PROGMEM = "SOLAR";
-const char dweet_light_string[] PROGMEM = "LIGHT";
-const char dweet_sendreadings_string[] PROGMEM = "SENDREADINGS";
+#define WEATHER_COMMANDS(X) \
+    X(dweet_updateinterval_string, "UPDATEINTERVAL") \
+    X(dweet_sampleinterval_string, "SAMPLEINTERVAL") \
+    X(dweet_nmeastream_string, "NMEASTREAM") \
+    X(dweet_gpspower_string, "GPSPOWER") \
+    X(dweet_light1_string, "LIGHT1") \
+    X(dweet_light2_string, "LIGHT2") \
+    X(dweet_windspeed_string, "WINDSPEED") \
+    X(dweet_winddir_string, "WINDDIR") \
+    X(dweet_temperature_string, "TEMPERATURE") \
+    X(dweet_barometer_string, "BAROMETER") \
+    X(dweet_humidity_string, "HUMIDITY") \
+    X(dweet_rainfall_string, "RAINFALL") \
+    X(dweet_gps_string, "GPS") \
+    X(dweet_battery_string, "BATTERY") \
+    X(dweet_solar_string, "SOLAR") \
+    X(dweet_light_string, "LIGHT") \
+    X(dweet_sendreadings_string, "SENDREADINGS")
+
+WEATHER_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const weather_string_table[] PROGMEM =
 {
-    dweet_updateinterval_string,
-    dweet_sampleinterval_string,
-    dweet_nmeastream_string,
-    dweet_gpspower_string,
-    dweet_light1_string,
-    dweet_light2_string,
-    dweet_windspeed_string,
-    dweet_winddir_string,
-    dweet_temperature_string,
-    dweet_barometer_string,
-    dweet_humidity_string,
-    dweet_rainfall_string,
-    dweet_gps_string,
-    dweet_battery_string,
-    dweet_solar_string,
-    dweet_light_string,
-    dweet_sendreadings_string
+    WEATHER_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t weather_hash_table[] =
+{
+    WEATHER_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -313,6 +302,7 @@ WeatherStationApp::Initialize(
     //
     parms.ModuleName = (PGM_P)weather_module_name_string;
     parms.stringTable = (PGM_P)weather_string_table;
+    parms.hashTable = weather_hash_table;
     parms.functionTable = (PGM_P)weather_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -549,6 +539,7 @@ WeatherStationApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* value
     //
     parms.ModuleName = (PGM_P)weather_module_name_string;
     parms.stringTable = (PGM_P)weather_string_table;
+    parms.hashTable = weather_hash_table;
     parms.functionTable = (PGM_P)weather_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -309,6 +309,12 @@ DweetLightHouse g_dweetLightHouse;
 
 DweetRadioSerialApp g_sensorApp;
 
+//
+// Packets received by the radio's IRQ interrupt wait here until
+// read. Leave receiveRing NULL to poll the radio without it.
+//
+MenloRadioReceiveRing g_receiveRing;
+
 // Arduino 1.6.8 now requires forward declarations like a proper C/C++ compiler.
 void ApplicationSetup();
 void MenloFrameworkSetup();
@@ -493,6 +499,7 @@ ApplicationSetup()
   config.csnPin = nRF24L01_CSN;
   config.cePin = nRF24L01_CE;
   config.irqPin = nRF24L01_IRQ;
+  config.receiveRing = &g_receiveRing;
   config.payLoadSize = nRF24L01_payLoadSize;
   config.forceDefaults = nRF24L01_forceDefaults;
   config.defaultChannel = nRF24L01_defaultChannel;
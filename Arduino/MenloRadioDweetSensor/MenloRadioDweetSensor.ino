@@ -63,6 +63,7 @@
 #include <MenloDweet.h>
 #include <DweetSerialChannel.h>
 #include <DweetRadio.h>
+#include <DweetRadioChannel.h>
 
 //
 // Arduino and Debug support
@@ -109,17 +109,22 @@
 //
 const char sensor_module_name_string[] PROGMEM = "SensorHardware";
 
-extern const char dweet_lightcolor_string[] PROGMEM = "LIGHTCOLOR";
-extern const char dweet_lightonlevel_string[] PROGMEM = "LIGHTONLEVEL";
+// SENSORS is the sensor/environmental support
+#define SENSOR_COMMANDS(X) \
+  X(dweet_lightcolor_string, "LIGHTCOLOR") \
+  X(dweet_lightonlevel_string, "LIGHTONLEVEL") \
+  X(dweet_sensors_string, "SENSORS")
 
-// Sensor/environmental support
-extern const char dweet_sensors_string[] PROGMEM = "SENSORS";
+SENSOR_COMMANDS(DWEET_COMMAND_EXTERN_STRING)
 
 const char* const sensor_string_table[] PROGMEM =
 {
-  dweet_lightcolor_string,
-  dweet_lightonlevel_string,
-  dweet_sensors_string
+  SENSOR_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t sensor_hash_table[] =
+{
+  SENSOR_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -215,6 +220,7 @@ SensorHardware::InitializeStateFromStoredConfig()
 
     parms.ModuleName = (PGM_P)sensor_module_name_string;
     parms.stringTable = (PGM_P)sensor_string_table;
+    parms.hashTable = sensor_hash_table;
     parms.functionTable = (PGM_P)sensor_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -275,6 +281,7 @@ SensorHardware::SubClassProcessAppCommands(MenloDweet* dweet, char* name, char*
     //
     parms.ModuleName = (PGM_P)sensor_module_name_string;
     parms.stringTable = (PGM_P)sensor_string_table;
+    parms.hashTable = sensor_hash_table;
     parms.functionTable = (PGM_P)sensor_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
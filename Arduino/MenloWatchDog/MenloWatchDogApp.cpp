@@ -138,26 +138,24 @@ void WatchDogSetLightState(bool state);
 
 const char watchdog_module_name_string[] PROGMEM = "MenloWatchDogApp";
 
-const char watchdog_timeout_string[] PROGMEM = "WATCHDOGTIMEOUT";
+#define WATCHDOG_COMMANDS(X) \
+    X(watchdog_timeout_string, "WATCHDOGTIMEOUT") \
+    X(watchdog_reset_string, "WATCHDOGRESET") \
+    X(watchdog_power_string, "WATCHDOGPOWER") \
+    X(watchdog_ind_string, "WATCHDOGIND") \
+    X(watchdog_resets_string, "WATCHDOGRESETS") \
+    X(watchdog_poke_string, "WATCHDOGPOKE")
 
-const char watchdog_reset_string[] PROGMEM = "WATCHDOGRESET";
-
-const char watchdog_power_string[] PROGMEM = "WATCHDOGPOWER";
-
-const char watchdog_ind_string[] PROGMEM = "WATCHDOGIND";
-
-const char watchdog_resets_string[] PROGMEM = "WATCHDOGRESETS";
-
-const char watchdog_poke_string[] PROGMEM = "WATCHDOGPOKE";
+WATCHDOG_COMMANDS(DWEET_COMMAND_STRING)
 
 const char* const watchdog_string_table[] PROGMEM =
 {
-    watchdog_timeout_string,
-    watchdog_reset_string,
-    watchdog_power_string,
-    watchdog_ind_string,
-    watchdog_resets_string,
-    watchdog_poke_string
+    WATCHDOG_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t watchdog_hash_table[] =
+{
+    WATCHDOG_COMMANDS(DWEET_COMMAND_HASH)
 };
 
 // Locally typed version of state dispatch function
@@ -578,6 +576,7 @@ MenloWatchDogApp::Initialize(WatchdogConfiguration* config)
     //
     parms.ModuleName = (PGM_P)watchdog_module_name_string;
     parms.stringTable = (PGM_P)watchdog_string_table;
+    parms.hashTable = watchdog_hash_table;
     parms.functionTable = (PGM_P)watchdog_function_table;
 #if DWEET_STATE_ENABLE_DEFAULT_TABLE_SUPPORT
     parms.defaultsTable = watchdog_default_table;
@@ -823,6 +822,7 @@ MenloWatchDogApp::ProcessAppCommands(MenloDweet* dweet, char* name, char* value)
     //
     parms.ModuleName = (PGM_P)watchdog_module_name_string;
     parms.stringTable = (PGM_P)watchdog_string_table;
+    parms.hashTable = watchdog_hash_table;
     parms.functionTable = (PGM_P)watchdog_function_table;
     parms.defaultsTable = NULL;
     parms.object =  this;
@@ -0,0 +1,1713 @@
+/*
+ * Copyright (C) 2016 Menlo Park Innovation LLC
+ *
+ * This is licensed software, all rights as to the software
+ * is reserved by Menlo Park Innovation LLC.
+ *
+ * A license included with the distribution provides certain limited
+ * rights to a given distribution of the work.
+ *
+ * This distribution includes a copy of the license agreement and must be
+ * provided along with any further distribution or copy thereof.
+ *
+ * If this license is missing, or you wish to license under different
+ * terms please contact:
+ *
+ * menloparkinnovation.com
+ * menloparkinnovation@gmail.com
+ */
+
+/*
+ *  Date: 06/12/2016
+ *  File: MenloHostBench.cpp
+ *
+ *  Host native benchmarks for the MenloFramework core.
+ *
+ *  Usage: menlo_host_bench [mode] [iterations]
+ *
+ *  Modes:
+ *
+ *    nmea     - MenloNMEA0183::parse() of a Dweet sentence
+ *    lookup   - Dweet command table lookup, linear vs. hashed
+ *    dweet    - Full Dweet dispatch through DweetSerialChannel, and
+ *               latency from the '\n' arriving to the reply
+ *    timer    - MenloTimer::Poll() with 10, 100 and 1000 registered
+ *               timers, list vs. heap ordered
+ *    dispatch - MenloDispatchObject::loop() over idle objects with a
+ *               busy one, legacy polling vs. wakeup enabled
+ *    profile  - Dispatch profiler over a small application, enabled
+ *               and read back through GETSTATE=PROFILE, then dumped
+ *    radio    - MenloRadioSerial stream over a lossy loopback radio
+ *               link, toggle protocol vs. windowed transport, and
+ *               Dweet replies with and without output coalescing,
+ *               and Dweets as NMEA 0183 over RadioSerial vs. binary
+ *               Dweets through DweetRadio
+ *    gateway  - Gateway receiving from 50 sensor nodes reporting at
+ *               once, forwarding from the radio event vs. through
+ *               MenloRadioReceiveScheduler, with the radio polled
+ *               vs. interrupt driven
+ *    all      - All of the above (default)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//
+// MenloFramework
+//
+#include <MenloPlatform.h>
+#include <MenloObject.h>
+#include <MenloMemoryMonitor.h>
+#include <MenloUtility.h>
+#include <MenloNMEA0183Stream.h>
+#include <MenloDebug.h>
+#include <MenloNMEA0183.h>
+#include <MenloDweet.h>
+#include <DweetChannel.h>
+#include <DweetSerialChannel.h>
+#include <DweetDebug.h>
+#include <MenloTimer.h>
+#include <MenloDispatchProfile.h>
+#include <MenloRadio.h>
+#include <MenloRadioSerial.h>
+#include <MenloRadioLoopback.h>
+#include <MenloRadioReceiveScheduler.h>
+#include <DweetRadio.h>
+#include <DweetRadioChannel.h>
+
+#define DEFAULT_ITERATIONS 100000
+
+//
+// Benchmarks use their own clock rather than micros() since
+// micros() is truncated to 32 bits to match the targets.
+//
+static uint64_t
+NowNanoseconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void
+Report(const char* name, unsigned long ops, uint64_t elapsed)
+{
+    printf("%-10s ops=%lu total_us=%llu ns/op=%.1f\n",
+        name,
+        ops,
+        (unsigned long long)(elapsed / 1000ULL),
+        (ops != 0) ? ((double)elapsed / (double)ops) : 0.0
+        );
+}
+
+//
+// Build a complete NMEA 0183 sentence with checksum
+// into buffer. The sentence ends with "\r\n".
+//
+static int
+BuildSentence(MenloNMEA0183* nmea, const char* cmd, char* buffer, int size)
+{
+    char* s;
+
+    nmea->reset();
+
+    // addCommand() returns 0 when the sentence is full
+    if (nmea->addCommand((char*)cmd) == 0) {
+        return 0;
+    }
+
+    s = nmea->generateSentence();
+    if (s == NULL) {
+        return 0;
+    }
+
+    return snprintf(buffer, size, "%s", s);
+}
+
+//
+// NMEA 0183 parse throughput
+//
+static void
+BenchNMEA(unsigned long iterations)
+{
+    char output[84];
+    char sentence[84];
+    char work[84];
+    char prefix[MenloNMEA0183::MaxPrefixSize + 1];
+    unsigned char checksum;
+    int checksumOK;
+    unsigned long okCount = 0;
+    MenloNMEA0183 nmea;
+    uint64_t start;
+
+    nmea.Initialize((char*)"$PDWT", output, sizeof(output));
+
+    if (BuildSentence(&nmea, "GETSTATE=TRACELEVEL", sentence, sizeof(sentence)) == 0) {
+        printf("nmea: could not build sentence\n");
+        return;
+    }
+
+    start = NowNanoseconds();
+
+    for (unsigned long i = 0; i < iterations; i++) {
+
+        // parse() modifies the buffer in place
+        strcpy(work, sentence);
+
+        if (nmea.parse(work, prefix, &checksum, &checksumOK) != NULL) {
+            if (checksumOK) okCount++;
+        }
+    }
+
+    Report("nmea", iterations, NowNanoseconds() - start);
+
+    if (okCount != iterations) {
+        printf("nmea: checksum failures %lu\n", iterations - okCount);
+    }
+}
+
+//
+// End to end Dweet dispatch from a Stream
+//
+static void
+BenchDweet(unsigned long iterations)
+{
+    char output[84];
+    char sentence[84];
+    int length;
+    size_t inputSize;
+    uint8_t* input;
+    uint8_t* reply;
+    MenloNMEA0183 nmea;
+    uint64_t start;
+    uint64_t latency;
+
+    //
+    // The channel registers for PollEvents and can not be
+    // unregistered, so it and its stream live until exit.
+    //
+    static MenloHostStream stream;
+    static DweetSerialChannel channel;
+
+    nmea.Initialize((char*)"$PDWT", output, sizeof(output));
+
+    length = BuildSentence(&nmea, "GETSTATE=TRACELEVEL", sentence, sizeof(sentence));
+    if (length == 0) {
+        printf("dweet: could not build sentence\n");
+        return;
+    }
+
+    // The sentences are delivered as one continuous stream
+    inputSize = (size_t)length * iterations;
+    input = (uint8_t*)malloc(inputSize);
+    reply = (uint8_t*)malloc(256);
+    if ((input == NULL) || (reply == NULL)) {
+        printf("dweet: out of memory\n");
+        free(input);
+        free(reply);
+        return;
+    }
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        memcpy(&input[i * length], sentence, length);
+    }
+
+    stream.SetInput(input, inputSize);
+    stream.SetOutput(reply, 256);
+
+    channel.Initialize(&stream, (char*)"$PDWT");
+
+    start = NowNanoseconds();
+
+    while (stream.available() > 0) {
+        MenloDispatchObject::loop(0);
+    }
+
+    Report("dweet", iterations, NowNanoseconds() - start);
+
+    // Show the first reply as a check that commands were dispatched
+    length = 0;
+    while ((length < 255) && ((size_t)length < stream.GetOutputCount()) &&
+           (reply[length] != '\r') && (reply[length] != '\n')) {
+        length++;
+    }
+
+    printf("dweet: reply bytes=%lu first=%.*s\n",
+        (unsigned long)stream.GetOutputCount(), length, (char*)reply);
+
+    //
+    // Latency from the sentence's '\n' arriving to the reply
+    // being sent. The rest of the sentence arrives first as it
+    // would from a UART.
+    //
+    latency = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+
+        stream.SetInput((uint8_t*)sentence, length - 1);
+        stream.SetOutput(reply, 256);
+
+        while (stream.available() > 0) {
+            MenloDispatchObject::loop(0);
+        }
+
+        stream.SetInput((uint8_t*)&sentence[length - 1], 1);
+
+        start = NowNanoseconds();
+
+        while (stream.GetOutputCount() == 0) {
+            MenloDispatchObject::loop(0);
+        }
+
+        latency += NowNanoseconds() - start;
+    }
+
+    Report("dweet_lat", iterations, latency);
+
+    free(input);
+    free(reply);
+}
+
+//
+// Dweet command table lookup
+//
+// Models a gateway with several modules registered. Each command
+// is offered to each module's table in turn until one recognizes
+// it, as DispatchDweetCommand() does through ProcessAppCommands()
+// and ProcessBuiltInCommands().
+//
+
+#define BENCH_RADIO_COMMANDS(X) \
+    X(bench_radiochannel_string, "RADIOCHANNEL") \
+    X(bench_radiotxaddr_string, "RADIOTXADDR") \
+    X(bench_radiorxaddr_string, "RADIORXADDR") \
+    X(bench_radiopowertimer_string, "RADIOPOWERTIMER") \
+    X(bench_radioatt_string, "RADIOATT") \
+    X(bench_radiooptions_string, "RADIOOPTIONS") \
+    X(bench_radiogateway_string, "RADIOGATEWAY")
+
+BENCH_RADIO_COMMANDS(DWEET_COMMAND_STRING)
+
+const char* const bench_radio_string_table[] PROGMEM =
+{
+    BENCH_RADIO_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t bench_radio_hash_table[] =
+{
+    BENCH_RADIO_COMMANDS(DWEET_COMMAND_HASH)
+};
+
+#define BENCH_SENSOR_COMMANDS(X) \
+    X(bench_updateinterval_string, "UPDATEINTERVAL") \
+    X(bench_sampleinterval_string, "SAMPLEINTERVAL") \
+    X(bench_windspeed_string, "WINDSPEED") \
+    X(bench_winddir_string, "WINDDIR") \
+    X(bench_temperature_string, "TEMPERATURE") \
+    X(bench_barometer_string, "BAROMETER") \
+    X(bench_humidity_string, "HUMIDITY") \
+    X(bench_rainfall_string, "RAINFALL") \
+    X(bench_battery_string, "BATTERY") \
+    X(bench_solar_string, "SOLAR") \
+    X(bench_light_string, "LIGHT") \
+    X(bench_sendreadings_string, "SENDREADINGS")
+
+BENCH_SENSOR_COMMANDS(DWEET_COMMAND_STRING)
+
+const char* const bench_sensor_string_table[] PROGMEM =
+{
+    BENCH_SENSOR_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t bench_sensor_hash_table[] =
+{
+    BENCH_SENSOR_COMMANDS(DWEET_COMMAND_HASH)
+};
+
+#define BENCH_CONFIG_COMMANDS(X) \
+    X(bench_model_string, "MODEL") \
+    X(bench_name_string, "NAME") \
+    X(bench_serial_string, "SERIAL") \
+    X(bench_version_string, "VERSION") \
+    X(bench_firmwareversion_string, "FIRMWAREVERSION") \
+    X(bench_tracelevel_string, "TRACELEVEL") \
+    X(bench_nochecksum_string, "NOCHECKSUM") \
+    X(bench_sleepmode_string, "SLEEPMODE") \
+    X(bench_cpuspeed_string, "CPUSPEED") \
+    X(bench_sleeptime_string, "SLEEPTIME") \
+    X(bench_awaketime_string, "AWAKETIME")
+
+BENCH_CONFIG_COMMANDS(DWEET_COMMAND_STRING)
+
+const char* const bench_config_string_table[] PROGMEM =
+{
+    BENCH_CONFIG_COMMANDS(DWEET_COMMAND_NAME)
+};
+
+PROGMEM const uint16_t bench_config_hash_table[] =
+{
+    BENCH_CONFIG_COMMANDS(DWEET_COMMAND_HASH)
+};
+
+struct BenchLookupTable {
+    PGM_P stringTable;
+    const uint16_t* hashTable;
+    int tableEntries;
+};
+
+//
+// Registration order, application modules first and
+// the built in commands last.
+//
+static const BenchLookupTable g_benchLookupTables[] =
+{
+    { (PGM_P)bench_radio_string_table, bench_radio_hash_table,
+      sizeof(bench_radio_string_table) / sizeof(char*) },
+
+    { (PGM_P)bench_sensor_string_table, bench_sensor_hash_table,
+      sizeof(bench_sensor_string_table) / sizeof(char*) },
+
+    { (PGM_P)bench_config_string_table, bench_config_hash_table,
+      sizeof(bench_config_string_table) / sizeof(char*) }
+};
+
+//
+// Command mix seen at a gateway. Sensors report readings and
+// the host polls radio and trace settings. Unrecognized commands
+// visit every table.
+//
+static const char* const g_benchLookupCommands[] =
+{
+    "WINDSPEED",
+    "TEMPERATURE",
+    "SENDREADINGS:01",
+    "RADIOGATEWAY",
+    "TRACELEVEL",
+    "HUMIDITY",
+    "RADIOCHANNEL:05",
+    "AWAKETIME",
+    "LIGHTPERIOD",
+    "BATTERY"
+};
+
+static unsigned long
+BenchLookupPass(MenloDweet* dweet, unsigned long iterations, bool useHash, int* found)
+{
+    char command[32];
+    int commandCount = sizeof(g_benchLookupCommands) / sizeof(char*);
+    int tableCount = sizeof(g_benchLookupTables) / sizeof(BenchLookupTable);
+    unsigned long lookups = 0;
+    int index;
+
+    *found = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+
+        // Commands are in RAM as they are when received
+        strcpy(command, g_benchLookupCommands[i % commandCount]);
+
+        for (int t = 0; t < tableCount; t++) {
+
+            index = dweet->LookupStringPrefixTableIndex(
+                g_benchLookupTables[t].stringTable,
+                useHash ? g_benchLookupTables[t].hashTable : NULL,
+                g_benchLookupTables[t].tableEntries,
+                command
+                );
+
+            lookups++;
+
+            if (index != (-1)) {
+                (*found)++;
+                break;
+            }
+        }
+    }
+
+    return lookups;
+}
+
+static void
+BenchLookup(unsigned long iterations)
+{
+    MenloDweet dweet;
+    uint64_t start;
+    int linearFound;
+    int hashFound;
+
+    // MENLO_DWEET_HASH_CHECK reports on the debug port
+    static MenloHostStream debugStream;
+    MenloDebug::Init(&debugStream);
+
+#if MENLO_DWEET_HASH_CHECK
+    for (int t = 0; t < (int)(sizeof(g_benchLookupTables) / sizeof(BenchLookupTable)); t++) {
+        if (!dweet.CheckHashTable(
+                g_benchLookupTables[t].stringTable,
+                g_benchLookupTables[t].hashTable,
+                g_benchLookupTables[t].tableEntries)) {
+            printf("lookup: hash table %d does not match its string table\n", t);
+        }
+    }
+#endif
+
+    start = NowNanoseconds();
+    BenchLookupPass(&dweet, iterations, false, &linearFound);
+    Report("linear", iterations, NowNanoseconds() - start);
+
+    start = NowNanoseconds();
+    BenchLookupPass(&dweet, iterations, true, &hashFound);
+    Report("hashed", iterations, NowNanoseconds() - start);
+
+    if (linearFound != hashFound) {
+        printf("lookup: mismatch linear=%d hashed=%d\n", linearFound, hashFound);
+    }
+}
+
+//
+// MenloTimer Poll() cost as the number of registered timers grows
+//
+// Intervals are spread from 1ms to 1s so that a few timers are
+// due on most polls as with a gateway's mix of radio, scheduler
+// and application timers.
+//
+
+class BenchTimerTarget : public MenloObject {
+public:
+    BenchTimerTarget() {
+        m_fireCount = 0;
+    }
+
+    unsigned long TimerEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs) {
+        m_fireCount++;
+        return MAX_POLL_TIME;
+    }
+
+    unsigned long m_fireCount;
+};
+
+static void
+BenchTimerPass(int timerCount, unsigned long iterations, bool useHeap)
+{
+    MenloTimer timer;
+    BenchTimerTarget target;
+    MenloTimerEventRegistration* registrations;
+    MenloTimerEventRegistration** heap;
+    char name[32];
+    uint64_t start;
+    uint64_t elapsed;
+
+    registrations = new MenloTimerEventRegistration[timerCount];
+    heap = new MenloTimerEventRegistration*[timerCount];
+
+    //
+    // The timer is not Initialize()'d so it is not placed on
+    // the static poll list. Poll() is called directly below.
+    //
+    if (useHeap) {
+        timer.InitializeHeap(heap, timerCount);
+    }
+
+    for (int i = 0; i < timerCount; i++) {
+        registrations[i].object = &target;
+        registrations[i].method = (MenloEventMethod)&BenchTimerTarget::TimerEvent;
+        registrations[i].m_interval = 1 + ((i * 7919UL) % 1000);
+        registrations[i].m_dueTime = 0L; // indicate not registered
+        timer.RegisterIntervalTimer(&registrations[i]);
+    }
+
+    start = NowNanoseconds();
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        timer.Poll();
+    }
+
+    elapsed = NowNanoseconds() - start;
+
+    snprintf(name, sizeof(name), "timer_%s_%d", useHeap ? "heap" : "list", timerCount);
+
+    Report(name, iterations, elapsed);
+
+    printf("%s: fires=%lu\n", name, target.m_fireCount);
+
+    for (int i = 0; i < timerCount; i++) {
+        timer.UnregisterIntervalTimer(&registrations[i]);
+    }
+
+    delete[] heap;
+    delete[] registrations;
+}
+
+static void
+BenchTimer(unsigned long iterations)
+{
+    static const int timerCounts[] = { 10, 100, 1000 };
+
+    for (unsigned int i = 0; i < sizeof(timerCounts) / sizeof(int); i++) {
+        BenchTimerPass(timerCounts[i], iterations, false);
+        BenchTimerPass(timerCounts[i], iterations, true);
+    }
+}
+
+//
+// Dispatch loop overhead over idle objects
+//
+// One busy object returns 0 from Poll() for several passes of
+// each loop() as an object raising events does. Legacy objects
+// are re-polled on each of those passes, wakeup enabled objects
+// are skipped unless woken. One idle object is woken per loop()
+// as a stream or interrupt handler would.
+//
+class BenchIdleObject : public MenloDispatchObject {
+public:
+    BenchIdleObject() {
+        m_pollCount = 0;
+    }
+
+    void UseWakeup() {
+        EnableWakeup();
+    }
+
+    virtual unsigned long Poll() {
+        m_pollCount++;
+        return MAX_POLL_TIME;
+    }
+
+    unsigned long m_pollCount;
+};
+
+class BenchBusyObject : public MenloDispatchObject {
+public:
+    BenchBusyObject() {
+        m_pollCount = 0;
+    }
+
+    // Request 3 more passes then idle
+    virtual unsigned long Poll() {
+        m_pollCount++;
+        return ((m_pollCount % 4) != 0) ? 0 : MAX_POLL_TIME;
+    }
+
+    unsigned long m_pollCount;
+};
+
+static void
+BenchDispatchPass(unsigned long iterations, bool useWakeup)
+{
+    const int objectCount = 32;
+    BenchIdleObject* objects;
+    BenchBusyObject* busy;
+    unsigned long polls = 0;
+    uint64_t start;
+    const char* name = useWakeup ? "dispatch_wakeup" : "dispatch";
+
+    objects = new BenchIdleObject[objectCount];
+    busy = new BenchBusyObject();
+
+    for (int i = 0; i < objectCount; i++) {
+        objects[i].Initialize();
+
+        if (useWakeup) {
+            objects[i].UseWakeup();
+        }
+    }
+
+    start = NowNanoseconds();
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        objects[i % objectCount].Wakeup();
+        MenloDispatchObject::loop(0);
+    }
+
+    Report(name, iterations, NowNanoseconds() - start);
+
+    for (int i = 0; i < objectCount; i++) {
+        polls += objects[i].m_pollCount;
+    }
+
+    printf("%s: objects=%d idle polls=%lu busy polls=%lu\n",
+        name, objectCount, polls, busy->m_pollCount);
+
+    // The destructor removes the objects from the poll list
+    delete busy;
+    delete[] objects;
+}
+
+static void
+BenchDispatch(unsigned long iterations)
+{
+    BenchDispatchPass(iterations, false);
+    BenchDispatchPass(iterations, true);
+}
+
+#if MENLO_DISPATCH_PROFILE
+
+//
+// Dispatch profiler
+//
+// A small application of a Dweet channel, timers and polled
+// objects is run with the profiler enabled through the
+// DweetDebug SETSTATE=PROFILE command. The results are read
+// back with GETSTATE=PROFILE and then dumped from the host.
+//
+
+class BenchProfileTarget : public MenloObject {
+public:
+    BenchProfileTarget() {
+        m_sum = 0;
+    }
+
+    // Simulates a handler doing a varying amount of work
+    unsigned long TimerEvent(MenloDispatchObject* sender, MenloEventArgs* eventArgs) {
+        unsigned long count = 100 + (m_sum % 1000);
+
+        for (unsigned long i = 0; i < count; i++) {
+            m_sum += i ^ (m_sum >> 3);
+        }
+
+        return MAX_POLL_TIME;
+    }
+
+    volatile unsigned long m_sum;
+};
+
+struct BenchProfileName {
+    const void* key;
+    const char* name;
+};
+
+static BenchProfileName g_benchProfileNames[16];
+static int g_benchProfileNameCount = 0;
+
+static void
+AddProfileName(const void* key, const char* name)
+{
+    if (g_benchProfileNameCount < (int)(sizeof(g_benchProfileNames) / sizeof(BenchProfileName))) {
+        g_benchProfileNames[g_benchProfileNameCount].key = key;
+        g_benchProfileNames[g_benchProfileNameCount].name = name;
+        g_benchProfileNameCount++;
+    }
+}
+
+static const char*
+GetProfileName(const void* key)
+{
+    for (int i = 0; i < g_benchProfileNameCount; i++) {
+        if (g_benchProfileNames[i].key == key) {
+            return g_benchProfileNames[i].name;
+        }
+    }
+
+    return "";
+}
+
+//
+// Host side dump of the profile
+//
+static void
+DumpProfile()
+{
+    MenloDispatchProfileEntry* entry;
+    static const char* const typeNames[] = { "", "poll", "event", "timer" };
+
+    printf("profile: loops=%lu passes=%lu drains=%lu entries=%d overflows=%lu\n",
+        MenloDispatchProfile::GetLoopCount(),
+        MenloDispatchProfile::GetPassCount(),
+        MenloDispatchProfile::GetDrainPassCount(),
+        MenloDispatchProfile::GetEntryCount(),
+        MenloDispatchProfile::GetOverflowCount()
+        );
+
+    printf("  idx type  %-18s %10s %10s %8s %8s  name\n",
+        "key", "count", "total_us", "max_us", "avg_us");
+
+    for (int i = 0; i < MenloDispatchProfile::GetEntryCount(); i++) {
+
+        entry = MenloDispatchProfile::GetEntry(i);
+
+        printf("  %3d %-5s %18p %10lu %10lu %8lu %8.2f  %s\n",
+            i,
+            (entry->type <= DISPATCH_PROFILE_TIMER) ? typeNames[entry->type] : "?",
+            entry->key,
+            entry->count,
+            entry->totalMicros,
+            entry->maxMicros,
+            (entry->count != 0) ? ((double)entry->totalMicros / (double)entry->count) : 0.0,
+            GetProfileName(entry->key)
+            );
+    }
+}
+
+//
+// Send a Dweet to the channel and print its reply
+//
+static void
+SendProfileDweet(MenloHostStream* stream, MenloNMEA0183* nmea, const char* cmd)
+{
+    char sentence[84];
+    uint8_t reply[84];
+    int length;
+    int loops;
+
+    length = BuildSentence(nmea, cmd, sentence, sizeof(sentence));
+    if (length == 0) {
+        printf("profile: could not build %s\n", cmd);
+        return;
+    }
+
+    stream->SetInput((uint8_t*)sentence, length);
+    stream->SetOutput(reply, sizeof(reply));
+
+    for (loops = 0; (loops < 100) && (stream->GetOutputCount() == 0); loops++) {
+        MenloDispatchObject::loop(0);
+    }
+
+    // Reply includes the "\r\n"
+    printf("profile: %s -> %.*s",
+        cmd, (int)stream->GetOutputCount(), (char*)reply);
+}
+
+static void
+BenchProfile(unsigned long iterations)
+{
+    const int idleCount = 4;
+    char output[84];
+    MenloNMEA0183 nmea;
+    BenchProfileTarget target;
+    BenchIdleObject* idle;
+    BenchBusyObject* busy;
+    MenloTimer timer;
+    MenloTimerEventRegistration timers[3];
+    static const unsigned long intervals[3] = { 1, 5, 10 };
+    static const char* const timerNames[3] = { "timer 1ms", "timer 5ms", "timer 10ms" };
+
+    //
+    // The channel and DweetDebug register for events which can
+    // not be unregistered, so they live until exit.
+    //
+    static MenloHostStream stream;
+    static DweetSerialChannel channel;
+    static DweetDebug debug;
+
+    nmea.Initialize((char*)"$PDWT", output, sizeof(output));
+
+    stream.SetInput(NULL, 0);
+    channel.Initialize(&stream, (char*)"$PDWT");
+    debug.Initialize(&channel);
+
+    idle = new BenchIdleObject[idleCount];
+    busy = new BenchBusyObject();
+
+    timer.Initialize();
+
+    for (int i = 0; i < 3; i++) {
+        timers[i].object = &target;
+        timers[i].method = (MenloEventMethod)&BenchProfileTarget::TimerEvent;
+        timers[i].m_interval = intervals[i];
+        timers[i].m_dueTime = 0L; // indicate not registered
+        timer.RegisterIntervalTimer(&timers[i]);
+        AddProfileName(&timers[i], timerNames[i]);
+    }
+
+    AddProfileName(&channel, "DweetSerialChannel");
+    AddProfileName(&timer, "MenloTimer");
+    AddProfileName(busy, "BenchBusyObject");
+
+    for (int i = 0; i < idleCount; i++) {
+        AddProfileName(&idle[i], "BenchIdleObject");
+    }
+
+    SendProfileDweet(&stream, &nmea, "SETSTATE=PROFILE:01");
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        MenloDispatchObject::loop(0);
+    }
+
+    SendProfileDweet(&stream, &nmea, "GETSTATE=PROFILE");
+    SendProfileDweet(&stream, &nmea, "GETSTATE=PROFILE:00");
+    SendProfileDweet(&stream, &nmea, "SETSTATE=PROFILE:00");
+
+    DumpProfile();
+
+    for (int i = 0; i < 3; i++) {
+        timer.UnregisterIntervalTimer(&timers[i]);
+    }
+
+    delete busy;
+    delete[] idle;
+}
+
+#else
+
+static void
+BenchProfile(unsigned long iterations)
+{
+    printf("profile: not built with MENLO_DISPATCH_PROFILE\n");
+}
+
+#endif // MENLO_DISPATCH_PROFILE
+
+//
+// MenloRadioSerial over a lossy link
+//
+// A byte stream is sent from one MenloRadioSerial to another over a
+// pair of MenloRadioLoopback radios timed as a 1 Mbps nRF24L01+. The
+// toggle protocol runs with the hardware auto acknowledge and retries
+// as it does on the radio, the windowed transport turns it off and
+// acknowledges itself. Loss applies to packets and acknowledges in
+// both directions.
+//
+// The receiver checks the stream. intact is the count received
+// before the first missing or wrong byte, and bytes/sec is of the
+// intact bytes. The stream size is fixed, iterations is not used.
+//
+
+#define RADIO_BENCH_BYTES      16384
+
+// Microseconds
+#define RADIO_BENCH_AIR_TIME   450
+#define RADIO_BENCH_ACK_TIME   250
+
+// nRF24L01+ default auto retransmit count
+#define RADIO_BENCH_RETRIES    3
+
+#define RADIO_BENCH_WINDOW     8
+
+// Milliseconds
+#define RADIO_BENCH_RETRANSMIT 10
+#define RADIO_BENCH_IDLE       200
+
+#define RADIO_BENCH_INPUT_SIZE 255
+
+static uint8_t
+BenchRadioPattern(unsigned long index)
+{
+    return (uint8_t)((index * 131) + (index >> 8));
+}
+
+static void
+BenchRadioPass(uint8_t lossRate, bool useWindow)
+{
+    MenloRadioLoopback* radios;
+    MenloRadioSerial* serials;
+    uint8_t* input;
+    MenloRadioSerialWindow* windowStates;
+    uint8_t* windows;
+    unsigned long sent = 0;
+    unsigned long received = 0;
+    unsigned long intact = 0;
+    bool streamError = false;
+    unsigned long chunk;
+    int c;
+    uint64_t start;
+    uint64_t now;
+    uint64_t lastProgress;
+    uint64_t elapsed;
+    char name[32];
+
+    //
+    // MenloRadioSerial registers a PollEvent that is never removed
+    // so these stay allocated, and idle, on the static poll lists.
+    //
+    radios = new MenloRadioLoopback[2];
+    serials = new MenloRadioSerial[2];
+    input = new uint8_t[2 * RADIO_BENCH_INPUT_SIZE];
+    windowStates = new MenloRadioSerialWindow[2];
+    windows = new uint8_t[4 * RADIO_BENCH_WINDOW * MENLO_RADIO_PACKET_SIZE];
+
+    radios[0].Initialize(&radios[1]);
+    radios[1].Initialize(&radios[0]);
+
+    for (int i = 0; i < 2; i++) {
+
+        radios[i].SetLossRate(lossRate, i + 1);
+
+        radios[i].SetLinkTiming(
+            RADIO_BENCH_AIR_TIME,
+            useWindow ? 0 : RADIO_BENCH_ACK_TIME,
+            RADIO_BENCH_RETRIES
+            );
+
+        serials[i].Initialize(
+            &radios[i],
+            NULL,
+            &input[i * RADIO_BENCH_INPUT_SIZE],
+            RADIO_BENCH_INPUT_SIZE,
+            MENLO_RADIO_PACKET_SIZE,
+            0
+            );
+
+        serials[i].EnableReceive(true);
+
+        if (useWindow) {
+            serials[i].EnableWindow(
+                &windowStates[i],
+                &windows[(i * 2) * RADIO_BENCH_WINDOW * MENLO_RADIO_PACKET_SIZE],
+                &windows[((i * 2) + 1) * RADIO_BENCH_WINDOW * MENLO_RADIO_PACKET_SIZE],
+                RADIO_BENCH_WINDOW,
+                RADIO_BENCH_RETRANSMIT
+                );
+        }
+    }
+
+    // Negotiation is not timed
+    if (useWindow) {
+
+        start = NowNanoseconds();
+
+        while (!serials[0].IsWindowActive() || !serials[1].IsWindowActive()) {
+
+            if ((NowNanoseconds() - start) > (RADIO_BENCH_IDLE * 1000000ULL)) {
+                break;
+            }
+
+            MenloDispatchObject::loop(0);
+        }
+    }
+
+    start = NowNanoseconds();
+    lastProgress = start;
+
+    for (;;) {
+
+        //
+        // Write a packet worth per pass as an application
+        // returning to the dispatch loop would.
+        //
+        chunk = serials[0].IsWindowActive() ?
+            WINDOW_DATA_PACKET_MAX_SIZE : DATA_PACKET_MAX_SIZE;
+
+        while ((chunk != 0) && (sent < RADIO_BENCH_BYTES)) {
+
+            if (serials[0].write(BenchRadioPattern(sent)) != 1) {
+                break;
+            }
+
+            sent++;
+            chunk--;
+            lastProgress = NowNanoseconds();
+        }
+
+        MenloDispatchObject::loop(0);
+
+        while ((c = serials[1].read()) != -1) {
+
+            if (!streamError && ((uint8_t)c != BenchRadioPattern(received))) {
+                streamError = true;
+            }
+
+            received++;
+
+            if (!streamError) {
+                intact = received;
+            }
+
+            lastProgress = NowNanoseconds();
+        }
+
+        if (received >= RADIO_BENCH_BYTES) {
+            break;
+        }
+
+        // Lost data never arrives
+        now = NowNanoseconds();
+        if ((now - lastProgress) > (RADIO_BENCH_IDLE * 1000000ULL)) {
+            break;
+        }
+    }
+
+    elapsed = lastProgress - start;
+
+    snprintf(name, sizeof(name), "radio_%s_loss%u",
+        serials[0].IsWindowActive() ? "window" : "toggle", lossRate);
+
+    printf("%s: bytes=%d received=%lu intact=%lu us=%llu bytes/sec=%.0f packets=%lu drops=%lu retransmits=%lu\n",
+        name,
+        RADIO_BENCH_BYTES,
+        received,
+        intact,
+        (unsigned long long)(elapsed / 1000ULL),
+        (elapsed != 0) ? ((double)intact * 1000000000.0 / (double)elapsed) : 0.0,
+        radios[0].GetTransmitCount() + radios[1].GetTransmitCount(),
+        radios[0].GetDropCount() + radios[1].GetDropCount(),
+        serials[0].GetRetransmitCount()
+        );
+}
+
+//
+// Dweet replies written in parts across dispatch loop passes as an
+// application building a reply from several events would. Without
+// coalescing each part goes out as its own full size packet, with it
+// the parts share packets up to the end of the line and the radio
+// sends only the valid bytes.
+//
+
+#define RADIO_BENCH_REPLIES 200
+
+// Milliseconds a partial line waits for the rest of its reply
+#define RADIO_BENCH_FLUSH_TIMEOUT 10
+
+static const char* const g_benchRadioReplyParts[] = {
+    "$PDWT,GETSTATE_REPLY=",
+    "TEMPERATURE:72.5",
+    "*3C\r\n"
+};
+
+static void
+BenchRadioCoalescePass(bool coalesce)
+{
+    MenloRadioLoopback* radios;
+    MenloRadioSerial* serials;
+    uint8_t* input;
+    unsigned long expected = 0;
+    unsigned long received = 0;
+    unsigned long part;
+    const char* p;
+    int c;
+    uint64_t start;
+    uint64_t elapsed;
+    const char* name = coalesce ? "radio_coalesce" : "radio_nocoalesce";
+
+    // Left on the static poll lists, see BenchRadioPass()
+    radios = new MenloRadioLoopback[2];
+    serials = new MenloRadioSerial[2];
+    input = new uint8_t[2 * RADIO_BENCH_INPUT_SIZE];
+
+    radios[0].Initialize(&radios[1]);
+    radios[1].Initialize(&radios[0]);
+
+    for (int i = 0; i < 2; i++) {
+
+        radios[i].SetLinkTiming(
+            RADIO_BENCH_AIR_TIME,
+            RADIO_BENCH_ACK_TIME,
+            RADIO_BENCH_RETRIES
+            );
+
+        radios[i].SetVariableLength(coalesce);
+
+        serials[i].Initialize(
+            &radios[i],
+            NULL,
+            &input[i * RADIO_BENCH_INPUT_SIZE],
+            RADIO_BENCH_INPUT_SIZE,
+            MENLO_RADIO_PACKET_SIZE,
+            0
+            );
+
+        // The default sends every partial packet at the next Poll()
+        if (coalesce) {
+            serials[i].SetFlushPolicy(MENLO_RADIO_PACKET_SIZE, RADIO_BENCH_FLUSH_TIMEOUT);
+        }
+
+        serials[i].EnableReceive(true);
+    }
+
+    start = NowNanoseconds();
+
+    for (unsigned long i = 0; i < RADIO_BENCH_REPLIES; i++) {
+
+        for (part = 0; part < sizeof(g_benchRadioReplyParts) / sizeof(char*); part++) {
+
+            p = g_benchRadioReplyParts[part];
+
+            serials[0].write((const uint8_t*)p, strlen(p));
+            expected += strlen(p);
+
+            MenloDispatchObject::loop(0);
+
+            while ((c = serials[1].read()) != -1) {
+                received++;
+            }
+        }
+    }
+
+    // The last reply ends a line and goes out on the next pass
+    while (received < expected) {
+
+        if ((NowNanoseconds() - start) > ((uint64_t)RADIO_BENCH_IDLE * 1000000ULL * 10)) {
+            break;
+        }
+
+        MenloDispatchObject::loop(0);
+
+        while ((c = serials[1].read()) != -1) {
+            received++;
+        }
+    }
+
+    elapsed = NowNanoseconds() - start;
+
+    printf("%s: replies=%d bytes=%lu received=%lu us=%llu packets=%lu packets/reply=%.2f air_bytes=%lu\n",
+        name,
+        RADIO_BENCH_REPLIES,
+        expected,
+        received,
+        (unsigned long long)(elapsed / 1000ULL),
+        radios[0].GetTransmitCount(),
+        (double)radios[0].GetTransmitCount() / (double)RADIO_BENCH_REPLIES,
+        radios[0].GetTransmitBytes()
+        );
+}
+
+//
+// Dweet round trips from the gateway to a sensor and back.
+//
+// NMEA 0183 sends the sentence over RadioSerial to a DweetSerialChannel
+// on the sensor, as the host does today through T= and R= Dweets.
+// Binary sends D= to DweetRadio on the gateway's serial channel,
+// one packet each way to a DweetRadioChannel on the sensor, with the
+// reply translated back to ASCII by the gateway.
+//
+// node_bytes is what the sensor receives and parses per command.
+//
+
+#define RADIO_BENCH_DWEETS 200
+
+static bool
+BenchRadioDweetWait(MenloHostStream* stream, const char* output, int lines)
+{
+    uint64_t start = NowNanoseconds();
+    int count;
+
+    for (;;) {
+
+        MenloDispatchObject::loop(0);
+
+        count = 0;
+
+        for (size_t i = 0; i < stream->GetOutputCount(); i++) {
+            if (output[i] == '\n') count++;
+        }
+
+        if (count >= lines) {
+            return true;
+        }
+
+        if ((NowNanoseconds() - start) > (RADIO_BENCH_IDLE * 1000000ULL)) {
+            return false;
+        }
+    }
+}
+
+static void
+BenchRadioDweetPass(bool binary)
+{
+    MenloRadioLoopback* radios;
+    MenloRadioSerial* serials;
+    MenloHostStream* stream;
+    DweetSerialChannel* channel;
+    DweetRadio* dweetRadio;
+    DweetRadioChannel* radioChannel;
+    uint8_t* input;
+    uint8_t packet[MENLO_RADIO_PACKET_SIZE];
+    char output[84];
+    char sentence[84];
+    char reply[256];
+    MenloNMEA0183 nmea;
+    int length;
+    int nodeBytes;
+    int c;
+    unsigned long completed = 0;
+    uint64_t start;
+    uint64_t elapsed;
+    const char* name = binary ? "radio_dweet_binary" : "radio_dweet_nmea";
+
+    // Left on the static poll lists, see BenchRadioPass()
+    radios = new MenloRadioLoopback[2];
+    stream = new MenloHostStream();
+    channel = new DweetSerialChannel();
+
+    radios[0].Initialize(&radios[1]);
+    radios[1].Initialize(&radios[0]);
+
+    for (int i = 0; i < 2; i++) {
+        radios[i].SetLinkTiming(
+            RADIO_BENCH_AIR_TIME,
+            RADIO_BENCH_ACK_TIME,
+            RADIO_BENCH_RETRIES
+            );
+    }
+
+    nmea.Initialize((char*)"$PDWT", output, sizeof(output));
+
+    if (binary) {
+
+        length = BuildSentence(&nmea, "D=0:GETSTATE=TRACELEVEL", sentence, sizeof(sentence));
+
+        nodeBytes = DweetRadio::EncodeRadioDweet(
+            MENLO_RADIO_DWEET, (char*)"GETSTATE=TRACELEVEL", packet);
+
+        // DweetRadio reports its stored settings on the debug port
+        static MenloHostStream debugStream;
+        MenloDebug::Init(&debugStream);
+
+        // Gateway
+        dweetRadio = new DweetRadio();
+        channel->Initialize(stream, (char*)"$PDWT");
+        dweetRadio->Initialize(channel, &radios[0]);
+        dweetRadio->EnableReceiveDweetStream(true);
+
+        // Sensor
+        radioChannel = new DweetRadioChannel();
+        radioChannel->Initialize(&radios[1], (char*)"$PDWT", 0);
+    }
+    else {
+
+        length = BuildSentence(&nmea, "GETSTATE=TRACELEVEL", sentence, sizeof(sentence));
+
+        nodeBytes = length;
+
+        serials = new MenloRadioSerial[2];
+        input = new uint8_t[2 * RADIO_BENCH_INPUT_SIZE];
+
+        for (int i = 0; i < 2; i++) {
+
+            serials[i].Initialize(
+                &radios[i],
+                NULL,
+                &input[i * RADIO_BENCH_INPUT_SIZE],
+                RADIO_BENCH_INPUT_SIZE,
+                MENLO_RADIO_PACKET_SIZE,
+                0
+                );
+
+            serials[i].EnableReceive(true);
+        }
+
+        // Sensor
+        channel->Initialize(&serials[1], (char*)"$PDWT");
+    }
+
+    start = NowNanoseconds();
+
+    for (unsigned long i = 0; i < RADIO_BENCH_DWEETS; i++) {
+
+        if (binary) {
+
+            stream->SetInput((uint8_t*)sentence, length);
+            stream->SetOutput((uint8_t*)reply, sizeof(reply));
+
+            // D_REPLY=0 then D=0:GETSTATE_REPLY=TRACELEVEL:00
+            if (!BenchRadioDweetWait(stream, reply, 2)) {
+                break;
+            }
+        }
+        else {
+
+            serials[0].write((const uint8_t*)sentence, length);
+
+            uint64_t wait = NowNanoseconds();
+            c = -1;
+
+            while (c != '\n') {
+
+                if ((NowNanoseconds() - wait) > (RADIO_BENCH_IDLE * 1000000ULL)) {
+                    break;
+                }
+
+                MenloDispatchObject::loop(0);
+
+                while ((c = serials[0].read()) != -1) {
+                    if (c == '\n') break;
+                }
+            }
+
+            if (c != '\n') {
+                break;
+            }
+        }
+
+        completed++;
+    }
+
+    elapsed = NowNanoseconds() - start;
+
+    printf("%s: dweets=%d completed=%lu us=%llu us/dweet=%.0f packets/dweet=%.2f air_bytes/dweet=%.1f node_bytes=%d\n",
+        name,
+        RADIO_BENCH_DWEETS,
+        completed,
+        (unsigned long long)(elapsed / 1000ULL),
+        (completed != 0) ? ((double)elapsed / 1000.0 / (double)completed) : 0.0,
+        (double)(radios[0].GetTransmitCount() + radios[1].GetTransmitCount()) / (double)RADIO_BENCH_DWEETS,
+        (double)(radios[0].GetTransmitBytes() + radios[1].GetTransmitBytes()) / (double)RADIO_BENCH_DWEETS,
+        nodeBytes
+        );
+
+    if (binary) {
+        printf("%s: gateway serial=%.*s", name, (int)stream->GetOutputCount(), reply);
+    }
+}
+
+static void
+BenchRadio(unsigned long iterations)
+{
+    static const uint8_t lossRates[] = { 0, 1, 5, 10, 20 };
+
+    for (unsigned int i = 0; i < sizeof(lossRates); i++) {
+        BenchRadioPass(lossRates[i], false);
+        BenchRadioPass(lossRates[i], true);
+    }
+
+    BenchRadioCoalescePass(false);
+    BenchRadioCoalescePass(true);
+
+    BenchRadioDweetPass(false);
+    BenchRadioDweetPass(true);
+}
+
+//
+// Gateway receive from many sensor nodes reporting at the same time.
+//
+// GATEWAY_BENCH_NODES nodes each send one sensor data packet to a
+// gateway MenloRadioLoopback whose receive queue is limited to the
+// 3 entry FIFO of the nRF24L01+. Node 1 sends a burst of
+// GATEWAY_BENCH_BURST packets first. Packets arrive one every
+// GATEWAY_BENCH_SPACING microseconds, about the air time of a full
+// packet with acknowledge at 2 Mbps, whatever the gateway is doing.
+// The nodes report again every GATEWAY_BENCH_INTERVAL.
+//
+// The gateway forwards them upstream as R= Dweets on a serial
+// port that takes GATEWAY_BENCH_BYTE_TIME per byte to send.
+//
+// direct forwards from the radio receive event as DweetRadio did.
+// scheduled forwards through MenloRadioReceiveScheduler.
+// _irq receives through the radio's interrupt ring rather than
+// polling it on each pass of the dispatch loop.
+//
+// fifo_lost is lost at the radio, sched_dropped by the scheduler.
+// ready_checks is calls to ReceiveDataReady() while the nodes are
+// sending, each an SPI status read on a polled nRF24L01+.
+// quiet_min is the fewest packets delivered for any node but node 1,
+// of GATEWAY_BENCH_ROUNDS sent by each.
+//
+
+#define GATEWAY_BENCH_NODES   50
+#define GATEWAY_BENCH_BURST   8
+#define GATEWAY_BENCH_ROUNDS  4
+#define GATEWAY_BENCH_FIFO    3
+
+// Microseconds
+#define GATEWAY_BENCH_SPACING   400
+#define GATEWAY_BENCH_INTERVAL  100000
+#define GATEWAY_BENCH_BYTE_TIME 10
+
+#define GATEWAY_BENCH_PACKETS \
+    (GATEWAY_BENCH_ROUNDS * (GATEWAY_BENCH_NODES + GATEWAY_BENCH_BURST - 1))
+
+#define GATEWAY_BENCH_OUTPUT_SIZE (GATEWAY_BENCH_PACKETS * 84)
+
+//
+// Sends the node packets at their arrival times from the dispatch
+// loop, and from BenchSerialStream so they keep arriving while the
+// gateway is blocked forwarding.
+//
+class BenchGatewayNodes : public MenloDispatchObject {
+public:
+
+    BenchGatewayNodes() {
+        m_nodes = NULL;
+        m_sent = 0;
+    }
+
+    void Start(MenloRadioLoopback* nodes) {
+        m_nodes = nodes;
+        m_sent = 0;
+        m_start = NowNanoseconds();
+    }
+
+    bool Done() {
+        return (m_sent == GATEWAY_BENCH_PACKETS);
+    }
+
+    virtual unsigned long Poll() {
+        Send();
+        return Done() ? MAX_POLL_TIME : 0;
+    }
+
+    void Send() {
+        uint8_t packet[MENLO_RADIO_PACKET_SIZE];
+        uint64_t now;
+        unsigned long perRound;
+        unsigned long index;
+        unsigned long due;
+        int node;
+
+        if (m_nodes == NULL) {
+            return;
+        }
+
+        now = NowNanoseconds();
+        perRound = GATEWAY_BENCH_NODES + GATEWAY_BENCH_BURST - 1;
+
+        while (!Done()) {
+
+            index = m_sent % perRound;
+
+            due = ((m_sent / perRound) * GATEWAY_BENCH_INTERVAL) +
+                (index * GATEWAY_BENCH_SPACING);
+
+            if ((now - m_start) < (due * 1000ULL)) {
+                break;
+            }
+
+            node = (index < GATEWAY_BENCH_BURST) ? 0 : (index - GATEWAY_BENCH_BURST + 1);
+
+            memset(packet, 0, sizeof(packet));
+            packet[0] = MENLO_RADIO_SENSOR_DATA;
+            packet[1] = MENLO_RADIO_APPLICATION_WEATHER_STATION;
+            packet[2] = (uint8_t)(node + 1);
+            packet[3] = (uint8_t)(m_sent / perRound);
+
+            m_nodes[node].Write(NULL, packet, sizeof(packet), 0);
+
+            m_sent++;
+        }
+    }
+
+private:
+
+    MenloRadioLoopback* m_nodes;
+    unsigned long m_sent;
+    uint64_t m_start;
+};
+
+//
+// Serial port that blocks for the time to send what is written,
+// as HardwareSerial does once its buffer is full.
+//
+// The nodes keep sending while it blocks.
+//
+class BenchSerialStream : public MenloHostStream {
+public:
+
+    BenchSerialStream(BenchGatewayNodes* nodes) {
+        m_nodes = nodes;
+    }
+
+    virtual size_t write(uint8_t c) {
+        Spin(1);
+        return MenloHostStream::write(c);
+    }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        Spin(size);
+        return MenloHostStream::write(buffer, size);
+    }
+
+private:
+
+    void Spin(size_t bytes) {
+        uint64_t end = NowNanoseconds() + (bytes * GATEWAY_BENCH_BYTE_TIME * 1000ULL);
+
+        while (NowNanoseconds() < end) {
+            m_nodes->Send();
+        }
+    }
+
+    BenchGatewayNodes* m_nodes;
+};
+
+static void
+BenchGatewayPass(bool scheduled, bool interrupt)
+{
+    MenloRadioLoopback* nodes;
+    MenloRadioLoopback* gateway;
+    MenloRadioReceiveRing* receiveRing = NULL;
+    MenloRadioReceiveScheduler* scheduler = NULL;
+    BenchSerialStream* stream;
+    DweetSerialChannel* channel;
+    DweetRadio* dweetRadio;
+    BenchGatewayNodes* arrivals;
+    char* output;
+    const char* line;
+    const char* end;
+    int delivered[GATEWAY_BENCH_NODES + 1];
+    unsigned long forwarded = 0;
+    unsigned long readyChecks;
+    int quietMin;
+    int source;
+    uint64_t start;
+    uint64_t elapsed;
+    const char* name;
+
+    if (scheduled) {
+        name = interrupt ? "gateway_scheduled_irq" : "gateway_scheduled";
+    }
+    else {
+        name = interrupt ? "gateway_direct_irq" : "gateway_direct";
+    }
+
+    // DweetRadio reports its stored settings on the debug port
+    static MenloHostStream debugStream;
+    MenloDebug::Init(&debugStream);
+
+    // Left on the static poll lists, see BenchRadioPass()
+    nodes = new MenloRadioLoopback[GATEWAY_BENCH_NODES];
+    gateway = new MenloRadioLoopback();
+    arrivals = new BenchGatewayNodes();
+    stream = new BenchSerialStream(arrivals);
+    channel = new DweetSerialChannel();
+    dweetRadio = new DweetRadio();
+
+    output = new char[GATEWAY_BENCH_OUTPUT_SIZE];
+
+    gateway->Initialize(&nodes[0]);
+    gateway->SetReceiveQueueDepth(GATEWAY_BENCH_FIFO);
+
+    if (interrupt) {
+        receiveRing = new MenloRadioReceiveRing();
+        gateway->AttachReceiveInterrupt(receiveRing);
+    }
+
+    for (int i = 0; i < GATEWAY_BENCH_NODES; i++) {
+        nodes[i].Initialize(gateway);
+        nodes[i].SetSourceAddress((uint8_t)(i + 1));
+    }
+
+    stream->SetOutput((uint8_t*)output, GATEWAY_BENCH_OUTPUT_SIZE);
+    channel->Initialize(stream, (char*)"$PDWT");
+
+    if (scheduled) {
+        scheduler = new MenloRadioReceiveScheduler();
+        scheduler->Initialize(gateway, MENLO_RADIO_RECEIVE_SCHEDULER_BATCH);
+        dweetRadio->Initialize(channel, gateway, scheduler);
+    }
+    else {
+        dweetRadio->Initialize(channel, gateway);
+    }
+
+    dweetRadio->EnableReceiveDweetStream(true);
+
+    start = NowNanoseconds();
+
+    arrivals->Start(nodes);
+
+    while (!arrivals->Done()) {
+        MenloDispatchObject::loop(0);
+    }
+
+    readyChecks = gateway->GetReadyCount();
+
+    while (gateway->ReceiveDataReady() ||
+           ((scheduler != NULL) && (scheduler->GetQueuedCount() != 0))) {
+        MenloDispatchObject::loop(0);
+    }
+
+    elapsed = NowNanoseconds() - start;
+
+    // Count what reached the host for each node, R=0:C210nn...
+    memset(delivered, 0, sizeof(delivered));
+
+    line = output;
+    end = output + stream->GetOutputCount();
+
+    while ((line = (const char*)memmem(line, end - line, "R=0:", 4)) != NULL) {
+
+        line += 4;
+
+        if ((end - line) < 6) {
+            break;
+        }
+
+        source = MenloUtility::HexToByte((char*)&line[4]);
+        if ((source >= 1) && (source <= GATEWAY_BENCH_NODES)) {
+            delivered[source]++;
+        }
+
+        forwarded++;
+    }
+
+    quietMin = GATEWAY_BENCH_ROUNDS;
+
+    for (int i = 2; i <= GATEWAY_BENCH_NODES; i++) {
+        if (delivered[i] < quietMin) {
+            quietMin = delivered[i];
+        }
+    }
+
+    printf("%s: nodes=%d sent=%d forwarded=%lu fifo_lost=%lu sched_dropped=%lu max_queued=%d burst_node=%d/%d quiet_min=%d/%d ready_checks=%lu ms=%.1f\n",
+        name,
+        GATEWAY_BENCH_NODES,
+        GATEWAY_BENCH_PACKETS,
+        forwarded,
+        gateway->GetOverflowCount(),
+        (scheduler != NULL) ? scheduler->GetDropCount() : 0UL,
+        (scheduler != NULL) ? scheduler->GetMaxQueuedCount() : 0,
+        delivered[1],
+        GATEWAY_BENCH_ROUNDS * GATEWAY_BENCH_BURST,
+        quietMin,
+        GATEWAY_BENCH_ROUNDS,
+        readyChecks,
+        (double)elapsed / 1000000.0
+        );
+}
+
+static void
+BenchGateway(unsigned long iterations)
+{
+    BenchGatewayPass(false, false);
+    BenchGatewayPass(true, false);
+    BenchGatewayPass(false, true);
+    BenchGatewayPass(true, true);
+}
+
+int
+main(int argc, char** argv)
+{
+    const char* mode = "all";
+    unsigned long iterations = DEFAULT_ITERATIONS;
+    bool all;
+
+    if (argc > 1) {
+        mode = argv[1];
+    }
+
+    if (argc > 2) {
+        iterations = strtoul(argv[2], NULL, 0);
+        if (iterations == 0) iterations = DEFAULT_ITERATIONS;
+    }
+
+    all = (strcmp(mode, "all") == 0);
+
+    if (all || (strcmp(mode, "nmea") == 0)) {
+        BenchNMEA(iterations);
+    }
+
+    if (all || (strcmp(mode, "lookup") == 0)) {
+        BenchLookup(iterations);
+    }
+
+    if (all || (strcmp(mode, "dweet") == 0)) {
+        BenchDweet(iterations);
+    }
+
+    if (all || (strcmp(mode, "timer") == 0)) {
+        BenchTimer(iterations);
+    }
+
+    if (all || (strcmp(mode, "profile") == 0)) {
+        BenchProfile(iterations);
+    }
+
+    if (all || (strcmp(mode, "radio") == 0)) {
+        BenchRadio(iterations);
+    }
+
+    if (all || (strcmp(mode, "gateway") == 0)) {
+        BenchGateway(iterations);
+    }
+
+    //
+    // This is last since the objects from the dweet mode
+    // stay on the static poll list.
+    //
+    if (all || (strcmp(mode, "dispatch") == 0)) {
+        BenchDispatch(iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+;
+; Loader benchmark program for menlo_cnc_app bench_assembler_file.
+;
+; Short 40us blocks, 25,000 blocks/sec, repeated with -repeat to
+; measure whether the loader sustains the rate without underruns.
+;
+; 100khz pulse rate, 4 pulses per block, all axis in lock step.
+;
+
+begin
+  INFO_X, HEADER, 1, 0, 0
+  INFO_Y, CONFIG, 4, 0x00000000, 0x00000000
+  INFO_Z, CONFIG, 0, 0, 0
+  INFO_A, CONFIG, 0, 0, 0
+end
+
+begin
+  X, CW,    100khz, 4, 2us
+  Y, CCW,   100khz, 4, 2us
+  Z, CW,    100khz, 4, 2us
+  A, DWELL, 100khz, 4, 0
+end
+
+begin
+  X, CCW,   100khz, 4, 2us
+  Y, CW,    100khz, 4, 2us
+  Z, CCW,   100khz, 4, 2us
+  A, DWELL, 100khz, 4, 0
+end
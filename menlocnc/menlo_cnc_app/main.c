@@ -12,6 +12,8 @@ refer to user manual chapter 7 for details about the demo
 */
 
 
+#define _GNU_SOURCE // pthread_setaffinity_np
+
 #include <stdio.h>
 #include <string.h> // strcmp
 #include <stdlib.h> // strtof
@@ -19,27 +21,114 @@ refer to user manual chapter 7 for details about the demo
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#if MENLO_CNC_SIMULATOR
+#include <stdbool.h>
+#include <stdint.h>
+#else
 #include "hwlib.h"
 #include "socal/socal.h"
 #include "socal/hps.h"
 #include "socal/alt_gpio.h"
+#endif
+
 #include "hps_0.h"
 
 #include "menlo_cnc.h"
+#include "menlo_cnc_ring.h"
+
+#if MENLO_CNC_SIMULATOR
+#include "menlo_cnc_sim.h"
+#endif
 
 // Include the assembler
 #include "menlo_cnc_asm.h"
 
+// Include the G-code compiler
+#include "menlo_cnc_gcode.h"
+
 #define HW_REGS_BASE ( ALT_STM_OFST ) // 0xfc000000
 #define HW_REGS_SPAN ( 0x04000000 )
 #define HW_REGS_MASK ( HW_REGS_SPAN - 1 )
 
+//
+// Pipelined feeder, see stream_instructions_pipelined()
+//
+
+// Converted blocks buffered ahead of the consumer, must be a power of 2
+#define FEEDER_RING_SIZE 1024
+
+// Producer resumes once a full ring has drained to this
+#define FEEDER_RING_LOW_WATER (FEEDER_RING_SIZE / 2)
+
+// Producer sleep while waiting for the ring to drain
+#define FEEDER_PRODUCER_SLEEP_US 100
+
+// Core the consumer is pinned to, core 0 takes most interrupts
+#define FEEDER_DEFAULT_CORE 1
+
+// Time ring_consumer waits for feed_ring to create the shared ring
+#define RING_CONSUMER_OPEN_RETRIES  1000
+#define RING_CONSUMER_OPEN_SLEEP_US 10000
+
+//
+// Batched loader, see stream_instructions_batched()
+//
+
+// Blocks per batch for -batch without a count
+#define LOADER_BATCH_DEFAULT 32
+
+#if MENLO_CNC_SIMULATOR
+#define LOADER_FIFO_CAPACITY sim_fifo_depth
+#else
+#define LOADER_FIFO_CAPACITY MENLO_CNC_FIFO_CAPACITY
+#endif
+
+typedef struct _FEEDER_CONTEXT {
+  PMENLO_CNC_RING ring;
+  PBLOCK_ARRAY binary;
+} FEEDER_CONTEXT, *PFEEDER_CONTEXT;
+
 void usage();
 
 int
 run_assembler_file(
     void* menlo_cnc_registers_base_address,
-    char *fileName
+    char *fileName,
+    int pipelined,
+    int batch,
+    int core
+    );
+
+int
+run_binary_file(
+    void* menlo_cnc_registers_base_address,
+    char *fileName,
+    int pipelined,
+    int batch,
+    int core
+    );
+
+int
+run_gcode_file(
+    void* menlo_cnc_registers_base_address,
+    char *fileName,
+    int pipelined,
+    int batch,
+    int core
+    );
+
+int
+run_instructions(
+    void* menlo_cnc_registers_base_address,
+    PBLOCK_ARRAY binary,
+    int pipelined,
+    int batch,
+    int core
     );
 
 unsigned long
@@ -48,6 +137,51 @@ stream_instructions(
     PBLOCK_ARRAY binary
     );
 
+unsigned long
+stream_instructions_pipelined(
+    void* menlo_cnc_registers_base_address,
+    PBLOCK_ARRAY binary,
+    int core
+    );
+
+unsigned long
+stream_compressed_instructions(
+    void* menlo_cnc_registers_base_address,
+    PCOMPRESSED_PROGRAM program
+    );
+
+unsigned long
+stream_instructions_batched(
+    void* menlo_cnc_registers_base_address,
+    PBLOCK_ARRAY binary,
+    int batch
+    );
+
+int
+bench_assembler_file(
+    void* menlo_cnc_registers_base_address,
+    char *fileName,
+    int binary_file,
+    int repeat,
+    int pipelined,
+    int compress,
+    int batch,
+    int core
+    );
+
+int
+run_ring_producer(
+    char *ringName,
+    char *fileName,
+    int binary_file
+    );
+
+int
+run_ring_consumer(
+    void* menlo_cnc_registers_base_address,
+    char *ringName
+    );
+
 int
 find_maximum_pulse_rate(
     void* registers
@@ -62,7 +196,22 @@ test_pulse_rate(
 unsigned long
 load_block(
     void* menlo_cnc_registers_base_address,
-    void* block
+    void* block,
+    int axis_count
+    );
+
+unsigned long
+load_block_changes(
+    void* menlo_cnc_registers_base_address,
+    void* block,
+    unsigned long long changed,
+    int axis_count
+    );
+
+void
+convert_block_binary(
+    POPCODE_BLOCK_BINARY src,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY target
     );
 
 int
@@ -81,6 +230,13 @@ test_menlo_cnc_pulse(
     char *frequency
     );
 
+#if MENLO_CNC_SIMULATOR
+int
+test_sim_underrun(
+    void* menlo_cnc_registers_base_address
+    );
+#endif
+
 int setup_hardware();
 
 int close_hardware();
@@ -88,7 +244,8 @@ int close_hardware();
 int
 validate_header_block(
     void* menlo_cnc_registers_base_address,
-    void* block
+    void* block,
+    int* axis_count
     );
 
 int memory_fd = -1;
@@ -106,6 +263,13 @@ void* ledpio_base_address = NULL;
 
 void* menlo_cnc_registers_base_address = NULL;
 
+#if MENLO_CNC_SIMULATOR
+unsigned long sim_fifo_depth = MENLO_CNC_SIM_DEFAULT_FIFO_DEPTH;
+
+// Stands in for the LED PIO register
+uint32_t sim_led_pio = 0;
+#endif
+
 int
 main(int ac, char**av)
 {
@@ -114,11 +278,25 @@ main(int ac, char**av)
         bool option_test_leds = false;
         bool option_test_cnc = false;
         bool option_test_cnc_pulse = false;
+        bool option_test_sim_underrun = false;
         bool option_run_assembler_file = false;
+        bool option_run_binary_file = false;
+        bool option_run_gcode_file = false;
+        bool option_bench_assembler_file = false;
+        bool option_feed_ring = false;
+        bool option_ring_consumer = false;
+        bool option_binary_file = false;
+        bool option_pipelined = false;
+        bool option_compress = false;
+        int batch = 0;
+        int core = FEEDER_DEFAULT_CORE;
+        int repeat = 1;
+        int index;
 
         // Default frequency
         char* frequency = "1";
         char* fileName = NULL;
+        char* ringName = NULL;
 
         if (ac == 1) {
   	    usage();
@@ -139,21 +317,181 @@ main(int ac, char**av)
 
           printf("test_cnc_pulse: using frequency=%s\n", frequency);
 	}
+#if MENLO_CNC_SIMULATOR
+	else if (strcmp("test_sim_underrun", av[1]) == 0) {
+	  option_test_sim_underrun = true;
+	}
+#endif
 	else if (strcmp("run_assembler_file", av[1]) == 0) {
           if (ac >= 3) {
 	      fileName = av[2];
           }
 	  option_run_assembler_file = true;
 
+          if ((ac >= 4) && (strcmp("-pipeline", av[3]) == 0)) {
+              option_pipelined = true;
+
+              if (ac >= 5) {
+                  core = atoi(av[4]);
+              }
+          }
+          else if ((ac >= 4) && (strcmp("-batch", av[3]) == 0)) {
+              batch = LOADER_BATCH_DEFAULT;
+
+              if (ac >= 5) {
+                  batch = atoi(av[4]);
+              }
+          }
+
           printf("run_assembler_file %s\n", fileName);
 	}
+	else if (strcmp("run_binary_file", av[1]) == 0) {
+          if (ac < 3) {
+              usage();
+          }
+
+	  fileName = av[2];
+
+	  option_run_binary_file = true;
+
+          if ((ac >= 4) && (strcmp("-pipeline", av[3]) == 0)) {
+              option_pipelined = true;
+
+              if (ac >= 5) {
+                  core = atoi(av[4]);
+              }
+          }
+          else if ((ac >= 4) && (strcmp("-batch", av[3]) == 0)) {
+              batch = LOADER_BATCH_DEFAULT;
+
+              if (ac >= 5) {
+                  batch = atoi(av[4]);
+              }
+          }
+
+          printf("run_binary_file %s\n", fileName);
+	}
+	else if (strcmp("run_gcode_file", av[1]) == 0) {
+          if (ac < 3) {
+              usage();
+          }
+
+	  fileName = av[2];
+
+	  option_run_gcode_file = true;
+
+          if ((ac >= 4) && (strcmp("-pipeline", av[3]) == 0)) {
+              option_pipelined = true;
+
+              if (ac >= 5) {
+                  core = atoi(av[4]);
+              }
+          }
+          else if ((ac >= 4) && (strcmp("-batch", av[3]) == 0)) {
+              batch = LOADER_BATCH_DEFAULT;
+
+              if (ac >= 5) {
+                  batch = atoi(av[4]);
+              }
+          }
+
+          printf("run_gcode_file %s\n", fileName);
+	}
+	else if (strcmp("bench_assembler_file", av[1]) == 0) {
+          if (ac < 3) {
+              usage();
+          }
+
+	  fileName = av[2];
+
+	  option_bench_assembler_file = true;
+
+          for (index = 3; index < ac; index++) {
+
+              if ((strcmp("-repeat", av[index]) == 0) && ((index + 1) < ac)) {
+                  repeat = atoi(av[++index]);
+              }
+              else if (strcmp("-binary", av[index]) == 0) {
+                  option_binary_file = true;
+              }
+              else if (strcmp("-compress", av[index]) == 0) {
+                  option_compress = true;
+              }
+              else if (strcmp("-batch", av[index]) == 0) {
+                  batch = LOADER_BATCH_DEFAULT;
+
+                  if (((index + 1) < ac) && (av[index + 1][0] != '-')) {
+                      batch = atoi(av[++index]);
+                  }
+              }
+#if MENLO_CNC_SIMULATOR
+              else if ((strcmp("-depth", av[index]) == 0) && ((index + 1) < ac)) {
+                  sim_fifo_depth = strtoul(av[++index], NULL, 0);
+              }
+#endif
+              else if (strcmp("-pipeline", av[index]) == 0) {
+                  option_pipelined = true;
+
+                  if (((index + 1) < ac) && (av[index + 1][0] != '-')) {
+                      core = atoi(av[++index]);
+                  }
+              }
+              else {
+                  usage();
+              }
+          }
+
+          // One loader at a time, the pipelined ring carries expanded blocks
+          if ((option_compress + option_pipelined + (batch > 0)) > 1) {
+              usage();
+          }
+
+          printf("bench_assembler_file %s repeat %d\n", fileName, repeat);
+	}
+	else if (strcmp("feed_ring", av[1]) == 0) {
+          if (ac < 4) {
+              usage();
+          }
+
+	  ringName = av[2];
+	  fileName = av[3];
+
+	  option_feed_ring = true;
+
+          if ((ac >= 5) && (strcmp("-binary", av[4]) == 0)) {
+              option_binary_file = true;
+          }
+
+          printf("feed_ring %s %s\n", ringName, fileName);
+	}
+	else if (strcmp("ring_consumer", av[1]) == 0) {
+          if (ac < 3) {
+              usage();
+          }
+
+	  ringName = av[2];
+
+	  option_ring_consumer = true;
+
+          printf("ring_consumer %s\n", ringName);
+	}
 	else {
   	    printf("menlo_cnc_app [test_leds] | [test_cnc] [test_cnc_pulse] [frequency]\n");
             return 1;
 	}
 
+        //
+        // The ring producer only converts instructions, the hardware
+        // belongs to the ring_consumer process.
+        //
+        if (option_feed_ring) {
+            return run_ring_producer(ringName, fileName, option_binary_file);
+        }
+
         // Setup the hardware
-        setup_hardware();
+        if (setup_hardware() != 0) {
+            return 1;
+        }
 
         if (option_test_leds) {
             retValue = test_leds(ledpio_base_address);
@@ -167,8 +505,60 @@ main(int ac, char**av)
 	   retValue = test_menlo_cnc_pulse(menlo_cnc_registers_base_address, frequency);
         }
 
+#if MENLO_CNC_SIMULATOR
+        if (option_test_sim_underrun) {
+	   retValue = test_sim_underrun(menlo_cnc_registers_base_address);
+        }
+#endif
+
         if (option_run_assembler_file) {
-	   retValue = run_assembler_file(menlo_cnc_registers_base_address, fileName);
+	   retValue = run_assembler_file(
+               menlo_cnc_registers_base_address,
+               fileName,
+               option_pipelined,
+               batch,
+               core
+               );
+        }
+
+        if (option_run_binary_file) {
+	   retValue = run_binary_file(
+               menlo_cnc_registers_base_address,
+               fileName,
+               option_pipelined,
+               batch,
+               core
+               );
+        }
+
+        if (option_run_gcode_file) {
+	   retValue = run_gcode_file(
+               menlo_cnc_registers_base_address,
+               fileName,
+               option_pipelined,
+               batch,
+               core
+               );
+        }
+
+        if (option_bench_assembler_file) {
+	   retValue = bench_assembler_file(
+               menlo_cnc_registers_base_address,
+               fileName,
+               option_binary_file,
+               repeat,
+               option_pipelined,
+               option_compress,
+               batch,
+               core
+               );
+        }
+
+        if (option_ring_consumer) {
+	   retValue = run_ring_consumer(
+               menlo_cnc_registers_base_address,
+               ringName
+               );
         }
 
         close_hardware();
@@ -179,6 +569,24 @@ main(int ac, char**av)
 int
 setup_hardware()
 {
+#if MENLO_CNC_SIMULATOR
+
+    //
+    // Simulated timing generator register file, see menlo_cnc_sim.h
+    //
+    menlo_cnc_registers_base_address = menlo_cnc_sim_create(sim_fifo_depth);
+    if (menlo_cnc_registers_base_address == NULL) {
+	    printf( "ERROR: could not create simulated registers depth %ld\n", sim_fifo_depth);
+	    return( 1 );
+    }
+
+    ledpio_base_address = &sim_led_pio;
+
+    printf("simulated menlo_cnc_registers fifo depth %ld\n", sim_fifo_depth);
+
+    return 0;
+
+#else
 
     //
     // Hardware specific setup is here.
@@ -296,11 +704,17 @@ setup_hardware()
     printf("menlo_cnc_registers_base_address=0x%lx\n", (unsigned long)menlo_cnc_registers_base_address);
 
     return 0;
+#endif
 }
 
 int
 close_hardware()
 {
+#if MENLO_CNC_SIMULATOR
+    menlo_cnc_sim_destroy(menlo_cnc_registers_base_address);
+
+    return 0;
+#else
 
     //
     // clean up our memory mapping and exit
@@ -314,6 +728,7 @@ close_hardware()
     close( memory_fd );
 
     return 0;
+#endif
 }
 
 //
@@ -331,6 +746,7 @@ stream_instructions(
     )
 {
   int ret;
+  int axis_count;
   unsigned long status;
   void *block;
   unsigned long instruction_block_count;
@@ -399,7 +815,7 @@ stream_instructions(
     return EBADF;
   }
 
-  ret = validate_header_block(registers, block);
+  ret = validate_header_block(registers, block, &axis_count);
   if (ret != 0) {
     printf("No HEADER block at start of instruction stream\n");
     return ret;
@@ -455,139 +871,1245 @@ stream_instructions(
   // stream, then non-real time cleanup.
   //
 
-  //
-  // Real time loop is defined as streaming commands from memory
-  // until there are no more, without an underrun condition occuring.
-  //
+  //
+  // Real time loop is defined as streaming commands from memory
+  // until there are no more, without an underrun condition occuring.
+  //
+
+  //
+  // Begin Run
+  //
+
+  status = 0;
+
+  instruction_block_count = 0;
+
+  underrun_errors = 0;
+
+  //
+  // Clear Sticky FIFO Underrun before entring the real time loop.
+  //
+  // This gets set if the FIFO's go empty once the first instruction
+  // has been loaded.
+  //
+  menlo_cnc_registers_reset_sfe(registers);
+
+  //
+  // Begin real time Loop
+  //
+  while (1) {
+
+    //
+    // Note: instruction counts can be reduced by inlining, macro's,
+    // etc. for status test, bumping through the sequential array, etc.
+    //
+    // These are considerations if this inner loop moves to a weaker embedded
+    // soft processor such as a Nios II.
+    //
+    // The ARM SoC's have plently of instruction execution rate, its
+    // just that their environment is more prone to interruptions
+    // and pauses by both system and internal chip processes.
+    //
+
+    block = block_array_get_next_entry(binary);
+    if (block == NULL) {
+      printf("No more instruction entries in block array, loaded %ld blocks\n",
+      instruction_block_count);
+      // status is set from last load, or initial value if array is empty.
+      goto Done;
+    }
+
+    instruction_block_count++;
+
+    status = load_block(registers, block, axis_count);
+    if (menlo_cnc_registers_is_error(status)) {
+      printf("error %ld loading block 0x%lx\n", status, instruction_block_count);
+      goto Done;
+    }
+
+    if (menlo_cnc_registers_is_underrun(status)) {
+
+      // Just report it, don't abort
+      printf("underrun occurred status 0x%lx at instruction block %ld\n",
+	     status, instruction_block_count);
+
+      underrun_errors++;
+
+      // Rearm it
+      menlo_cnc_registers_reset_sfe(registers);
+    }
+  }
+
+  //
+  // End real time Loop
+  //
+
+  //
+  // End Run
+  //
+
+Done:
+
+  printf("instruction block count %ld, underrun errors %ld, status 0x%ld\n",
+    instruction_block_count,
+    underrun_errors,
+    status);
+
+  return status;
+}
+
+//
+// Run the in memory binary instruction stream on the machine in a real
+// time loop, loading batch blocks at a time.
+//
+// The same as stream_instructions() except blocks are converted a
+// batch ahead and loaded with menlo_cnc_load_blocks(), which checks
+// status and FIFO space once per batch rather than on every block.
+//
+unsigned long
+stream_instructions_batched(
+    void* registers,
+    PBLOCK_ARRAY binary,
+    int batch
+    )
+{
+  int ret;
+  int axis_count;
+  unsigned long status;
+  unsigned long command;
+  unsigned long count;
+  unsigned long first;
+  unsigned long loaded;
+  void *block;
+  unsigned long instruction_block_count;
+  unsigned long underrun_errors;
+  PMENLO_CNC_OPCODE_BLOCK_BINARY blocks;
+
+  printf("resetting timing engine fabric...\n");
+
+  status = menlo_cnc_reset_timing_engine(registers);
+
+  printf("reset timing engine done\n");
+
+  printf("status after reset 0x%lx\n", status);
+
+  ret = block_array_seek_entry(binary, 0);
+  if (ret != 0) {
+    printf("error rewinding block array %d\n", ret);
+    return ret;
+  }
+
+  //
+  // Note: First entry must be header
+  //
+
+  block = block_array_get_next_entry(binary);
+  if (block == NULL) {
+    printf("Empty assembly streadm\n");
+    return EBADF;
+  }
+
+  ret = validate_header_block(registers, block, &axis_count);
+  if (ret != 0) {
+    printf("No HEADER block at start of instruction stream\n");
+    return ret;
+  }
+
+  blocks = (PMENLO_CNC_OPCODE_BLOCK_BINARY)malloc(batch * sizeof(MENLO_CNC_OPCODE_BLOCK_BINARY));
+  if (blocks == NULL) {
+    printf("error allocating batch of %d blocks\n", batch);
+    return ENOMEM;
+  }
+
+  command = 0;
+  command |= (MENLO_CNC_REGISTERS_COMMAND_CMD |
+              MENLO_CNC_REGISTERS_COMMAND_EAN);
+
+  //
+  // Begin Run
+  //
+
+  status = 0;
+
+  instruction_block_count = 0;
+
+  underrun_errors = 0;
+
+  // Converted blocks are blocks[first] to blocks[count - 1]
+  first = 0;
+  count = 0;
+
+  menlo_cnc_registers_reset_sfe(registers);
+
+  //
+  // Begin real time Loop
+  //
+  while (1) {
+
+    if (first == count) {
+
+      first = 0;
+      count = 0;
+
+      while ((count < (unsigned long)batch) &&
+             ((block = block_array_get_next_entry(binary)) != NULL)) {
+        convert_block_binary((POPCODE_BLOCK_BINARY)block, &blocks[count]);
+        count++;
+      }
+
+      if (count == 0) {
+        printf("No more instruction entries in block array, loaded %ld blocks\n",
+        instruction_block_count);
+        goto Done;
+      }
+    }
+
+    //
+    // Loads none while the FIFO is full.
+    //
+    status = menlo_cnc_load_blocks(
+        registers,
+        command,
+        &blocks[first],
+        count - first,
+        axis_count,
+        LOADER_FIFO_CAPACITY,
+        &loaded
+        );
+
+    first += loaded;
+
+    instruction_block_count += loaded;
+
+    if (menlo_cnc_registers_is_error(status)) {
+      printf("error %ld loading batch ending at block 0x%lx\n", status, instruction_block_count);
+      goto Done;
+    }
+
+    if (menlo_cnc_registers_is_underrun(status)) {
+
+      // Just report it, don't abort
+      printf("underrun occurred status 0x%lx at instruction block %ld\n",
+	     status, instruction_block_count);
+
+      underrun_errors++;
+
+      // Rearm it
+      menlo_cnc_registers_reset_sfe(registers);
+    }
+  }
+
+  //
+  // End real time Loop
+  //
+
+Done:
+
+  free(blocks);
+
+  printf("instruction block count %ld, underrun errors %ld, status 0x%ld\n",
+    instruction_block_count,
+    underrun_errors,
+    status);
+
+  return status;
+}
+
+//
+// Run a compressed program on the machine in a real time loop.
+//
+// The same as stream_instructions() except that each block is
+// expanded from the compressed program just before it is loaded, and
+// only the registers which changed from the previous block are
+// written. A repeated block is only a command write.
+//
+unsigned long
+stream_compressed_instructions(
+    void* registers,
+    PCOMPRESSED_PROGRAM program
+    )
+{
+  int ret;
+  int axis_count;
+  unsigned long status;
+  unsigned long long changed;
+  void *block;
+  unsigned long instruction_block_count;
+  unsigned long underrun_errors;
+  COMPRESSED_STREAM stream;
+
+  printf("resetting timing engine fabric...\n");
+
+  status = menlo_cnc_reset_timing_engine(registers);
+
+  printf("reset timing engine done\n");
+
+  printf("status after reset 0x%lx\n", status);
+
+  compressed_stream_initialize(&stream, program);
+
+  //
+  // Note: First entry must be header
+  //
+
+  block = compressed_stream_next(&stream);
+  if (block == NULL) {
+    printf("Empty compressed stream\n");
+    return EBADF;
+  }
+
+  ret = validate_header_block(registers, block, &axis_count);
+  if (ret != 0) {
+    printf("No HEADER block at start of instruction stream\n");
+    return ret;
+  }
+
+  //
+  // Begin Run
+  //
+
+  status = 0;
+
+  instruction_block_count = 0;
+
+  underrun_errors = 0;
+
+  menlo_cnc_registers_reset_sfe(registers);
+
+  //
+  // Begin real time Loop
+  //
+  while (1) {
+
+    block = compressed_stream_next(&stream);
+    if (block == NULL) {
+
+      if (stream.error != 0) {
+        printf("invalid compressed program after %ld blocks\n", instruction_block_count);
+        status = MENLO_CNC_REGISTERS_STATUS_ERR;
+        goto Done;
+      }
+
+      printf("No more instruction entries in compressed program, loaded %ld blocks\n",
+      instruction_block_count);
+      goto Done;
+    }
+
+    //
+    // The header was not loaded so the first instruction block
+    // loads all of the registers.
+    //
+    changed = stream.changed;
+
+    if (instruction_block_count == 0) {
+      changed = ~0ULL;
+    }
+
+    instruction_block_count++;
+
+    status = load_block_changes(registers, block, changed, axis_count);
+    if (menlo_cnc_registers_is_error(status)) {
+      printf("error %ld loading block 0x%lx\n", status, instruction_block_count);
+      goto Done;
+    }
+
+    if (menlo_cnc_registers_is_underrun(status)) {
+
+      // Just report it, don't abort
+      printf("underrun occurred status 0x%lx at instruction block %ld\n",
+	     status, instruction_block_count);
+
+      underrun_errors++;
+
+      // Rearm it
+      menlo_cnc_registers_reset_sfe(registers);
+    }
+  }
+
+  //
+  // End real time Loop
+  //
+
+Done:
+
+  printf("instruction block count %ld, underrun errors %ld, status 0x%ld\n",
+    instruction_block_count,
+    underrun_errors,
+    status);
+
+  return status;
+}
+
+//
+// Convert the remaining blocks of the block array into the ring ahead
+// of the consumer. When the ring is full it sleeps until the consumer has
+// drained it to FEEDER_RING_LOW_WATER so it wakes once per half ring
+// rather than once per block.
+//
+// Returns when the block array is exhausted, after marking the ring
+// producer done, or early if the consumer has stopped.
+//
+void
+feed_ring(
+    PMENLO_CNC_RING ring,
+    PBLOCK_ARRAY binary
+    )
+{
+  void *block;
+  PMENLO_CNC_OPCODE_BLOCK_BINARY target;
+
+  while (1) {
+
+    block = block_array_get_next_entry(binary);
+    if (block == NULL) {
+      break;
+    }
+
+    target = menlo_cnc_ring_reserve(ring);
+
+    if (target == NULL) {
+
+      while (menlo_cnc_ring_count(ring) > FEEDER_RING_LOW_WATER) {
+
+        if (menlo_cnc_ring_is_consumer_done(ring)) {
+          return;
+        }
+
+        usleep(FEEDER_PRODUCER_SLEEP_US);
+      }
+
+      target = menlo_cnc_ring_reserve(ring);
+    }
+
+    convert_block_binary((POPCODE_BLOCK_BINARY)block, target);
+
+    // Publish the converted block
+    menlo_cnc_ring_commit(ring);
+  }
+
+  menlo_cnc_ring_set_producer_done(ring);
+}
+
+//
+// Producer thread for stream_instructions_pipelined().
+//
+void*
+feeder_producer(
+    void* context
+    )
+{
+  PFEEDER_CONTEXT feeder;
+
+  feeder = (PFEEDER_CONTEXT)context;
+
+  feed_ring(feeder->ring, feeder->binary);
+
+  return NULL;
+}
+
+//
+// Display the consumer results of a ring once consumer_done is set.
+//
+void
+print_ring_results(
+    PMENLO_CNC_RING ring
+    )
+{
+  if (ring->underruns != 0) {
+    printf("first underrun at instruction block %ld\n", ring->first_underrun_block);
+  }
+
+  printf("instruction block count %ld, underrun errors %ld, status 0x%lx\n",
+    ring->blocks_loaded,
+    ring->underruns,
+    ring->status);
+
+  printf("ring empty count %ld, minimum fifo depth at refill %ld\n",
+    ring->ring_empty_count,
+    ring->min_fifo_depth);
+}
+
+//
+// Run the in memory binary instruction stream on the machine with
+// block conversion and register loading on separate threads.
+//
+// stream_instructions() converts a block, then spins on FBF until
+// the FIFO accepts it, so any stall delays every later block.
+//
+// Here a producer thread converts blocks ahead of time into a
+// menlo_cnc_ring and the calling thread becomes the consumer. It is
+// pinned to core, raised to SCHED_FIFO and locked into memory where
+// permitted, and runs menlo_cnc_ring_consume() which only copies
+// ready blocks into the registers.
+//
+// Stops on reported errors.
+//
+unsigned long
+stream_instructions_pipelined(
+    void* registers,
+    PBLOCK_ARRAY binary,
+    int core
+    )
+{
+  int ret;
+  int cpu;
+  int cpu_count;
+  int dedicated;
+  int axis_count;
+  unsigned long status;
+  void *block;
+  PMENLO_CNC_RING ring;
+  FEEDER_CONTEXT feeder;
+  pthread_t producer;
+  cpu_set_t cpus;
+  struct sched_param param;
+
+  printf("resetting timing engine fabric...\n");
+
+  status = menlo_cnc_reset_timing_engine(registers);
+
+  printf("reset timing engine done\n");
+
+  printf("status after reset 0x%lx\n", status);
+
+  ret = block_array_seek_entry(binary, 0);
+  if (ret != 0) {
+    printf("error rewinding block array %d\n", ret);
+    return ret;
+  }
+
+  //
+  // Note: First entry must be header
+  //
+
+  block = block_array_get_next_entry(binary);
+  if (block == NULL) {
+    printf("Empty assembly streadm\n");
+    return EBADF;
+  }
+
+  ret = validate_header_block(registers, block, &axis_count);
+  if (ret != 0) {
+    printf("No HEADER block at start of instruction stream\n");
+    return ret;
+  }
+
+  ring = (PMENLO_CNC_RING)malloc(menlo_cnc_ring_size(FEEDER_RING_SIZE));
+  if (ring == NULL) {
+    printf("error allocating feeder ring\n");
+    return ENOMEM;
+  }
+
+  menlo_cnc_ring_initialize(ring, FEEDER_RING_SIZE, axis_count);
+
+  feeder.ring = ring;
+  feeder.binary = binary;
+
+  //
+  // Consumer on core, producer on any other core.
+  //
+  // Failures here are reported but not fatal so the pipelined
+  // mode may still be used for jogging without privileges.
+  //
+  // The consumer spins, so it is only raised to SCHED_FIFO when it
+  // has a core to itself. Otherwise it would starve the producer.
+  //
+
+  cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  dedicated = 0;
+
+  if ((cpu_count > 1) && (core >= 0) && (core < cpu_count)) {
+
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (ret != 0) {
+      printf("warning: could not pin feeder to core %d %s\n", core, strerror(ret));
+    }
+    else {
+      dedicated = 1;
+    }
+  }
+  else {
+    printf("warning: no core %d to dedicate of %d, feeder not real time\n",
+      core, cpu_count);
+  }
+
+  if (dedicated) {
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+
+    ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) {
+      printf("warning: could not set SCHED_FIFO %s\n", strerror(ret));
+    }
+  }
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    printf("warning: could not lock memory %s\n", strerror(errno));
+  }
+
+  ret = pthread_create(&producer, NULL, feeder_producer, &feeder);
+  if (ret != 0) {
+    printf("error creating feeder producer thread %s\n", strerror(ret));
+    free(ring);
+    return ret;
+  }
+
+  if (dedicated) {
+
+    CPU_ZERO(&cpus);
+
+    for (cpu = 0; cpu < cpu_count; cpu++) {
+      if (cpu != core) {
+        CPU_SET(cpu, &cpus);
+      }
+    }
+
+    // Best effort, the producer is not timing critical
+    pthread_setaffinity_np(producer, sizeof(cpus), &cpus);
+  }
+
+  //
+  // Let the producer get ahead before motion starts so the first
+  // bursts are not limited by conversion.
+  //
+  while ((menlo_cnc_ring_count(ring) < FEEDER_RING_LOW_WATER) &&
+         !__atomic_load_n(&ring->producer_done, __ATOMIC_ACQUIRE)) {
+    usleep(FEEDER_PRODUCER_SLEEP_US);
+  }
+
+  //
+  // Begin Run
+  //
+
+  status = menlo_cnc_ring_consume(ring, registers);
+
+  //
+  // End Run
+  //
+
+  if (menlo_cnc_registers_is_error(status)) {
+    printf("error %ld loading block 0x%lx\n", status, ring->blocks_loaded);
+  }
+  else {
+    printf("No more instruction entries in block array, loaded %ld blocks\n",
+      ring->blocks_loaded);
+  }
+
+  // consumer_done is set, the producer returns at its next full ring
+  pthread_join(producer, NULL);
+
+  print_ring_results(ring);
+
+  free(ring);
+
+  return status;
+}
+
+//
+// Producer side of a ring in POSIX shared memory.
+//
+// Creates ringName, assembles or maps fileName and converts its
+// instruction blocks into the ring for a ring_consumer process, which
+// owns the hardware. Waits for the consumer to finish, displays its
+// results and removes the ring.
+//
+int
+run_ring_producer(
+    char *ringName,
+    char *fileName,
+    int binary_file
+    )
+{
+  int ret;
+  int fd;
+  int axis_count;
+  void *block;
+  unsigned long length;
+  PMENLO_CNC_RING ring;
+  PBLOCK_ARRAY binary = NULL;
+
+  if (binary_file) {
+    ret = map_binary_file(fileName, &binary);
+  }
+  else {
+    ret = assemble_file(fileName, &binary);
+  }
+
+  if (ret != 0) {
+    printf("error %d %s loading %s, exiting\n", ret, strerror(ret), fileName);
+    return ret;
+  }
+
+  printf("loaded %d opcode blocks\n", block_array_get_array_size(binary));
+
+  //
+  // Note: First entry must be header
+  //
+
+  block = block_array_get_next_entry(binary);
+  if ((block == NULL) || (validate_header_block(NULL, block, &axis_count) != 0)) {
+    printf("No HEADER block at start of instruction stream\n");
+    block_array_free(binary);
+    return EBADF;
+  }
+
+  length = menlo_cnc_ring_size(FEEDER_RING_SIZE);
+
+  fd = shm_open(ringName, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1) {
+    ret = errno;
+    printf("error %d %s creating ring %s\n", ret, strerror(ret), ringName);
+    block_array_free(binary);
+    return ret;
+  }
+
+  if (ftruncate(fd, length) != 0) {
+    ret = errno;
+    printf("error %d %s sizing ring %s\n", ret, strerror(ret), ringName);
+    close(fd);
+    shm_unlink(ringName);
+    block_array_free(binary);
+    return ret;
+  }
+
+  ring = (PMENLO_CNC_RING)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  close(fd);
+
+  if (ring == MAP_FAILED) {
+    ret = errno;
+    printf("error %d %s mapping ring %s\n", ret, strerror(ret), ringName);
+    shm_unlink(ringName);
+    block_array_free(binary);
+    return ret;
+  }
+
+  menlo_cnc_ring_initialize(ring, FEEDER_RING_SIZE, axis_count);
+
+  printf("waiting for ring_consumer %s\n", ringName);
+
+  feed_ring(ring, binary);
+
+  while (!menlo_cnc_ring_is_consumer_done(ring)) {
+    usleep(FEEDER_PRODUCER_SLEEP_US);
+  }
+
+  print_ring_results(ring);
+
+  ret = 0;
+
+  if (menlo_cnc_registers_is_error(ring->status) ||
+      menlo_cnc_registers_is_underrun(ring->status)) {
+    ret = 1;
+  }
+
+  munmap(ring, length);
+
+  shm_unlink(ringName);
+
+  block_array_free(binary);
+
+  return ret;
+}
+
+//
+// Consumer side of a ring in POSIX shared memory.
+//
+// Waits for feed_ring to create ringName, resets the timing engine
+// and loads the ring into the machine until the producer is done.
+//
+int
+run_ring_consumer(
+    void* menlo_cnc_registers_base_address,
+    char *ringName
+    )
+{
+  int ret;
+  int fd;
+  int retries;
+  unsigned long status;
+  struct stat st;
+  PMENLO_CNC_RING ring;
+
+  ring = NULL;
+
+  for (retries = 0; retries < RING_CONSUMER_OPEN_RETRIES; retries++) {
+
+    fd = shm_open(ringName, O_RDWR, 0);
+    if (fd != -1) {
+
+      //
+      // The producer creates, sizes then initializes the ring so it may
+      // not be valid yet.
+      //
+      if ((fstat(fd, &st) == 0) &&
+          (st.st_size >= (off_t)sizeof(MENLO_CNC_RING))) {
+
+        ring = (PMENLO_CNC_RING)mmap(
+            NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (ring == MAP_FAILED) {
+          ret = errno;
+          printf("error %d %s mapping ring %s\n", ret, strerror(ret), ringName);
+          close(fd);
+          return ret;
+        }
+
+        if (menlo_cnc_ring_validate(ring, st.st_size) == 0) {
+          close(fd);
+          break;
+        }
+
+        munmap(ring, st.st_size);
+        ring = NULL;
+      }
+
+      close(fd);
+    }
+
+    usleep(RING_CONSUMER_OPEN_SLEEP_US);
+  }
+
+  if (ring == NULL) {
+    printf("no valid ring %s\n", ringName);
+    return ENOENT;
+  }
+
+  printf("resetting timing engine fabric...\n");
+
+  status = menlo_cnc_reset_timing_engine(menlo_cnc_registers_base_address);
+
+  printf("status after reset 0x%lx\n", status);
+
+  status = menlo_cnc_ring_consume(ring, menlo_cnc_registers_base_address);
+
+  print_ring_results(ring);
+
+  ret = 0;
+
+  if (menlo_cnc_registers_is_error(status)) {
+    printf("Error 0x%lx returned from menlo_cnc_ring_consume\n", status);
+    ret = 1;
+  }
+
+  if (menlo_cnc_registers_is_underrun(status)) {
+    printf("Underrun occurred during menlo_cnc_ring_consume status 0x%lx\n", status);
+    ret = 1;
+  }
+
+  munmap(ring, st.st_size);
+
+  return ret;
+}
+
+//
+// Load an assembler file from the file system, compile it completely
+// into a sequential memory block, and run it on the machine in
+// a real time loop.
+//
+int
+run_assembler_file(
+    void* menlo_cnc_registers_base_address,
+    char *fileName,
+    int pipelined,
+    int batch,
+    int core
+    )
+{
+  int ret;
+  PBLOCK_ARRAY binary = NULL;
+
+  ret = assemble_file(fileName, &binary);
+
+  if (ret != 0) {
+    printf("assembler error %d %s, exiting\n", ret, strerror(ret));
+    return ret;
+  }
+
+  printf("assembled %d opcode blocks\n", block_array_get_array_size(binary));
+  printf("assembly success, exiting\n");
+
+  return run_instructions(menlo_cnc_registers_base_address, binary, pipelined, batch, core);
+}
+
+//
+// Map a binary program file written by menlo_cnc_asm -o and run it
+// on the machine in a real time loop without reassembly.
+//
+// A compressed binary file from menlo_cnc_asm -o -z is expanded as it
+// streams, or up front for the pipelined loader.
+//
+int
+run_binary_file(
+    void* menlo_cnc_registers_base_address,
+    char *fileName,
+    int pipelined,
+    int batch,
+    int core
+    )
+{
+  int ret;
+  unsigned long status;
+  PBLOCK_ARRAY binary = NULL;
+  PCOMPRESSED_PROGRAM program = NULL;
+
+  if (!pipelined && (batch == 0)) {
+
+    ret = map_compressed_binary_file(fileName, &program);
+
+    if (ret == 0) {
+
+      printf("loaded compressed program of %ld opcode blocks in %d words\n",
+        program->block_count,
+        block_array_get_array_size(program->words));
+
+      status = stream_compressed_instructions(menlo_cnc_registers_base_address, program);
+
+      compressed_program_free(program);
+
+      if (menlo_cnc_registers_is_error(status)) {
+        printf("Error 0x%lx returned from stream_compressed_instructions\n", status);
+        return 1;
+      }
+
+      if (menlo_cnc_registers_is_underrun(status)) {
+        printf("Underrun occurred during stream_compressed_instructions status 0x%lx\n", status);
+        return 1;
+      }
+
+      return 0;
+    }
+
+    // EINVAL is an uncompressed binary file
+    if (ret != EINVAL) {
+      printf("error %d %s loading binary file, exiting\n", ret, strerror(ret));
+      return ret;
+    }
+  }
+
+  ret = map_binary_file(fileName, &binary);
+
+  if (ret != 0) {
+    printf("error %d %s loading binary file, exiting\n", ret, strerror(ret));
+    return ret;
+  }
+
+  printf("loaded %d opcode blocks\n", block_array_get_array_size(binary));
+
+  ret = run_instructions(menlo_cnc_registers_base_address, binary, pipelined, batch, core);
+
+  block_array_free(binary);
+
+  return ret;
+}
+
+//
+// Compile a G-code file into a sequential memory block, and run
+// it on the machine in a real time loop.
+//
+// The default machine in menlo_cnc_gcode.h is used.
+//
+int
+run_gcode_file(
+    void* menlo_cnc_registers_base_address,
+    char *fileName,
+    int pipelined,
+    int batch,
+    int core
+    )
+{
+  int ret;
+  PBLOCK_ARRAY binary = NULL;
+  GCODE_STATISTICS statistics;
+
+  ret = compile_gcode_file(fileName, NULL, &binary, &statistics);
+
+  if (ret != 0) {
+    printf("gcode error %d %s, exiting\n", ret, strerror(ret));
+    return ret;
+  }
+
+  printf("compiled %lu lines into %d opcode blocks, program time %g seconds\n",
+         statistics.lines,
+         block_array_get_array_size(binary),
+         (double)statistics.program_clocks / (double)TIMING_GENERATOR_BASE_CLOCK_RATE);
+
+  ret = run_instructions(menlo_cnc_registers_base_address, binary, pipelined, batch, core);
+
+  block_array_free(binary);
+
+  return ret;
+}
+
+//
+// Stream binary instructions to the machine and report the result.
+//
+// batch is the blocks per batch for stream_instructions_batched(), 0
+// to load a block at a time.
+//
+int
+run_instructions(
+    void* menlo_cnc_registers_base_address,
+    PBLOCK_ARRAY binary,
+    int pipelined,
+    int batch,
+    int core
+    )
+{
+  int ret;
+  unsigned long status;
+
+  if (pipelined) {
+    status = stream_instructions_pipelined(
+        menlo_cnc_registers_base_address,
+        binary,
+        core
+        );
+  }
+  else if (batch > 0) {
+    status = stream_instructions_batched(menlo_cnc_registers_base_address, binary, batch);
+  }
+  else {
+    status = stream_instructions(menlo_cnc_registers_base_address, binary);
+  }
+
+  ret = 0;
+
+  if (menlo_cnc_registers_is_error(status)) {
+    printf("Error 0x%lx returned from stream_instructions\n", status);
+    ret = 1;
+  }
+
+  if (menlo_cnc_registers_is_underrun(status)) {
+    printf("Underrun occurred during stream_instructions status 0x%lx\n", status);
+    ret = 1;
+  }
+
+  return ret;
+}
+
+//
+// Benchmark the instruction loader with an assembler file.
+//
+// With binary_file set fileName is a binary program file rather
+// than assembler source.
+//
+// The instruction blocks after the header are repeated repeat times
+// so a short test program can measure a sustained rate, then streamed
+// with stream_instructions() or stream_instructions_pipelined().
+//
+// Reports the blocks/sec loaded, and with the simulated register
+// file the underruns and timing generator utilization from the model.
+//
+// With compress set the repeated program is compressed and streamed
+// with stream_compressed_instructions(). With batch set it's streamed
+// with stream_instructions_batched().
+//
+// Streaming stops when the last block is loaded, so the run time
+// here also waits for the timing generator to go idle.
+//
+int
+bench_assembler_file(
+    void* registers,
+    char *fileName,
+    int binary_file,
+    int repeat,
+    int pipelined,
+    int compress,
+    int batch,
+    int core
+    )
+{
+  int ret;
+  int index;
+  int pass;
+  int program_size;
+  unsigned long status;
+  unsigned long blocks;
+  double load_seconds;
+  double run_seconds;
+  struct timespec start_time;
+  struct timespec load_time;
+  struct timespec end_time;
+  PBLOCK_ARRAY program = NULL;
+  PBLOCK_ARRAY binary;
+  PCOMPRESSED_PROGRAM compressed = NULL;
+#if MENLO_CNC_SIMULATOR
+  MENLO_CNC_SIM_STATISTICS statistics;
+  unsigned long load_register_reads;
+  double program_seconds;
+#endif
+
+  if (repeat < 1) {
+    repeat = 1;
+  }
 
-  //
-  // Begin Run
-  //
+  if (binary_file) {
+    ret = map_binary_file(fileName, &program);
+  }
+  else {
+    ret = assemble_file(fileName, &program);
+  }
 
-  status = 0;
+  if (ret != 0) {
+    printf("error %d %s loading program, exiting\n", ret, strerror(ret));
+    return ret;
+  }
 
-  instruction_block_count = 0;
+  program_size = block_array_get_array_size(program);
 
-  underrun_errors = 0;
+  if (program_size < 2) {
+    printf("no instruction blocks after header\n");
+    return EBADF;
+  }
 
   //
-  // Clear Sticky FIFO Underrun before entring the real time loop.
-  //
-  // This gets set if the FIFO's go empty once the first instruction
-  // has been loaded.
+  // Header, then the program body repeat times.
   //
-  menlo_cnc_registers_reset_sfe(registers);
+  binary = block_array_allocate(
+      sizeof(OPCODE_BLOCK_BINARY),
+      ((program_size - 1) * repeat) + 2,
+      program_size
+      );
 
-  //
-  // Begin real time Loop
-  //
-  while (1) {
+  if (binary == NULL) {
+    printf("error allocating benchmark block array\n");
+    return ENOMEM;
+  }
 
-    //
-    // Note: instruction counts can be reduced by inlining, macro's,
-    // etc. for status test, bumping through the sequential array, etc.
-    //
-    // These are considerations if this inner loop moves to a weaker embedded
-    // soft processor such as a Nios II.
-    //
-    // The ARM SoC's have plently of instruction execution rate, its
-    // just that their environment is more prone to interruptions
-    // and pauses by both system and internal chip processes.
-    //
+  block_array_push_entry(
+      binary,
+      block_array_get_entry(program, 0),
+      sizeof(OPCODE_BLOCK_BINARY)
+      );
 
-    block = block_array_get_next_entry(binary);
-    if (block == NULL) {
-      printf("No more instruction entries in block array, loaded %ld blocks\n",
-      instruction_block_count);
-      // status is set from last load, or initial value if array is empty.
-      goto Done;
+  for (pass = 0; pass < repeat; pass++) {
+    for (index = 1; index < program_size; index++) {
+      block_array_push_entry(
+          binary,
+          block_array_get_entry(program, index),
+          sizeof(OPCODE_BLOCK_BINARY)
+          );
     }
+  }
 
-    instruction_block_count++;
+  blocks = (unsigned long)(block_array_get_array_size(binary) - 1);
 
-    status = load_block(registers, block);
-    if (menlo_cnc_registers_is_error(status)) {
-      printf("error %ld loading block 0x%lx\n", status, instruction_block_count);
-      goto Done;
+  if (compress) {
+
+    ret = compress_binary(binary, &compressed);
+
+    if (ret != 0) {
+      printf("error %d %s compressing benchmark program\n", ret, strerror(ret));
+      return ret;
     }
 
-    if (menlo_cnc_registers_is_underrun(status)) {
+    printf("compressed %ld blocks into %d words, %g words per block\n",
+      compressed->block_count,
+      block_array_get_array_size(compressed->words),
+      (double)block_array_get_array_size(compressed->words) / (double)compressed->block_count);
+  }
 
-      // Just report it, don't abort
-      printf("underrun occurred status 0x%lx at instruction block %ld\n",
-	     status, instruction_block_count);
+  if (batch > 0) {
+    printf("benchmark %ld instruction blocks, batched loader, %d blocks per batch\n",
+      blocks, batch);
+  }
+  else {
+    printf("benchmark %ld instruction blocks, %s loader\n",
+      blocks, pipelined ? "pipelined" : (compress ? "compressed" : "synchronous"));
+  }
 
-      underrun_errors++;
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
 
-      // Rearm it
-      menlo_cnc_registers_reset_sfe(registers);
-    }
+  if (pipelined) {
+    status = stream_instructions_pipelined(registers, binary, core);
+  }
+  else if (compress) {
+    status = stream_compressed_instructions(registers, compressed);
+  }
+  else if (batch > 0) {
+    status = stream_instructions_batched(registers, binary, batch);
+  }
+  else {
+    status = stream_instructions(registers, binary);
   }
 
-  //
-  // End real time Loop
-  //
+  clock_gettime(CLOCK_MONOTONIC, &load_time);
+
+#if MENLO_CNC_SIMULATOR
+  // Reads by the loader, not the wait for idle below
+  menlo_cnc_sim_get_statistics(registers, &statistics);
+  load_register_reads = statistics.register_reads;
+#endif
 
   //
-  // End Run
+  // Wait for the timing generator to finish the stream.
   //
+  while (!menlo_cnc_registers_is_error(status) &&
+         ((status & MENLO_CNC_REGISTERS_STATUS_IDL) == 0)) {
+    status = menlo_cnc_read_status(registers);
+  }
 
-Done:
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
 
-  printf("instruction block count %ld, underrun errors %ld, status 0x%ld\n",
-    instruction_block_count,
-    underrun_errors,
-    status);
+  load_seconds = (double)(load_time.tv_sec - start_time.tv_sec) +
+                 ((double)(load_time.tv_nsec - start_time.tv_nsec) / 1000000000.0);
 
-  return status;
-}
+  run_seconds = (double)(end_time.tv_sec - start_time.tv_sec) +
+                ((double)(end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0);
 
-//
-// Load an assembler file from the file system, compile it completely
-// into a sequential memory block, and run it on the machine in
-// a real time loop.
-//
-int
-run_assembler_file(
-    void* menlo_cnc_registers_base_address,
-    char *fileName
-    )
-{
-  int ret;
-  unsigned long status;
-  PBLOCK_ARRAY binary = NULL;
+  printf("loaded %ld blocks in %g seconds, %g blocks/sec\n",
+    blocks, load_seconds, (double)blocks / load_seconds);
 
-  ret = assemble_file(fileName, &binary);
+  printf("run completed in %g seconds, %g blocks/sec sustained\n",
+    run_seconds, (double)blocks / run_seconds);
 
-  if (ret != 0) {
-    printf("assembler error %d %s, exiting\n", ret, strerror(ret));
-    return ret;
-  }
+#if MENLO_CNC_SIMULATOR
+  menlo_cnc_sim_get_statistics(registers, &statistics);
 
-  printf("assembled %d opcode blocks\n", block_array_get_array_size(binary));
-  printf("assembly success, exiting\n");
+  program_seconds = (double)statistics.busy_clocks / (double)TIMING_GENERATOR_BASE_CLOCK_RATE;
 
-  status = stream_instructions(menlo_cnc_registers_base_address, binary);
+  printf("simulator: loaded %ld executed %ld underruns %ld max fifo depth %ld fifo full reads %ld\n",
+    statistics.blocks_loaded,
+    statistics.blocks_executed,
+    statistics.underruns,
+    statistics.max_fifo_depth,
+    statistics.fifo_full_reads);
 
-  ret = 0;
+  printf("simulator: status and fifo depth reads while loading %ld, %g per block\n",
+    load_register_reads,
+    (double)load_register_reads / (double)blocks);
 
-  if (menlo_cnc_registers_is_error(status)) {
-    printf("Error 0x%lx returned from stream_instructions\n", status);
-    ret = 1;
+  printf("simulator: program time %g seconds, starved %g seconds, utilization %g%%\n",
+    program_seconds,
+    (double)statistics.starved_clocks / (double)TIMING_GENERATOR_BASE_CLOCK_RATE,
+    (program_seconds * 100.0) / run_seconds);
+#endif
+
+  if (compressed != NULL) {
+    compressed_program_free(compressed);
   }
 
-  if (menlo_cnc_registers_is_underrun(status)) {
-    printf("Underrun occurred during stream_instructions status 0x%lx\n", status);
-    ret = 1;
+  block_array_free(binary);
+  block_array_free(program);
+
+  if (menlo_cnc_registers_is_error(status)) {
+    printf("Error 0x%lx during benchmark\n", status);
+    return 1;
   }
 
-  return ret;
+  return 0;
 }
 
 void
 convert_axis_binary(
     PAXIS_OPCODE_BINARY src,
-    PMENLO_CNC_AXIS_OPCODE_BINARY target
+    PMENLO_CNC_AXIS_REGISTERS target
     )
 {
   // 
@@ -606,88 +2128,61 @@ convert_axis_binary(
   // 
   // menlo_cnc.h
   //
-  // target:
+  // target, in register order:
   //
-  // typedef struct _MENLO_CNC_AXIS_OPCODE_BINARY {
-  //   unsigned long instruction;
+  // typedef struct _MENLO_CNC_AXIS_REGISTERS {
   //   unsigned long pulse_rate;
   //   unsigned long pulse_count;
   //   unsigned long pulse_width;
-  // } MENLO_CNC_AXIS_OPCODE_BINARY, *PMENLO_CNC_AXIS_OPCODE_BINARY;
+  //   unsigned long pulse_instruction;
+  // } *PMENLO_CNC_AXIS_REGISTERS, MENLO_CNC_AXIS_REGISTERS;
   // 
 
-  target->instruction = src->instruction;
   target->pulse_rate = src->pulse_rate;
   target->pulse_count = src->pulse_count;
   target->pulse_width = src->pulse_width;
+  target->pulse_instruction = src->instruction;
 
   return;
 }
 
 void
-convert_four_axis_binary(
-    POPCODE_BLOCK_FOUR_AXIS_BINARY src,
-    PMENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY target
+convert_block_binary(
+    POPCODE_BLOCK_BINARY src,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY target
     )
 {
-  //
-  // TODO: Should use the same base type for opcode binary
-  // to cut down on number of instructions in the main streaming loop.
-  //
-  // Problem with headers right now. May need to go to a separate header
-  // for base types between the assembler and the binary loader.
-  //
-  // This does have the advantage in which the assembler can place
-  // extra formatting information such as begin, end, blocks into the
-  // binary opcode blocks which gets converted to the low level register
-  // format.
-  //
+  int index;
 
-  // 
-  // menlo_cnc_asm.h
-  //
-  // src:
   //
-  // typedef struct _OPCODE_BLOCK_FOUR_AXIS_BINARY {
-  //   AXIS_OPCODE_BINARY begin;
-  //   AXIS_OPCODE_BINARY x;
-  //   AXIS_OPCODE_BINARY y;
-  //   AXIS_OPCODE_BINARY z;
-  //   AXIS_OPCODE_BINARY a;
-  //   AXIS_OPCODE_BINARY end;
-  // } OPCODE_BLOCK_FOUR_AXIS_BINARY, *POPCODE_BLOCK_FOUR_AXIS_BINARY;
-  // 
-
-  // 
-  // menlo_cnc.h
+  // The assembler binary has begin and end records around the axis
+  // and the instruction first in each axis as in the binary file.
+  // The target is in register file order for menlo_cnc_load_block().
   //
-  // target:
+  // Both are MENLO_CNC_AXIS_COUNT axis from X.
   //
-  // typedef struct _MENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY {
-  //   MENLO_CNC_AXIS_OPCODE_BINARY x;
-  //   MENLO_CNC_AXIS_OPCODE_BINARY y;
-  //   MENLO_CNC_AXIS_OPCODE_BINARY z;
-  //   MENLO_CNC_AXIS_OPCODE_BINARY a;
-  // } MENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY, *PMENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY;
-  // 
 
-  convert_axis_binary(&src->x, &target->x);
-  convert_axis_binary(&src->y, &target->y);
-  convert_axis_binary(&src->z, &target->z);
-  convert_axis_binary(&src->a, &target->a);
+  for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+    convert_axis_binary(&src->axis[index], &target->axis[index]);
+  }
 
   return;
 }
 
+//
+// Validate the HEADER, CONFIG info block and return the
+// number_of_axis the program was assembled for.
+//
 int
 validate_header_block(
     void* menlo_cnc_registers_base_address,
-    void* block
+    void* block,
+    int* axis_count
     )
 {
-  POPCODE_BLOCK_FOUR_AXIS_BINARY src;
+  POPCODE_BLOCK_BINARY src;
 
-  src = (POPCODE_BLOCK_FOUR_AXIS_BINARY)block;
+  src = (POPCODE_BLOCK_BINARY)block;
 
   if (src->x.instruction != OPCODE_HEADER) {
     return EBADF;
@@ -705,6 +2200,17 @@ validate_header_block(
     return EBADF;
   }
 
+  //
+  // CONFIG number_of_axis
+  //
+  if ((src->y.pulse_rate == 0) || (src->y.pulse_rate > MENLO_CNC_AXIS_COUNT)) {
+    printf("program number_of_axis %ld not supported, %d axis configured\n",
+           src->y.pulse_rate, MENLO_CNC_AXIS_COUNT);
+    return EBADF;
+  }
+
+  *axis_count = (int)src->y.pulse_rate;
+
   //
   // TODO: Validate against machine parameters and version
   // in regsiter file.
@@ -716,15 +2222,16 @@ validate_header_block(
 unsigned long
 load_block(
     void* menlo_cnc_registers_base_address,
-    void* block
+    void* block,
+    int axis_count
     )
 {
   unsigned long status;
   unsigned long command;
-  POPCODE_BLOCK_FOUR_AXIS_BINARY src;
-  MENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY target;
+  POPCODE_BLOCK_BINARY src;
+  MENLO_CNC_OPCODE_BLOCK_BINARY target;
 
-  src = (POPCODE_BLOCK_FOUR_AXIS_BINARY)block;
+  src = (POPCODE_BLOCK_BINARY)block;
 
   command = 0;
   command |= (MENLO_CNC_REGISTERS_COMMAND_CMD |
@@ -734,7 +2241,7 @@ load_block(
   // Convert it
   //
 
-  convert_four_axis_binary(src, &target);
+  convert_block_binary(src, &target);
 
   //
   // N.B. This spinwaits for the FIFO to not be full.
@@ -742,13 +2249,59 @@ load_block(
   // It will return early if there is an error.
   //
 
-  status = menlo_cnc_load_four_axis(
+  status = menlo_cnc_load_block(
+      menlo_cnc_registers_base_address,
+      command,
+      &target,
+      axis_count
+      );
+
+  return status;
+}
+
+//
+// Load a block from a compressed program.
+//
+// changed is COMPRESSED_STREAM changed, a bit per word of the binary
+// file record. It's converted to the register bits for
+// menlo_cnc_load_block_changes() skipping the begin record, and moving
+// the instruction from first in each axis record to last.
+//
+unsigned long
+load_block_changes(
+    void* menlo_cnc_registers_base_address,
+    void* block,
+    unsigned long long changed,
+    int axis_count
+    )
+{
+  int index;
+  unsigned long field;
+  unsigned long status;
+  unsigned long command;
+  unsigned long long register_changes;
+  MENLO_CNC_OPCODE_BLOCK_BINARY target;
+
+  command = 0;
+  command |= (MENLO_CNC_REGISTERS_COMMAND_CMD |
+              MENLO_CNC_REGISTERS_COMMAND_EAN);
+
+  register_changes = 0;
+
+  for (index = 0; index < axis_count; index++) {
+    field = (unsigned long)(changed >> ((index + 1) * 4)) & 0xF;
+    register_changes |= (unsigned long long)((field >> 1) | ((field & 1) << 3)) << (index * 4);
+  }
+
+  if (register_changes != 0) {
+    convert_block_binary((POPCODE_BLOCK_BINARY)block, &target);
+  }
+
+  status = menlo_cnc_load_block_changes(
       menlo_cnc_registers_base_address,
       command,
-      &target.x,
-      &target.y,
-      &target.z,
-      &target.a
+      &target,
+      register_changes
       );
 
   return status;
@@ -1050,7 +2603,7 @@ test_menlo_cnc_pulse(
 int
 test_initialize_test_block(
     void* registers_base_address,
-    PMENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY target,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY target,
     unsigned long instruction,
     unsigned long pulse_count,
     double frequency,
@@ -1059,6 +2612,7 @@ test_initialize_test_block(
 {
     PMENLO_CNC_REGISTERS registers;
     int ret;
+    int index;
     unsigned long pulse_rate;
     unsigned long pulse_width;
 
@@ -1086,33 +2640,157 @@ test_initialize_test_block(
       return 1;
     }
 
-    target->x.instruction = instruction;
-    target->x.pulse_rate = pulse_rate;
-    target->x.pulse_count = pulse_count;
-    target->x.pulse_width = pulse_width;
+    for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+        target->axis[index].pulse_rate = pulse_rate;
+        target->axis[index].pulse_count = pulse_count;
+        target->axis[index].pulse_width = pulse_width;
+        target->axis[index].pulse_instruction = instruction;
+    }
+
+    return 0;
+}
+
+#if MENLO_CNC_SIMULATOR
+//
+// Check the simulated timing generator only reports an underrun
+// when it runs out of blocks mid stream.
+//
+// A stream loaded faster than it executes keeps the FIFO full, so
+// neither the loader's SFE check nor the simulator statistics may
+// report an underrun. SFE is then set once the stream drains, and a
+// block loaded after that is counted as an underrun.
+//
+int
+test_sim_underrun(
+    void* registers_base_address
+    )
+{
+    PMENLO_CNC_REGISTERS registers;
+    MENLO_CNC_OPCODE_BLOCK_BINARY target;
+    MENLO_CNC_SIM_STATISTICS statistics;
+    unsigned long command;
+    unsigned long instruction;
+    unsigned long status;
+    unsigned long underrun_errors;
+    unsigned long count_to_load;
+    unsigned long index;
+    double frequency;
+    int ret;
+
+    registers = (PMENLO_CNC_REGISTERS)registers_base_address;
+
+    command = 0;
+    command |= (MENLO_CNC_REGISTERS_COMMAND_CMD |
+                MENLO_CNC_REGISTERS_COMMAND_EAN);
+
+    instruction = 1;
+    instruction |= MENLO_CNC_REGISTERS_INSTRUCTION_PULSE;
+
+    //
+    // A single pulse at 10Khz is 100us per block, the loader stays
+    // well ahead of it.
+    //
+    frequency = (double)10000;
+
+    ret = test_initialize_test_block(
+        registers_base_address,
+        &target,
+        instruction,
+        1,
+        frequency,
+        frequency / (double)2
+        );
+
+    if (ret != 0) {
+      printf("overflow error initializing test block %d\n", ret);
+      return ret;
+    }
+
+    status = menlo_cnc_reset_timing_engine(registers);
+
+    menlo_cnc_registers_reset_sfe(registers);
+
+    //
+    // Twice the FIFO depth so the loader waits on a full FIFO
+    // for the second half of the stream.
+    //
+    count_to_load = sim_fifo_depth * 2;
+
+    underrun_errors = 0;
+
+    for (index = 0; index < count_to_load; index++) {
+
+        status = menlo_cnc_load_block(
+            registers,
+            command,
+            &target,
+            MENLO_CNC_AXIS_COUNT
+            );
+
+        if (menlo_cnc_registers_is_error(status)) {
+          printf("error 0x%lx loading block %ld\n", status, index);
+          return EBADF;
+        }
+
+        if (menlo_cnc_registers_is_underrun(status)) {
+          underrun_errors++;
+        }
+    }
+
+    menlo_cnc_sim_get_statistics(registers, &statistics);
+
+    printf("full fifo: blocks %ld, underrun errors %ld, simulator underruns %ld, max fifo depth %ld\n",
+      count_to_load,
+      underrun_errors,
+      statistics.underruns,
+      statistics.max_fifo_depth);
+
+    if ((underrun_errors != 0) || (statistics.underruns != 0) ||
+        (statistics.max_fifo_depth != sim_fifo_depth)) {
+      printf("test_sim_underrun failure: underrun reported with a full fifo\n");
+      return EBADF;
+    }
+
+    //
+    // Let the stream drain, the end of the stream sets SFE.
+    //
+    while ((status & MENLO_CNC_REGISTERS_STATUS_IDL) == 0) {
+      status = menlo_cnc_read_status(registers);
+    }
+
+    if (!menlo_cnc_registers_is_underrun(status)) {
+      printf("test_sim_underrun failure: SFE not set after the stream drained status 0x%lx\n", status);
+      return EBADF;
+    }
+
+    //
+    // A block loaded onto the idle timing generator is an underrun.
+    //
+    status = menlo_cnc_load_block(
+        registers,
+        command,
+        &target,
+        MENLO_CNC_AXIS_COUNT
+        );
 
-    target->y.instruction = instruction;
-    target->y.pulse_rate = pulse_rate;
-    target->y.pulse_count = pulse_count;
-    target->y.pulse_width = pulse_width;
+    menlo_cnc_sim_get_statistics(registers, &statistics);
 
-    target->z.instruction = instruction;
-    target->z.pulse_rate = pulse_rate;
-    target->z.pulse_count = pulse_count;
-    target->z.pulse_width = pulse_width;
+    if (statistics.underruns != 1) {
+      printf("test_sim_underrun failure: simulator underruns %ld after loading on idle, expected 1\n",
+        statistics.underruns);
+      return EBADF;
+    }
 
-    target->a.instruction = instruction;
-    target->a.pulse_rate = pulse_rate;
-    target->a.pulse_count = pulse_count;
-    target->a.pulse_width = pulse_width;
+    printf("test_sim_underrun success\n");
 
     return 0;
 }
+#endif
 
 int
 run_maximum_pulse_test_pass(
     void* registers_base_address,
-    PMENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY target,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY target,
     unsigned long command,
     int count_to_load
     )
@@ -1141,13 +2819,11 @@ run_maximum_pulse_test_pass(
 
     for (index = 0; index < count_to_load; index++) {
 
-        status = menlo_cnc_load_four_axis(
+        status = menlo_cnc_load_block(
             registers_base_address,
             command,
-            &target->x,
-            &target->y,
-            &target->z,
-            &target->a
+            target,
+            MENLO_CNC_AXIS_COUNT
             );
 
         if (menlo_cnc_registers_is_error(status)) {
@@ -1213,7 +2889,7 @@ test_pulse_rate(
     double frequency
     )
 {
-    MENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY target;
+    MENLO_CNC_OPCODE_BLOCK_BINARY target;
     unsigned long instruction;
     unsigned long pulse_count;
     unsigned long command;
@@ -1284,9 +2960,21 @@ void
 usage()
 {
   printf("menlo_cnc_app:\n");
-  printf("    run_assembler_file file_name\n");
+  printf("    run_assembler_file file_name [-pipeline [core] | -batch [n]]\n");
+  printf("    run_binary_file file_name [-pipeline [core] | -batch [n]]\n");
+  printf("    run_gcode_file file_name [-pipeline [core] | -batch [n]]\n");
+  printf("    bench_assembler_file file_name [-binary] [-repeat n] [-pipeline [core] | -compress | -batch [n]]");
+#if MENLO_CNC_SIMULATOR
+  printf(" [-depth n]");
+#endif
+  printf("\n");
+  printf("    feed_ring ring_name file_name [-binary]\n");
+  printf("    ring_consumer ring_name\n");
   printf("    test_cnc_pulse [frequency]\n");
   printf("    test_leds\n");
   printf("    test_cnc\n");
+#if MENLO_CNC_SIMULATOR
+  printf("    test_sim_underrun\n");
+#endif
   exit(1);
 }
@@ -72,6 +72,37 @@
 
 #include "menlo_cnc.h"
 
+//
+// Register accesses with side effects in the timing generator.
+//
+// With MENLO_CNC_SIMULATOR these go to the software model in
+// menlo_cnc_sim.c so the loader can run on a host without the FPGA.
+//
+#if MENLO_CNC_SIMULATOR
+#include "menlo_cnc_sim.h"
+
+#define MENLO_CNC_READ_STATUS(registers) \
+    menlo_cnc_sim_read_status(registers)
+
+#define MENLO_CNC_WRITE_COMMAND(registers, value) \
+    menlo_cnc_sim_write_command(registers, value)
+
+#define MENLO_CNC_WRITE_STATUSCLEARBITS(registers, value) \
+    menlo_cnc_sim_write_statusclearbits(registers, value)
+
+#define MENLO_CNC_READ_FIFO_DEPTH(registers) \
+    menlo_cnc_sim_read_fifo_depth(registers)
+#else
+#define MENLO_CNC_READ_STATUS(registers) ((registers)->status)
+
+#define MENLO_CNC_WRITE_COMMAND(registers, value) ((registers)->command = (value))
+
+#define MENLO_CNC_WRITE_STATUSCLEARBITS(registers, value) \
+    ((registers)->statusclearbits = (value))
+
+#define MENLO_CNC_READ_FIFO_DEPTH(registers) ((registers)->current_fifo_depth)
+#endif
+
 int
 menlo_cnc_registers_test_pass(
     PMENLO_CNC_REGISTERS registers,
@@ -250,6 +281,20 @@ menlo_cnc_registers_calculate_pulse_rate_by_hz(
       return -1;
     }
 
+    //
+    // Whole frequencies use the exact integer calculation.
+    //
+    if ((frequency_in_hz < MENLO_CNC_DECIMAL_MANTISSA_LIMIT) &&
+        (frequency_in_hz == (double)(unsigned long long)frequency_in_hz)) {
+
+      return menlo_cnc_registers_calculate_pulse_rate_by_decimal_hz(
+          registers,
+          (unsigned long long)frequency_in_hz,
+          0,
+          binary_pulse_rate
+          );
+    }
+
     //
     // Clock period for 50Mhz is 20ns
     //
@@ -450,9 +495,7 @@ menlo_cnc_registers_calculate_pulse_width(
     unsigned long* binary_pulse_width
     )
 {
-    double clock_period;
-    double clock_scale_factor;
-    double periods;
+    unsigned long periods;
 
     //
     // Zero is always zero.
@@ -462,16 +505,11 @@ menlo_cnc_registers_calculate_pulse_width(
       return 0;
     }
 
-    clock_period = (double)TIMING_GENERATOR_BASE_CLOCK_PERIOD_IN_NANOSECONDS;
-
-    clock_scale_factor = (double)TIMING_GENERATOR_PULSE_WIDTH_SCALE_FACTOR;
-
-    periods = (double)pulse_width_in_nanoseconds / clock_period;
-
     //
-    // Apply any scale factor
+    // Whole nanoseconds divide exactly, apply any scale factor.
     //
-    periods = periods / clock_scale_factor;
+    periods = pulse_width_in_nanoseconds /
+        (TIMING_GENERATOR_BASE_CLOCK_PERIOD_IN_NANOSECONDS * TIMING_GENERATOR_PULSE_WIDTH_SCALE_FACTOR);
 
     if (periods > TIMING_GENERATOR_MAXIMUM_PULSE_WIDTH_COUNT) {
       return -1;
@@ -483,9 +521,224 @@ menlo_cnc_registers_calculate_pulse_width(
     // Note that we checked for a request of zero on entry so in this
     // case its an underflow.
     //
-    if ((unsigned long)periods == 0) {
+    if (periods == 0) {
 #if DBG_TRACE
-      printf("calculate_pulse_width underflow in pulse_width %g\n", periods);
+      printf("calculate_pulse_width underflow in pulse_width %lu ns\n", pulse_width_in_nanoseconds);
+#endif
+      return -1;
+    }
+
+    *binary_pulse_width = periods;
+
+    return 0;
+}
+
+//
+// Calculate floor(numerator * 10^exponent / denominator) by long
+// division, one decimal digit at a time, in 64 bit integers.
+//
+// exact is set when there is no remainder.
+//
+// Returns -1 if the result is greater than maximum or
+// denominator can't be represented.
+//
+int
+menlo_cnc_decimal_scale_divide(
+    unsigned long long numerator,
+    int exponent,
+    unsigned long long denominator,
+    unsigned long long maximum,
+    unsigned long long* quotient,
+    int* exact
+    )
+{
+    unsigned long long q;
+    unsigned long long r;
+
+    if (denominator == 0) {
+      return -1;
+    }
+
+    //
+    // A negative exponent scales the denominator. Once it is
+    // larger than any numerator the result is 0.
+    //
+    for (; exponent < 0; exponent++) {
+
+      if (denominator > (MENLO_CNC_DECIMAL_MAXIMUM / 10)) {
+        *quotient = 0;
+        *exact = (numerator == 0);
+        return 0;
+      }
+
+      denominator *= 10;
+    }
+
+    q = numerator / denominator;
+    r = numerator % denominator;
+
+    if (q > maximum) {
+      return -1;
+    }
+
+    //
+    // Each digit of a positive exponent brings down a 0.
+    //
+    // r < denominator so r * 10 fits when the denominator does.
+    //
+    for (; exponent > 0; exponent--) {
+
+      if ((q > (maximum / 10)) || (denominator > (MENLO_CNC_DECIMAL_MAXIMUM / 10))) {
+        return -1;
+      }
+
+      r *= 10;
+
+      q = (q * 10) + (r / denominator);
+      r = r % denominator;
+
+      if (q > maximum) {
+        return -1;
+      }
+    }
+
+    *quotient = q;
+    *exact = (r == 0);
+
+    return 0;
+}
+
+//
+// The fixed point pulse_rate is
+//
+//   (TIMING_GENERATOR_BASE_CLOCK_RATE / TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR) / frequency
+//
+// with the clock ratio from TIMING_GENERATOR_PULSE_RATE_CLOCK_MANTISSA
+// and TIMING_GENERATOR_PULSE_RATE_CLOCK_EXPONENT.
+//
+int
+menlo_cnc_registers_calculate_pulse_rate_by_decimal_hz(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long long mantissa,
+    int exponent,
+    unsigned long* binary_pulse_rate
+    )
+{
+    int ret;
+    int exact;
+    unsigned long long pulse_rate;
+
+    //
+    // Zero is always zero.
+    //
+    if (mantissa == 0) {
+      *binary_pulse_rate = 0;
+      return 0;
+    }
+
+    ret = menlo_cnc_decimal_scale_divide(
+        TIMING_GENERATOR_PULSE_RATE_CLOCK_MANTISSA,
+        TIMING_GENERATOR_PULSE_RATE_CLOCK_EXPONENT - exponent,
+        mantissa,
+        TIMING_GENERATOR_MAXIMUM_CLOCK_PERIOD_COUNT - 1,
+        &pulse_rate,
+        &exact
+        );
+
+    if (ret != 0) {
+#if DBG_TRACE
+      printf("pulse_rate_by_decimal_hz overflow %llue%d\n", mantissa, exponent);
+#endif
+      return -1;
+    }
+
+    // Underflow, the frequency is too high
+    if (pulse_rate == 0) {
+#if DBG_TRACE
+      printf("pulse_rate_by_decimal_hz underflow %llue%d\n", mantissa, exponent);
+#endif
+      return -1;
+    }
+
+    *binary_pulse_rate = (unsigned long)pulse_rate;
+
+    return 0;
+}
+
+int
+menlo_cnc_registers_calculate_pulse_rate_by_decimal_period(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long long mantissa,
+    int exponent,
+    unsigned long* binary_pulse_rate
+    )
+{
+    int ret;
+    int exact;
+    unsigned long long pulse_rate;
+
+    if (mantissa == 0) {
+      *binary_pulse_rate = 0;
+      return 0;
+    }
+
+    if (mantissa > (MENLO_CNC_DECIMAL_MAXIMUM / TIMING_GENERATOR_PULSE_RATE_CLOCK_MANTISSA)) {
+      return -1;
+    }
+
+    ret = menlo_cnc_decimal_scale_divide(
+        mantissa * TIMING_GENERATOR_PULSE_RATE_CLOCK_MANTISSA,
+        exponent + TIMING_GENERATOR_PULSE_RATE_CLOCK_EXPONENT,
+        1,
+        TIMING_GENERATOR_MAXIMUM_CLOCK_PERIOD_COUNT - 1,
+        &pulse_rate,
+        &exact
+        );
+
+    if ((ret != 0) || (pulse_rate == 0)) {
+#if DBG_TRACE
+      printf("pulse_rate_by_decimal_period out of range %llue%d\n", mantissa, exponent);
+#endif
+      return -1;
+    }
+
+    *binary_pulse_rate = (unsigned long)pulse_rate;
+
+    return 0;
+}
+
+int
+menlo_cnc_registers_calculate_pulse_width_by_decimal_period(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long long mantissa,
+    int exponent,
+    unsigned long* binary_pulse_width
+    )
+{
+    int ret;
+    int exact;
+    unsigned long long periods;
+
+    if (mantissa == 0) {
+      *binary_pulse_width = 0;
+      return 0;
+    }
+
+    //
+    // Nanoseconds divided by the clock period and any scale factor.
+    //
+    ret = menlo_cnc_decimal_scale_divide(
+        mantissa,
+        exponent + 9,
+        TIMING_GENERATOR_BASE_CLOCK_PERIOD_IN_NANOSECONDS * TIMING_GENERATOR_PULSE_WIDTH_SCALE_FACTOR,
+        TIMING_GENERATOR_MAXIMUM_PULSE_WIDTH_COUNT,
+        &periods,
+        &exact
+        );
+
+    if ((ret != 0) || (periods == 0)) {
+#if DBG_TRACE
+      printf("pulse_width_by_decimal_period out of range %llue%d\n", mantissa, exponent);
 #endif
       return -1;
     }
@@ -664,8 +917,10 @@ menlo_cnc_registers_initialize(
     PMENLO_CNC_REGISTERS registers
     )
 {
+    int index;
     unsigned long status;
     unsigned long value;
+    volatile MENLO_CNC_AXIS_REGISTERS* axis;
 
 #if DBG_TRACE2
     printf("menlo_cnc_registers_initialize entered registers=0x%lx\n", (unsigned long)registers);
@@ -726,7 +981,7 @@ menlo_cnc_registers_initialize(
     printf("interface_serial_number 0x%lx\n", value);
 #endif
 
-    registers->command = 0;
+    MENLO_CNC_WRITE_COMMAND(registers, 0);
 
 #if DBG_TRACE2
     printf("menlo_cnc_registers_initialize survived first store\n");
@@ -736,29 +991,16 @@ menlo_cnc_registers_initialize(
     registers->reserved2 = 0;
     registers->reserved3 = 0;
 
-    registers->x_pulse_rate = 0;
-    registers->x_pulse_count = 0;
-    registers->x_pulse_width = 0;
-    registers->x_pulse_instruction = 0;
+    axis = MENLO_CNC_REGISTERS_AXIS(registers);
 
-    registers->y_pulse_rate = 0;
-    registers->y_pulse_count = 0;
-    registers->y_pulse_width = 0;
-    registers->y_pulse_instruction = 0;
-
-    registers->z_pulse_rate = 0;
-    registers->z_pulse_count = 0;
-    registers->z_pulse_width = 0;
-    registers->z_pulse_instruction = 0;
-
-    registers->a_pulse_rate = 0;
-    registers->a_pulse_count = 0;
-    registers->a_pulse_width = 0;
-    registers->a_pulse_instruction = 0;
-
-    // TODO: Initialize optional axis
+    for (index = 0; index < MENLO_CNC_REGISTERS_AXIS_SLOTS; index++) {
+        axis[index].pulse_rate = 0;
+        axis[index].pulse_count = 0;
+        axis[index].pulse_width = 0;
+        axis[index].pulse_instruction = 0;
+    }
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
   
@@ -778,11 +1020,11 @@ menlo_cnc_reset_timing_engine(
 {
     unsigned long status;
 
-    registers->command = MENLO_CNC_REGISTERS_COMMAND_RST;
+    MENLO_CNC_WRITE_COMMAND(registers, MENLO_CNC_REGISTERS_COMMAND_RST);
 
-    registers->command = 0;
+    MENLO_CNC_WRITE_COMMAND(registers, 0);
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -800,7 +1042,7 @@ menlo_cnc_read_status(
 {
     unsigned long status;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -819,10 +1061,10 @@ menlo_cnc_wait_for_fifo_ready(
 {
     unsigned long status;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     while ((status & MENLO_CNC_REGISTERS_STATUS_FBF) != 0) {
-        status = registers->status;
+        status = MENLO_CNC_READ_STATUS(registers);
 
         if (status & MENLO_CNC_REGISTERS_STATUS_EMS) {
           // ESTOP
@@ -854,9 +1096,9 @@ menlo_cnc_load_command(
 {
     unsigned long status;
 
-    registers->command = command;
+    MENLO_CNC_WRITE_COMMAND(registers, command);
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -896,7 +1138,7 @@ menlo_cnc_registers_set_value_to_all_axis(
 
     // TODO: set optional axis
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
   
@@ -1041,7 +1283,7 @@ menlo_cnc_registers_validate_value_from_all_axis(
     // triggered an error condition.
     //
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
         *register_in_error = 0;
@@ -1082,7 +1324,7 @@ menlo_cnc_registers_set_number_to_each_register(
     registers->a_pulse_width = 18;
     registers->a_pulse_instruction = 19;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1212,7 +1454,7 @@ menlo_cnc_registers_validate_number_from_each_register(
         return MENLO_CNC_REGISTERS_STATUS_ERR;
     }
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1242,7 +1484,7 @@ menlo_cnc_load_axis_x(
     registers->x_pulse_width = pulse_width;
     registers->x_pulse_instruction = instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1263,7 +1505,7 @@ menlo_cnc_load_axis_y(
     registers->y_pulse_width = pulse_width;
     registers->y_pulse_instruction = instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1284,7 +1526,7 @@ menlo_cnc_load_axis_z(
     registers->z_pulse_width = pulse_width;
     registers->z_pulse_instruction = instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1305,7 +1547,7 @@ menlo_cnc_load_axis_a(
     registers->a_pulse_width = pulse_width;
     registers->a_pulse_instruction = instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1346,7 +1588,7 @@ menlo_cnc_load_four_axis(
     registers->x_pulse_width = x->pulse_width;
     registers->x_pulse_instruction = x->instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
     if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
         return status;
     }
@@ -1356,7 +1598,7 @@ menlo_cnc_load_four_axis(
     registers->y_pulse_width = y->pulse_width;
     registers->y_pulse_instruction = y->instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
     if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
         return status;
     }
@@ -1366,7 +1608,7 @@ menlo_cnc_load_four_axis(
     registers->z_pulse_width = z->pulse_width;
     registers->z_pulse_instruction = z->instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
     if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
         return status;
     }
@@ -1376,7 +1618,7 @@ menlo_cnc_load_four_axis(
     registers->a_pulse_width = a->pulse_width;
     registers->a_pulse_instruction = a->instruction;
 
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
     if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
         return status;
     }
@@ -1397,10 +1639,213 @@ menlo_cnc_load_four_axis(
     // This could start axis motion.
     //
 
-    registers->command = command;
+    MENLO_CNC_WRITE_COMMAND(registers, command);
+
+    // Return the status
+    status = MENLO_CNC_READ_STATUS(registers);
+
+    return status;
+}
+
+//
+// Load an instruction block for axis_count axis starting from X.
+//
+// The block is in register order so this is a single sequential copy
+// of axis_count * 4 registers regardless of the number of axis.
+//
+// Returns:
+//
+// Value of Status register on error or success.
+//
+unsigned long
+menlo_cnc_load_block(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY block,
+    int axis_count
+    )
+{
+    int index;
+    int count;
+    unsigned long status;
+    unsigned long* source;
+    volatile unsigned long* target;
+
+    source = (unsigned long*)&block->axis[0];
+    target = (volatile unsigned long*)MENLO_CNC_REGISTERS_AXIS(registers);
+
+    count = axis_count * (sizeof(MENLO_CNC_AXIS_REGISTERS) / sizeof(unsigned long));
+
+    for (index = 0; index < count; index++) {
+        target[index] = source[index];
+    }
+
+    //
+    // If an error is set after loading the axis return
+    // the status and don't load the command.
+    //
+    status = MENLO_CNC_READ_STATUS(registers);
+    if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
+        return status;
+    }
+
+    //
+    // Wait for the FIFO to not be busy.
+    //
+    status = menlo_cnc_wait_for_fifo_ready(registers);
+
+    if ((status & MENLO_CNC_REGISTERS_STATUS_FBF) != 0) {
+      // Buffer still full, must have returned due to an error, or ESTOP.
+      return status;
+    }
+
+    //
+    // Now load the instruction block into the FIFO.
+    //
+    // This could start axis motion.
+    //
+
+    MENLO_CNC_WRITE_COMMAND(registers, command);
+
+    // Return the status
+    status = MENLO_CNC_READ_STATUS(registers);
+
+    return status;
+}
+
+//
+// Load an instruction block writing only the changed axis registers.
+//
+// Compressed programs change a few registers between blocks, often
+// only a pulse count, so this saves most of the bus writes of
+// menlo_cnc_load_block() for them.
+//
+// Returns:
+//
+// Value of Status register on error or success.
+//
+unsigned long
+menlo_cnc_load_block_changes(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY block,
+    unsigned long long changed
+    )
+{
+    int index;
+    unsigned long status;
+    unsigned long* source;
+    volatile unsigned long* target;
+
+    source = (unsigned long*)&block->axis[0];
+    target = (volatile unsigned long*)MENLO_CNC_REGISTERS_AXIS(registers);
+
+    while (changed != 0) {
+        index = __builtin_ctzll(changed);
+        changed &= changed - 1;
+
+        target[index] = source[index];
+    }
+
+    //
+    // If an error is set after loading the axis return
+    // the status and don't load the command.
+    //
+    status = MENLO_CNC_READ_STATUS(registers);
+    if ((status & MENLO_CNC_REGISTERS_STATUS_ERR) != 0) {
+        return status;
+    }
+
+    //
+    // Wait for the FIFO to not be busy.
+    //
+    status = menlo_cnc_wait_for_fifo_ready(registers);
+
+    if ((status & MENLO_CNC_REGISTERS_STATUS_FBF) != 0) {
+      // Buffer still full, must have returned due to an error, or ESTOP.
+      return status;
+    }
+
+    //
+    // Now load the instruction block into the FIFO.
+    //
+    // This could start axis motion.
+    //
+
+    MENLO_CNC_WRITE_COMMAND(registers, command);
+
+    // Return the status
+    status = MENLO_CNC_READ_STATUS(registers);
+
+    return status;
+}
+
+//
+// Load a batch of instruction blocks with a single status check.
+//
+// menlo_cnc_load_block() reads status after the axis registers and
+// spins on it for FIFO space before each command. These are uncached
+// reads across the bridge which cost more than the writes, so here
+// the space for the batch is reserved up front from the FIFO depth.
+//
+// Returns:
+//
+// Value of Status register on error or success.
+//
+unsigned long
+menlo_cnc_load_blocks(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY blocks,
+    unsigned long count,
+    int axis_count,
+    unsigned long fifo_capacity,
+    unsigned long* loaded
+    )
+{
+    int index;
+    int words;
+    unsigned long block;
+    unsigned long depth;
+    unsigned long status;
+    unsigned long* source;
+    volatile unsigned long* target;
+
+    *loaded = 0;
+
+    status = MENLO_CNC_READ_STATUS(registers);
+    if ((status & MENLO_CNC_REGISTERS_ERROR_MASK) != 0) {
+        return status;
+    }
+
+    depth = MENLO_CNC_READ_FIFO_DEPTH(registers);
+    if (depth >= fifo_capacity) {
+        return status;
+    }
+
+    if (count > (fifo_capacity - depth)) {
+        count = fifo_capacity - depth;
+    }
+
+    target = (volatile unsigned long*)MENLO_CNC_REGISTERS_AXIS(registers);
+
+    words = axis_count * (sizeof(MENLO_CNC_AXIS_REGISTERS) / sizeof(unsigned long));
+
+    for (block = 0; block < count; block++) {
+
+        source = (unsigned long*)&blocks[block].axis[0];
+
+        for (index = 0; index < words; index++) {
+            target[index] = source[index];
+        }
+
+        MENLO_CNC_WRITE_COMMAND(registers, command);
+    }
+
+    *loaded = count;
 
     // Return the status
-    status = registers->status;
+    status = MENLO_CNC_READ_STATUS(registers);
 
     return status;
 }
@@ -1426,7 +1871,7 @@ menlo_cnc_registers_reset_sfe(
     )
 {
   // Clear it through the status clear bits register
-  registers->statusclearbits = MENLO_CNC_REGISTERS_STATUS_SFE;
+  MENLO_CNC_WRITE_STATUSCLEARBITS(registers, MENLO_CNC_REGISTERS_STATUS_SFE);
 
   return 0;
 }
@@ -1436,7 +1881,7 @@ menlo_cnc_registers_get_fifo_depth(
     PMENLO_CNC_REGISTERS registers
     )
 {
-  return registers->current_fifo_depth;
+  return MENLO_CNC_READ_FIFO_DEPTH(registers);
 }
 
 int
@@ -732,6 +732,53 @@ typedef struct _MENLO_CNC_REGISTERS {
 
 } *PMENLO_CNC_REGISTERS, MENLO_CNC_REGISTERS;
 
+//
+// Axis register slots x_pulse_rate through w_pulse_instruction.
+//
+// Each slot is pulse_rate, pulse_count, pulse_width, pulse_instruction
+// at a stride of 4 registers so the slots may be addressed as an
+// array with MENLO_CNC_REGISTERS_AXIS().
+//
+typedef struct _MENLO_CNC_AXIS_REGISTERS {
+    unsigned long pulse_rate;
+    unsigned long pulse_count;
+    unsigned long pulse_width;
+    unsigned long pulse_instruction;
+} *PMENLO_CNC_AXIS_REGISTERS, MENLO_CNC_AXIS_REGISTERS;
+
+#define MENLO_CNC_REGISTERS_AXIS_SLOTS 9
+
+#define MENLO_CNC_REGISTERS_AXIS(registers) \
+    ((volatile MENLO_CNC_AXIS_REGISTERS*)&(registers)->x_pulse_rate)
+
+//
+// Axis slot index
+//
+#define MENLO_CNC_AXIS_X 0
+#define MENLO_CNC_AXIS_Y 1
+#define MENLO_CNC_AXIS_Z 2
+#define MENLO_CNC_AXIS_A 3
+#define MENLO_CNC_AXIS_B 4
+#define MENLO_CNC_AXIS_C 5
+#define MENLO_CNC_AXIS_U 6
+#define MENLO_CNC_AXIS_V 7
+#define MENLO_CNC_AXIS_W 8
+
+//
+// Number of axis in an instruction block, starting from X.
+//
+// This sets the binary file record and loader block size for the
+// build. Programs may use fewer, the axis count from their CONFIG
+// block determines how many slots the loader writes.
+//
+#ifndef MENLO_CNC_AXIS_COUNT
+#define MENLO_CNC_AXIS_COUNT 4
+#endif
+
+#if (MENLO_CNC_AXIS_COUNT < 4) || (MENLO_CNC_AXIS_COUNT > MENLO_CNC_REGISTERS_AXIS_SLOTS)
+#error MENLO_CNC_AXIS_COUNT must be from 4 to 9
+#endif
+
 #define MENLO_CNC_REGISTERS_INTERFACE_VERSION 0x00000002
 
 #define MENLO_CNC_REGISTERS_SERIAL_NUMBER     0x12345678
@@ -840,6 +887,16 @@ typedef struct _MENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY {
   MENLO_CNC_AXIS_OPCODE_BINARY a;
 } MENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY, *PMENLO_CNC_OPCODE_BLOCK_FOUR_AXIS_BINARY;
 
+//
+// Instruction block in register order.
+//
+// Each axis is laid out as its register slot so a block is loaded
+// by a single sequential copy into the register file.
+//
+typedef struct _MENLO_CNC_OPCODE_BLOCK_BINARY {
+  MENLO_CNC_AXIS_REGISTERS axis[MENLO_CNC_AXIS_COUNT];
+} MENLO_CNC_OPCODE_BLOCK_BINARY, *PMENLO_CNC_OPCODE_BLOCK_BINARY;
+
 //
 // Published routines from menlo_cnc.c
 //
@@ -1002,6 +1059,80 @@ menlo_cnc_load_four_axis(
     PMENLO_CNC_AXIS_OPCODE_BINARY a
     );
 
+//
+// Load an instruction block for axis_count axis starting from X.
+//
+// The axis registers are written in a single pass and the status is
+// checked once before the command is written, otherwise the same as
+// menlo_cnc_load_four_axis().
+//
+// axis_count is from 1 to MENLO_CNC_AXIS_COUNT.
+//
+// Returns:
+//
+// Value of Status register on error or success.
+//
+unsigned long
+menlo_cnc_load_block(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY block,
+    int axis_count
+    );
+
+//
+// Load an instruction block writing only the axis registers whose bit
+// is set in changed, bit (axis * 4) + register in register order from
+// pulse_rate of X.
+//
+// The other axis registers must already hold their values for this
+// block, as they do when the previous block loaded was this block
+// with those registers unchanged. A changed of 0 loads the previous
+// block again.
+//
+// Returns:
+//
+// Value of Status register on error or success.
+//
+unsigned long
+menlo_cnc_load_block_changes(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY block,
+    unsigned long long changed
+    );
+
+//
+// Load up to count instruction blocks for axis_count axis back to back.
+//
+// fifo_capacity is the number of blocks the FIFO holds, normally
+// MENLO_CNC_FIFO_CAPACITY. The free space is read once from the FIFO
+// depth register and at most that many blocks are loaded, which can't
+// overfill the FIFO as it only drains meanwhile. So each block is its
+// axis registers and command with no status reads or FIFO waits in
+// between, and the status is read once for the batch.
+//
+// An error set by a block is seen at the end of the batch rather than
+// before the next command, so callers keep batches short.
+//
+// *loaded is set to the number of blocks loaded, 0 if the FIFO was
+// full or status had an error on entry.
+//
+// Returns:
+//
+// Value of Status register on error or success.
+//
+unsigned long
+menlo_cnc_load_blocks(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command,
+    PMENLO_CNC_OPCODE_BLOCK_BINARY blocks,
+    unsigned long count,
+    int axis_count,
+    unsigned long fifo_capacity,
+    unsigned long* loaded
+    );
+
 //
 // Note: Calculation routines try and stay with 32 bit unsigned
 // integers so they may be handled by a weak "soft" FPGA processor
@@ -1062,6 +1193,28 @@ menlo_cnc_load_four_axis(
 // Pulse width scale factor is base clock rate divided by stages scale factor.
 #define TIMING_GENERATOR_PULSE_WIDTH_SCALE_FACTOR   1
 
+// Instruction blocks held by the command FIFO.
+#define MENLO_CNC_FIFO_CAPACITY                     512
+
+//
+// This must track above. It's the base clock rate divided by the
+// pulse rate scale factor as a decimal mantissa and exponent for
+// the fixed point calculations.
+//
+// 50Mhz / 4 == 125 * 10^5
+//
+#define TIMING_GENERATOR_PULSE_RATE_CLOCK_MANTISSA  125
+#define TIMING_GENERATOR_PULSE_RATE_CLOCK_EXPONENT  5
+
+//
+// Fixed point values are unsigned 64 bit integers.
+//
+// Mantissas are less than the limit so they can be scaled by the
+// clock mantissa and by 10 without overflow.
+//
+#define MENLO_CNC_DECIMAL_MAXIMUM          0xFFFFFFFFFFFFFFFFULL
+#define MENLO_CNC_DECIMAL_MANTISSA_LIMIT   100000000000000000ULL
+
 //
 // Calculates the number of clock periods for the given
 // frequency in HZ.
@@ -1154,6 +1307,69 @@ menlo_cnc_registers_calculate_pulse_width(
     unsigned long* binary_pulse_width
     );
 
+//
+// Exact fixed point versions of the above.
+//
+// The value is mantissa * 10^exponent as written in the source, so
+// 2.5khz is mantissa 25 exponent 2 and 10us is mantissa 10 exponent -6.
+// mantissa must be less than MENLO_CNC_DECIMAL_MANTISSA_LIMIT.
+//
+// Results are computed with 64 bit integer long division and
+// truncated as the double versions are, so they are the same on
+// every processor and need no floating point. The double versions
+// can be one less where the exact result is a whole number, such
+// as a pulse_rate for 10us.
+//
+// menlo_cnc_registers_calculate_pulse_rate_by_hz() uses this for
+// whole frequencies.
+//
+int
+menlo_cnc_registers_calculate_pulse_rate_by_decimal_hz(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long long mantissa,
+    int exponent,
+    unsigned long* binary_pulse_rate
+    );
+
+//
+// pulse_rate for a pulse period in seconds.
+//
+int
+menlo_cnc_registers_calculate_pulse_rate_by_decimal_period(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long long mantissa,
+    int exponent,
+    unsigned long* binary_pulse_rate
+    );
+
+//
+// pulse_width for a pulse width in seconds.
+//
+int
+menlo_cnc_registers_calculate_pulse_width_by_decimal_period(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long long mantissa,
+    int exponent,
+    unsigned long* binary_pulse_width
+    );
+
+//
+// floor(numerator * 10^exponent / denominator) in 64 bit integers.
+//
+// exact is set if there is no remainder.
+//
+// Returns -1 if the result is greater than maximum.
+//
+int
+menlo_cnc_decimal_scale_divide(
+    unsigned long long numerator,
+    int exponent,
+    unsigned long long denominator,
+    unsigned long long maximum,
+    unsigned long long* quotient,
+    int* exact
+    );
+
 //
 // Reset Sticky FIFO Empty.
 //
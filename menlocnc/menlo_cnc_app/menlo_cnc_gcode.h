@@ -0,0 +1,2 @@
+
+#include "../menlo_cnc_asm/menlo_cnc_gcode.h"
@@ -0,0 +1,344 @@
+//
+// Shared memory instruction ring for Menlo CNC Controller.
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// 06/24/2018
+//
+
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "menlo_cnc.h"
+#include "menlo_cnc_ring.h"
+
+//
+// The producer and consumer may be separate processes or processors
+// so ordering is through the gcc __atomic builtins rather than a lock.
+//
+#define RING_LOAD_ACQUIRE(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define RING_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+static PMENLO_CNC_OPCODE_BLOCK_BINARY
+menlo_cnc_ring_entry(
+    PMENLO_CNC_RING ring,
+    unsigned long index
+    )
+{
+  PMENLO_CNC_OPCODE_BLOCK_BINARY entries;
+
+  entries = (PMENLO_CNC_OPCODE_BLOCK_BINARY)(ring + 1);
+
+  return &entries[index & ring->entry_mask];
+}
+
+unsigned long
+menlo_cnc_ring_size(
+    unsigned long entry_count
+    )
+{
+  return sizeof(MENLO_CNC_RING) +
+         (entry_count * sizeof(MENLO_CNC_OPCODE_BLOCK_BINARY));
+}
+
+int
+menlo_cnc_ring_initialize(
+    PMENLO_CNC_RING ring,
+    unsigned long entry_count,
+    unsigned long axis_count
+    )
+{
+  if ((entry_count == 0) || ((entry_count & (entry_count - 1)) != 0)) {
+    return -1;
+  }
+
+  if ((axis_count == 0) || (axis_count > MENLO_CNC_AXIS_COUNT)) {
+    return -1;
+  }
+
+  memset(ring, 0, sizeof(MENLO_CNC_RING));
+
+  ring->entry_count = entry_count;
+  ring->entry_mask = entry_count - 1;
+  ring->axis_count = axis_count;
+  ring->entry_size = sizeof(MENLO_CNC_OPCODE_BLOCK_BINARY);
+  ring->version = MENLO_CNC_RING_VERSION;
+
+  ring->min_fifo_depth = MENLO_CNC_RING_FIFO_HIGH_WATER;
+
+  // Valid once magic is visible
+  RING_STORE_RELEASE(&ring->magic, MENLO_CNC_RING_MAGIC);
+
+  return 0;
+}
+
+int
+menlo_cnc_ring_validate(
+    PMENLO_CNC_RING ring,
+    unsigned long length
+    )
+{
+  if (length < sizeof(MENLO_CNC_RING)) {
+    return -1;
+  }
+
+  if (RING_LOAD_ACQUIRE(&ring->magic) != MENLO_CNC_RING_MAGIC) {
+    return -1;
+  }
+
+  if (ring->version != MENLO_CNC_RING_VERSION) {
+    return -1;
+  }
+
+  if ((ring->entry_count == 0) ||
+      (ring->entry_mask != (ring->entry_count - 1)) ||
+      ((ring->entry_count & ring->entry_mask) != 0)) {
+    return -1;
+  }
+
+  //
+  // Producer and consumer must be built for the same number of axis.
+  //
+  if ((ring->entry_size != sizeof(MENLO_CNC_OPCODE_BLOCK_BINARY)) ||
+      (ring->axis_count == 0) ||
+      (ring->axis_count > MENLO_CNC_AXIS_COUNT)) {
+    return -1;
+  }
+
+  if (length < menlo_cnc_ring_size(ring->entry_count)) {
+    return -1;
+  }
+
+  return 0;
+}
+
+unsigned long
+menlo_cnc_ring_count(
+    PMENLO_CNC_RING ring
+    )
+{
+  return RING_LOAD_ACQUIRE(&ring->head) - RING_LOAD_ACQUIRE(&ring->tail);
+}
+
+PMENLO_CNC_OPCODE_BLOCK_BINARY
+menlo_cnc_ring_reserve(
+    PMENLO_CNC_RING ring
+    )
+{
+  unsigned long head;
+
+  head = ring->head;
+
+  if ((head - RING_LOAD_ACQUIRE(&ring->tail)) == ring->entry_count) {
+    return NULL;
+  }
+
+  return menlo_cnc_ring_entry(ring, head);
+}
+
+void
+menlo_cnc_ring_commit(
+    PMENLO_CNC_RING ring
+    )
+{
+  RING_STORE_RELEASE(&ring->head, ring->head + 1);
+}
+
+void
+menlo_cnc_ring_set_producer_done(
+    PMENLO_CNC_RING ring
+    )
+{
+  RING_STORE_RELEASE(&ring->producer_done, 1);
+}
+
+int
+menlo_cnc_ring_is_consumer_done(
+    PMENLO_CNC_RING ring
+    )
+{
+  return (RING_LOAD_ACQUIRE(&ring->consumer_done) != 0);
+}
+
+unsigned long
+menlo_cnc_ring_consume(
+    PMENLO_CNC_RING ring,
+    PMENLO_CNC_REGISTERS registers
+    )
+{
+  unsigned long status;
+  unsigned long command;
+  unsigned long depth;
+  unsigned long head;
+  unsigned long tail;
+  unsigned long count;
+  unsigned long contiguous;
+  unsigned long loaded;
+  int axis_count;
+  PMENLO_CNC_OPCODE_BLOCK_BINARY target;
+
+  command = 0;
+  command |= (MENLO_CNC_REGISTERS_COMMAND_CMD |
+              MENLO_CNC_REGISTERS_COMMAND_EAN);
+
+  status = menlo_cnc_read_status(registers);
+
+  tail = ring->tail;
+
+  axis_count = (int)ring->axis_count;
+
+  //
+  // Clear Sticky FIFO Underrun before entering the real time loop.
+  //
+  menlo_cnc_registers_reset_sfe(registers);
+
+  //
+  // Begin real time Loop
+  //
+  while (1) {
+
+    head = RING_LOAD_ACQUIRE(&ring->head);
+
+    if (head == tail) {
+
+      if (RING_LOAD_ACQUIRE(&ring->producer_done)) {
+
+        // Producer may have published its last entries before done
+        head = RING_LOAD_ACQUIRE(&ring->head);
+
+        if (head == tail) {
+          break;
+        }
+      }
+      else {
+
+        // Waiting for the first entry is not a stall
+        if (ring->blocks_loaded != 0) {
+          ring->ring_empty_count++;
+        }
+
+        continue;
+      }
+    }
+
+    depth = menlo_cnc_registers_get_fifo_depth(registers);
+
+    if (depth >= MENLO_CNC_RING_FIFO_HIGH_WATER) {
+
+      //
+      // Full enough, wait for the low water mark while still
+      // watching for errors and ESTOP.
+      //
+      while (depth > MENLO_CNC_RING_FIFO_LOW_WATER) {
+
+        status = menlo_cnc_read_status(registers);
+        if (menlo_cnc_registers_is_error(status)) {
+          goto Done;
+        }
+
+        depth = menlo_cnc_registers_get_fifo_depth(registers);
+      }
+    }
+
+    if ((ring->blocks_loaded != 0) && (depth < ring->min_fifo_depth)) {
+      ring->min_fifo_depth = depth;
+    }
+
+    //
+    // Load a burst up to the high water mark from what is ready.
+    //
+    // Ready entries are loaded in batches up to the end of the ring
+    // with menlo_cnc_load_blocks(), which reserves the FIFO space for
+    // each batch from the depth register so there is a status check
+    // per batch rather than per block.
+    //
+    while ((tail != head) && (depth < MENLO_CNC_RING_FIFO_HIGH_WATER)) {
+
+      count = head - tail;
+
+      contiguous = (ring->entry_mask + 1) - (tail & ring->entry_mask);
+
+      if (count > contiguous) {
+        count = contiguous;
+      }
+
+      target = menlo_cnc_ring_entry(ring, tail);
+
+      status = menlo_cnc_load_blocks(
+          registers,
+          command,
+          target,
+          count,
+          axis_count,
+          MENLO_CNC_RING_FIFO_HIGH_WATER,
+          &loaded
+          );
+
+      ring->blocks_loaded += loaded;
+
+      if (menlo_cnc_registers_is_error(status)) {
+        goto Done;
+      }
+
+      // At the high water mark
+      if (loaded == 0) {
+        break;
+      }
+
+      tail += loaded;
+      depth += loaded;
+
+      // Return the entries to the producer
+      RING_STORE_RELEASE(&ring->tail, tail);
+    }
+
+    if (menlo_cnc_registers_is_underrun(status)) {
+
+      // Record it, don't abort
+      if (ring->underruns == 0) {
+        ring->first_underrun_block = ring->blocks_loaded;
+      }
+
+      ring->underruns++;
+
+      // Rearm it
+      menlo_cnc_registers_reset_sfe(registers);
+    }
+  }
+
+  //
+  // End real time Loop
+  //
+
+Done:
+
+  ring->status = status;
+
+  RING_STORE_RELEASE(&ring->consumer_done, 1);
+
+  return status;
+}
@@ -0,0 +1,222 @@
+//
+// Shared memory instruction ring for Menlo CNC Controller.
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// 06/24/2018
+//
+
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//
+// Single producer, single consumer ring of register ready
+// MENLO_CNC_OPCODE_BLOCK_BINARY instruction blocks.
+//
+// This is the shared memory region of architecture.txt. The host
+// converts compiled microcode into the ring and the real time
+// consumer drains it into the timing generator FIFO's, so host
+// scheduling latency is absorbed by the depth of the ring rather
+// than the depth of the FIFO.
+//
+// The ring is position independent, entries are located by offset
+// from the ring header, so it may be mapped at different addresses
+// by the producer and consumer. It may be placed in process memory,
+// POSIX shared memory, or memory shared with a soft processor.
+//
+// head is only written by the producer and tail only by the consumer,
+// each in its own 16 word group so they don't share a cache line.
+// No locks are used.
+//
+// menlo_cnc_ring_consume() is the consumer loop. It makes no system
+// calls and only uses the menlo_cnc.c register interface so it can
+// run on a dedicated core or a Nios II as well as the host.
+//
+
+#ifndef MENLO_CNC_RING_H
+#define MENLO_CNC_RING_H
+
+#define MENLO_CNC_RING_MAGIC   0x474E4952 // "RING"
+
+#define MENLO_CNC_RING_VERSION 2
+
+//
+// The consumer tops the hardware FIFO up to the high water mark,
+// then waits for it to drain to the low water mark before loading
+// the next burst. The hardware FIFO is 512 entries.
+//
+#define MENLO_CNC_RING_FIFO_HIGH_WATER 448
+#define MENLO_CNC_RING_FIFO_LOW_WATER  256
+
+typedef struct _MENLO_CNC_RING {
+
+  //
+  // Set by menlo_cnc_ring_initialize(), read only afterwards.
+  //
+  unsigned long magic;
+  unsigned long version;
+  unsigned long entry_count;
+  unsigned long entry_mask;
+
+  // Axis loaded from each entry, and sizeof each entry
+  unsigned long axis_count;
+  unsigned long entry_size;
+
+  unsigned long reserved0[10];
+
+  //
+  // Producer owned.
+  //
+  unsigned long head;
+
+  // No more entries will be added
+  unsigned long producer_done;
+
+  unsigned long reserved1[14];
+
+  //
+  // Consumer owned.
+  //
+  unsigned long tail;
+
+  // Consumer has stopped, results below are final
+  unsigned long consumer_done;
+
+  unsigned long reserved2[14];
+
+  //
+  // Consumer results, valid once consumer_done is set.
+  //
+
+  // Last status read from the timing generator
+  unsigned long status;
+
+  unsigned long blocks_loaded;
+
+  unsigned long underruns;
+
+  // Block count at which the first underrun was seen
+  unsigned long first_underrun_block;
+
+  // Times the consumer found the ring empty mid stream
+  unsigned long ring_empty_count;
+
+  // Lowest FIFO depth seen when refilling
+  unsigned long min_fifo_depth;
+
+  unsigned long reserved3[10];
+
+  // entry_count entries follow
+
+} MENLO_CNC_RING, *PMENLO_CNC_RING;
+
+//
+// Bytes required for a ring of entry_count entries.
+//
+unsigned long
+menlo_cnc_ring_size(
+    unsigned long entry_count
+    );
+
+//
+// entry_count must be a power of 2.
+//
+// axis_count is the number of axis from X the consumer loads from
+// each entry, from 1 to MENLO_CNC_AXIS_COUNT.
+//
+// Returns 0 on success.
+//
+int
+menlo_cnc_ring_initialize(
+    PMENLO_CNC_RING ring,
+    unsigned long entry_count,
+    unsigned long axis_count
+    );
+
+//
+// Validate a ring mapped from shared memory.
+//
+// Returns 0 on success.
+//
+int
+menlo_cnc_ring_validate(
+    PMENLO_CNC_RING ring,
+    unsigned long length
+    );
+
+//
+// Number of entries in the ring, may be called from either side.
+//
+unsigned long
+menlo_cnc_ring_count(
+    PMENLO_CNC_RING ring
+    );
+
+//
+// Producer
+//
+
+//
+// Returns the next free entry or NULL if the ring is full. It is
+// not visible to the consumer until menlo_cnc_ring_commit().
+//
+PMENLO_CNC_OPCODE_BLOCK_BINARY
+menlo_cnc_ring_reserve(
+    PMENLO_CNC_RING ring
+    );
+
+void
+menlo_cnc_ring_commit(
+    PMENLO_CNC_RING ring
+    );
+
+void
+menlo_cnc_ring_set_producer_done(
+    PMENLO_CNC_RING ring
+    );
+
+int
+menlo_cnc_ring_is_consumer_done(
+    PMENLO_CNC_RING ring
+    );
+
+//
+// Consumer
+//
+
+//
+// Load every entry from the ring into the timing generator until
+// the producer is done and the ring is empty, or an error occurs.
+//
+// Underruns are recorded and don't stop the stream.
+//
+// Returns the last status and sets consumer_done.
+//
+unsigned long
+menlo_cnc_ring_consume(
+    PMENLO_CNC_RING ring,
+    PMENLO_CNC_REGISTERS registers
+    );
+
+#endif // MENLO_CNC_RING_H
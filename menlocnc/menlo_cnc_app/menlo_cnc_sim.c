@@ -0,0 +1,444 @@
+//
+// Simulated register file for Menlo CNC Controller.
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// 06/22/2018
+//
+
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "menlo_cnc.h"
+#include "menlo_cnc_sim.h"
+
+//
+// The register file is the first member so the PMENLO_CNC_REGISTERS
+// handed to menlo_cnc.c is also the simulator context.
+//
+typedef struct _MENLO_CNC_SIM {
+  MENLO_CNC_REGISTERS registers;
+
+  // FIFO of block durations in timing generator clocks
+  unsigned long long* fifo;
+  unsigned long fifo_depth;
+  unsigned long fifo_head;
+  unsigned long fifo_count;
+
+  // Clocks left on the executing block, 0 when not busy
+  unsigned long long remaining;
+
+  // Timing generator clock of the last update
+  unsigned long long clock;
+  struct timespec start_time;
+
+  // A block has been loaded since the last SFE clear
+  int loaded_since_clear;
+
+  unsigned long sticky_status;
+
+  MENLO_CNC_SIM_STATISTICS statistics;
+} MENLO_CNC_SIM, *PMENLO_CNC_SIM;
+
+unsigned long long
+menlo_cnc_sim_get_clock(
+    PMENLO_CNC_SIM sim
+    )
+{
+  struct timespec now;
+  unsigned long long nanoseconds;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  nanoseconds =
+    (unsigned long long)(now.tv_sec - sim->start_time.tv_sec) * 1000000000ULL;
+
+  nanoseconds += now.tv_nsec;
+  nanoseconds -= sim->start_time.tv_nsec;
+
+  return nanoseconds / TIMING_GENERATOR_BASE_CLOCK_PERIOD_IN_NANOSECONDS;
+}
+
+//
+// Clocks the timing generator runs for a single axis.
+//
+unsigned long long
+menlo_cnc_sim_axis_clocks(
+    unsigned long instruction,
+    unsigned long pulse_rate,
+    unsigned long pulse_count
+    )
+{
+  if ((instruction & MENLO_CNC_REGISTERS_INSTRUCTION_MASK) == MENLO_CNC_OPCODE_NOP) {
+    return 0;
+  }
+
+  return (unsigned long long)pulse_rate *
+         TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR *
+         pulse_count;
+}
+
+//
+// The block completes when its longest axis completes.
+//
+unsigned long long
+menlo_cnc_sim_block_clocks(
+    PMENLO_CNC_REGISTERS r
+    )
+{
+  int index;
+  unsigned long long clocks;
+  unsigned long long axis;
+  volatile MENLO_CNC_AXIS_REGISTERS* slot;
+
+  slot = MENLO_CNC_REGISTERS_AXIS(r);
+
+  clocks = 0;
+
+  for (index = 0; index < MENLO_CNC_REGISTERS_AXIS_SLOTS; index++) {
+    axis = menlo_cnc_sim_axis_clocks(slot[index].pulse_instruction,
+                                     slot[index].pulse_rate,
+                                     slot[index].pulse_count);
+    if (axis > clocks) clocks = axis;
+  }
+
+  //
+  // An all NOP block still takes a clock to pass through
+  // the timing generator.
+  //
+  if (clocks == 0) {
+    clocks = 1;
+  }
+
+  return clocks;
+}
+
+int
+menlo_cnc_sim_is_reserved_opcode(
+    unsigned long instruction
+    )
+{
+  return ((instruction & MENLO_CNC_REGISTERS_INSTRUCTION_MASK) > MENLO_CNC_OPCCODE_PWM);
+}
+
+//
+// Advance the timing generator to the current time.
+//
+void
+menlo_cnc_sim_update(
+    PMENLO_CNC_SIM sim
+    )
+{
+  unsigned long long now;
+  unsigned long long elapsed;
+  unsigned long long step;
+  unsigned long status;
+
+  now = menlo_cnc_sim_get_clock(sim);
+
+  elapsed = now - sim->clock;
+
+  sim->clock = now;
+
+  //
+  // Paused or ESTOP, time passes without execution.
+  //
+  if (((sim->registers.command & MENLO_CNC_REGISTERS_COMMAND_EAN) == 0) ||
+      ((sim->registers.command & MENLO_CNC_REGISTERS_COMMAND_EMS) != 0)) {
+    elapsed = 0;
+  }
+
+  while (elapsed != 0) {
+
+    if (sim->remaining == 0) {
+
+      if (sim->fifo_count == 0) {
+
+        // Starved, accounted for on the next load
+        if (sim->statistics.blocks_executed != 0) {
+          sim->statistics.starved_clocks += elapsed;
+        }
+
+        break;
+      }
+
+      sim->remaining = sim->fifo[sim->fifo_head];
+
+      sim->fifo_head = (sim->fifo_head + 1) % sim->fifo_depth;
+      sim->fifo_count--;
+
+      sim->statistics.blocks_executed++;
+    }
+
+    step = sim->remaining;
+    if (step > elapsed) {
+      step = elapsed;
+    }
+
+    sim->remaining -= step;
+    elapsed -= step;
+
+    sim->statistics.busy_clocks += step;
+  }
+
+  //
+  // SFE is set when the timing generator reaches a block boundary
+  // with nothing in the FIFO. A block that starts on an idle timing
+  // generator leaves the FIFO empty while it executes, that is not
+  // an underrun.
+  //
+  if ((sim->remaining == 0) && (sim->fifo_count == 0) &&
+      sim->loaded_since_clear && (sim->statistics.blocks_executed != 0)) {
+    sim->sticky_status |= MENLO_CNC_REGISTERS_STATUS_SFE;
+  }
+
+  //
+  // Refresh the register file so a debugger or a direct read
+  // sees the same values as the accessors.
+  //
+  status = sim->sticky_status;
+
+  if (sim->fifo_count >= sim->fifo_depth) {
+    status |= MENLO_CNC_REGISTERS_STATUS_FBF;
+  }
+
+  if (sim->fifo_count == 0) {
+    status |= MENLO_CNC_REGISTERS_STATUS_FBE;
+  }
+
+  if (sim->remaining != 0) {
+    status |= MENLO_CNC_REGISTERS_STATUS_BSY;
+  }
+  else if (sim->fifo_count == 0) {
+    status |= MENLO_CNC_REGISTERS_STATUS_IDL;
+  }
+
+  if ((sim->registers.command & MENLO_CNC_REGISTERS_COMMAND_EMS) != 0) {
+    status |= MENLO_CNC_REGISTERS_STATUS_EMS;
+  }
+
+  sim->registers.status = status;
+  sim->registers.current_fifo_depth = sim->fifo_count;
+}
+
+void
+menlo_cnc_sim_reset(
+    PMENLO_CNC_SIM sim
+    )
+{
+  sim->fifo_head = 0;
+  sim->fifo_count = 0;
+  sim->remaining = 0;
+  sim->loaded_since_clear = 0;
+  sim->sticky_status = 0;
+
+  memset(&sim->statistics, 0, sizeof(sim->statistics));
+
+  clock_gettime(CLOCK_MONOTONIC, &sim->start_time);
+  sim->clock = 0;
+
+  menlo_cnc_sim_update(sim);
+}
+
+PMENLO_CNC_REGISTERS
+menlo_cnc_sim_create(
+    unsigned long fifo_depth
+    )
+{
+  PMENLO_CNC_SIM sim;
+
+  if (fifo_depth == 0) {
+    return NULL;
+  }
+
+  sim = (PMENLO_CNC_SIM)malloc(sizeof(MENLO_CNC_SIM));
+  if (sim == NULL) {
+    return NULL;
+  }
+
+  memset(sim, 0, sizeof(MENLO_CNC_SIM));
+
+  sim->fifo = (unsigned long long*)malloc(sizeof(unsigned long long) * fifo_depth);
+  if (sim->fifo == NULL) {
+    free(sim);
+    return NULL;
+  }
+
+  sim->fifo_depth = fifo_depth;
+
+  sim->registers.hexafives = 0xA5A5A5A5;
+  sim->registers.hexfiveas = 0x5A5A5A5A;
+  sim->registers.interface_version = MENLO_CNC_REGISTERS_INTERFACE_VERSION;
+  sim->registers.interface_serial_number = MENLO_CNC_REGISTERS_SERIAL_NUMBER;
+
+  menlo_cnc_sim_reset(sim);
+
+  return &sim->registers;
+}
+
+void
+menlo_cnc_sim_destroy(
+    PMENLO_CNC_REGISTERS registers
+    )
+{
+  PMENLO_CNC_SIM sim = (PMENLO_CNC_SIM)registers;
+
+  free(sim->fifo);
+  free(sim);
+}
+
+unsigned long
+menlo_cnc_sim_read_status(
+    PMENLO_CNC_REGISTERS registers
+    )
+{
+  PMENLO_CNC_SIM sim = (PMENLO_CNC_SIM)registers;
+
+  menlo_cnc_sim_update(sim);
+
+  sim->statistics.register_reads++;
+
+  if ((registers->status & MENLO_CNC_REGISTERS_STATUS_FBF) != 0) {
+    sim->statistics.fifo_full_reads++;
+  }
+
+  return registers->status;
+}
+
+void
+menlo_cnc_sim_write_command(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command
+    )
+{
+  PMENLO_CNC_SIM sim = (PMENLO_CNC_SIM)registers;
+  int index;
+  unsigned long tail;
+  volatile MENLO_CNC_AXIS_REGISTERS* slot;
+
+  // Run up to the write with the previous EAN/EMS state
+  menlo_cnc_sim_update(sim);
+
+  if ((command & MENLO_CNC_REGISTERS_COMMAND_RST) != 0) {
+    registers->command = command;
+    menlo_cnc_sim_reset(sim);
+    return;
+  }
+
+  // CMD always reads as 0
+  registers->command = command & ~MENLO_CNC_REGISTERS_COMMAND_CMD;
+
+  if ((command & MENLO_CNC_REGISTERS_COMMAND_CMD) == 0) {
+    menlo_cnc_sim_update(sim);
+    return;
+  }
+
+  if (sim->fifo_count >= sim->fifo_depth) {
+    sim->sticky_status |= MENLO_CNC_REGISTERS_STATUS_ERR;
+    menlo_cnc_sim_update(sim);
+    return;
+  }
+
+  slot = MENLO_CNC_REGISTERS_AXIS(registers);
+
+  for (index = 0; index < MENLO_CNC_REGISTERS_AXIS_SLOTS; index++) {
+    if (menlo_cnc_sim_is_reserved_opcode(slot[index].pulse_instruction)) {
+      sim->sticky_status |= MENLO_CNC_REGISTERS_STATUS_ERR;
+    }
+  }
+
+  //
+  // The timing generator ran dry before this block arrived.
+  //
+  if ((sim->remaining == 0) && (sim->fifo_count == 0) &&
+      (sim->statistics.blocks_executed != 0)) {
+    sim->statistics.underruns++;
+  }
+
+  tail = (sim->fifo_head + sim->fifo_count) % sim->fifo_depth;
+
+  sim->fifo[tail] = menlo_cnc_sim_block_clocks(registers);
+  sim->fifo_count++;
+
+  sim->loaded_since_clear = 1;
+
+  sim->statistics.blocks_loaded++;
+
+  if (sim->fifo_count > sim->statistics.max_fifo_depth) {
+    sim->statistics.max_fifo_depth = sim->fifo_count;
+  }
+
+  // Start execution if idle
+  menlo_cnc_sim_update(sim);
+}
+
+void
+menlo_cnc_sim_write_statusclearbits(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long bits
+    )
+{
+  PMENLO_CNC_SIM sim = (PMENLO_CNC_SIM)registers;
+
+  menlo_cnc_sim_update(sim);
+
+  sim->sticky_status &= ~bits;
+
+  if ((bits & MENLO_CNC_REGISTERS_STATUS_SFE) != 0) {
+    sim->loaded_since_clear = 0;
+  }
+
+  menlo_cnc_sim_update(sim);
+}
+
+unsigned long
+menlo_cnc_sim_read_fifo_depth(
+    PMENLO_CNC_REGISTERS registers
+    )
+{
+  PMENLO_CNC_SIM sim = (PMENLO_CNC_SIM)registers;
+
+  menlo_cnc_sim_update(sim);
+
+  sim->statistics.register_reads++;
+
+  return registers->current_fifo_depth;
+}
+
+void
+menlo_cnc_sim_get_statistics(
+    PMENLO_CNC_REGISTERS registers,
+    PMENLO_CNC_SIM_STATISTICS statistics
+    )
+{
+  PMENLO_CNC_SIM sim = (PMENLO_CNC_SIM)registers;
+
+  menlo_cnc_sim_update(sim);
+
+  *statistics = sim->statistics;
+}
@@ -0,0 +1,144 @@
+//
+// Simulated register file for Menlo CNC Controller.
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// 06/22/2018
+//
+
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//
+// Software model of the timing generator register file so the
+// loader, streaming and benchmark paths can run on a host without
+// the DE10 FPGA.
+//
+// Built when MENLO_CNC_SIMULATOR is set. menlo_cnc.c then routes
+// status, command, status clear and FIFO depth register accesses
+// through this model, all other registers are plain memory.
+//
+// The model runs against the host monotonic clock. Each instruction
+// block occupies the timing generator for its longest axis:
+//
+//   pulse_rate * TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR * pulse_count
+//
+// clocks at TIMING_GENERATOR_BASE_CLOCK_RATE, NOP axis take no time.
+// So a loader that can't keep up with the programmed rate sees the
+// FIFO drain and SFE set just as it would on the machine.
+//
+// Status bits FBF, FBE, BSY, IDL, EMS and SFE are modeled. ERR is set
+// for reserved opcodes and for a CMD written while the FIFO is full.
+//
+// Not thread safe, the register file must be accessed by a single
+// thread at a time as the hardware streaming loops do.
+//
+
+#ifndef MENLO_CNC_SIM_H
+#define MENLO_CNC_SIM_H
+
+#define MENLO_CNC_SIM_DEFAULT_FIFO_DEPTH MENLO_CNC_FIFO_CAPACITY
+
+typedef struct _MENLO_CNC_SIM_STATISTICS {
+
+  // Blocks transferred into the FIFO by CMD
+  unsigned long blocks_loaded;
+
+  // Blocks started by the timing generator
+  unsigned long blocks_executed;
+
+  //
+  // Times a block was loaded after the timing generator had
+  // run out of work mid stream. The final drain at the end of a
+  // program is not counted.
+  //
+  unsigned long underruns;
+
+  // Status reads which returned FBF
+  unsigned long fifo_full_reads;
+
+  // Status and FIFO depth register reads
+  unsigned long register_reads;
+
+  // Largest FIFO depth reached
+  unsigned long max_fifo_depth;
+
+  // Clocks spent executing blocks
+  unsigned long long busy_clocks;
+
+  //
+  // Clocks idle with no work after the first block started,
+  // including after the final block.
+  //
+  unsigned long long starved_clocks;
+
+} MENLO_CNC_SIM_STATISTICS, *PMENLO_CNC_SIM_STATISTICS;
+
+//
+// Allocate a simulated register file with the given FIFO depth.
+//
+// Returns NULL on failure.
+//
+PMENLO_CNC_REGISTERS
+menlo_cnc_sim_create(
+    unsigned long fifo_depth
+    );
+
+void
+menlo_cnc_sim_destroy(
+    PMENLO_CNC_REGISTERS registers
+    );
+
+unsigned long
+menlo_cnc_sim_read_status(
+    PMENLO_CNC_REGISTERS registers
+    );
+
+void
+menlo_cnc_sim_write_command(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long command
+    );
+
+void
+menlo_cnc_sim_write_statusclearbits(
+    PMENLO_CNC_REGISTERS registers,
+    unsigned long bits
+    );
+
+unsigned long
+menlo_cnc_sim_read_fifo_depth(
+    PMENLO_CNC_REGISTERS registers
+    );
+
+//
+// Statistics are cleared by RST.
+//
+void
+menlo_cnc_sim_get_statistics(
+    PMENLO_CNC_REGISTERS registers,
+    PMENLO_CNC_SIM_STATISTICS statistics
+    );
+
+#endif // MENLO_CNC_SIM_H
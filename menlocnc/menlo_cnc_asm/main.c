@@ -89,11 +89,18 @@
 #include <stdlib.h> // exit
 
 #include <string.h> // strtok, bzero
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/resource.h> // getrusage
 
+#include "menlo_cnc.h"
 #include "menlo_cnc_asm.h"
+#include "menlo_cnc_gcode.h"
 
 void usage();
 
+int bench_assemble_file(char* fileName, int threads, int repeat);
+
 //
 // Standalone front end driver for menlo_cnc_asm.c library module.
 //
@@ -102,23 +109,198 @@ int
 main(int ac, char* av[])
 {
   int ret;
-  char* fileName;
+  int index;
+  int gcode = 0;
+  int compress = 0;
+  int disassemble = 0;
+  int analyze = 0;
+  unsigned long fifo_depth = 0;
+  double loader_rate = 0;
+  int threads = -1;
+  int repeat = 0;
+  int verbose;
+  char* fileName = NULL;
+  char* outputFileName = NULL;
+  double elapsed;
+  double program_time;
+  struct timespec start_time;
+  struct timespec end_time;
+  GCODE_STATISTICS statistics;
   PBLOCK_ARRAY binary = NULL;
+  PCOMPRESSED_PROGRAM program = NULL;
+  unsigned long compressed_bytes;
+  unsigned long binary_bytes;
   
-  if (ac < 2) {
+  for (index = 1; index < ac; index++) {
+
+    if (strcmp("-o", av[index]) == 0) {
+
+      if ((index + 1) >= ac) {
+        usage();
+      }
+
+      outputFileName = av[++index];
+    }
+    else if (strcmp("-gcode", av[index]) == 0) {
+      gcode = 1;
+    }
+    else if (strcmp("-z", av[index]) == 0) {
+      compress = 1;
+    }
+    else if (strcmp("-dis", av[index]) == 0) {
+      disassemble = 1;
+    }
+    else if (strcmp("-stats", av[index]) == 0) {
+      analyze = 1;
+    }
+    else if (strcmp("-depth", av[index]) == 0) {
+
+      if ((index + 1) >= ac) {
+        usage();
+      }
+
+      fifo_depth = strtoul(av[++index], NULL, 0);
+    }
+    else if (strcmp("-rate", av[index]) == 0) {
+
+      if ((index + 1) >= ac) {
+        usage();
+      }
+
+      loader_rate = atof(av[++index]);
+    }
+    else if (strcmp("-bench", av[index]) == 0) {
+
+      // Optional repeat count
+      repeat = 10;
+
+      if (((index + 1) < ac) && (av[index + 1][0] >= '0') && (av[index + 1][0] <= '9')) {
+        repeat = atoi(av[++index]);
+      }
+    }
+    else if (strcmp("-conformance", av[index]) == 0) {
+
+      // Optional verbose flag
+      verbose = 0;
+
+      if (((index + 1) < ac) && (strcmp("-v", av[index + 1]) == 0)) {
+        verbose = 1;
+        index++;
+      }
+
+      ret = pulse_timing_conformance_test(verbose);
+
+      if (gcode_conformance_test(verbose) != 0) {
+        ret = EINVAL;
+      }
+
+      return ret;
+    }
+    else if (strcmp("-mmap", av[index]) == 0) {
+      block_array_set_default_backing(BLOCK_ARRAY_BACKING_MMAP);
+    }
+    else if (strcmp("-hugetlb", av[index]) == 0) {
+      block_array_set_default_backing(BLOCK_ARRAY_BACKING_HUGETLB);
+    }
+    else if (strcmp("-j", av[index]) == 0) {
+
+      // Optional thread count, default one per processor
+      threads = 0;
+
+      if (((index + 1) < ac) && (av[index + 1][0] >= '0') && (av[index + 1][0] <= '9')) {
+        threads = atoi(av[++index]);
+      }
+    }
+    else if (fileName == NULL) {
+      fileName = av[index];
+    }
+    else {
+      usage();
+    }
+  }
+
+  if (fileName == NULL) {
     usage();
   }
 
-  fileName = av[1];
+  //
+  // fileName is a binary program file, or - for a pipe.
+  //
+  if (disassemble) {
+    return disassemble_binary_file(fileName);
+  }
 
-  ret = assemble_file(fileName, &binary);
+  if (analyze) {
+    return analyze_binary_file(fileName, fifo_depth, loader_rate);
+  }
 
-  if (ret != 0) {
-    printf("assembler error %d %s, exiting\n", ret, strerror(ret));
-    return ret;
+  if (repeat > 0) {
+    return bench_assemble_file(fileName, threads, repeat);
   }
 
-  printf("assembled %d opcode blocks\n", block_array_get_array_size(binary));
+  if (gcode) {
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    ret = compile_gcode_file(fileName, NULL, &binary, &statistics);
+
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    if (ret != 0) {
+      printf("gcode error %d %s, exiting\n", ret, strerror(ret));
+      return ret;
+    }
+
+    elapsed = (double)(end_time.tv_sec - start_time.tv_sec) +
+              ((double)(end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0);
+
+    program_time = (double)statistics.program_clocks / (double)TIMING_GENERATOR_BASE_CLOCK_RATE;
+
+    printf("compiled %ld lines, %ld moves, %ld arcs into %d opcode blocks\n",
+      statistics.lines,
+      statistics.moves,
+      statistics.arcs,
+      block_array_get_array_size(binary));
+
+    printf("compile time %g seconds, %g lines/sec, program time %g seconds, %g times real time\n",
+      elapsed,
+      (double)statistics.lines / elapsed,
+      program_time,
+      program_time / elapsed);
+  }
+  else if (threads >= 0) {
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    ret = assemble_file_parallel(fileName, threads, &binary);
+
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    if (ret != 0) {
+      printf("assembler error %d %s, exiting\n", ret, strerror(ret));
+      return ret;
+    }
+
+    elapsed = (double)(end_time.tv_sec - start_time.tv_sec) +
+              ((double)(end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0);
+
+    printf("assembled %d opcode blocks\n", block_array_get_array_size(binary));
+
+    printf("assembly time %g seconds, %g blocks/sec\n",
+      elapsed,
+      (double)block_array_get_array_size(binary) / elapsed);
+  }
+  else {
+
+    ret = assemble_file(fileName, &binary);
+
+    if (ret != 0) {
+      printf("assembler error %d %s, exiting\n", ret, strerror(ret));
+      return ret;
+    }
+
+    printf("assembled %d opcode blocks\n", block_array_get_array_size(binary));
+  }
 
   //
   // context->compiled_binary is a pointer to the block array
@@ -127,6 +309,52 @@ main(int ac, char* av[])
   // for DMA, etc.
   //
 
+  if ((outputFileName != NULL) && compress) {
+
+    ret = compress_binary(binary, &program);
+
+    if (ret == 0) {
+      ret = write_compressed_binary_file(outputFileName, program);
+    }
+
+    if (ret != 0) {
+      printf("error %d %s writing compressed binary file %s\n", ret, strerror(ret), outputFileName);
+      return ret;
+    }
+
+    compressed_bytes = sizeof(BINARY_FILE_HEADER) +
+        ((unsigned long)block_array_get_array_size(program->words) * sizeof(unsigned int));
+
+    binary_bytes = sizeof(BINARY_FILE_HEADER) +
+        ((unsigned long)block_array_get_array_size(binary) * BINARY_FILE_RECORD_SIZE);
+
+    printf("wrote compressed binary file %s, %ld blocks in %d words, %ld bytes, %g%% of %ld bytes uncompressed\n",
+      outputFileName,
+      program->block_count,
+      block_array_get_array_size(program->words),
+      compressed_bytes,
+      (100.0 * (double)compressed_bytes) / (double)binary_bytes,
+      binary_bytes);
+
+    compressed_program_free(program);
+
+    return 0;
+  }
+
+  if (outputFileName != NULL) {
+
+    ret = write_binary_file(outputFileName, binary);
+
+    if (ret != 0) {
+      printf("error %d %s writing binary file %s\n", ret, strerror(ret), outputFileName);
+      return ret;
+    }
+
+    printf("wrote binary file %s\n", outputFileName);
+
+    return 0;
+  }
+
   printf("\ndisassembling stream:\n");
 
   ret = disassemble_stream(binary);
@@ -134,9 +362,102 @@ main(int ac, char* av[])
   return 0;
 }
 
+//
+// Assemble fileName repeat times and report the best and mean time.
+//
+// threads < 0 uses assemble_file(), otherwise assemble_file_parallel().
+//
+// The file is read once first so the passes run from the page cache.
+//
+// Peak RSS is for the process, so it is the largest of the passes.
+//
+int
+bench_assemble_file(char* fileName, int threads, int repeat)
+{
+  int ret;
+  int pass;
+  int blocks;
+  double elapsed;
+  double best;
+  double total;
+  struct stat st;
+  struct rusage usage;
+  struct timespec start_time;
+  struct timespec end_time;
+  PBLOCK_ARRAY binary = NULL;
+
+  if (stat(fileName, &st) != 0) {
+    printf("error %d %s opening %s\n", errno, strerror(errno), fileName);
+    return errno;
+  }
+
+  best = 0;
+  total = 0;
+  blocks = 0;
+
+  for (pass = 0; pass <= repeat; pass++) {
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    if (threads < 0) {
+      ret = assemble_file(fileName, &binary);
+    }
+    else {
+      ret = assemble_file_parallel(fileName, threads, &binary);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    if (ret != 0) {
+      printf("assembler error %d %s, exiting\n", ret, strerror(ret));
+      return ret;
+    }
+
+    blocks = block_array_get_array_size(binary);
+
+    block_array_free(binary);
+
+    // Pass 0 warms the page cache
+    if (pass == 0) {
+      continue;
+    }
+
+    elapsed = (double)(end_time.tv_sec - start_time.tv_sec) +
+              ((double)(end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0);
+
+    if ((best == 0) || (elapsed < best)) {
+      best = elapsed;
+    }
+
+    total += elapsed;
+  }
+
+  printf("assembled %d opcode blocks from %ld bytes %d times\n", blocks, (long)st.st_size, repeat);
+
+  printf("best %g seconds, mean %g seconds, %g blocks/sec, %g MB/sec\n",
+    best,
+    total / repeat,
+    (double)blocks / best,
+    ((double)st.st_size / best) / (1024.0 * 1024.0));
+
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+
+    // ru_maxrss is in kilobytes
+    printf("peak RSS %g MB, %g MB of opcode blocks\n",
+      (double)usage.ru_maxrss / 1024.0,
+      ((double)blocks * sizeof(OPCODE_BLOCK_BINARY)) / (1024.0 * 1024.0));
+  }
+
+  return 0;
+}
+
 void
 usage()
 {
-  fprintf(stderr, "usage: menlo_cnc_asm filename.txt\n");
+  fprintf(stderr, "usage: menlo_cnc_asm [-o binary_file [-z]] [-gcode | -j [threads]] [-bench [repeat]] [-mmap | -hugetlb] filename.txt\n");
+  fprintf(stderr, "       menlo_cnc_asm -dis binary_file\n");
+  fprintf(stderr, "       menlo_cnc_asm -stats [-depth fifo_depth] [-rate blocks_per_second] binary_file\n");
+  fprintf(stderr, "       menlo_cnc_asm -conformance [-v]\n");
+  fprintf(stderr, "binary_file may be - for standard input\n");
   exit(1);
 }
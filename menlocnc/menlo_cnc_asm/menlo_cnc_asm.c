@@ -96,6 +96,12 @@
 #include <stdlib.h> // exit
 #include <limits.h> // LONG_MAX, LONG_MIN
 #include <string.h> // strtok, bzero
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <time.h>
 
 // Include binary type definitions for menlo_cnc
 #include "menlo_cnc.h"
@@ -180,6 +186,134 @@ int g_verboseLevel = DEBUG_LEVEL_NONE;
 #define DBG_PRINT3(x, arg, arg2, arg3)
 #endif
 
+//
+// Reserved symbols
+//
+// Every reserved symbol is classified by a single lookup in an open
+// addressed hash table rather than strcmp() against each symbol in
+// turn. The table is built on first use.
+//
+// Axis and opcode symbols of an assembled block point at the symbol
+// strings here so they are not copied.
+//
+
+#define ASSEMBLER_SYMBOL_BEGIN  1
+#define ASSEMBLER_SYMBOL_END    2
+#define ASSEMBLER_SYMBOL_AXIS   3
+#define ASSEMBLER_SYMBOL_OPCODE 4
+
+// HEADER, CONFIG
+#define ASSEMBLER_SYMBOL_INFO   5
+
+// Numeric value postfix, see supported_postfix_array[]
+#define ASSEMBLER_SYMBOL_POSTFIX 6
+
+// Must be a power of 2 and at least twice the symbol count
+#define ASSEMBLER_SYMBOL_TABLE_SIZE 128
+
+#define ASSEMBLER_POSTFIX_MAXIMUM 32
+
+// Longer symbols are not reserved
+#define ASSEMBLER_SYMBOL_MAXIMUM_LENGTH 16
+
+//
+// Where a postfix is valid, see parse_pulse_rate_to_binary() and
+// parse_pulse_width_to_binary().
+//
+
+// pulse_rate as a frequency
+#define ASSEMBLER_POSTFIX_RATE_FREQUENCY 0x01
+
+// pulse_rate as the pulse period
+#define ASSEMBLER_POSTFIX_RATE_PERIOD    0x02
+
+// pulse_width as a time
+#define ASSEMBLER_POSTFIX_WIDTH          0x04
+
+typedef struct _ASSEMBLER_POSTFIX {
+
+  char* postfix;
+
+  // Power of 10 the value is scaled by
+  int exponent;
+
+  // ASSEMBLER_POSTFIX_* flags
+  int flags;
+
+} ASSEMBLER_POSTFIX, *PASSEMBLER_POSTFIX;
+
+typedef struct _ASSEMBLER_SYMBOL {
+
+  char* symbol;
+
+  int type;
+
+  // ASSEMBLER_SYMBOL_AXIS
+  enum AxisState axis_state;
+
+  // axis_symbol_to_binary() value, the axis[] index
+  int axis_code;
+
+  // ASSEMBLER_SYMBOL_OPCODE and ASSEMBLER_SYMBOL_INFO binary instruction
+  unsigned long instruction;
+
+  // ASSEMBLER_SYMBOL_POSTFIX
+  PASSEMBLER_POSTFIX postfix;
+
+} ASSEMBLER_SYMBOL, *PASSEMBLER_SYMBOL;
+
+ASSEMBLER_SYMBOL assembler_symbols[] = {
+  { OPCODE_BEGIN_SYMBOL,      ASSEMBLER_SYMBOL_BEGIN,  AxisStateUnknown, -1, 0 },
+  { OPCODE_END_SYMBOL,        ASSEMBLER_SYMBOL_END,    AxisStateUnknown, -1, 0 },
+
+  { X_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateX, AXIS_CODE_X, 0 },
+  { Y_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateY, AXIS_CODE_Y, 0 },
+  { Z_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateZ, AXIS_CODE_Z, 0 },
+  { A_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateA, AXIS_CODE_A, 0 },
+  { B_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateB, AXIS_CODE_B, 0 },
+  { C_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateC, AXIS_CODE_C, 0 },
+  { U_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateU, AXIS_CODE_U, 0 },
+  { V_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateV, AXIS_CODE_V, 0 },
+  { W_AXIS_SYMBOL,            ASSEMBLER_SYMBOL_AXIS,   AxisStateW, AXIS_CODE_W, 0 },
+
+  { INFO_AXIS_SYMBOL_X,       ASSEMBLER_SYMBOL_AXIS,   AxisStateX, AXIS_CODE_INFO, 0 },
+  { INFO_AXIS_SYMBOL_Y,       ASSEMBLER_SYMBOL_AXIS,   AxisStateY, AXIS_CODE_INFO, 0 },
+  { INFO_AXIS_SYMBOL_Z,       ASSEMBLER_SYMBOL_AXIS,   AxisStateZ, AXIS_CODE_INFO, 0 },
+  { INFO_AXIS_SYMBOL_A,       ASSEMBLER_SYMBOL_AXIS,   AxisStateA, AXIS_CODE_INFO, 0 },
+
+  { OPCODE_NOP_SYMBOL,        ASSEMBLER_SYMBOL_OPCODE, AxisStateUnknown, -1, OPCODE_NOP },
+  { OPCODE_MOTION_CW_SYMBOL,  ASSEMBLER_SYMBOL_OPCODE, AxisStateUnknown, -1, OPCODE_MOTION_CW },
+  { OPCODE_MOTION_CCW_SYMBOL, ASSEMBLER_SYMBOL_OPCODE, AxisStateUnknown, -1, OPCODE_MOTION_CCW },
+  { OPCODE_DWELL_SYMBOL,      ASSEMBLER_SYMBOL_OPCODE, AxisStateUnknown, -1, OPCODE_DWELL },
+
+  { OPCODE_HEADER_SYMBOL,     ASSEMBLER_SYMBOL_INFO,   AxisStateUnknown, -1, OPCODE_HEADER },
+  { OPCODE_CONFIG_SYMBOL,     ASSEMBLER_SYMBOL_INFO,   AxisStateUnknown, -1, OPCODE_CONFIG },
+
+  { NULL, 0, AxisStateUnknown, -1, 0 }
+};
+
+//
+// Axis names in axis[] order, AXIS_CODE_* is the index.
+//
+char* assembler_axis_names[MENLO_CNC_REGISTERS_AXIS_SLOTS] = {
+  X_AXIS_SYMBOL,
+  Y_AXIS_SYMBOL,
+  Z_AXIS_SYMBOL,
+  A_AXIS_SYMBOL,
+  B_AXIS_SYMBOL,
+  C_AXIS_SYMBOL,
+  U_AXIS_SYMBOL,
+  V_AXIS_SYMBOL,
+  W_AXIS_SYMBOL
+};
+
+// Entries for supported_postfix_array[]
+ASSEMBLER_SYMBOL assembler_postfix_symbols[ASSEMBLER_POSTFIX_MAXIMUM];
+
+PASSEMBLER_SYMBOL assembler_symbol_table[ASSEMBLER_SYMBOL_TABLE_SIZE];
+
+pthread_once_t assembler_symbol_table_once = PTHREAD_ONCE_INIT;
+
 //
 // Forward references.
 //
@@ -198,6 +332,14 @@ char* stripLeadingWhiteSpace(char *s);
 
 char* stripTrailingWhiteSpace(char *old);
 
+char* stripTrailingWhiteSpaceInPlace(char *s);
+
+char* assembler_arena_copy_string(PASSEMBLER_ARENA arena, char* s);
+
+void assembler_arena_reset(PASSEMBLER_ARENA arena);
+
+void assembler_arena_free(PASSEMBLER_ARENA arena);
+
 void reset_assembler_context(PASSEMBLER_CONTEXT context);
 
 int process_begin_line(PASSEMBLER_CONTEXT context);
@@ -230,12 +372,29 @@ int process_opcode(PASSEMBLER_CONTEXT context, PAXIS_OPCODE op, char* symbol);
 
 int processLines(PASSEMBLER_CONTEXT context, FILE* f);
 
+PASSEMBLER_SYMBOL assembler_symbol_lookup(char* s);
+
+extern ASSEMBLER_POSTFIX supported_postfix_array[];
+
 int parse_pulse_rate_to_binary(char* s, unsigned long* l);
 
 int parse_pulse_count_to_binary(char* s, unsigned long* l);
 
 int parse_pulse_width_to_binary(char* s, unsigned long* l);
 
+int parse_pulse_rate_to_binary_double(char* s, unsigned long* l);
+
+int parse_pulse_width_to_binary_double(char* s, unsigned long* l);
+
+int
+parse_string_value_decimal(
+    char* s,
+    unsigned long long* mantissa,
+    int* exponent,
+    int* negative,
+    PASSEMBLER_POSTFIX* returnPostFix
+    );
+
 // block_array support
 int block_array_seek_entry(PBLOCK_ARRAY ba, int entry_index);
 
@@ -254,8 +413,8 @@ parse_string_value(
 int
 compile_assembly_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
-    POPCODE_BLOCK_FOUR_AXIS_BINARY bin
+    POPCODE_BLOCK symbolic,
+    POPCODE_BLOCK_BINARY bin
     );
 
 int
@@ -268,28 +427,28 @@ compile_axis_opcode(
 int
 compile_begin_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
+    POPCODE_BLOCK symbolic,
     PAXIS_OPCODE_BINARY bin
     );
 
 int
 compile_end_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
+    POPCODE_BLOCK symbolic,
     PAXIS_OPCODE_BINARY bin
     );
 
 int
 compile_info_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
-    POPCODE_BLOCK_FOUR_AXIS_BINARY bin,
+    POPCODE_BLOCK symbolic,
+    POPCODE_BLOCK_BINARY bin,
     int * isInfoBlock
     );
 
 void
-dump_opcode_block_four_axis_binary(
-    POPCODE_BLOCK_FOUR_AXIS_BINARY b,
+dump_opcode_block_binary(
+    POPCODE_BLOCK_BINARY b,
     unsigned long tag
     );
 
@@ -301,7 +460,7 @@ dump_opcode_block_four_axis_binary(
 //
 // It may also represent a comment, etc.
 //
-// Caller allocated and frees string.
+// Caller allocated and frees string. The string is modified.
 //
 // Returns: 
 //   0 - Success
@@ -337,14 +496,12 @@ process_assembler_line(PASSEMBLER_CONTEXT context, char* line)
 
   s = stripLeadingWhiteSpace(s);
 
-  news = stripTrailingWhiteSpace(s);
+  news = stripTrailingWhiteSpaceInPlace(s);
 
   ret = process_begin_line(context);
 
   ret = processSymbol(context, news);
 
-  free(news);
-
   if (ret != 0) {
     return ret;
   }
@@ -355,7 +512,7 @@ process_assembler_line(PASSEMBLER_CONTEXT context, char* line)
   while ((s = strtok_r(NULL, ",", &saveptr)) != NULL) {
 
     s = stripLeadingWhiteSpace(s);
-    news = stripTrailingWhiteSpace(s);
+    news = stripTrailingWhiteSpaceInPlace(s);
 
     if (news[0] == '\0') {
       printf("internal error, unexpected empty token line %d\n", context->lineNumber);
@@ -363,7 +520,6 @@ process_assembler_line(PASSEMBLER_CONTEXT context, char* line)
     }
 
     ret = processSymbol(context, news);
-    free(news);
 
     if (ret != 0) {
       return ret;
@@ -391,17 +547,21 @@ process_assembler_line(PASSEMBLER_CONTEXT context, char* line)
 int
 processSymbol(PASSEMBLER_CONTEXT context, char* symbol)
 {
+  PASSEMBLER_SYMBOL reserved;
+
   //
   // Main state machine handles header, config, and begin, end blocks.
   //
 
   DBG_PRINT1("    processing symbol :%s:\n", symbol);
 
-  if (strcmp(symbol, OPCODE_BEGIN_SYMBOL) == 0) {
+  reserved = assembler_symbol_lookup(symbol);
+
+  if ((reserved != NULL) && (reserved->type == ASSEMBLER_SYMBOL_BEGIN)) {
 
     return process_begin_block(context, symbol);
   }
-  else if (strcmp(symbol, OPCODE_END_SYMBOL) == 0) {
+  else if ((reserved != NULL) && (reserved->type == ASSEMBLER_SYMBOL_END)) {
 
     return process_end_block(context, symbol);
   }
@@ -513,6 +673,211 @@ char* stripTrailingWhiteSpace(char *old)
   return news;
 }
 
+//
+// stripTrailingWhiteSpace() without the copy, the string is
+// terminated at the first white space.
+//
+char* stripTrailingWhiteSpaceInPlace(char *s)
+{
+  char* p;
+
+  for (p = s; *p != '\0'; p++) {
+
+    if ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) {
+      *p = '\0';
+      break;
+    }
+  }
+
+  return s;
+}
+
+//
+// Copy a string into the arena.
+//
+// Returns NULL if a new chunk could not be allocated.
+//
+char*
+assembler_arena_copy_string(PASSEMBLER_ARENA arena, char* s)
+{
+  char* news;
+  size_t len;
+  size_t size;
+  PASSEMBLER_ARENA_CHUNK chunk;
+
+  len = strlen(s) + 1;
+
+  chunk = arena->current;
+
+  while ((chunk == NULL) || ((chunk->size - chunk->used) < len)) {
+
+    if ((chunk != NULL) && (chunk->next != NULL)) {
+
+      // Reuse a chunk from an earlier block
+      chunk = chunk->next;
+      chunk->used = 0;
+      continue;
+    }
+
+    size = ASSEMBLER_ARENA_CHUNK_SIZE;
+    if (size < len) {
+      size = len;
+    }
+
+    news = (char*)malloc(sizeof(ASSEMBLER_ARENA_CHUNK) + size);
+    if (news == NULL) {
+      return NULL;
+    }
+
+    if (chunk == NULL) {
+      arena->first = (PASSEMBLER_ARENA_CHUNK)news;
+    }
+    else {
+      chunk->next = (PASSEMBLER_ARENA_CHUNK)news;
+    }
+
+    chunk = (PASSEMBLER_ARENA_CHUNK)news;
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+  }
+
+  arena->current = chunk;
+
+  news = &chunk->data[chunk->used];
+  chunk->used += len;
+
+  memcpy(news, s, len);
+
+  return news;
+}
+
+//
+// Release all strings in the arena, the chunks are kept.
+//
+void
+assembler_arena_reset(PASSEMBLER_ARENA arena)
+{
+  arena->current = arena->first;
+
+  if (arena->first != NULL) {
+    arena->first->used = 0;
+  }
+}
+
+void
+assembler_arena_free(PASSEMBLER_ARENA arena)
+{
+  PASSEMBLER_ARENA_CHUNK chunk;
+  PASSEMBLER_ARENA_CHUNK next;
+
+  for (chunk = arena->first; chunk != NULL; chunk = next) {
+    next = chunk->next;
+    free(chunk);
+  }
+
+  arena->first = NULL;
+  arena->current = NULL;
+}
+
+//
+// Build the reserved symbol hash table, see assembler_symbols[].
+//
+
+unsigned int
+assembler_symbol_hash(char* s, int* length)
+{
+  unsigned int hash;
+  int index;
+
+  // FNV-1a
+  hash = 2166136261U;
+
+  for (index = 0; s[index] != '\0'; index++) {
+
+    if (index >= ASSEMBLER_SYMBOL_MAXIMUM_LENGTH) {
+      break;
+    }
+
+    hash ^= (unsigned char)s[index];
+    hash *= 16777619U;
+  }
+
+  *length = index;
+
+  return hash;
+}
+
+void
+assembler_symbol_table_insert(PASSEMBLER_SYMBOL entry)
+{
+  int length;
+  unsigned int slot;
+
+  slot = assembler_symbol_hash(entry->symbol, &length);
+
+  while (assembler_symbol_table[slot & (ASSEMBLER_SYMBOL_TABLE_SIZE - 1)] != NULL) {
+    slot++;
+  }
+
+  assembler_symbol_table[slot & (ASSEMBLER_SYMBOL_TABLE_SIZE - 1)] = entry;
+}
+
+void
+assembler_symbol_table_initialize()
+{
+  int index;
+  PASSEMBLER_SYMBOL entry;
+
+  for (index = 0; assembler_symbols[index].symbol != NULL; index++) {
+    assembler_symbol_table_insert(&assembler_symbols[index]);
+  }
+
+  for (index = 0; supported_postfix_array[index].postfix != NULL; index++) {
+
+    entry = &assembler_postfix_symbols[index];
+
+    entry->symbol = supported_postfix_array[index].postfix;
+    entry->type = ASSEMBLER_SYMBOL_POSTFIX;
+    entry->axis_state = AxisStateUnknown;
+    entry->axis_code = -1;
+    entry->instruction = 0;
+    entry->postfix = &supported_postfix_array[index];
+
+    assembler_symbol_table_insert(entry);
+  }
+}
+
+//
+// Return the reserved symbol entry for s, NULL if s is not reserved.
+//
+PASSEMBLER_SYMBOL
+assembler_symbol_lookup(char* s)
+{
+  int length;
+  unsigned int slot;
+  PASSEMBLER_SYMBOL entry;
+
+  pthread_once(&assembler_symbol_table_once, assembler_symbol_table_initialize);
+
+  slot = assembler_symbol_hash(s, &length);
+
+  if (length >= ASSEMBLER_SYMBOL_MAXIMUM_LENGTH) {
+    return NULL;
+  }
+
+  while ((entry = assembler_symbol_table[slot & (ASSEMBLER_SYMBOL_TABLE_SIZE - 1)]) != NULL) {
+
+    if (strcmp(entry->symbol, s) == 0) {
+      return entry;
+    }
+
+    slot++;
+  }
+
+  return NULL;
+}
+
 int
 process_begin_block(PASSEMBLER_CONTEXT context, char* symbol)
 {
@@ -694,11 +1059,8 @@ process_generic_symbol(PASSEMBLER_CONTEXT context, char* symbol)
       return EBADF;
     }
 
-    context->current_axis_opcode->axis = copyNewString(symbol);
-    if (context->current_axis_opcode->axis == NULL) {
-      printf("out of memory assembling axis opcode line %d\n", context->lineNumber);
-      return ENOMEM;
-    }
+    // Reserved symbol string, not copied
+    context->current_axis_opcode->axis = assembler_symbol_lookup(symbol)->symbol;
 
     DBG_PRINT1("    AXIS: %s\n", symbol);
 
@@ -736,7 +1098,7 @@ process_generic_symbol(PASSEMBLER_CONTEXT context, char* symbol)
     // stored as the argument.
     //
 
-    context->current_axis_opcode->arg0 = copyNewString(symbol);
+    context->current_axis_opcode->arg0 = assembler_arena_copy_string(&context->arena, symbol);
     if (context->current_axis_opcode->arg0 == NULL) {
       printf("out of memory assembling opcode arg0 line %d\n", context->lineNumber);
       return ENOMEM;
@@ -753,7 +1115,7 @@ process_generic_symbol(PASSEMBLER_CONTEXT context, char* symbol)
     // Current symbol is the second argument Arg1
     //
 
-    context->current_axis_opcode->arg1 = copyNewString(symbol);
+    context->current_axis_opcode->arg1 = assembler_arena_copy_string(&context->arena, symbol);
     if (context->current_axis_opcode->arg1 == NULL) {
       printf("out of memory assembling opcode arg1 line %d\n", context->lineNumber);
       return ENOMEM;
@@ -770,7 +1132,7 @@ process_generic_symbol(PASSEMBLER_CONTEXT context, char* symbol)
     // Current symbol is the third argument Arg2
     //
 
-    context->current_axis_opcode->arg2 = copyNewString(symbol);
+    context->current_axis_opcode->arg2 = assembler_arena_copy_string(&context->arena, symbol);
     if (context->current_axis_opcode->arg2 == NULL) {
       printf("out of memory assembling opcode arg2 line %d\n", context->lineNumber);
       return ENOMEM;
@@ -812,53 +1174,16 @@ process_generic_symbol(PASSEMBLER_CONTEXT context, char* symbol)
 enum AxisState
 get_axis_state_by_symbol(PASSEMBLER_CONTEXT context, char* symbol)
 {
-  enum AxisState axis = AxisStateUnknown;
+  PASSEMBLER_SYMBOL reserved;
 
-  if (strcmp(symbol, X_AXIS_SYMBOL) == 0) {
-    axis = AxisStateX;
-  }
-  else if (strcmp(symbol, Y_AXIS_SYMBOL) == 0) {
-    axis = AxisStateY;
-  }
-  else if (strcmp(symbol, Z_AXIS_SYMBOL) == 0) {
-    axis = AxisStateZ;
-  }
-  else if (strcmp(symbol, A_AXIS_SYMBOL) == 0) {
-    axis = AxisStateA;
-  }
-  else if (strcmp(symbol, B_AXIS_SYMBOL) == 0) {
-    axis = AxisStateB;
-  }
-  else if (strcmp(symbol, C_AXIS_SYMBOL) == 0) {
-    axis = AxisStateC;
-  }
-  else if (strcmp(symbol, U_AXIS_SYMBOL) == 0) {
-    axis = AxisStateU;
-  }
-  else if (strcmp(symbol, V_AXIS_SYMBOL) == 0) {
-    axis = AxisStateV;
-  }
-  else if (strcmp(symbol, W_AXIS_SYMBOL) == 0) {
-    axis = AxisStateW;
-  }
-  else if (strcmp(symbol, INFO_AXIS_SYMBOL_X) == 0) {
-    axis = AxisStateX;
-  }
-  else if (strcmp(symbol, INFO_AXIS_SYMBOL_Y) == 0) {
-    axis = AxisStateY;
-  }
-  else if (strcmp(symbol, INFO_AXIS_SYMBOL_Z) == 0) {
-    axis = AxisStateZ;
-  }
-  else if (strcmp(symbol, INFO_AXIS_SYMBOL_A) == 0) {
-    axis = AxisStateA;
-  }
-  else {
+  reserved = assembler_symbol_lookup(symbol);
+
+  if ((reserved == NULL) || (reserved->type != ASSEMBLER_SYMBOL_AXIS)) {
     printf("unrecognized axis %s\n", symbol);
-    axis = AxisStateUnknown;
+    return AxisStateUnknown;
   }
 
-  return axis;
+  return reserved->axis_state;
 }
 
 //
@@ -867,49 +1192,28 @@ get_axis_state_by_symbol(PASSEMBLER_CONTEXT context, char* symbol)
 PAXIS_OPCODE
 get_axis_opcode(PASSEMBLER_CONTEXT context)
 {
+  int index;
 
   //
   // Determine which axis/resource whose instruction is currently being assembled.
   //
-  switch(context->axis_state) {
-
-  case AxisStateX:
-    return &context->opcode_block.x;
-    break;
-
-  case AxisStateY:
-    return &context->opcode_block.y;
-    break;
-
-  case AxisStateZ:
-    return &context->opcode_block.z;
-    break;
-
-  case AxisStateA:
-    return &context->opcode_block.a;
-    break;
-
-  case AxisStateB:
-
-    // fall through for unsupported axis right now
-
-  case AxisStateC:
-
-  case AxisStateU:
-
-  case AxisStateV:
-
-  case AxisStateW:
+  // Axis states are in axis[] order from X. Axis beyond
+  // MENLO_CNC_AXIS_COUNT are not in this build.
+  //
+  if ((context->axis_state < AxisStateX) || (context->axis_state > AxisStateW)) {
+    printf("bad axis_state for opcode line %d", context->lineNumber);
+    return NULL;
+  }
 
-  case AxisStateIdle:
-    // fallthrough
+  index = context->axis_state - AxisStateX;
 
-  default:
-    printf("bad axis_state for opcode line %d", context->lineNumber);
+  if (index >= MENLO_CNC_AXIS_COUNT) {
+    printf("axis %s not supported, %d axis configured, line %d\n",
+           assembler_axis_names[index], MENLO_CNC_AXIS_COUNT, context->lineNumber);
     return NULL;
   }
 
-  return NULL;
+  return &context->opcode_block.axis[index];
 }
 
 //
@@ -918,31 +1222,19 @@ get_axis_opcode(PASSEMBLER_CONTEXT context)
 int
 process_opcode(PASSEMBLER_CONTEXT context, PAXIS_OPCODE op, char* symbol)
 {
+  PASSEMBLER_SYMBOL reserved;
 
-  if (strcmp(symbol, OPCODE_NOP_SYMBOL) == 0) {
-    // copy new string
-    op->opcode = copyNewString(symbol);
-  }
-  else if (strcmp(symbol, OPCODE_MOTION_CW_SYMBOL) == 0) {
-    op->opcode = copyNewString(symbol);
-  }
-  else if (strcmp(symbol, OPCODE_MOTION_CCW_SYMBOL) == 0) {
-    op->opcode = copyNewString(symbol);
-  }
-  else if (strcmp(symbol, OPCODE_DWELL_SYMBOL) == 0) {
-    op->opcode = copyNewString(symbol);
-  }
-  else if (strcmp(symbol, OPCODE_HEADER_SYMBOL) == 0) {
-    op->opcode = copyNewString(symbol);
-  }
-  else if (strcmp(symbol, OPCODE_CONFIG_SYMBOL) == 0) {
-    op->opcode = copyNewString(symbol);
-  }
-  else {
+  reserved = assembler_symbol_lookup(symbol);
+
+  if ((reserved == NULL) ||
+      ((reserved->type != ASSEMBLER_SYMBOL_OPCODE) && (reserved->type != ASSEMBLER_SYMBOL_INFO))) {
     printf("unrecognized opcode %s\n", symbol);
     return EBADF;
   }
 
+  // Reserved symbol string, not copied
+  op->opcode = reserved->symbol;
+
   return 0;
 }
 
@@ -951,47 +1243,26 @@ initialize_axis_opcode(PAXIS_OPCODE o)
 {
 
   //
-  // Strings could have been allocated in an assembler pass.
+  // Strings are reserved symbols or in the context arena
+  // which is reset with the block.
   //
-  if (o->axis != NULL) {
-    free(o->axis);
-  }
-
   o->axis = NULL;
-
-  if (o->opcode != NULL) {
-    free(o->opcode);
-  }
-
   o->opcode = NULL;
-
-  if (o->arg0 != NULL) {
-    free(o->arg0);
-  }
-
   o->arg0 = NULL;
-
-  if (o->arg1 != NULL) {
-    free(o->arg1);
-  }
-
   o->arg1 = NULL;
-
-  if (o->arg2 != NULL) {
-    free(o->arg2);
-  }
-
   o->arg2 = NULL;
 }
 
 void
-initialize_opcode_block_four_axis(POPCODE_BLOCK_FOUR_AXIS b)
+initialize_opcode_block(POPCODE_BLOCK b)
 {
+  int index;
+
   initialize_axis_opcode(&b->info);
-  initialize_axis_opcode(&b->x);
-  initialize_axis_opcode(&b->y);
-  initialize_axis_opcode(&b->z);
-  initialize_axis_opcode(&b->a);
+
+  for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+    initialize_axis_opcode(&b->axis[index]);
+  }
 }
 
 void
@@ -1016,6 +1287,12 @@ initialize_assembler_context(PASSEMBLER_CONTEXT context)
   reset_assembler_context(context);
 }
 
+void
+free_assembler_context(PASSEMBLER_CONTEXT context)
+{
+  assembler_arena_free(&context->arena);
+}
+
 //
 // Reset the current assembler block.
 //
@@ -1027,7 +1304,9 @@ reset_assembler_context(PASSEMBLER_CONTEXT context)
 
   reset_current_assembler_axis(context);
 
-  initialize_opcode_block_four_axis(&context->opcode_block);
+  initialize_opcode_block(&context->opcode_block);
+
+  assembler_arena_reset(&context->arena);
 
   context->opcode_block_valid = 0;
 
@@ -1123,13 +1402,35 @@ dump_axis_opcode(PAXIS_OPCODE opcode, char* entry)
 }
 
 void
-dump_opcode_block_four_axis(POPCODE_BLOCK_FOUR_AXIS b)
+dump_opcode_block(POPCODE_BLOCK b)
 {
+  int index;
+
   dump_axis_opcode(&b->info, "INFO");
-  dump_axis_opcode(&b->x,    "   X");
-  dump_axis_opcode(&b->y,    "   Y");
-  dump_axis_opcode(&b->z,    "   Z");
-  dump_axis_opcode(&b->a,    "   A");
+
+  for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+    printf("   ");
+    dump_axis_opcode(&b->axis[index], assembler_axis_names[index]);
+  }
+}
+
+//
+// Returns NULL for an unknown instruction.
+//
+char*
+binary_instruction_name(
+    unsigned long instruction
+    )
+{
+  switch (instruction) {
+  case OPCODE_NOP:        return "NOP";
+  case OPCODE_DWELL:      return "DWELL";
+  case OPCODE_MOTION_CW:  return "MOTION_CW";
+  case OPCODE_MOTION_CCW: return "MOTION_CCW";
+  case OPCODE_HEADER:     return "HEADER";
+  case OPCODE_CONFIG:     return "CONFIG";
+  default:                return NULL;
+  }
 }
 
 void
@@ -1137,23 +1438,12 @@ dump_axis_opcode_binary_instruction(
     unsigned long instruction
     )
 {
-  if (instruction == OPCODE_NOP) {
-    printf("NOP (0x%lx), ", instruction);
-  }
-  else if (instruction == OPCODE_DWELL) {
-    printf("DWELL (0x%lx), ", instruction);
-  }
-  else if (instruction == OPCODE_MOTION_CW) {
-    printf("MOTION_CW (0x%lx), ", instruction);
-  }
-  else if (instruction == OPCODE_MOTION_CCW) {
-    printf("MOTION_CCW (0x%lx), ", instruction);
-  }
-  else if (instruction == OPCODE_HEADER) {
-    printf("HEADER (0x%lx), ", instruction);
-  }
-  else if (instruction == OPCODE_CONFIG) {
-    printf("CONFIG (0x%lx), ", instruction);
+  char* name;
+
+  name = binary_instruction_name(instruction);
+
+  if (name != NULL) {
+    printf("%s (0x%lx), ", name, instruction);
   }
   else {
     printf("0x%lx (%ld), ", instruction, instruction);
@@ -1201,16 +1491,19 @@ dump_axis_opcode_binary_end(
 }
 
 void
-dump_opcode_block_four_axis_binary(
-    POPCODE_BLOCK_FOUR_AXIS_BINARY b,
+dump_opcode_block_binary(
+    POPCODE_BLOCK_BINARY b,
     unsigned long tag
     )
 {
+  int index;
+
   dump_axis_opcode_binary_begin(&b->begin, tag);
-  dump_axis_opcode_binary(&b->x, "X");
-  dump_axis_opcode_binary(&b->y, "Y");
-  dump_axis_opcode_binary(&b->z, "Z");
-  dump_axis_opcode_binary(&b->a, "A");
+
+  for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+    dump_axis_opcode_binary(&b->axis[index], assembler_axis_names[index]);
+  }
+
   dump_axis_opcode_binary_end(&b->end);
   printf("\n");
 }
@@ -1219,7 +1512,7 @@ int
 process_assembly_block(PASSEMBLER_CONTEXT context)
 {
   int ret;
-  OPCODE_BLOCK_FOUR_AXIS_BINARY bin;
+  OPCODE_BLOCK_BINARY bin;
   void* newBin;
 
   bzero(&bin, sizeof(bin));
@@ -1227,7 +1520,7 @@ process_assembly_block(PASSEMBLER_CONTEXT context)
   DBG_PRINT1("    process_assembly_block Line: %d\n", context->lineNumber);
 
   if (g_verboseLevel >= DEBUG_LEVEL_ONE) {
-    dump_opcode_block_four_axis(&context->opcode_block);
+    dump_opcode_block(&context->opcode_block);
   }
 
   ret = compile_assembly_block(context, &context->opcode_block, &bin);
@@ -1241,7 +1534,7 @@ process_assembly_block(PASSEMBLER_CONTEXT context)
       printf("!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
       printf("!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
 
-      dump_opcode_block_four_axis_binary(&bin, 0);
+      dump_opcode_block_binary(&bin, 0);
 
       printf("!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
       printf("!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
@@ -1269,17 +1562,18 @@ process_assembly_block(PASSEMBLER_CONTEXT context)
 //
 // Compiled the symbolic opcode block to binary.
 //
-// This compiles across four axis, plus the virtual
+// This compiles across MENLO_CNC_AXIS_COUNT axis, plus the virtual
 // resource axis INFO.
 //
 int
 compile_assembly_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
-    POPCODE_BLOCK_FOUR_AXIS_BINARY bin
+    POPCODE_BLOCK symbolic,
+    POPCODE_BLOCK_BINARY bin
     )
 {
   int ret;
+  int index;
   int isInfoBlock;
 
   //
@@ -1292,7 +1586,7 @@ compile_assembly_block(
   ret = compile_info_block(context, symbolic, bin, &isInfoBlock);
   if (ret != 0) {
     printf("INFO block bad format\n");
-    dump_opcode_block_four_axis(symbolic);
+    dump_opcode_block(symbolic);
     return ret;
   }
 
@@ -1308,42 +1602,24 @@ compile_assembly_block(
   ret = compile_begin_block(context, symbolic, &bin->begin);
   if (ret != 0) {
     printf("BEGIN block bad format\n");
-    dump_opcode_block_four_axis(symbolic);
-    return ret;
-  }
-
-  ret = compile_axis_opcode(context, &symbolic->x, &bin->x);
-  if (ret != 0) {
-    printf("X axis compile error\n");
-    dump_opcode_block_four_axis(symbolic);
+    dump_opcode_block(symbolic);
     return ret;
   }
 
-  ret = compile_axis_opcode(context, &symbolic->y, &bin->y);
-  if (ret != 0) {
-    printf("Y axis compile error\n");
-    dump_opcode_block_four_axis(symbolic);
-    return ret;
-  }
-
-  ret = compile_axis_opcode(context, &symbolic->z, &bin->z);
-  if (ret != 0) {
-    printf("Z axis compile error\n");
-    dump_opcode_block_four_axis(symbolic);
-    return ret;
-  }
+  for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
 
-  ret = compile_axis_opcode(context, &symbolic->a, &bin->a);
-  if (ret != 0) {
-    printf("A axis compile error\n");
-    dump_opcode_block_four_axis(symbolic);
-    return ret;
+    ret = compile_axis_opcode(context, &symbolic->axis[index], &bin->axis[index]);
+    if (ret != 0) {
+      printf("%s axis compile error\n", assembler_axis_names[index]);
+      dump_opcode_block(symbolic);
+      return ret;
+    }
   }
 
   ret = compile_end_block(context, symbolic, &bin->end);
   if (ret != 0) {
     printf("END block bad format\n");
-    dump_opcode_block_four_axis(symbolic);
+    dump_opcode_block(symbolic);
     return ret;
   }
 
@@ -1356,7 +1632,7 @@ compile_assembly_block(
 int
 compile_begin_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
+    POPCODE_BLOCK symbolic,
     PAXIS_OPCODE_BINARY bin
     )
 {
@@ -1373,7 +1649,7 @@ compile_begin_block(
 int
 compile_end_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
+    POPCODE_BLOCK symbolic,
     PAXIS_OPCODE_BINARY bin
     )
 {
@@ -1452,8 +1728,8 @@ compile_info_block_parameters(
 int
 compile_info_block(
     PASSEMBLER_CONTEXT context,
-    POPCODE_BLOCK_FOUR_AXIS symbolic,
-    POPCODE_BLOCK_FOUR_AXIS_BINARY bin,
+    POPCODE_BLOCK symbolic,
+    POPCODE_BLOCK_BINARY bin,
     int * isInfoBlock
     )
 {
@@ -1528,6 +1804,15 @@ compile_info_block(
     return ret;
   }
 
+  //
+  // The program can't use more axis than the block has.
+  //
+  if ((bin->y.pulse_rate == 0) || (bin->y.pulse_rate > MENLO_CNC_AXIS_COUNT)) {
+    printf("CONFIG number_of_axis %ld not supported, %d axis configured, line %d\n",
+           bin->y.pulse_rate, MENLO_CNC_AXIS_COUNT, context->lineNumber);
+    return ERANGE;
+  }
+
   ret = compile_info_block_parameters(&symbolic->z, &bin->z);
   if (ret != 0) {
     return ret;
@@ -1539,6 +1824,7 @@ compile_info_block(
   }
 
   context->saw_info_block = 1;
+  context->info_block_line = context->lineNumber;
 
   // It's a valid info block
   *isInfoBlock = 1;
@@ -1618,8 +1904,83 @@ compile_axis_opcode(
 // Output is the number of machine clock cycles with any
 // scaling factors applied.
 //
+// The value is converted exactly in fixed point. Values it can't
+// represent, such as exponent notation or more than 16 significant
+// digits, use parse_pulse_rate_to_binary_double().
+//
 int
 parse_pulse_rate_to_binary(char* s, unsigned long* l)
+{
+  int ret;
+  int negative;
+  int exponent;
+  int exact;
+  unsigned long long mantissa;
+  unsigned long long whole;
+  unsigned long temp_l;
+  PASSEMBLER_POSTFIX postFix;
+
+  // A NULL string returns a 0 entry since its not specified.
+  if ((s == NULL) || (*s == '\0')) {
+    return 0;
+  }
+
+  ret = parse_string_value_decimal(s, &mantissa, &exponent, &negative, &postFix);
+  if (ret != 0) {
+    return parse_pulse_rate_to_binary_double(s, l);
+  }
+
+  if (postFix == NULL) {
+
+    //
+    // no postFix, only allow 0 with no postfix
+    //
+    menlo_cnc_decimal_scale_divide(mantissa, exponent, 1, MENLO_CNC_DECIMAL_MAXIMUM, &whole, &exact);
+
+    if (whole == 0) {
+      *l = 0;
+      return 0;
+    }
+
+    // No postFix, fail since we want to be explicit in regards to time or frequency.
+    printf("pulse_rate requires value type postfix in either time or frequency\n");
+    return EBADF;
+  }
+
+  if (postFix->flags & ASSEMBLER_POSTFIX_RATE_FREQUENCY) {
+    ret = menlo_cnc_registers_calculate_pulse_rate_by_decimal_hz(NULL, mantissa, exponent, &temp_l);
+  }
+  else if (postFix->flags & ASSEMBLER_POSTFIX_RATE_PERIOD) {
+    ret = menlo_cnc_registers_calculate_pulse_rate_by_decimal_period(NULL, mantissa, exponent, &temp_l);
+  }
+  else {
+    // not recognized, fail.
+    printf("postfix %s not valid for pulse_rate\n", postFix->postfix);
+    return EBADF;
+  }
+
+  // Negative frequency or time makes no sense.
+  if ((ret == 0) && negative && (temp_l != 0)) {
+    ret = -1;
+  }
+
+  if (ret != 0) {
+    printf("pulse_rate %s out of range for target hardware\n", s);
+    return ret;
+  }
+
+  *l = temp_l;
+
+  return 0;
+}
+
+//
+// pulse_rate using double precision floating point.
+//
+// This is the reference for pulse_timing_conformance_test().
+//
+int
+parse_pulse_rate_to_binary_double(char* s, unsigned long* l)
 {
   int ret;
   char* postFix = NULL;
@@ -1760,8 +2121,90 @@ parse_pulse_count_to_binary(char* s, unsigned long* l)
   return 0;
 }
 
+//
+// Parse pulse_width string to binary for opcode parameter.
+//
+// A value without a postfix is the register value in clocks.
+//
+// The value is converted exactly in fixed point as for
+// parse_pulse_rate_to_binary().
+//
 int
 parse_pulse_width_to_binary(char* s, unsigned long* l)
+{
+  int ret;
+  int negative;
+  int exponent;
+  int exact;
+  unsigned long long mantissa;
+  unsigned long long whole;
+  unsigned long temp_l;
+  PASSEMBLER_POSTFIX postFix;
+
+  // A NULL string returns a 0 entry since its not specified.
+  if ((s == NULL) || (*s == '\0')) {
+    return 0;
+  }
+
+  ret = parse_string_value_decimal(s, &mantissa, &exponent, &negative, &postFix);
+  if (ret != 0) {
+    return parse_pulse_width_to_binary_double(s, l);
+  }
+
+  if (postFix == NULL) {
+
+    ret = menlo_cnc_decimal_scale_divide(
+        mantissa,
+        exponent,
+        1,
+        TIMING_GENERATOR_MAXIMUM_PULSE_WIDTH_COUNT,
+        &whole,
+        &exact
+        );
+
+    if ((ret != 0) || (negative && (whole != 0))) {
+      printf("pulse_width %s out of range for target hardware\n", s);
+      return EBADF;
+    }
+
+    *l = (unsigned long)whole;
+
+    return 0;
+  }
+
+  if ((postFix->flags & ASSEMBLER_POSTFIX_WIDTH) == 0) {
+
+    // TODO: Support percent for PWM instructions.
+    // Needs pulse_period/rate for input
+
+    // not recognized.
+    printf("postfix %s not valid for pulse_width\n", postFix->postfix);
+    return EBADF;
+  }
+
+  ret = menlo_cnc_registers_calculate_pulse_width_by_decimal_period(NULL, mantissa, exponent, &temp_l);
+
+  if ((ret == 0) && negative && (temp_l != 0)) {
+    ret = -1;
+  }
+
+  if (ret != 0) {
+    printf("pulse_width %s out of range for target hardware\n", s);
+    return ret;
+  }
+
+  *l = temp_l;
+
+  return 0;
+}
+
+//
+// pulse_width using double precision floating point.
+//
+// This is the reference for pulse_timing_conformance_test().
+//
+int
+parse_pulse_width_to_binary_double(char* s, unsigned long* l)
 {
   int ret;
   char* postFix = NULL;
@@ -1808,6 +2251,18 @@ parse_pulse_width_to_binary(char* s, unsigned long* l)
       return EBADF;
     }
   }
+  else {
+
+    // Register value in clocks
+    if ((double_value < 0) || (double_value > (double)TIMING_GENERATOR_MAXIMUM_PULSE_WIDTH_COUNT)) {
+      printf("pulse_width %g out of range for target hardware\n", double_value);
+      return EBADF;
+    }
+
+    *l = (unsigned long)double_value;
+
+    return 0;
+  }
 
   time_in_nanoseconds = raw_time * (double)1000000000;
 
@@ -1822,43 +2277,326 @@ parse_pulse_width_to_binary(char* s, unsigned long* l)
   return 0;
 }
 
-char* supported_postfix_array[] = {
+//
+// Fixed point pulse timing conformance test.
+//
+// Known values are checked for the exact result. Then generated
+// values in range for the hardware are converted by the fixed point
+// and double implementations. The double result may be one count
+// less or more where the exact result is at or next to a whole
+// number, any other difference is a failure.
+//
+
+typedef struct _PULSE_TIMING_TEST_VALUE {
+
+  char* value;
+
+  // 0 pulse_rate, 1 pulse_width
+  int width;
+
+  // Expected return is 0
+  int valid;
+
+  unsigned long expected;
+
+} PULSE_TIMING_TEST_VALUE, *PPULSE_TIMING_TEST_VALUE;
+
+PULSE_TIMING_TEST_VALUE pulse_timing_test_values[] = {
+
+  // 50Mhz / 4 is 12.5Mhz
+  { "1hz",        0, 1, 12500000 },
+  { "0.5hz",      0, 1, 25000000 },
+  { "1200hz",     0, 1, 10416 },
+  { "1.5khz",     0, 1, 8333 },
+  { "2.5khz",     0, 1, 5000 },
+  { "100khz",     0, 1, 125 },
+  { "1mhz",       0, 1, 12 },
+  { "7.5mhz",     0, 1, 1 },
+  { "0xAmhz",     0, 1, 1 },
+  { "12.5mhz",    0, 1, 1 },
+  { "12.6mhz",    0, 0, 0 },
+  { "1s",         0, 1, 12500000 },
+  { "1ms",        0, 1, 12500 },
+  { "0.5ms",      0, 1, 6250 },
+  { "10us",       0, 1, 125 },
+  { "3us",        0, 1, 37 },
+  { "80ns",       0, 1, 1 },
+  { "79ns",       0, 0, 0 },
+  { "0.001hz",    0, 0, 0 },
+  { "0",          0, 1, 0 },
+  { "0.5",        0, 1, 0 },
+  { "5",          0, 0, 0 },
+  { "-1hz",       0, 0, 0 },
+  { "10k",        0, 0, 0 },
+  { "1e3hz",      0, 1, 12500 },
+
+  // 20ns clock
+  { "2us",        1, 1, 100 },
+  { "20ns",       1, 1, 1 },
+  { "19ns",       1, 0, 0 },
+  { "500ms",      1, 1, 25000000 },
+  { "25ms",       1, 1, 1250000 },
+  { "0.1us",      1, 1, 5 },
+  { "1s",         1, 1, 50000000 },
+  { "4",          1, 1, 4 },
+  { "0x10",       1, 1, 16 },
+  { "0",          1, 1, 0 },
+  { "2hz",        1, 0, 0 },
+
+  { NULL, 0, 0, 0 }
+};
+
+//
+// Pulse rate and width postfixes with the range of values in them
+// the hardware can represent.
+//
+typedef struct _PULSE_TIMING_TEST_RANGE {
+
+  char* postfix;
+
+  int width;
+
+  double minimum;
+
+  double maximum;
+
+} PULSE_TIMING_TEST_RANGE, *PPULSE_TIMING_TEST_RANGE;
+
+PULSE_TIMING_TEST_RANGE pulse_timing_test_ranges[] = {
+  { "hz",  0, 0.003,   12500000.0 },
+  { "khz", 0, 0.00001, 12500.0 },
+  { "mhz", 0, 0.00001, 12.5 },
+  { "s",   0, 0.003,   12500000.0 },
+  { "ms",  0, 0.00008, 340000.0 },
+  { "us",  0, 0.08,    340000000.0 },
+  { "ns",  0, 80.0,    340000000000.0 },
+
+  { "s",   1, 0.00000002, 85.0 },
+  { "ms",  1, 0.00002,    85000.0 },
+  { "us",  1, 0.02,       85000000.0 },
+  { "ns",  1, 20.0,       85000000000.0 },
+  { "",    1, 0.0,        4294967294.0 },
+
+  { NULL, 0, 0, 0 }
+};
+
+#define PULSE_TIMING_TEST_COUNT 100000
+
+double
+pulse_timing_test_elapsed(struct timespec* start_time)
+{
+  struct timespec end_time;
+
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+  return (double)(end_time.tv_sec - start_time->tv_sec) +
+         ((double)(end_time.tv_nsec - start_time->tv_nsec) / 1000000000.0);
+}
+
+int
+pulse_timing_conformance_test(int verbose)
+{
+  int ret;
+  int ret_double;
+  int index;
+  int count;
+  int places;
+  int failures;
+  int rounding;
+  int compared;
+  unsigned long value;
+  unsigned long value_double;
+  unsigned long mantissa;
+  unsigned long seed;
+  unsigned long power;
+  double number;
+  double fixed_time;
+  double double_time;
+  char buffer[64];
+  struct timespec start_time;
+  PPULSE_TIMING_TEST_VALUE test;
+  PPULSE_TIMING_TEST_RANGE range;
+
+  failures = 0;
+  rounding = 0;
+  compared = 0;
+  fixed_time = 0;
+  double_time = 0;
+
+  //
+  // Exact results
+  //
+  for (test = pulse_timing_test_values; test->value != NULL; test++) {
+
+    value = 0;
+
+    if (test->width) {
+      ret = parse_pulse_width_to_binary(test->value, &value);
+    }
+    else {
+      ret = parse_pulse_rate_to_binary(test->value, &value);
+    }
+
+    if (((ret == 0) != test->valid) || (test->valid && (value != test->expected))) {
+      printf("%s %s: ret %d value %lu expected %s %lu\n",
+        test->width ? "pulse_width" : "pulse_rate",
+        test->value,
+        ret,
+        value,
+        test->valid ? "valid" : "error",
+        test->expected);
+
+      failures++;
+    }
+  }
+
+  //
+  // Fixed point against double
+  //
+  seed = 1;
+
+  for (range = pulse_timing_test_ranges; range->postfix != NULL; range++) {
+
+    for (count = 0; count < PULSE_TIMING_TEST_COUNT; count++) {
+
+      // Whole numbers first, then up to 9 digits with up to 6 places
+      if (count < 1000) {
+        mantissa = count + 1;
+        places = 0;
+      }
+      else {
+        seed = (seed * 1103515245) + 12345;
+        mantissa = (seed >> 8) % 1000000000;
+        seed = (seed * 1103515245) + 12345;
+        places = (seed >> 8) % 7;
+      }
+
+      for (power = 1, index = 0; index < places; index++) {
+        power *= 10;
+      }
+
+      number = (double)mantissa / (double)power;
+
+      if ((number < range->minimum) || (number > range->maximum)) {
+        continue;
+      }
+
+      if (places == 0) {
+        sprintf(buffer, "%lu%s", mantissa, range->postfix);
+      }
+      else {
+        sprintf(buffer, "%lu.%0*lu%s", mantissa / power, places, mantissa % power, range->postfix);
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+      if (range->width) {
+        ret = parse_pulse_width_to_binary(buffer, &value);
+      }
+      else {
+        ret = parse_pulse_rate_to_binary(buffer, &value);
+      }
+
+      fixed_time += pulse_timing_test_elapsed(&start_time);
+
+      clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+      if (range->width) {
+        ret_double = parse_pulse_width_to_binary_double(buffer, &value_double);
+      }
+      else {
+        ret_double = parse_pulse_rate_to_binary_double(buffer, &value_double);
+      }
+
+      double_time += pulse_timing_test_elapsed(&start_time);
+
+      compared++;
+
+      if ((ret == ret_double) && ((ret != 0) || (value == value_double))) {
+        continue;
+      }
+
+      if ((ret == 0) && (ret_double == 0) &&
+          (((value - value_double) == 1) || ((value_double - value) == 1))) {
+
+        if (verbose) {
+          printf("%s %s: fixed %lu double %lu\n",
+            range->width ? "pulse_width" : "pulse_rate", buffer, value, value_double);
+        }
+
+        rounding++;
+        continue;
+      }
+
+      printf("%s %s: fixed ret %d value %lu, double ret %d value %lu\n",
+        range->width ? "pulse_width" : "pulse_rate",
+        buffer,
+        ret,
+        value,
+        ret_double,
+        value_double);
+
+      failures++;
+    }
+  }
+
+  printf("pulse timing conformance: %d values, %d double rounding differences, %d failures\n",
+    compared, rounding, failures);
+
+  printf("fixed point %g us per value, double %g us per value\n",
+    (fixed_time * 1000000.0) / compared,
+    (double_time * 1000000.0) / compared);
+
+  if (failures != 0) {
+    return EINVAL;
+  }
+
+  return 0;
+}
+
+ASSEMBLER_POSTFIX supported_postfix_array[] = {
 
   //
-  // Note: larger strings to smaller strings to allow
-  // a simple forward search for a substring.
+  // Entered in the reserved symbol table, a postfix is matched
+  // against the whole rest of the value string.
+  //
+  // The exponent scales the value as scale_by_postfix() does.
+  //
+  // s is a pulse_rate frequency, 1 second == 1 Hertz.
   //
 
-  "clocks",
-  "percent",
+  { "clocks",   0, 0 },
+  { "percent", -2, 0 },
 
-  "khz",
-  "mhz",
-  "ghz",
-  "thz",
+  { "khz",      3, ASSEMBLER_POSTFIX_RATE_FREQUENCY },
+  { "mhz",      6, ASSEMBLER_POSTFIX_RATE_FREQUENCY },
+  { "ghz",      9, 0 },
+  { "thz",     12, 0 },
 
-  "hz",
-  "ms",
-  "us",
-  "ns",
-  "ps",
+  { "hz",       0, ASSEMBLER_POSTFIX_RATE_FREQUENCY },
+  { "ms",      -3, ASSEMBLER_POSTFIX_RATE_PERIOD | ASSEMBLER_POSTFIX_WIDTH },
+  { "us",      -6, ASSEMBLER_POSTFIX_RATE_PERIOD | ASSEMBLER_POSTFIX_WIDTH },
+  { "ns",      -9, ASSEMBLER_POSTFIX_RATE_PERIOD | ASSEMBLER_POSTFIX_WIDTH },
+  { "ps",     -12, 0 },
 
   //
   // Note: single character a, b, c, d, e, f, are not allowed
   // as they conflict with hex numbers.
   //
 
-  "s",
-  "k",
-  "m",
-  "g",
-  "t",
+  { "s",        0, ASSEMBLER_POSTFIX_RATE_FREQUENCY | ASSEMBLER_POSTFIX_WIDTH },
+  { "k",        3, 0 },
+  { "m",        6, 0 },
+  { "g",        9, 0 },
+  { "t",       12, 0 },
 
-  NULL
+  { NULL, 0, 0 }
 };
 
 //
-// Find one of the supported postfixes.
+// Return s if it is one of the supported postfixes, otherwise NULL.
+//
+// s is the rest of a value string after the number.
 //
 // Note: postfix must be presented in lower case in the
 // string since strcasestr() does not appear in the embedded
@@ -1869,24 +2607,16 @@ char* supported_postfix_array[] = {
 char*
 find_supported_postfix(char* s)
 {
-  char* testString;
-  char* resultString;
-  int index;
-
-  index = 0;
-  testString = supported_postfix_array[index];
+  PASSEMBLER_SYMBOL reserved;
 
-  while (testString != NULL) {
-
-    resultString = strstr(s, testString);
-    if (resultString != NULL) {
+  if (*s == '\0') {
+    return NULL;
+  }
 
-      // found a match
-      return resultString;
-    }
+  reserved = assembler_symbol_lookup(s);
 
-    index++;
-    testString = supported_postfix_array[index];
+  if ((reserved != NULL) && (reserved->type == ASSEMBLER_SYMBOL_POSTFIX)) {
+    return s;
   }
 
   return NULL;
@@ -1972,40 +2702,146 @@ scale_by_postfix(char* postFix, double* l)
 
 
 //
-// Parse a string with optional semantic post fix.
-//
-// Returns:
-//
-// Value as a double that can be converted by the caller
-// according to its semantics.
-//
-// Pointer to the postfix value in the string so caller
-// can determine which semantics to apply/enforce.
-//
-// The returned postfix value is not converted to upper/lower
-// case, so the caller should treat it as case insensitive.
-//
-// format:
+// Parse a string with optional semantic post fix as a decimal
+// fixed point value, mantissa * 10^exponent, with the postfix
+// scale applied to exponent.
 //
-// 123 - decimal integer
+// Formats are as parse_string_value() without floating point.
 //
-// 1.3 - floating point number, only decimal bases allowed.
+// Returns:
 //
-// 0x123 - hexadecimal integer, no fractional components allowed.
+// 0 - Success.
 //
-// Note: the following post fixes are supported:
+// ERANGE - More significant digits than fit in the mantissa.
 //
-//   - They are case insensitive.
+// EINVAL - Not a decimal or hex value with a supported postfix,
+//          such as exponent notation.
 //
-//   - Values without postfix are their integer value.
+// parse_string_value() handles the values that are not
+// accepted here and reports any errors.
 //
-// 1hz  - one Hertz
-// 1khz - one kilo-Hertz
-// 1mhz - one mega-Hertz
-// 1s   - one second
-// 1ms  - 1 millisecond
-// 1us  - 1 microsecond
-// 1ns  - 1 nanosecond
+int
+parse_string_value_decimal(
+    char* s,
+    unsigned long long* mantissa,
+    int* exponent,
+    int* negative,
+    PASSEMBLER_POSTFIX* returnPostFix
+    )
+{
+  int digits;
+  int scale;
+  unsigned long long value;
+  char* p;
+  PASSEMBLER_SYMBOL reserved;
+
+  *returnPostFix = NULL;
+  *negative = 0;
+
+  value = 0;
+  scale = 0;
+  digits = 0;
+
+  p = s;
+
+  if ((p[0] == '0') && (p[1] == 'x')) {
+
+    // Hex is an integer
+    value = strtoull(p, &p, 16);
+    if (value >= MENLO_CNC_DECIMAL_MANTISSA_LIMIT) {
+      return ERANGE;
+    }
+
+    digits = 1;
+  }
+  else {
+
+    if ((*p == '-') || (*p == '+')) {
+      *negative = (*p == '-');
+      p++;
+    }
+
+    for (; (*p >= '0') && (*p <= '9'); p++, digits++) {
+
+      if (value >= (MENLO_CNC_DECIMAL_MANTISSA_LIMIT / 10)) {
+        return ERANGE;
+      }
+
+      value = (value * 10) + (*p - '0');
+    }
+
+    if (*p == '.') {
+
+      for (p++; (*p >= '0') && (*p <= '9'); p++, digits++) {
+
+        if (value >= (MENLO_CNC_DECIMAL_MANTISSA_LIMIT / 10)) {
+          return ERANGE;
+        }
+
+        value = (value * 10) + (*p - '0');
+        scale--;
+      }
+    }
+  }
+
+  if (digits == 0) {
+    return EINVAL;
+  }
+
+  if (*p != '\0') {
+
+    reserved = assembler_symbol_lookup(p);
+
+    if ((reserved == NULL) || (reserved->type != ASSEMBLER_SYMBOL_POSTFIX)) {
+      return EINVAL;
+    }
+
+    *returnPostFix = reserved->postfix;
+
+    scale += reserved->postfix->exponent;
+  }
+
+  *mantissa = value;
+  *exponent = scale;
+
+  return 0;
+}
+
+//
+// Parse a string with optional semantic post fix.
+//
+// Returns:
+//
+// Value as a double that can be converted by the caller
+// according to its semantics.
+//
+// Pointer to the postfix value in the string so caller
+// can determine which semantics to apply/enforce.
+//
+// The returned postfix value is not converted to upper/lower
+// case, so the caller should treat it as case insensitive.
+//
+// format:
+//
+// 123 - decimal integer
+//
+// 1.3 - floating point number, only decimal bases allowed.
+//
+// 0x123 - hexadecimal integer, no fractional components allowed.
+//
+// Note: the following post fixes are supported:
+//
+//   - They are case insensitive.
+//
+//   - Values without postfix are their integer value.
+//
+// 1hz  - one Hertz
+// 1khz - one kilo-Hertz
+// 1mhz - one mega-Hertz
+// 1s   - one second
+// 1ms  - 1 millisecond
+// 1us  - 1 microsecond
+// 1ns  - 1 nanosecond
 // 100clocks - 100 clocks. Clock period defined by implementation.
 // 50%  - 50 percent
 //
@@ -2040,20 +2876,6 @@ parse_string_value(char* s, double* l, char** returnPostFix)
     isHex = 1;
   }
 
-  //
-  // lookup post fix
-  //
-  // Note: currently case sensitive to lower case only.
-  //
-  postFix = find_supported_postfix(s);
-  if (postFix == NULL) {
-    // No postFix
-  }
-  else {
-    // This lets the caller determine how to treat the value.
-    *returnPostFix = postFix;
-  }
-
   if (isHex) {
       // strtol will parse till any post fix characters returning the integer.
       integer_value = strtol(s, &endptr, 16);
@@ -2071,30 +2893,32 @@ parse_string_value(char* s, double* l, char** returnPostFix)
       double_value = strtod(s, &endptr);
   }
 
-  if (postFix != NULL) {
+  //
+  // lookup post fix
+  //
+  // The conversion stops at the postfix which must be the rest of
+  // the string, postfix's should not conflict with valid strtod
+  // values such as ., +, -, nan, inf, infinity.
+  //
+  // Ubuntu Linux "man strtod"
+  // STRTOD(3)
+  //
+  // Note: currently case sensitive to lower case only.
+  //
+  postFix = find_supported_postfix(endptr);
+  if (postFix == NULL) {
 
     //
-    // If there is a postfix, we expect the conversion to stop
-    // there as postfix's should not conflict with valid strtod
-    // values such as ., +, -, nan, inf, infinity.
+    // No postFix, endptr should be '\0'
     //
-    // Ubuntu Linux "man strtod"
-    // STRTOD(3)
-    //
-    if (endptr != postFix) {
+    if (*endptr != '\0') {
       printf("Invalid character :%c: in number:%s:\n", *endptr, s);
       return EBADF;
     }
   }
   else {
-
-    //
-    // endptr should be '\0'
-    //
-    if (*endptr != '\0') {
-      printf("Invalid character :%c: in number:%s:\n", *endptr, s);
-      return EBADF;
-    }
+    // This lets the caller determine how to treat the value.
+    *returnPostFix = postFix;
   }
 
   //
@@ -2172,21 +2996,21 @@ string_to_unsigned_long(char* s, unsigned long* l)
 unsigned long
 info_symbol_to_binary(char* s)
 {
+  PASSEMBLER_SYMBOL reserved;
+
   // if null, the opcode is NOP
   if (s == NULL) {
     return OPCODE_NOP;
   }
 
-  if (strcmp(s, OPCODE_HEADER_SYMBOL) == 0) {
-    return OPCODE_HEADER;
-  }
-  else if (strcmp(s, OPCODE_CONFIG_SYMBOL) == 0) {
-    return OPCODE_CONFIG;
-  }
-  else {
-    // Not an INFO block
-    return OPCODE_NOP;
+  reserved = assembler_symbol_lookup(s);
+
+  if ((reserved != NULL) && (reserved->type == ASSEMBLER_SYMBOL_INFO)) {
+    return reserved->instruction;
   }
+
+  // Not an INFO block
+  return OPCODE_NOP;
 }
 
 //
@@ -2199,58 +3023,34 @@ info_symbol_to_binary(char* s)
 int
 opcode_symbol_to_binary(char* s)
 {
+  PASSEMBLER_SYMBOL reserved;
+
   // if null, the opcode is NOP
   if (s == NULL) {
     return OPCODE_NOP;
   }
 
-  if (strcmp(s, OPCODE_NOP_SYMBOL) == 0) {
-    return OPCODE_NOP;
-  }
-  else if (strcmp(s, OPCODE_MOTION_CW_SYMBOL) == 0) {
-    return OPCODE_MOTION_CW;
-  }
-  else if (strcmp(s, OPCODE_MOTION_CCW_SYMBOL) == 0) {
-    return OPCODE_MOTION_CCW;
-  }
-  else if (strcmp(s, OPCODE_DWELL_SYMBOL) == 0) {
-    return OPCODE_DWELL;
-  }
-  else {
-    return -1;
+  reserved = assembler_symbol_lookup(s);
+
+  if ((reserved != NULL) && (reserved->type == ASSEMBLER_SYMBOL_OPCODE)) {
+    return (int)reserved->instruction;
   }
+
+  return -1;
 }
 
 int
 axis_symbol_to_binary(char* s)
 {
-  if (strcmp(s, X_AXIS_SYMBOL) == 0) {
-    return AXIS_CODE_X;
-  }
-  else if (strcmp(s, Y_AXIS_SYMBOL) == 0) {
-    return AXIS_CODE_Y;
-  }
-  else if (strcmp(s, Z_AXIS_SYMBOL) == 0) {
-    return AXIS_CODE_Z;
-  }
-  else if (strcmp(s, A_AXIS_SYMBOL) == 0) {
-    return AXIS_CODE_A;
-  }
-  else if (strcmp(s, INFO_AXIS_SYMBOL_X) == 0) {
-    return AXIS_CODE_INFO;
-  }
-  else if (strcmp(s, INFO_AXIS_SYMBOL_Y) == 0) {
-    return AXIS_CODE_INFO;
-  }
-  else if (strcmp(s, INFO_AXIS_SYMBOL_Z) == 0) {
-    return AXIS_CODE_INFO;
-  }
-  else if (strcmp(s, INFO_AXIS_SYMBOL_A) == 0) {
-    return AXIS_CODE_INFO;
-  }
-  else {
-    return -1;
+  PASSEMBLER_SYMBOL reserved;
+
+  reserved = assembler_symbol_lookup(s);
+
+  if ((reserved != NULL) && (reserved->type == ASSEMBLER_SYMBOL_AXIS)) {
+    return reserved->axis_code;
   }
+
+  return -1;
 }
 
 //
@@ -2263,11 +3063,97 @@ axis_symbol_to_binary(char* s)
 // but in this case we are optimizing for streams.
 //
 
+//
+// Growth doubles the capacity so pushing n entries copies O(n)
+// entries in total. New capacity is not zeroed, only entries below
+// array_size are read, so pages are first touched by the push that
+// fills them.
+//
+
+int g_block_array_backing = BLOCK_ARRAY_BACKING_MALLOC;
+
+void
+block_array_set_default_backing(int backing)
+{
+  g_block_array_backing = backing;
+}
+
+//
+// Allocate length bytes of backing store, returning the length
+// mapped in mapped_length for the mapped backings.
+//
+void*
+block_array_allocate_blocks(size_t length, int backing, size_t* mapped_length)
+{
+  void* blocks;
+  size_t page_size;
+
+  if (backing == BLOCK_ARRAY_BACKING_MALLOC) {
+    *mapped_length = 0;
+    return malloc(length);
+  }
+
+#ifdef MAP_HUGETLB
+  if (backing == BLOCK_ARRAY_BACKING_HUGETLB) {
+
+    page_size = BLOCK_ARRAY_HUGE_PAGE_SIZE;
+    length = (length + page_size - 1) & ~(page_size - 1);
+
+    blocks = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (blocks != MAP_FAILED) {
+      *mapped_length = length;
+      return blocks;
+    }
+
+    // No huge pages reserved, use normal pages
+  }
+#endif
+
+  page_size = (size_t)sysconf(_SC_PAGESIZE);
+  length = (length + page_size - 1) & ~(page_size - 1);
+
+  blocks = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (blocks == MAP_FAILED) {
+    return NULL;
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (backing == BLOCK_ARRAY_BACKING_HUGETLB) {
+    // Transparent huge pages, failure is not an error
+    madvise(blocks, length, MADV_HUGEPAGE);
+  }
+#endif
+
+  *mapped_length = length;
+
+  return blocks;
+}
+
 PBLOCK_ARRAY
 block_array_allocate(int entry_size, int array_size, int array_increment_size)
+{
+  return block_array_allocate_backed(
+      entry_size,
+      array_size,
+      array_increment_size,
+      g_block_array_backing
+      );
+}
+
+PBLOCK_ARRAY
+block_array_allocate_backed(
+    int entry_size,
+    int array_size,
+    int array_increment_size,
+    int backing
+    )
 {
   PBLOCK_ARRAY ba;
-  int total_length;
+  size_t mapped_length;
   static int test_run = 0;
 
   //
@@ -2289,15 +3175,19 @@ block_array_allocate(int entry_size, int array_size, int array_increment_size)
 
   bzero((void*)ba, sizeof(BLOCK_ARRAY));
 
-  total_length = entry_size * array_size;
+  ba->blocks = block_array_allocate_blocks(
+      (size_t)entry_size * array_size,
+      backing,
+      &mapped_length
+      );
 
-  ba->blocks = malloc(total_length);
   if (ba->blocks == NULL) {
     free(ba);
     return (PBLOCK_ARRAY)NULL;
   }
 
-  bzero(ba->blocks, total_length);
+  ba->backing = backing;
+  ba->backing_length = mapped_length;
 
   ba->entry_size = entry_size;
 
@@ -2316,11 +3206,114 @@ block_array_allocate(int entry_size, int array_size, int array_increment_size)
 void
 block_array_free(PBLOCK_ARRAY ba)
 {
-  free(ba->blocks);
+  if (ba->mapping != NULL) {
+    munmap(ba->mapping, ba->mapping_length);
+  }
+  else if (ba->backing != BLOCK_ARRAY_BACKING_MALLOC) {
+    munmap(ba->blocks, ba->backing_length);
+  }
+  else {
+    free(ba->blocks);
+  }
+
   free(ba);
   return;
 }
 
+int
+block_array_reserve(PBLOCK_ARRAY ba, int array_capacity)
+{
+  void* new_blocks;
+  size_t mapped_length;
+
+  if (ba->mapping != NULL) {
+    return EBADF;
+  }
+
+  if (array_capacity <= ba->array_capacity) {
+    return 0;
+  }
+
+  if (ba->backing == BLOCK_ARRAY_BACKING_MALLOC) {
+
+    new_blocks = realloc(ba->blocks, (size_t)array_capacity * ba->entry_size);
+    if (new_blocks == NULL) {
+      return ENOMEM;
+    }
+  }
+  else {
+
+    new_blocks = block_array_allocate_blocks(
+        (size_t)array_capacity * ba->entry_size,
+        ba->backing,
+        &mapped_length
+        );
+
+    if (new_blocks == NULL) {
+      return ENOMEM;
+    }
+
+    bcopy(ba->blocks, new_blocks, (size_t)ba->array_size * ba->entry_size);
+
+    munmap(ba->blocks, ba->backing_length);
+
+    ba->backing_length = mapped_length;
+  }
+
+  ba->blocks = new_blocks;
+  ba->array_capacity = array_capacity;
+
+  return 0;
+}
+
+//
+// Grow to hold at least array_size entries, plus the one entry
+// block_array_push_entry() keeps in reserve.
+//
+int
+block_array_grow(PBLOCK_ARRAY ba, int array_size)
+{
+  long new_capacity;
+
+  new_capacity = (long)ba->array_capacity * 2;
+
+  if (new_capacity < ((long)ba->array_capacity + ba->array_increment_size)) {
+    new_capacity = (long)ba->array_capacity + ba->array_increment_size;
+  }
+
+  if (new_capacity <= array_size) {
+    new_capacity = (long)array_size + 1;
+  }
+
+  if (new_capacity > INT_MAX) {
+    new_capacity = INT_MAX;
+  }
+
+  if (new_capacity <= array_size) {
+    return ENOMEM;
+  }
+
+  return block_array_reserve(ba, (int)new_capacity);
+}
+
+int
+block_array_capacity_hint(unsigned long file_size, int bytes_per_block)
+{
+  unsigned long capacity;
+
+  capacity = file_size / bytes_per_block;
+
+  if (capacity < BLOCK_ARRAY_INITIAL_ALLOCATION) {
+    capacity = BLOCK_ARRAY_INITIAL_ALLOCATION;
+  }
+
+  if (capacity > (INT_MAX / 2)) {
+    capacity = INT_MAX / 2;
+  }
+
+  return (int)capacity;
+}
+
 void*
 block_array_get_entry(PBLOCK_ARRAY ba, int index)
 {
@@ -2331,7 +3324,7 @@ block_array_get_entry(PBLOCK_ARRAY ba, int index)
   }
 
   tmp = (char*)ba->blocks;
-  tmp += (index * ba->entry_size);
+  tmp += ((size_t)index * ba->entry_size);
 
   return (void*)tmp;
 }
@@ -2350,39 +3343,24 @@ block_array_push_entry(
     )
 {
   char* tmp;
-  void* new_blocks;
-  int new_capacity;
-  int new_bytes;
 
   if (entry_size != ba->entry_size) {
     return (void*)NULL;
   }
 
-  if (ba->array_size >= (ba->array_capacity - 1)) {
-    // realloc
-    new_capacity = ba->array_capacity + ba->array_increment_size;
+  if (ba->mapping != NULL) {
+    return (void*)NULL;
+  }
 
-    new_bytes = new_capacity * ba->entry_size;
+  if (ba->array_size >= (ba->array_capacity - 1)) {
 
-    new_blocks = realloc(ba->blocks, new_bytes);
-    if (new_blocks == NULL) {
+    if (block_array_grow(ba, ba->array_size + 1) != 0) {
       return (void*)NULL;
     }
-
-    // realloc has copied the memory, but not initialized the new bytes
-    tmp = (char*)new_blocks;
-
-    // Advance to end of current capacity
-    tmp += (ba->entry_size * ba->array_capacity);
-
-    bzero(tmp, new_bytes - (ba->array_capacity * ba->entry_size));
-
-    ba->blocks = new_blocks;
-    ba->array_capacity = new_capacity;    
   }
 
   tmp = (char*)ba->blocks;
-  tmp += (ba->array_size * ba->entry_size);
+  tmp += ((size_t)ba->array_size * ba->entry_size);
 
   bcopy(entry, tmp, ba->entry_size);
 
@@ -2393,41 +3371,66 @@ block_array_push_entry(
 }
 
 int
-block_array_get_array_size(PBLOCK_ARRAY ba)
+block_array_append(PBLOCK_ARRAY dst, PBLOCK_ARRAY src)
 {
-  return ba->array_size;
-}
+  int ret;
+  int new_size;
+  char* tmp;
 
-void
-initialize_opcode_block_four_axis_binary(
-    POPCODE_BLOCK_FOUR_AXIS_BINARY b,
+  if (src->entry_size != dst->entry_size) {
+    return EINVAL;
+  }
+
+  if (dst->mapping != NULL) {
+    return EBADF;
+  }
+
+  new_size = dst->array_size + src->array_size;
+
+  // Same one entry reserve as block_array_push_entry()
+  if (new_size >= (dst->array_capacity - 1)) {
+
+    ret = block_array_grow(dst, new_size);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  tmp = (char*)dst->blocks;
+  tmp += ((size_t)dst->array_size * dst->entry_size);
+
+  bcopy(src->blocks, tmp, (size_t)src->array_size * src->entry_size);
+
+  dst->array_size = new_size;
+
+  return 0;
+}
+
+int
+block_array_get_array_size(PBLOCK_ARRAY ba)
+{
+  return ba->array_size;
+}
+
+void
+initialize_opcode_block_binary(
+    POPCODE_BLOCK_BINARY b,
     unsigned long count
     )
 {
+  int index;
+
   b->begin.instruction = count;
   b->begin.pulse_rate = count;
   b->begin.pulse_count = count;
   b->begin.pulse_width = count;
 
-  b->x.instruction = count;
-  b->x.pulse_rate = count;
-  b->x.pulse_count = count;
-  b->x.pulse_width = count;
-
-  b->y.instruction = count;
-  b->y.pulse_rate = count;
-  b->y.pulse_count = count;
-  b->y.pulse_width = count;
-
-  b->z.instruction = count;
-  b->z.pulse_rate = count;
-  b->z.pulse_count = count;
-  b->z.pulse_width = count;
-
-  b->a.instruction = count;
-  b->a.pulse_rate = count;
-  b->a.pulse_count = count;
-  b->a.pulse_width = count;
+  for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+    b->axis[index].instruction = count;
+    b->axis[index].pulse_rate = count;
+    b->axis[index].pulse_count = count;
+    b->axis[index].pulse_width = count;
+  }
 
   b->end.instruction = count;
   b->end.pulse_rate = count;
@@ -2452,8 +3455,8 @@ block_array_internal_test()
 {
   int ret;
   void* newBin;
-  OPCODE_BLOCK_FOUR_AXIS_BINARY old;
-  POPCODE_BLOCK_FOUR_AXIS_BINARY newBlock;
+  OPCODE_BLOCK_BINARY old;
+  POPCODE_BLOCK_BINARY newBlock;
   PBLOCK_ARRAY array;
   unsigned long count;
   int test_loop_count;
@@ -2463,10 +3466,10 @@ block_array_internal_test()
 
   count = 0x5555FFFF;
 
-  initialize_opcode_block_four_axis_binary(&old, count);
+  initialize_opcode_block_binary(&old, count);
 
   array = block_array_allocate(
-      sizeof(OPCODE_BLOCK_FOUR_AXIS_BINARY),
+      sizeof(OPCODE_BLOCK_BINARY),
       BLOCK_ARRAY_INITIAL_ALLOCATION,
       BLOCK_ARRAY_INCREMENTAL_ALLOCATION
       );
@@ -2511,7 +3514,7 @@ block_array_internal_test()
   //
 
   array = block_array_allocate(
-      sizeof(OPCODE_BLOCK_FOUR_AXIS_BINARY),
+      sizeof(OPCODE_BLOCK_BINARY),
       BLOCK_ARRAY_INITIAL_ALLOCATION,
       BLOCK_ARRAY_INCREMENTAL_ALLOCATION
       );
@@ -2525,7 +3528,7 @@ block_array_internal_test()
 
   for (i = 0; i < test_loop_count; i++) {
 
-      initialize_opcode_block_four_axis_binary(&old, count);
+      initialize_opcode_block_binary(&old, count);
 
        newBin = block_array_push_entry(
                    array,
@@ -2555,7 +3558,7 @@ block_array_internal_test()
 
   for (i = 0; i < test_loop_count; i++) {
 
-      initialize_opcode_block_four_axis_binary(&old, count);
+      initialize_opcode_block_binary(&old, count);
 
       newBlock = block_array_get_next_entry(array);
       if (newBlock == NULL) {
@@ -2566,11 +3569,11 @@ block_array_internal_test()
       if (memcmp(&old, newBlock, sizeof(old)) != 0) {
         printf("memcmp failure index %d, data=\n", i);
 
-        dump_opcode_block_four_axis_binary(newBlock, count);
+        dump_opcode_block_binary(newBlock, count);
 
         printf("SB=\n");
 
-        dump_opcode_block_four_axis_binary(&old, count);
+        dump_opcode_block_binary(&old, count);
 
         block_array_dump_state(array);
 
@@ -2598,6 +3601,8 @@ assemble_file(char* fileName, PBLOCK_ARRAY* binary)
 {
   int ret;
   FILE *file;
+  struct stat st;
+  int capacity;
   PASSEMBLER_CONTEXT context = NULL;
 
   file = fopen(fileName, "r");
@@ -2606,6 +3611,13 @@ assemble_file(char* fileName, PBLOCK_ARRAY* binary)
     return errno;
   }
 
+  // Size the block array for the program from the source size
+  capacity = BLOCK_ARRAY_INITIAL_ALLOCATION;
+
+  if (fstat(fileno(file), &st) == 0) {
+    capacity = block_array_capacity_hint(st.st_size, ASSEMBLER_SOURCE_BYTES_PER_BLOCK);
+  }
+
   // Allocate context
   context = (PASSEMBLER_CONTEXT)malloc(sizeof(ASSEMBLER_CONTEXT));
   bzero((void*)context, sizeof(ASSEMBLER_CONTEXT));
@@ -2615,8 +3627,8 @@ assemble_file(char* fileName, PBLOCK_ARRAY* binary)
 
   // Allocate block array
   context->compiled_binary = block_array_allocate(
-      sizeof(OPCODE_BLOCK_FOUR_AXIS_BINARY),
-      BLOCK_ARRAY_INITIAL_ALLOCATION,
+      sizeof(OPCODE_BLOCK_BINARY),
+      capacity,
       BLOCK_ARRAY_INCREMENTAL_ALLOCATION
       );
 
@@ -2628,6 +3640,8 @@ assemble_file(char* fileName, PBLOCK_ARRAY* binary)
 
   fclose(file);
 
+  free_assembler_context(context);
+
   if (ret != 0) {
     DBG_PRINT3("assembler error lineno %d, (%d) %s, exiting\n",
            context->lineNumber, ret, strerror(ret));
@@ -2639,9 +3653,392 @@ assemble_file(char* fileName, PBLOCK_ARRAY* binary)
 
   *binary = context->compiled_binary;
 
+  free(context);
+
+  return 0;
+}
+
+//
+// Parallel assembly
+//
+// The file is mapped and divided evenly, then each division is moved
+// forward to an opcode block boundary. A boundary is the next line
+// which starts with begin, or the line after one which ends with end.
+// With neither before the end of the file the remaining lines can
+// only be single line blocks and the next line is used.
+//
+// Each chunk is assembled by processLines() with its own context on
+// a worker thread. The context lineNumber starts at the line the chunk
+// begins on so error messages report the line in the file. The chunk
+// block arrays are then appended in file order.
+//
+// The info block must be the first block in the file so it is in the
+// first chunk. The other chunks start as if they had seen it, which
+// also reports a second info block from the chunk it is in. That the
+// first chunk has it, and begin with no end, are checked across the
+// chunks after they are assembled.
+//
+
+typedef struct _ASSEMBLER_CHUNK {
+
+  ASSEMBLER_CONTEXT context;
+
+  char* start;
+
+  size_t length;
+
+  pthread_t thread;
+
+  int thread_started;
+
+  int result;
+
+} ASSEMBLER_CHUNK, *PASSEMBLER_CHUNK;
+
+//
+// Return 1 if the first symbol on the line from s to eol is symbol.
+//
+int
+assembler_line_starts_with(char* s, char* eol, char* symbol)
+{
+  size_t length;
+
+  while ((s < eol) && ((*s == ' ') || (*s == '\t'))) {
+    s++;
+  }
+
+  length = strlen(symbol);
+
+  if ((size_t)(eol - s) < length) {
+    return 0;
+  }
+
+  if (memcmp(s, symbol, length) != 0) {
+    return 0;
+  }
+
+  s += length;
+
+  if ((s == eol) || (*s == ',') || (*s == ' ') || (*s == '\t') || (*s == '\r')) {
+    return 1;
+  }
+
+  return 0;
+}
+
+//
+// Return 1 if the last symbol on the line from s to eol is symbol.
+//
+int
+assembler_line_ends_with(char* s, char* eol, char* symbol)
+{
+  size_t length;
+  char* p;
+
+  while ((s < eol) && ((*s == ' ') || (*s == '\t'))) {
+    s++;
+  }
+
+  // comment
+  if ((s < eol) && (*s == ';')) {
+    return 0;
+  }
+
+  while ((eol > s) && ((eol[-1] == ' ') || (eol[-1] == '\t') || (eol[-1] == '\r'))) {
+    eol--;
+  }
+
+  length = strlen(symbol);
+
+  if ((size_t)(eol - s) < length) {
+    return 0;
+  }
+
+  p = eol - length;
+
+  if (memcmp(p, symbol, length) != 0) {
+    return 0;
+  }
+
+  if ((p == s) || (p[-1] == ',') || (p[-1] == ' ') || (p[-1] == '\t')) {
+    return 1;
+  }
+
   return 0;
 }
 
+//
+// Return the first opcode block boundary after s.
+//
+char*
+assembler_find_block_boundary(char* s, char* limit)
+{
+  char* line;
+  char* eol;
+
+  // Start of the next line
+  line = memchr(s, '\n', limit - s);
+  if (line == NULL) {
+    return limit;
+  }
+
+  line++;
+
+  for (s = line; s < limit; s = eol + 1) {
+
+    eol = memchr(s, '\n', limit - s);
+    if (eol == NULL) {
+      eol = limit;
+    }
+
+    if (assembler_line_starts_with(s, eol, OPCODE_BEGIN_SYMBOL)) {
+      return s;
+    }
+
+    if (assembler_line_ends_with(s, eol, OPCODE_END_SYMBOL)) {
+      return (eol == limit) ? limit : eol + 1;
+    }
+  }
+
+  return line;
+}
+
+void*
+assembler_chunk_worker(void* arg)
+{
+  FILE* f;
+  PASSEMBLER_CHUNK chunk = (PASSEMBLER_CHUNK)arg;
+
+  f = fmemopen(chunk->start, chunk->length, "r");
+  if (f == NULL) {
+    chunk->result = errno;
+    return NULL;
+  }
+
+  chunk->result = processLines(&chunk->context, f);
+
+  fclose(f);
+
+  return NULL;
+}
+
+int
+assemble_file_parallel(char* fileName, int threads, PBLOCK_ARRAY* binary)
+{
+  int ret;
+  int fd;
+  int index;
+  int chunk_count;
+  int lines;
+  size_t size;
+  char* base;
+  char* limit;
+  char* s;
+  char* next;
+  char* p;
+  struct stat st;
+  PASSEMBLER_CHUNK chunks;
+  PASSEMBLER_CHUNK chunk;
+
+  if (threads <= 0) {
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  if (threads > ASSEMBLER_PARALLEL_MAXIMUM_THREADS) {
+    threads = ASSEMBLER_PARALLEL_MAXIMUM_THREADS;
+  }
+
+  fd = open(fileName, O_RDONLY);
+  if (fd < 0) {
+    return errno;
+  }
+
+  if (fstat(fd, &st) != 0) {
+    ret = errno;
+    close(fd);
+    return ret;
+  }
+
+  size = (size_t)st.st_size;
+
+  if ((size_t)threads > (size / ASSEMBLER_PARALLEL_MINIMUM_CHUNK)) {
+    threads = (int)(size / ASSEMBLER_PARALLEL_MINIMUM_CHUNK);
+  }
+
+  if (threads <= 1) {
+    close(fd);
+    return assemble_file(fileName, binary);
+  }
+
+  base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (base == MAP_FAILED) {
+    return errno;
+  }
+
+  limit = base + size;
+
+  chunks = (PASSEMBLER_CHUNK)malloc(sizeof(ASSEMBLER_CHUNK) * threads);
+  if (chunks == NULL) {
+    munmap(base, size);
+    return ENOMEM;
+  }
+
+  bzero(chunks, sizeof(ASSEMBLER_CHUNK) * threads);
+
+  //
+  // Divide the file at block boundaries, counting the lines
+  // before each chunk for its context.
+  //
+  chunk_count = 0;
+  lines = 0;
+  s = base;
+
+  for (index = 0; (index < threads) && (s < limit); index++) {
+
+    if (index == (threads - 1)) {
+      next = limit;
+    }
+    else {
+      next = base + ((size * (index + 1)) / threads);
+
+      if (next < s) {
+        next = s;
+      }
+
+      next = assembler_find_block_boundary(next, limit);
+    }
+
+    if (next == s) {
+      continue;
+    }
+
+    chunk = &chunks[chunk_count];
+
+    initialize_assembler_context(&chunk->context);
+
+    chunk->context.lineNumber = lines;
+
+    if (chunk_count != 0) {
+      chunk->context.saw_info_block = 1;
+    }
+
+    //
+    // Allocate here, the first allocation runs the block array test.
+    //
+    // The other chunks are appended to the first so it is sized for
+    // the whole program.
+    //
+    chunk->context.compiled_binary = block_array_allocate(
+        sizeof(OPCODE_BLOCK_BINARY),
+        block_array_capacity_hint(
+            (chunk_count == 0) ? size : (unsigned long)(next - s),
+            ASSEMBLER_SOURCE_BYTES_PER_BLOCK
+            ),
+        BLOCK_ARRAY_INCREMENTAL_ALLOCATION
+        );
+
+    if (chunk->context.compiled_binary == NULL) {
+      ret = ENOMEM;
+      goto Done;
+    }
+
+    chunk->start = s;
+    chunk->length = next - s;
+
+    chunk_count++;
+
+    for (p = s; (p = memchr(p, '\n', next - p)) != NULL; p++) {
+      lines++;
+    }
+
+    s = next;
+  }
+
+  for (index = 0; index < chunk_count; index++) {
+
+    chunk = &chunks[index];
+
+    ret = pthread_create(&chunk->thread, NULL, assembler_chunk_worker, chunk);
+    if (ret != 0) {
+      printf("assemble_file_parallel: error %d creating thread\n", ret);
+      goto Done;
+    }
+
+    chunk->thread_started = 1;
+  }
+
+  for (index = 0; index < chunk_count; index++) {
+    pthread_join(chunks[index].thread, NULL);
+    chunks[index].thread_started = 0;
+  }
+
+  //
+  // Report the first error in the file.
+  //
+  for (index = 0; index < chunk_count; index++) {
+
+    chunk = &chunks[index];
+
+    if (chunk->result != 0) {
+      ret = chunk->result;
+      goto Done;
+    }
+
+    if ((index != 0) &&
+        (chunks[0].context.saw_info_block == 0) &&
+        (block_array_get_array_size(chunk->context.compiled_binary) != 0)) {
+      printf("Line %d: Opcodes can only be specified after an info block\n", chunk->context.lineNumber);
+      ret = EBADF;
+      goto Done;
+    }
+
+    if ((index < (chunk_count - 1)) && (chunk->context.saw_begin != 0)) {
+      printf("begin block without end before line %d\n", chunk->context.lineNumber);
+      ret = EBADF;
+      goto Done;
+    }
+  }
+
+  for (index = 1; index < chunk_count; index++) {
+
+    ret = block_array_append(chunks[0].context.compiled_binary, chunks[index].context.compiled_binary);
+    if (ret != 0) {
+      goto Done;
+    }
+  }
+
+  *binary = chunks[0].context.compiled_binary;
+  chunks[0].context.compiled_binary = NULL;
+
+  ret = 0;
+
+Done:
+
+  for (index = 0; index < chunk_count; index++) {
+
+    chunk = &chunks[index];
+
+    if (chunk->thread_started) {
+      pthread_join(chunk->thread, NULL);
+    }
+
+    if (chunk->context.compiled_binary != NULL) {
+      block_array_free(chunk->context.compiled_binary);
+    }
+
+    free_assembler_context(&chunk->context);
+  }
+
+  free(chunks);
+
+  munmap(base, size);
+
+  return ret;
+}
+
 int
 disassemble_stream(
     PBLOCK_ARRAY binary
@@ -2670,7 +4067,7 @@ disassemble_stream(
       goto Done;
     }
 
-    dump_opcode_block_four_axis_binary(block, instruction_block_count);
+    dump_opcode_block_binary(block, instruction_block_count);
 
     instruction_block_count++;
   }
@@ -2682,6 +4079,1736 @@ Done:
   return 0;
 }
 
+//
+// CRC-32 (IEEE 802.3) for binary program files.
+//
+unsigned int
+binary_file_crc32(
+    unsigned int crc,
+    void* data,
+    unsigned long length
+    )
+{
+  static unsigned int table[256];
+  static int table_valid = 0;
+  unsigned char* p;
+  unsigned int value;
+  int index;
+  int bit;
+
+  if (!table_valid) {
+
+    for (index = 0; index < 256; index++) {
+
+      value = (unsigned int)index;
+
+      for (bit = 0; bit < 8; bit++) {
+        if (value & 1) {
+          value = 0xEDB88320 ^ (value >> 1);
+        }
+        else {
+          value = value >> 1;
+        }
+      }
+
+      table[index] = value;
+    }
+
+    table_valid = 1;
+  }
+
+  p = (unsigned char*)data;
+
+  crc = ~crc;
+
+  while (length-- != 0) {
+    crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+//
+// The opcode block is BINARY_FILE_RECORD_WORDS unsigned longs
+// in file order.
+//
+
+void
+binary_file_pack_record(
+    POPCODE_BLOCK_BINARY block,
+    unsigned int* record
+    )
+{
+  unsigned long* words;
+  int index;
+
+  words = (unsigned long*)block;
+
+  for (index = 0; index < BINARY_FILE_RECORD_WORDS; index++) {
+    record[index] = (unsigned int)words[index];
+  }
+}
+
+void
+binary_file_unpack_record(
+    unsigned int* record,
+    POPCODE_BLOCK_BINARY block
+    )
+{
+  unsigned long* words;
+  int index;
+
+  words = (unsigned long*)block;
+
+  for (index = 0; index < BINARY_FILE_RECORD_WORDS; index++) {
+    words[index] = record[index];
+  }
+}
+
+//
+// Save the assembled binary instructions as a binary program file.
+//
+int
+write_binary_file(
+    char* fileName,
+    PBLOCK_ARRAY binary
+    )
+{
+  int ret;
+  int index;
+  int count;
+  FILE *file;
+  BINARY_FILE_HEADER header;
+  unsigned int record[BINARY_FILE_RECORD_WORDS];
+  unsigned int crc;
+
+  count = block_array_get_array_size(binary);
+
+  if (count == 0) {
+    return EBADF;
+  }
+
+  file = fopen(fileName, "wb");
+  if (file == NULL) {
+    DBG_PRINT2("error creating file errno %d file %s\n", errno, fileName);
+    return errno;
+  }
+
+  bzero(&header, sizeof(header));
+
+  header.magic = BINARY_FILE_MAGIC;
+  header.version = BINARY_FILE_VERSION;
+  header.header_size = sizeof(BINARY_FILE_HEADER);
+  header.record_size = BINARY_FILE_RECORD_SIZE;
+  header.record_count = count;
+  header.checksum = 0;
+
+  crc = binary_file_crc32(0, &header, sizeof(header));
+
+  //
+  // Header is rewritten with the checksum once the records
+  // are written.
+  //
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    ret = EIO;
+    goto Error;
+  }
+
+  for (index = 0; index < count; index++) {
+
+    binary_file_pack_record(
+        (POPCODE_BLOCK_BINARY)block_array_get_entry(binary, index),
+        record
+        );
+
+    crc = binary_file_crc32(crc, record, sizeof(record));
+
+    if (fwrite(record, sizeof(record), 1, file) != 1) {
+      ret = EIO;
+      goto Error;
+    }
+  }
+
+  header.checksum = crc;
+
+  if ((fseek(file, 0, SEEK_SET) != 0) ||
+      (fwrite(&header, sizeof(header), 1, file) != 1)) {
+    ret = EIO;
+    goto Error;
+  }
+
+  if (fclose(file) != 0) {
+    return EIO;
+  }
+
+  return 0;
+
+Error:
+
+  fclose(file);
+
+  unlink(fileName);
+
+  return ret;
+}
+
+//
+// Validate the fields of a binary program file header other than the
+// checksum.
+//
+int
+binary_file_validate_header(
+    PBINARY_FILE_HEADER header
+    )
+{
+  unsigned long record_size;
+
+  if ((header->flags & BINARY_FILE_FLAG_COMPRESSED) != 0) {
+    record_size = sizeof(unsigned int);
+  }
+  else {
+    record_size = BINARY_FILE_RECORD_SIZE;
+  }
+
+  if ((header->magic != BINARY_FILE_MAGIC) ||
+      (header->version != BINARY_FILE_VERSION) ||
+      (header->header_size != sizeof(BINARY_FILE_HEADER)) ||
+      ((header->flags & ~BINARY_FILE_FLAG_COMPRESSED) != 0) ||
+      (header->record_size != record_size) ||
+      (header->record_count == 0)) {
+    return EBADF;
+  }
+
+  return 0;
+}
+
+//
+// Map a binary program file and validate its header and checksum.
+//
+// Returns the mapping, its length and the header. The records
+// follow the header in the mapping.
+//
+int
+binary_file_map(
+    char* fileName,
+    char** returnMapping,
+    unsigned long* returnLength,
+    PBINARY_FILE_HEADER header
+    )
+{
+  int ret;
+  int fd;
+  int flags;
+  struct stat file_stat;
+  char* mapping;
+  unsigned long length;
+  unsigned int crc;
+
+  fd = open(fileName, O_RDONLY);
+  if (fd == -1) {
+    DBG_PRINT2("error opening file errno %d file %s\n", errno, fileName);
+    return errno;
+  }
+
+  if (fstat(fd, &file_stat) != 0) {
+    ret = errno;
+    close(fd);
+    return ret;
+  }
+
+  length = (unsigned long)file_stat.st_size;
+
+  if (length < sizeof(BINARY_FILE_HEADER)) {
+    close(fd);
+    return EBADF;
+  }
+
+  //
+  // Fault the file in now rather than in the real time loop.
+  //
+  flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+  flags |= MAP_POPULATE;
+#endif
+
+  mapping = (char*)mmap(NULL, length, PROT_READ, flags, fd, 0);
+
+  ret = errno;
+
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    return ret;
+  }
+
+  bcopy(mapping, header, sizeof(BINARY_FILE_HEADER));
+
+  if ((binary_file_validate_header(header) != 0) ||
+      (length != (header->header_size +
+                  ((unsigned long)header->record_count * header->record_size)))) {
+    DBG_PRINT1("invalid binary file header %s\n", fileName);
+    ret = EBADF;
+    goto Error;
+  }
+
+  header->checksum = 0;
+
+  crc = binary_file_crc32(0, header, sizeof(BINARY_FILE_HEADER));
+
+  crc = binary_file_crc32(
+      crc,
+      mapping + header->header_size,
+      (unsigned long)header->record_count * header->record_size
+      );
+
+  header->checksum = ((PBINARY_FILE_HEADER)mapping)->checksum;
+
+  if (crc != header->checksum) {
+    DBG_PRINT1("binary file checksum mismatch %s\n", fileName);
+    ret = EBADF;
+    goto Error;
+  }
+
+  *returnMapping = mapping;
+  *returnLength = length;
+
+  return 0;
+
+Error:
+
+  munmap(mapping, length);
+
+  return ret;
+}
+
+//
+// Map and validate a binary program file and return its binary
+// instructions without reassembly.
+//
+// The whole file is validated up front so a damaged file fails
+// before any instruction block reaches the machine.
+//
+int
+map_binary_file(
+    char* fileName,
+    PBLOCK_ARRAY* binary
+    )
+{
+  int ret;
+  int index;
+  char* mapping;
+  unsigned long length;
+  unsigned int* records;
+  BINARY_FILE_HEADER header;
+  PBLOCK_ARRAY ba;
+  PCOMPRESSED_PROGRAM program;
+
+  ret = binary_file_map(fileName, &mapping, &length, &header);
+  if (ret != 0) {
+    return ret;
+  }
+
+  if ((header.flags & BINARY_FILE_FLAG_COMPRESSED) != 0) {
+
+    munmap(mapping, length);
+
+    ret = map_compressed_binary_file(fileName, &program);
+    if (ret != 0) {
+      return ret;
+    }
+
+    ret = expand_compressed_program(program, binary);
+
+    compressed_program_free(program);
+
+    return ret;
+  }
+
+  records = (unsigned int*)(mapping + header.header_size);
+
+  if (sizeof(OPCODE_BLOCK_BINARY) == BINARY_FILE_RECORD_SIZE) {
+
+    //
+    // 32 bit host, stream straight from the mapping.
+    //
+    ba = (PBLOCK_ARRAY)malloc(sizeof(BLOCK_ARRAY));
+    if (ba == NULL) {
+      ret = ENOMEM;
+      goto Error;
+    }
+
+    bzero((void*)ba, sizeof(BLOCK_ARRAY));
+
+    ba->blocks = (void*)records;
+    ba->entry_size = sizeof(OPCODE_BLOCK_BINARY);
+    ba->array_size = header.record_count;
+    ba->array_capacity = header.record_count;
+    ba->array_increment_size = 0;
+    ba->seek_index = 0;
+
+    ba->mapping = mapping;
+    ba->mapping_length = length;
+
+    *binary = ba;
+
+    return 0;
+  }
+
+  //
+  // Wider unsigned long, widen each record into a block array.
+  //
+  ba = block_array_allocate(
+      sizeof(OPCODE_BLOCK_BINARY),
+      header.record_count + 1,
+      BLOCK_ARRAY_INCREMENTAL_ALLOCATION
+      );
+
+  if (ba == NULL) {
+    ret = ENOMEM;
+    goto Error;
+  }
+
+  for (index = 0; index < (int)header.record_count; index++) {
+    binary_file_unpack_record(
+        records + (index * BINARY_FILE_RECORD_WORDS),
+        (POPCODE_BLOCK_BINARY)((char*)ba->blocks + (index * ba->entry_size))
+        );
+  }
+
+  ba->array_size = header.record_count;
+
+  munmap(mapping, length);
+
+  *binary = ba;
+
+  return 0;
+
+Error:
+
+  munmap(mapping, length);
+
+  return ret;
+}
+
+//
+// Compressed programs.
+//
+
+PCOMPRESSED_PROGRAM
+compressed_program_allocate(
+    int word_count
+    )
+{
+  PCOMPRESSED_PROGRAM program;
+
+  program = (PCOMPRESSED_PROGRAM)malloc(sizeof(COMPRESSED_PROGRAM));
+  if (program == NULL) {
+    return NULL;
+  }
+
+  program->block_count = 0;
+
+  program->words = block_array_allocate(
+      sizeof(unsigned int),
+      word_count,
+      BLOCK_ARRAY_INCREMENTAL_ALLOCATION
+      );
+
+  if (program->words == NULL) {
+    free(program);
+    return NULL;
+  }
+
+  return program;
+}
+
+void
+compressed_program_free(
+    PCOMPRESSED_PROGRAM program
+    )
+{
+  block_array_free(program->words);
+
+  free(program);
+}
+
+int
+compressed_program_push(
+    PCOMPRESSED_PROGRAM program,
+    unsigned int word
+    )
+{
+  if (block_array_push_entry(program->words, &word, sizeof(word)) == NULL) {
+    return ENOMEM;
+  }
+
+  return 0;
+}
+
+//
+// Emit the pending repeat of the last block.
+//
+int
+compressed_program_push_repeat(
+    PCOMPRESSED_PROGRAM program,
+    unsigned long* repeat
+    )
+{
+  int ret;
+
+  if (*repeat == 0) {
+    return 0;
+  }
+
+  ret = compressed_program_push(program, COMPRESSED_RECORD_REPEAT | (unsigned int)*repeat);
+
+  *repeat = 0;
+
+  return ret;
+}
+
+//
+// Compress the binary instructions into a compressed program.
+//
+// Each block is compared with the last in binary file form. An
+// identical block extends a REPEAT, a block with changes is a DELTA
+// of the changed words, or a BLOCK when the delta would be as large.
+//
+int
+compress_binary(
+    PBLOCK_ARRAY binary,
+    PCOMPRESSED_PROGRAM* returnProgram
+    )
+{
+  int ret;
+  int index;
+  int word;
+  int count;
+  int changed_words;
+  unsigned long repeat;
+  unsigned long long changed;
+  unsigned int record[BINARY_FILE_RECORD_WORDS];
+  unsigned int previous[BINARY_FILE_RECORD_WORDS];
+  PCOMPRESSED_PROGRAM program;
+
+  count = block_array_get_array_size(binary);
+
+  if (count == 0) {
+    return EBADF;
+  }
+
+  //
+  // Sized for a program of mostly single field deltas.
+  //
+  program = compressed_program_allocate((count * 2) + BINARY_FILE_RECORD_WORDS + 1);
+  if (program == NULL) {
+    return ENOMEM;
+  }
+
+  repeat = 0;
+
+  for (index = 0; index < count; index++) {
+
+    binary_file_pack_record(
+        (POPCODE_BLOCK_BINARY)block_array_get_entry(binary, index),
+        record
+        );
+
+    program->block_count++;
+
+    if (index == 0) {
+
+      ret = compressed_program_push(program, COMPRESSED_RECORD_BLOCK);
+
+      for (word = 0; (ret == 0) && (word < BINARY_FILE_RECORD_WORDS); word++) {
+        ret = compressed_program_push(program, record[word]);
+      }
+
+      if (ret != 0) {
+        goto Error;
+      }
+
+      bcopy(record, previous, sizeof(record));
+      continue;
+    }
+
+    changed = 0;
+    changed_words = 0;
+
+    for (word = 0; word < BINARY_FILE_RECORD_WORDS; word++) {
+      if (record[word] != previous[word]) {
+        changed |= (1ULL << word);
+        changed_words++;
+      }
+    }
+
+    if (changed == 0) {
+
+      repeat++;
+
+      if (repeat == COMPRESSED_RECORD_OPERAND_MASK) {
+        ret = compressed_program_push_repeat(program, &repeat);
+        if (ret != 0) {
+          goto Error;
+        }
+      }
+
+      continue;
+    }
+
+    ret = compressed_program_push_repeat(program, &repeat);
+    if (ret != 0) {
+      goto Error;
+    }
+
+    if ((changed_words + 2) > BINARY_FILE_RECORD_WORDS) {
+
+      ret = compressed_program_push(program, COMPRESSED_RECORD_BLOCK);
+
+      for (word = 0; (ret == 0) && (word < BINARY_FILE_RECORD_WORDS); word++) {
+        ret = compressed_program_push(program, record[word]);
+      }
+    }
+    else {
+
+      if ((changed >> COMPRESSED_RECORD_DELTA_BITS) == 0) {
+        ret = compressed_program_push(program, COMPRESSED_RECORD_DELTA | (unsigned int)changed);
+      }
+      else {
+
+        ret = compressed_program_push(
+            program,
+            COMPRESSED_RECORD_DELTA_WIDE | ((unsigned int)changed & COMPRESSED_RECORD_OPERAND_MASK)
+            );
+
+        if (ret == 0) {
+          ret = compressed_program_push(program, (unsigned int)(changed >> COMPRESSED_RECORD_DELTA_BITS));
+        }
+      }
+
+      for (word = 0; (ret == 0) && (word < BINARY_FILE_RECORD_WORDS); word++) {
+        if ((changed & (1ULL << word)) != 0) {
+          ret = compressed_program_push(program, record[word]);
+        }
+      }
+    }
+
+    if (ret != 0) {
+      goto Error;
+    }
+
+    bcopy(record, previous, sizeof(record));
+  }
+
+  ret = compressed_program_push_repeat(program, &repeat);
+  if (ret != 0) {
+    goto Error;
+  }
+
+  *returnProgram = program;
+
+  return 0;
+
+Error:
+
+  compressed_program_free(program);
+
+  return ret;
+}
+
+void
+compressed_stream_initialize(
+    PCOMPRESSED_STREAM stream,
+    PCOMPRESSED_PROGRAM program
+    )
+{
+  bzero(stream, sizeof(COMPRESSED_STREAM));
+
+  stream->words = (unsigned int*)program->words->blocks;
+  stream->word_count = (unsigned long)block_array_get_array_size(program->words);
+}
+
+POPCODE_BLOCK_BINARY
+compressed_stream_next(
+    PCOMPRESSED_STREAM stream
+    )
+{
+  int word;
+  unsigned int record;
+  unsigned long long mask;
+  unsigned long* block;
+
+  if (stream->repeat != 0) {
+    stream->repeat--;
+    stream->changed = 0;
+    return &stream->block;
+  }
+
+  if (stream->index >= stream->word_count) {
+    return NULL;
+  }
+
+  block = (unsigned long*)&stream->block;
+
+  record = stream->words[stream->index++];
+
+  switch (record & COMPRESSED_RECORD_TYPE_MASK) {
+
+  case COMPRESSED_RECORD_BLOCK:
+
+    if (((record & COMPRESSED_RECORD_OPERAND_MASK) != 0) ||
+        ((stream->word_count - stream->index) < BINARY_FILE_RECORD_WORDS)) {
+      goto Invalid;
+    }
+
+    for (word = 0; word < BINARY_FILE_RECORD_WORDS; word++) {
+      block[word] = stream->words[stream->index++];
+    }
+
+    stream->valid = 1;
+    stream->changed = (1ULL << BINARY_FILE_RECORD_WORDS) - 1;
+    break;
+
+  case COMPRESSED_RECORD_DELTA:
+  case COMPRESSED_RECORD_DELTA_WIDE:
+
+    if (!stream->valid) {
+      goto Invalid;
+    }
+
+    mask = record & COMPRESSED_RECORD_OPERAND_MASK;
+
+    if ((record & COMPRESSED_RECORD_TYPE_MASK) == COMPRESSED_RECORD_DELTA_WIDE) {
+
+      if (stream->index >= stream->word_count) {
+        goto Invalid;
+      }
+
+      mask |= (unsigned long long)stream->words[stream->index++] << COMPRESSED_RECORD_DELTA_BITS;
+    }
+
+    if ((mask == 0) || ((mask >> BINARY_FILE_RECORD_WORDS) != 0)) {
+      goto Invalid;
+    }
+
+    stream->changed = mask;
+
+    while (mask != 0) {
+
+      if (stream->index >= stream->word_count) {
+        goto Invalid;
+      }
+
+      word = __builtin_ctzll(mask);
+      mask &= mask - 1;
+
+      block[word] = stream->words[stream->index++];
+    }
+
+    break;
+
+  case COMPRESSED_RECORD_REPEAT:
+
+    if (!stream->valid || ((record & COMPRESSED_RECORD_OPERAND_MASK) == 0)) {
+      goto Invalid;
+    }
+
+    stream->repeat = (record & COMPRESSED_RECORD_OPERAND_MASK) - 1;
+    stream->changed = 0;
+    break;
+
+  default:
+    goto Invalid;
+  }
+
+  return &stream->block;
+
+Invalid:
+
+  DBG_PRINT1("invalid compressed program record at word %ld\n", stream->index);
+
+  stream->error = EBADF;
+  stream->index = stream->word_count;
+  stream->repeat = 0;
+
+  return NULL;
+}
+
+//
+// Expand a compressed program into binary instructions.
+//
+int
+expand_compressed_program(
+    PCOMPRESSED_PROGRAM program,
+    PBLOCK_ARRAY* binary
+    )
+{
+  COMPRESSED_STREAM stream;
+  POPCODE_BLOCK_BINARY block;
+  PBLOCK_ARRAY ba;
+
+  ba = block_array_allocate(
+      sizeof(OPCODE_BLOCK_BINARY),
+      (int)program->block_count + 1,
+      BLOCK_ARRAY_INCREMENTAL_ALLOCATION
+      );
+
+  if (ba == NULL) {
+    return ENOMEM;
+  }
+
+  compressed_stream_initialize(&stream, program);
+
+  while ((block = compressed_stream_next(&stream)) != NULL) {
+    if (block_array_push_entry(ba, block, sizeof(OPCODE_BLOCK_BINARY)) == NULL) {
+      block_array_free(ba);
+      return ENOMEM;
+    }
+  }
+
+  if (stream.error != 0) {
+    block_array_free(ba);
+    return stream.error;
+  }
+
+  *binary = ba;
+
+  return 0;
+}
+
+//
+// Save a compressed program as a compressed binary program file.
+//
+int
+write_compressed_binary_file(
+    char* fileName,
+    PCOMPRESSED_PROGRAM program
+    )
+{
+  int ret;
+  int count;
+  FILE *file;
+  BINARY_FILE_HEADER header;
+  unsigned int crc;
+
+  count = block_array_get_array_size(program->words);
+
+  if (count == 0) {
+    return EBADF;
+  }
+
+  file = fopen(fileName, "wb");
+  if (file == NULL) {
+    DBG_PRINT2("error creating file errno %d file %s\n", errno, fileName);
+    return errno;
+  }
+
+  bzero(&header, sizeof(header));
+
+  header.magic = BINARY_FILE_MAGIC;
+  header.version = BINARY_FILE_VERSION;
+  header.header_size = sizeof(BINARY_FILE_HEADER);
+  header.record_size = sizeof(unsigned int);
+  header.record_count = count;
+  header.checksum = 0;
+  header.flags = BINARY_FILE_FLAG_COMPRESSED;
+  header.block_count = (unsigned int)program->block_count;
+
+  crc = binary_file_crc32(0, &header, sizeof(header));
+
+  crc = binary_file_crc32(
+      crc,
+      program->words->blocks,
+      (unsigned long)count * sizeof(unsigned int)
+      );
+
+  header.checksum = crc;
+
+  if ((fwrite(&header, sizeof(header), 1, file) != 1) ||
+      (fwrite(program->words->blocks, sizeof(unsigned int), count, file) != (size_t)count)) {
+    ret = EIO;
+    goto Error;
+  }
+
+  if (fclose(file) != 0) {
+    return EIO;
+  }
+
+  return 0;
+
+Error:
+
+  fclose(file);
+
+  unlink(fileName);
+
+  return ret;
+}
+
+//
+// Map and validate a compressed binary program file.
+//
+// The words are used in place from the mapping. The stream is
+// walked once here so a damaged program fails before any instruction
+// block reaches the machine.
+//
+int
+map_compressed_binary_file(
+    char* fileName,
+    PCOMPRESSED_PROGRAM* returnProgram
+    )
+{
+  int ret;
+  char* mapping;
+  unsigned long length;
+  unsigned long blocks;
+  BINARY_FILE_HEADER header;
+  COMPRESSED_STREAM stream;
+  PCOMPRESSED_PROGRAM program;
+  PBLOCK_ARRAY ba;
+
+  ret = binary_file_map(fileName, &mapping, &length, &header);
+  if (ret != 0) {
+    return ret;
+  }
+
+  if ((header.flags & BINARY_FILE_FLAG_COMPRESSED) == 0) {
+    munmap(mapping, length);
+    return EINVAL;
+  }
+
+  program = (PCOMPRESSED_PROGRAM)malloc(sizeof(COMPRESSED_PROGRAM));
+  ba = (PBLOCK_ARRAY)malloc(sizeof(BLOCK_ARRAY));
+
+  if ((program == NULL) || (ba == NULL)) {
+    free(program);
+    free(ba);
+    munmap(mapping, length);
+    return ENOMEM;
+  }
+
+  bzero((void*)ba, sizeof(BLOCK_ARRAY));
+
+  ba->blocks = (void*)(mapping + header.header_size);
+  ba->entry_size = sizeof(unsigned int);
+  ba->array_size = header.record_count;
+  ba->array_capacity = header.record_count;
+
+  ba->mapping = mapping;
+  ba->mapping_length = length;
+
+  program->words = ba;
+  program->block_count = header.block_count;
+
+  compressed_stream_initialize(&stream, program);
+
+  blocks = 0;
+
+  while (compressed_stream_next(&stream) != NULL) {
+    blocks++;
+  }
+
+  if ((stream.error != 0) || (blocks != program->block_count)) {
+    DBG_PRINT1("invalid compressed program %s\n", fileName);
+    compressed_program_free(program);
+    return EBADF;
+  }
+
+  *returnProgram = program;
+
+  return 0;
+}
+
+//
+// Streaming binary program file reader.
+//
+
+//
+// Read length bytes, a short read is the end of a truncated file.
+//
+int
+binary_file_read(
+    int fd,
+    void* buffer,
+    unsigned long length
+    )
+{
+  ssize_t count;
+  unsigned long total;
+
+  total = 0;
+
+  while (total < length) {
+
+    count = read(fd, (char*)buffer + total, length - total);
+
+    if (count < 0) {
+
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return errno;
+    }
+
+    if (count == 0) {
+      return EBADF;
+    }
+
+    total += count;
+  }
+
+  return 0;
+}
+
+//
+// Move the unread words to the start of the buffer and read as much of
+// the file after them as fits.
+//
+// index and count are the reader's, or for a compressed file the
+// stream's.
+//
+int
+binary_file_reader_fill(
+    PBINARY_FILE_READER reader,
+    unsigned long* index,
+    unsigned long* count
+    )
+{
+  int ret;
+  unsigned long left;
+  unsigned long words;
+
+  left = *count - *index;
+
+  if ((left != 0) && (*index != 0)) {
+    memmove(reader->words, reader->words + *index, left * sizeof(unsigned int));
+  }
+
+  *index = 0;
+  *count = left;
+
+  words = BINARY_FILE_READER_WORDS - left;
+
+  if (words > reader->file_words) {
+    words = reader->file_words;
+  }
+
+  ret = binary_file_read(reader->fd, reader->words + left, words * sizeof(unsigned int));
+  if (ret != 0) {
+    reader->error = ret;
+    return ret;
+  }
+
+  reader->crc = binary_file_crc32(reader->crc, reader->words + left, words * sizeof(unsigned int));
+
+  *count += words;
+
+  reader->file_words -= words;
+
+  return 0;
+}
+
+int
+binary_file_reader_open(
+    char* fileName,
+    PBINARY_FILE_READER* returnReader
+    )
+{
+  int ret;
+  unsigned int checksum;
+  PBINARY_FILE_READER reader;
+
+  reader = (PBINARY_FILE_READER)malloc(sizeof(BINARY_FILE_READER));
+  if (reader == NULL) {
+    return ENOMEM;
+  }
+
+  bzero((void*)reader, sizeof(BINARY_FILE_READER) - sizeof(reader->words));
+
+  if (strcmp(fileName, "-") == 0) {
+    reader->fd = STDIN_FILENO;
+  }
+  else {
+
+    reader->fd = open(fileName, O_RDONLY);
+
+    if (reader->fd == -1) {
+      ret = errno;
+      DBG_PRINT2("error opening file errno %d file %s\n", errno, fileName);
+      free(reader);
+      return ret;
+    }
+  }
+
+  ret = binary_file_read(reader->fd, &reader->header, sizeof(BINARY_FILE_HEADER));
+
+  if ((ret == 0) && (binary_file_validate_header(&reader->header) != 0)) {
+    DBG_PRINT1("invalid binary file header %s\n", fileName);
+    ret = EBADF;
+  }
+
+  if (ret != 0) {
+    reader->error = ret;
+    binary_file_reader_close(reader);
+    return ret;
+  }
+
+  checksum = reader->header.checksum;
+
+  reader->header.checksum = 0;
+
+  reader->crc = binary_file_crc32(0, &reader->header, sizeof(BINARY_FILE_HEADER));
+
+  reader->header.checksum = checksum;
+
+  reader->file_words = ((unsigned long)reader->header.record_count *
+                        reader->header.record_size) / sizeof(unsigned int);
+
+  if ((reader->header.flags & BINARY_FILE_FLAG_COMPRESSED) != 0) {
+    reader->compressed = 1;
+    reader->stream.words = reader->words;
+  }
+
+  *returnReader = reader;
+
+  return 0;
+}
+
+POPCODE_BLOCK_BINARY
+binary_file_reader_next(
+    PBINARY_FILE_READER reader
+    )
+{
+  PCOMPRESSED_STREAM stream;
+  POPCODE_BLOCK_BINARY block;
+
+  if (reader->error != 0) {
+    return NULL;
+  }
+
+  if (reader->compressed) {
+
+    stream = &reader->stream;
+
+    //
+    // Keep at least the largest record in the buffer.
+    //
+    if ((stream->repeat == 0) &&
+        ((stream->word_count - stream->index) < (BINARY_FILE_RECORD_WORDS + 2)) &&
+        (reader->file_words != 0)) {
+
+      if (binary_file_reader_fill(reader, &stream->index, &stream->word_count) != 0) {
+        return NULL;
+      }
+    }
+
+    block = compressed_stream_next(stream);
+
+    if ((block == NULL) && (stream->error != 0)) {
+      reader->error = stream->error;
+      return NULL;
+    }
+  }
+  else {
+
+    if (((reader->word_count - reader->index) < BINARY_FILE_RECORD_WORDS) &&
+        (reader->file_words != 0)) {
+
+      if (binary_file_reader_fill(reader, &reader->index, &reader->word_count) != 0) {
+        return NULL;
+      }
+    }
+
+    block = NULL;
+
+    if ((reader->word_count - reader->index) >= BINARY_FILE_RECORD_WORDS) {
+
+      binary_file_unpack_record(reader->words + reader->index, &reader->block);
+
+      reader->index += BINARY_FILE_RECORD_WORDS;
+
+      block = &reader->block;
+    }
+  }
+
+  if (block != NULL) {
+    reader->blocks++;
+    return block;
+  }
+
+  //
+  // End of the file, the checksum now covers all of it.
+  //
+  if (reader->crc != reader->header.checksum) {
+    DBG_PRINT("binary file checksum mismatch\n");
+    reader->error = EBADF;
+  }
+  else if (reader->compressed && (reader->blocks != reader->header.block_count)) {
+    DBG_PRINT("compressed program block count mismatch\n");
+    reader->error = EBADF;
+  }
+
+  return NULL;
+}
+
+int
+binary_file_reader_close(
+    PBINARY_FILE_READER reader
+    )
+{
+  int ret;
+
+  if (reader->fd != STDIN_FILENO) {
+    close(reader->fd);
+  }
+
+  ret = reader->error;
+
+  free(reader);
+
+  return ret;
+}
+
+//
+// Output is formatted into a buffer written when full, rather than
+// a printf per field, so large programs disassemble at disk speed.
+//
+#define DISASSEMBLER_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// Room for the longest block
+#define DISASSEMBLER_OUTPUT_BLOCK_SIZE  ((MENLO_CNC_AXIS_COUNT + 2) * 128)
+
+//
+// Append "0x%lx (%ld)" for value to buffer and return the length.
+//
+int
+disassembler_format_value(
+    char* buffer,
+    unsigned long value
+    )
+{
+  int length;
+  int digits;
+  unsigned long v;
+  char decimal[24];
+
+  length = 0;
+
+  buffer[length++] = '0';
+  buffer[length++] = 'x';
+
+  digits = 1;
+  while ((digits < (int)(sizeof(unsigned long) * 2)) && ((value >> (digits * 4)) != 0)) {
+    digits++;
+  }
+
+  while (digits-- > 0) {
+    buffer[length++] = "0123456789abcdef"[(value >> (digits * 4)) & 0xF];
+  }
+
+  buffer[length++] = ' ';
+  buffer[length++] = '(';
+
+  //
+  // %ld of the value
+  //
+  v = value;
+
+  if ((long)value < 0) {
+    buffer[length++] = '-';
+    v = -value;
+  }
+
+  digits = 0;
+
+  do {
+    decimal[digits++] = '0' + (v % 10);
+    v /= 10;
+  } while (v != 0);
+
+  while (digits-- > 0) {
+    buffer[length++] = decimal[digits];
+  }
+
+  buffer[length++] = ')';
+
+  return length;
+}
+
+int
+disassemble_binary_file(
+    char* fileName
+    )
+{
+  int ret;
+  int index;
+  int length;
+  char* name;
+  char* buffer;
+  POPCODE_BLOCK_BINARY block;
+  PAXIS_OPCODE_BINARY opcode;
+  PBINARY_FILE_READER reader;
+
+  ret = binary_file_reader_open(fileName, &reader);
+  if (ret != 0) {
+    printf("disassemble_binary_file: error %d %s opening %s\n", ret, strerror(ret), fileName);
+    return ret;
+  }
+
+  buffer = (char*)malloc(DISASSEMBLER_OUTPUT_BUFFER_SIZE);
+  if (buffer == NULL) {
+    binary_file_reader_close(reader);
+    return ENOMEM;
+  }
+
+  length = 0;
+
+  printf("    rsrc, opcode, rate, count, width\n");
+
+  fflush(stdout);
+
+  while ((block = binary_file_reader_next(reader)) != NULL) {
+
+    if ((DISASSEMBLER_OUTPUT_BUFFER_SIZE - length) < DISASSEMBLER_OUTPUT_BLOCK_SIZE) {
+      fwrite(buffer, 1, length, stdout);
+      length = 0;
+    }
+
+    length += sprintf(buffer + length, "begin %ld\n", reader->blocks - 1);
+
+    for (index = 0; index < MENLO_CNC_AXIS_COUNT; index++) {
+
+      opcode = &block->axis[index];
+
+      name = binary_instruction_name(opcode->instruction);
+
+      if (name != NULL) {
+        length += sprintf(buffer + length, "    %s %s (0x%lx), ",
+                          assembler_axis_names[index], name, opcode->instruction);
+      }
+      else {
+        length += sprintf(buffer + length, "    %s ", assembler_axis_names[index]);
+        length += disassembler_format_value(buffer + length, opcode->instruction);
+        buffer[length++] = ',';
+        buffer[length++] = ' ';
+      }
+
+      length += disassembler_format_value(buffer + length, opcode->pulse_rate);
+      buffer[length++] = ',';
+      buffer[length++] = ' ';
+
+      length += disassembler_format_value(buffer + length, opcode->pulse_count);
+      buffer[length++] = ',';
+      buffer[length++] = ' ';
+
+      length += disassembler_format_value(buffer + length, opcode->pulse_width);
+      buffer[length++] = '\n';
+    }
+
+    length += sprintf(buffer + length, "end\n\n");
+  }
+
+  fwrite(buffer, 1, length, stdout);
+
+  free(buffer);
+
+  printf("disassemble_binary_file: disassembled %ld blocks\n", reader->blocks);
+
+  ret = binary_file_reader_close(reader);
+
+  if (ret != 0) {
+    printf("disassemble_binary_file: error %d %s reading %s\n", ret, strerror(ret), fileName);
+  }
+
+  return ret;
+}
+
+//
+// Program analysis.
+//
+
+int
+program_analysis_initialize(
+    PPROGRAM_ANALYSIS analysis,
+    unsigned long fifo_depth,
+    double loader_rate
+    )
+{
+  bzero(analysis, sizeof(PROGRAM_ANALYSIS));
+
+  if (fifo_depth == 0) {
+    fifo_depth = PROGRAM_ANALYSIS_DEFAULT_FIFO_DEPTH;
+  }
+
+  analysis->fifo_depth = fifo_depth;
+  analysis->loader_rate = loader_rate;
+
+  analysis->end_clocks = (unsigned long long*)malloc(fifo_depth * sizeof(unsigned long long));
+  analysis->start_clocks = (double*)malloc(fifo_depth * sizeof(double));
+
+  if ((analysis->end_clocks == NULL) || (analysis->start_clocks == NULL)) {
+    program_analysis_free(analysis);
+    return ENOMEM;
+  }
+
+  return 0;
+}
+
+void
+program_analysis_free(
+    PPROGRAM_ANALYSIS analysis
+    )
+{
+  free(analysis->end_clocks);
+  free(analysis->start_clocks);
+
+  analysis->end_clocks = NULL;
+  analysis->start_clocks = NULL;
+}
+
+//
+// Keep the windows with the highest refill rates, with overlapping
+// windows counted once at the highest.
+//
+void
+program_analysis_add_risk(
+    PPROGRAM_ANALYSIS analysis,
+    PPROGRAM_ANALYSIS_RISK entry
+    )
+{
+  int index;
+  int lowest;
+
+  lowest = 0;
+
+  for (index = 0; index < analysis->risk_count; index++) {
+
+    if ((entry->block - analysis->risk[index].block) < analysis->fifo_depth) {
+
+      if (entry->refill_rate > analysis->risk[index].refill_rate) {
+        analysis->risk[index] = *entry;
+      }
+
+      return;
+    }
+
+    if (analysis->risk[index].refill_rate < analysis->risk[lowest].refill_rate) {
+      lowest = index;
+    }
+  }
+
+  if (analysis->risk_count < PROGRAM_ANALYSIS_RISK_BLOCKS) {
+    analysis->risk[analysis->risk_count++] = *entry;
+    return;
+  }
+
+  if (entry->refill_rate > analysis->risk[lowest].refill_rate) {
+    analysis->risk[lowest] = *entry;
+  }
+}
+
+int
+program_analysis_add_block(
+    PPROGRAM_ANALYSIS analysis,
+    POPCODE_BLOCK_BINARY block
+    )
+{
+  int index;
+  unsigned long slot;
+  unsigned long instruction;
+  unsigned long long clocks;
+  unsigned long long axis_clocks;
+  double interval;
+  double load;
+  double start;
+  PAXIS_OPCODE_BINARY opcode;
+  PROGRAM_ANALYSIS_RISK entry;
+
+  if (analysis->number_of_axis == 0) {
+
+    if ((block->x.instruction != OPCODE_HEADER) ||
+        (block->y.instruction != OPCODE_CONFIG) ||
+        (block->y.pulse_rate == 0) ||
+        (block->y.pulse_rate > MENLO_CNC_AXIS_COUNT)) {
+      return EBADF;
+    }
+
+    analysis->number_of_axis = (int)block->y.pulse_rate;
+
+    return 0;
+  }
+
+  //
+  // The block runs for its longest axis.
+  //
+  clocks = 0;
+
+  for (index = 0; index < analysis->number_of_axis; index++) {
+
+    opcode = &block->axis[index];
+
+    instruction = opcode->instruction & MENLO_CNC_REGISTERS_INSTRUCTION_MASK;
+
+    if (instruction == OPCODE_NOP) {
+      continue;
+    }
+
+    axis_clocks = (unsigned long long)opcode->pulse_rate *
+                  TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR *
+                  opcode->pulse_count;
+
+    if (axis_clocks > clocks) {
+      clocks = axis_clocks;
+    }
+
+    if (instruction == OPCODE_MOTION_CW) {
+      analysis->axis_pulses[index] += opcode->pulse_count;
+      analysis->axis_position[index] += opcode->pulse_count;
+    }
+    else if (instruction == OPCODE_MOTION_CCW) {
+      analysis->axis_pulses[index] += opcode->pulse_count;
+      analysis->axis_position[index] -= opcode->pulse_count;
+    }
+  }
+
+  //
+  // An all NOP block still takes a clock to pass through
+  // the timing generator.
+  //
+  if (clocks == 0) {
+    clocks = 1;
+  }
+
+  analysis->blocks++;
+
+  if ((analysis->shortest_block == 0) || (clocks < analysis->shortest_block_clocks)) {
+    analysis->shortest_block = analysis->blocks;
+    analysis->shortest_block_clocks = clocks;
+  }
+
+  if (clocks > analysis->longest_block_clocks) {
+    analysis->longest_block = analysis->blocks;
+    analysis->longest_block_clocks = clocks;
+  }
+
+  analysis->program_clocks += clocks;
+
+  //
+  // The ring slot holds block blocks - fifo_depth until it's
+  // replaced with this one.
+  //
+  slot = (analysis->blocks - 1) % analysis->fifo_depth;
+
+  entry.block = analysis->blocks;
+
+  if (analysis->blocks > analysis->fifo_depth) {
+    entry.window_blocks = analysis->fifo_depth;
+    entry.window_clocks = analysis->program_clocks - analysis->end_clocks[slot];
+  }
+  else {
+    entry.window_blocks = analysis->blocks;
+    entry.window_clocks = analysis->program_clocks;
+  }
+
+  analysis->end_clocks[slot] = analysis->program_clocks;
+
+  entry.refill_rate = ((double)entry.window_blocks * (double)TIMING_GENERATOR_BASE_CLOCK_RATE) /
+                      (double)entry.window_clocks;
+
+  if (entry.refill_rate > analysis->peak.refill_rate) {
+    analysis->peak = entry;
+  }
+
+  program_analysis_add_risk(analysis, &entry);
+
+  if (analysis->loader_rate <= 0) {
+    return 0;
+  }
+
+  //
+  // Loader model.
+  //
+  // The loader writes a block every interval once there is room in
+  // the FIFO, which is when the block fifo_depth back has started. The
+  // block starts when it's loaded and the last block is done, if it
+  // was loaded after the last block was done the FIFO ran empty.
+  //
+  interval = (double)TIMING_GENERATOR_BASE_CLOCK_RATE / analysis->loader_rate;
+
+  load = analysis->load_clock;
+
+  if ((analysis->blocks > analysis->fifo_depth) && (analysis->start_clocks[slot] > load)) {
+    load = analysis->start_clocks[slot];
+  }
+
+  load += interval;
+
+  analysis->load_clock = load;
+
+  start = analysis->loader_program_clocks;
+
+  if (load > start) {
+
+    if (analysis->blocks > 1) {
+
+      if (analysis->loader_underruns == 0) {
+        analysis->loader_first_underrun = analysis->blocks;
+      }
+
+      analysis->loader_underruns++;
+    }
+
+    start = load;
+  }
+
+  analysis->start_clocks[slot] = start;
+
+  analysis->loader_program_clocks = start + (double)clocks;
+
+  return 0;
+}
+
+void
+program_analysis_report(
+    PPROGRAM_ANALYSIS analysis
+    )
+{
+  int index;
+  int next;
+  PROGRAM_ANALYSIS_RISK entry;
+  double clock_rate;
+
+  clock_rate = (double)TIMING_GENERATOR_BASE_CLOCK_RATE;
+
+  printf("program %ld instruction blocks, %d axis\n",
+    analysis->blocks, analysis->number_of_axis);
+
+  for (index = 0; index < analysis->number_of_axis; index++) {
+    printf("    %s pulses %llu net %lld\n",
+      assembler_axis_names[index],
+      analysis->axis_pulses[index],
+      analysis->axis_position[index]);
+  }
+
+  if (analysis->blocks == 0) {
+    return;
+  }
+
+  printf("run time %g seconds, %g blocks/sec average\n",
+    (double)analysis->program_clocks / clock_rate,
+    ((double)analysis->blocks * clock_rate) / (double)analysis->program_clocks);
+
+  printf("shortest block %g us at block %ld, longest block %g us at block %ld\n",
+    ((double)analysis->shortest_block_clocks * 1000000.0) / clock_rate,
+    analysis->shortest_block,
+    ((double)analysis->longest_block_clocks * 1000000.0) / clock_rate,
+    analysis->longest_block);
+
+  printf("peak refill rate %g blocks/sec, %ld blocks in %g ms ending at block %ld, fifo depth %ld\n",
+    analysis->peak.refill_rate,
+    analysis->peak.window_blocks,
+    ((double)analysis->peak.window_clocks * 1000.0) / clock_rate,
+    analysis->peak.block,
+    analysis->fifo_depth);
+
+  //
+  // Highest refill rate first.
+  //
+  for (index = 1; index < analysis->risk_count; index++) {
+
+    entry = analysis->risk[index];
+
+    for (next = index; next > 0; next--) {
+
+      if (analysis->risk[next - 1].refill_rate >= entry.refill_rate) {
+        break;
+      }
+
+      analysis->risk[next] = analysis->risk[next - 1];
+    }
+
+    analysis->risk[next] = entry;
+  }
+
+  printf("blocks most at risk of underrun:\n");
+
+  for (index = 0; index < analysis->risk_count; index++) {
+    printf("    block %ld, %ld blocks in %g ms, %g blocks/sec\n",
+      analysis->risk[index].block,
+      analysis->risk[index].window_blocks,
+      ((double)analysis->risk[index].window_clocks * 1000.0) / clock_rate,
+      analysis->risk[index].refill_rate);
+  }
+
+  if (analysis->loader_rate <= 0) {
+    return;
+  }
+
+  if (analysis->loader_underruns == 0) {
+    printf("loader at %g blocks/sec streams cleanly, run time %g seconds\n",
+      analysis->loader_rate,
+      analysis->loader_program_clocks / clock_rate);
+  }
+  else {
+    printf("loader at %g blocks/sec underruns %ld times, first at block %ld, run time %g seconds\n",
+      analysis->loader_rate,
+      analysis->loader_underruns,
+      analysis->loader_first_underrun,
+      analysis->loader_program_clocks / clock_rate);
+  }
+}
+
+int
+analyze_binary_file(
+    char* fileName,
+    unsigned long fifo_depth,
+    double loader_rate
+    )
+{
+  int ret;
+  POPCODE_BLOCK_BINARY block;
+  PBINARY_FILE_READER reader;
+  PROGRAM_ANALYSIS analysis;
+
+  ret = binary_file_reader_open(fileName, &reader);
+  if (ret != 0) {
+    printf("analyze_binary_file: error %d %s opening %s\n", ret, strerror(ret), fileName);
+    return ret;
+  }
+
+  ret = program_analysis_initialize(&analysis, fifo_depth, loader_rate);
+  if (ret != 0) {
+    binary_file_reader_close(reader);
+    return ret;
+  }
+
+  while ((block = binary_file_reader_next(reader)) != NULL) {
+
+    ret = program_analysis_add_block(&analysis, block);
+
+    if (ret != 0) {
+      printf("analyze_binary_file: no HEADER block at start of program\n");
+      binary_file_reader_close(reader);
+      program_analysis_free(&analysis);
+      return ret;
+    }
+  }
+
+  ret = binary_file_reader_close(reader);
+
+  if (ret != 0) {
+    printf("analyze_binary_file: error %d %s reading %s\n", ret, strerror(ret), fileName);
+  }
+  else {
+    program_analysis_report(&analysis);
+  }
+
+  program_analysis_free(&analysis);
+
+  return ret;
+}
+
 //
 // Seek stream in block array
 //
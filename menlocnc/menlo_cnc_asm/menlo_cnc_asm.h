@@ -38,47 +38,23 @@ typedef struct _AXIS_OPCODE {
 // No instructions may be present if an info block has any
 // non-NULL fields.
 //
+// The number of axis is MENLO_CNC_AXIS_COUNT from menlo_cnc.h,
+// axis[] is indexed by MENLO_CNC_AXIS_X through MENLO_CNC_AXIS_W.
+// x, y, z and a name the first four which every build has.
+//
 
-typedef struct _OPCODE_BLOCK_FOUR_AXIS {
+typedef struct _OPCODE_BLOCK {
   AXIS_OPCODE info;
-  AXIS_OPCODE x;
-  AXIS_OPCODE y;
-  AXIS_OPCODE z;
-  AXIS_OPCODE a;
-} OPCODE_BLOCK_FOUR_AXIS, *POPCODE_BLOCK_FOUR_AXIS;
-
-typedef struct _OPCODE_BLOCK_FIVE_AXIS {
-  AXIS_OPCODE info;
-  AXIS_OPCODE x;
-  AXIS_OPCODE y;
-  AXIS_OPCODE z;
-  AXIS_OPCODE a;
-  AXIS_OPCODE b;
-} OPCODE_BLOCK_FIVE_AXIS, *POPCODE_BLOCK_FIVE_AXIS;
-
-typedef struct _OPCODE_BLOCK_SEVEN_AXIS {
-  AXIS_OPCODE info;
-  AXIS_OPCODE x;
-  AXIS_OPCODE y;
-  AXIS_OPCODE z;
-  AXIS_OPCODE a;
-  AXIS_OPCODE b;
-  AXIS_OPCODE c;
-  AXIS_OPCODE u;
-} OPCODE_BLOCK_SEVEN_AXIS, *POPCODE_BLOCK_SEVEN_AXIS;
-
-typedef struct _OPCODE_BLOCK_NINE_AXIS {
-  AXIS_OPCODE info;
-  AXIS_OPCODE x;
-  AXIS_OPCODE y;
-  AXIS_OPCODE z;
-  AXIS_OPCODE a;
-  AXIS_OPCODE b;
-  AXIS_OPCODE c;
-  AXIS_OPCODE u;
-  AXIS_OPCODE v;
-  AXIS_OPCODE w;
-} OPCODE_BLOCK_NINE_AXIS, *POPCODE_BLOCK_NINE_AXIS;
+  union {
+    AXIS_OPCODE axis[MENLO_CNC_AXIS_COUNT];
+    struct {
+      AXIS_OPCODE x;
+      AXIS_OPCODE y;
+      AXIS_OPCODE z;
+      AXIS_OPCODE a;
+    };
+  };
+} OPCODE_BLOCK, *POPCODE_BLOCK;
 
 //
 // State enum for opcode assembly
@@ -143,12 +119,29 @@ typedef struct _BLOCK_ARRAY {
   // Current allocated capacity.
   int array_capacity;
 
-  // Amount of new capacity added when growing.
+  //
+  // Minimum new capacity added when growing, capacity otherwise
+  // doubles.
+  //
   int array_increment_size;
 
   // Supports seek, get next interface
   int seek_index;
 
+  //
+  // Set when blocks points into a mapped binary file, see
+  // map_binary_file(). The array is read only.
+  //
+  void* mapping;
+  unsigned long mapping_length;
+
+  //
+  // BLOCK_ARRAY_BACKING_* blocks was allocated from, and the
+  // length of an anonymous mapping.
+  //
+  int backing;
+  unsigned long backing_length;
+
 } BLOCK_ARRAY, *PBLOCK_ARRAY;
 
 //
@@ -167,15 +160,56 @@ typedef struct _AXIS_OPCODE_BINARY {
 //
 // The end marker contains a checksum of the block.
 //
+// Axis are as in OPCODE_BLOCK, MENLO_CNC_AXIS_COUNT of them.
+//
 
-typedef struct _OPCODE_BLOCK_FOUR_AXIS_BINARY {
+typedef struct _OPCODE_BLOCK_BINARY {
   AXIS_OPCODE_BINARY begin;
-  AXIS_OPCODE_BINARY x;
-  AXIS_OPCODE_BINARY y;
-  AXIS_OPCODE_BINARY z;
-  AXIS_OPCODE_BINARY a;
+  union {
+    AXIS_OPCODE_BINARY axis[MENLO_CNC_AXIS_COUNT];
+    struct {
+      AXIS_OPCODE_BINARY x;
+      AXIS_OPCODE_BINARY y;
+      AXIS_OPCODE_BINARY z;
+      AXIS_OPCODE_BINARY a;
+    };
+  };
   AXIS_OPCODE_BINARY end;
-} OPCODE_BLOCK_FOUR_AXIS_BINARY, *POPCODE_BLOCK_FOUR_AXIS_BINARY;
+} OPCODE_BLOCK_BINARY, *POPCODE_BLOCK_BINARY;
+
+//
+// Arena for the symbol strings of the opcode block being assembled.
+//
+// Argument strings are copied here rather than allocated one by one,
+// and the arena is reset as each block is compiled. The chunks are
+// kept for the next block so once they have grown to the longest
+// block in the file assembly makes no heap allocations.
+//
+// Axis and opcode symbols point into the reserved symbol table and
+// are not copied.
+//
+#define ASSEMBLER_ARENA_CHUNK_SIZE 4096
+
+typedef struct _ASSEMBLER_ARENA_CHUNK {
+
+  struct _ASSEMBLER_ARENA_CHUNK* next;
+
+  size_t size;
+
+  size_t used;
+
+  char data[];
+
+} ASSEMBLER_ARENA_CHUNK, *PASSEMBLER_ARENA_CHUNK;
+
+typedef struct _ASSEMBLER_ARENA {
+
+  PASSEMBLER_ARENA_CHUNK first;
+
+  // Chunk strings are being allocated from
+  PASSEMBLER_ARENA_CHUNK current;
+
+} ASSEMBLER_ARENA, *PASSEMBLER_ARENA;
 
 //
 // An opcode block can be assembled from multiple
@@ -189,12 +223,15 @@ typedef struct _ASSEMBLER_CONTEXT {
   AXIS_OPCODE_BINARY opcode_binary;
 
   // Current opcode block being assembled.
-  OPCODE_BLOCK_FOUR_AXIS opcode_block;
+  OPCODE_BLOCK opcode_block;
 
   char opcode_block_valid;
 
   char saw_info_block;
 
+  // Line of the info block when saw_info_block is set
+  int info_block_line;
+
   char saw_begin;
 
   char saw_end;
@@ -209,6 +246,9 @@ typedef struct _ASSEMBLER_CONTEXT {
 
   char* current_axis_symbol;
 
+  // Strings of the current opcode block
+  ASSEMBLER_ARENA arena;
+
   //
   // Dynamic block array for compiled binary opcode blocks.
   //
@@ -485,6 +525,9 @@ typedef struct _ASSEMBLER_CONTEXT {
 //
 // config must follow header
 //
+// number_of_axis is from 1 to MENLO_CNC_AXIS_COUNT, and is the
+// number of axis from X the loader writes for each block.
+//
 // Takes 3 32 bit unsigned options.
 //
 #define OPCODE_CONFIG_SYMBOL      "CONFIG"
@@ -667,6 +710,303 @@ typedef struct _ASSEMBLER_CONTEXT {
 
 #define BLOCK_ARRAY_INCREMENTAL_ALLOCATION BLOCK_ARRAY_INITIAL_ALLOCATION
 
+//
+// Block array backing store
+//
+// MALLOC is the C heap.
+//
+// MMAP is an anonymous mapping. Capacity which has not been pushed
+// is never touched so it costs address space, not memory.
+//
+// HUGETLB is an anonymous MAP_HUGETLB mapping, which needs huge
+// pages reserved in /proc/sys/vm/nr_hugepages. Without them it is
+// an MMAP mapping advised for transparent huge pages. Huge pages
+// are reserved for the whole capacity when mapped.
+//
+#define BLOCK_ARRAY_BACKING_MALLOC  0
+#define BLOCK_ARRAY_BACKING_MMAP    1
+#define BLOCK_ARRAY_BACKING_HUGETLB 2
+
+#define BLOCK_ARRAY_HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+//
+// Pre-size hints from the input file size so that block arrays for
+// typical programs are allocated once. These are on the small side
+// of real programs, the array grows if they are exceeded.
+//
+// Assembler source bytes per opcode block
+#define ASSEMBLER_SOURCE_BYTES_PER_BLOCK 48
+
+// G-code bytes per opcode block, ramps emit several blocks a move
+#define GCODE_SOURCE_BYTES_PER_BLOCK     8
+
+//
+// assemble_file_parallel() limits
+//
+#define ASSEMBLER_PARALLEL_MAXIMUM_THREADS 64
+
+// Smallest chunk of the file given to a thread in bytes
+#define ASSEMBLER_PARALLEL_MINIMUM_CHUNK   (256 * 1024)
+
+//
+// Binary program file.
+//
+// An assembled program saved by write_binary_file() so it can be run
+// again without reassembly. It is a BINARY_FILE_HEADER followed by
+// record_count records of OPCODE_BLOCK_BINARY, the first
+// being the HEADER/CONFIG info block as in an assembled stream.
+//
+// Records are 32 bit words (begin, each axis, end opcodes of
+// instruction, pulse_rate, pulse_count, pulse_width), 24 for the
+// default four axis build, in little endian
+// order regardless of the size of unsigned long, so a file assembled on
+// an x64 host runs on the 32 bit ARM SoC. When the host layout matches
+// the file map_binary_file() streams straight from the mapped file.
+//
+// version is incremented on any incompatible change to the layout.
+//
+// checksum is the CRC-32 of the header, with checksum as 0, followed
+// by all of the records.
+//
+// With BINARY_FILE_FLAG_COMPRESSED in flags the records are the 32 bit
+// words of a compressed program, see COMPRESSED_RECORD_*. record_size
+// is 4, record_count is the number of words and block_count the number
+// of opcode blocks they expand to. block_count is 0 otherwise.
+//
+#define BINARY_FILE_MAGIC        0x434E434D // "MCNC"
+
+#define BINARY_FILE_VERSION      1
+
+#define BINARY_FILE_RECORD_WORDS ((MENLO_CNC_AXIS_COUNT + 2) * 4)
+
+#define BINARY_FILE_RECORD_SIZE  (BINARY_FILE_RECORD_WORDS * 4)
+
+#define BINARY_FILE_FLAG_COMPRESSED 0x00000001
+
+typedef struct _BINARY_FILE_HEADER {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int header_size;
+  unsigned int record_size;
+  unsigned int record_count;
+  unsigned int checksum;
+  unsigned int flags;
+  unsigned int block_count;
+} BINARY_FILE_HEADER, *PBINARY_FILE_HEADER;
+
+//
+// Compressed program.
+//
+// Generated programs are mostly runs of identical blocks and blocks
+// which differ from the last in a few fields, typically pulse_count.
+// A compressed program is a stream of 32 bit words where each record
+// starts with a word holding the record type in the upper 4 bits and
+// an operand in the lower 28 bits:
+//
+//   BLOCK       operand 0, followed by the BINARY_FILE_RECORD_WORDS
+//               words of an opcode block in binary file order.
+//
+//   DELTA       operand is a mask of the words of the block which
+//               differ from the last block, bit 0 is the first word.
+//               Followed by the new value of each in word order.
+//
+//   DELTA_WIDE  As DELTA, with the next word holding the mask for
+//               words 28 and up, for builds of more than five axis.
+//
+//   REPEAT      operand is the number of times to repeat the last
+//               block.
+//
+// The first record is a BLOCK. The stream expands to exactly the
+// blocks it was compressed from, including the info block.
+//
+#define COMPRESSED_RECORD_BLOCK        0x10000000
+#define COMPRESSED_RECORD_DELTA        0x20000000
+#define COMPRESSED_RECORD_DELTA_WIDE   0x30000000
+#define COMPRESSED_RECORD_REPEAT       0x40000000
+
+#define COMPRESSED_RECORD_TYPE_MASK    0xF0000000
+#define COMPRESSED_RECORD_OPERAND_MASK 0x0FFFFFFF
+
+#define COMPRESSED_RECORD_DELTA_BITS   28
+
+typedef struct _COMPRESSED_PROGRAM {
+
+  // Block array of the unsigned int record words
+  PBLOCK_ARRAY words;
+
+  // Opcode blocks the words expand to
+  unsigned long block_count;
+
+} COMPRESSED_PROGRAM, *PCOMPRESSED_PROGRAM;
+
+//
+// Expands a compressed program one opcode block at a time.
+//
+typedef struct _COMPRESSED_STREAM {
+
+  unsigned int* words;
+  unsigned long word_count;
+
+  // Next word
+  unsigned long index;
+
+  // Repeats left of the current block
+  unsigned long repeat;
+
+  // Set once the first BLOCK has been read
+  int valid;
+
+  // EBADF if the stream is invalid
+  int error;
+
+  //
+  // Words of block changed by the last compressed_stream_next(),
+  // bit 0 is the first word. 0 for a repeat.
+  //
+  unsigned long long changed;
+
+  OPCODE_BLOCK_BINARY block;
+
+} COMPRESSED_STREAM, *PCOMPRESSED_STREAM;
+
+//
+// Reads a binary program file, compressed or not, an opcode block at
+// a time through a fixed buffer so a program of any size, or one
+// arriving on a pipe, is read in constant memory.
+//
+// The checksum can only be checked once the whole file has been read,
+// so a damaged file is reported at the end rather than up front as
+// map_binary_file() does.
+//
+#define BINARY_FILE_READER_WORDS 16384
+
+typedef struct _BINARY_FILE_READER {
+
+  int fd;
+
+  BINARY_FILE_HEADER header;
+
+  int compressed;
+
+  // Running checksum of the file
+  unsigned int crc;
+
+  // Words of the file not yet read
+  unsigned long file_words;
+
+  //
+  // words[] holds word_count words with index the next, or for a
+  // compressed file the stream's words, word_count and index.
+  //
+  unsigned long word_count;
+  unsigned long index;
+
+  // Opcode blocks returned
+  unsigned long blocks;
+
+  // EBADF if the file is invalid, or the errno of a read error
+  int error;
+
+  COMPRESSED_STREAM stream;
+
+  OPCODE_BLOCK_BINARY block;
+
+  unsigned int words[BINARY_FILE_READER_WORDS];
+
+} BINARY_FILE_READER, *PBINARY_FILE_READER;
+
+//
+// Program analysis.
+//
+// Computes from the instruction blocks alone what a program asks of
+// the loader, so a program which can't stream cleanly is found before
+// it is run.
+//
+// Each block runs for its longest axis as in the timing generator,
+// pulse_rate * TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR * pulse_count
+// clocks with NOP axis taking no time.
+//
+// The required refill rate at a block is the number of blocks in the
+// window of up to fifo_depth blocks ending there, divided by the run
+// time of the window. A loader slower than that over the window
+// drains the FIFO. The blocks at risk are the ends of the windows
+// with the highest required rates, at most one per fifo_depth blocks.
+//
+// With loader_rate set, a loader writing loader_rate blocks per second
+// into a fifo_depth FIFO is modeled from the first block to count the
+// underruns it would see.
+//
+#define PROGRAM_ANALYSIS_DEFAULT_FIFO_DEPTH 512
+
+#define PROGRAM_ANALYSIS_RISK_BLOCKS        10
+
+typedef struct _PROGRAM_ANALYSIS_RISK {
+
+  // Last block of the window, 1 is the first instruction block
+  unsigned long block;
+
+  // Blocks in the window
+  unsigned long window_blocks;
+
+  unsigned long long window_clocks;
+
+  // Blocks per second
+  double refill_rate;
+
+} PROGRAM_ANALYSIS_RISK, *PPROGRAM_ANALYSIS_RISK;
+
+typedef struct _PROGRAM_ANALYSIS {
+
+  unsigned long fifo_depth;
+
+  // Blocks per second, 0 for no loader model
+  double loader_rate;
+
+  // From the info block
+  int number_of_axis;
+
+  // Instruction blocks, not including the info block
+  unsigned long blocks;
+
+  // CW and CCW pulses, and CW less CCW
+  unsigned long long axis_pulses[MENLO_CNC_AXIS_COUNT];
+  long long axis_position[MENLO_CNC_AXIS_COUNT];
+
+  unsigned long long program_clocks;
+
+  unsigned long shortest_block;
+  unsigned long long shortest_block_clocks;
+
+  unsigned long longest_block;
+  unsigned long long longest_block_clocks;
+
+  // Highest required refill rate
+  PROGRAM_ANALYSIS_RISK peak;
+
+  int risk_count;
+  PROGRAM_ANALYSIS_RISK risk[PROGRAM_ANALYSIS_RISK_BLOCKS];
+
+  //
+  // Loader model
+  //
+  unsigned long loader_underruns;
+  unsigned long loader_first_underrun;
+
+  // Clocks including underrun stalls
+  double loader_program_clocks;
+
+  //
+  // Rings of fifo_depth entries by block number, the program clocks
+  // at the end of each block, and for the loader model the clock each
+  // block started.
+  //
+  unsigned long long* end_clocks;
+  double* start_clocks;
+
+  double load_clock;
+
+} PROGRAM_ANALYSIS, *PPROGRAM_ANALYSIS;
+
 //
 // API Contracts
 //
@@ -681,11 +1021,115 @@ typedef struct _ASSEMBLER_CONTEXT {
 //
 int assemble_file(char* fileName, PBLOCK_ARRAY* binary);
 
+//
+// Assemble the specified file on up to threads worker threads, 0 for
+// one per online processor, and return the same binary instructions
+// as assemble_file().
+//
+// Large generated programs are divided into chunks at opcode block
+// boundaries which are assembled in parallel. Error messages report
+// the line in the file as assemble_file() does.
+//
+int assemble_file_parallel(char* fileName, int threads, PBLOCK_ARRAY* binary);
+
 //
 // Disassemble stream.
 //
 int disassemble_stream(PBLOCK_ARRAY binary);
 
+//
+// Save the assembled binary instructions as a binary program file.
+//
+int write_binary_file(char* fileName, PBLOCK_ARRAY binary);
+
+//
+// Map and validate a binary program file and return its binary
+// instructions without reassembly.
+//
+// The returned block array is read only. block_array_free()
+// unmaps it.
+//
+// A compressed binary file is expanded into an allocated block array.
+//
+int map_binary_file(char* fileName, PBLOCK_ARRAY* binary);
+
+//
+// Compress the binary instructions into a compressed program.
+//
+int compress_binary(PBLOCK_ARRAY binary, PCOMPRESSED_PROGRAM* program);
+
+//
+// Expand a compressed program into binary instructions.
+//
+int expand_compressed_program(PCOMPRESSED_PROGRAM program, PBLOCK_ARRAY* binary);
+
+void compressed_program_free(PCOMPRESSED_PROGRAM program);
+
+//
+// Save a compressed program as a compressed binary program file.
+//
+int write_compressed_binary_file(char* fileName, PCOMPRESSED_PROGRAM program);
+
+//
+// Map and validate a compressed binary program file.
+//
+// Returns EINVAL for a binary file which is not compressed, which
+// map_binary_file() loads.
+//
+int map_compressed_binary_file(char* fileName, PCOMPRESSED_PROGRAM* program);
+
+//
+// Stream the opcode blocks of a compressed program.
+//
+// compressed_stream_next() returns the next block, which is valid
+// until the next call, or NULL at the end of the program or if the
+// stream is invalid, with error set.
+//
+void compressed_stream_initialize(PCOMPRESSED_STREAM stream, PCOMPRESSED_PROGRAM program);
+
+POPCODE_BLOCK_BINARY compressed_stream_next(PCOMPRESSED_STREAM stream);
+
+//
+// Open a binary program file for streaming, "-" for standard input.
+//
+// binary_file_reader_next() returns the next block, which is valid
+// until the next call, or NULL at the end of the file or on an error
+// with error set. binary_file_reader_close() returns error.
+//
+int binary_file_reader_open(char* fileName, PBINARY_FILE_READER* reader);
+
+POPCODE_BLOCK_BINARY binary_file_reader_next(PBINARY_FILE_READER reader);
+
+int binary_file_reader_close(PBINARY_FILE_READER reader);
+
+//
+// Disassemble a binary program file as disassemble_stream() does,
+// streaming it in constant memory with buffered output.
+//
+int disassemble_binary_file(char* fileName);
+
+//
+// Analyze a program.
+//
+// fifo_depth 0 is PROGRAM_ANALYSIS_DEFAULT_FIFO_DEPTH. loader_rate is
+// in blocks per second, 0 to not model a loader.
+//
+// The first block added must be the info block.
+//
+int program_analysis_initialize(PPROGRAM_ANALYSIS analysis, unsigned long fifo_depth, double loader_rate);
+
+int program_analysis_add_block(PPROGRAM_ANALYSIS analysis, POPCODE_BLOCK_BINARY block);
+
+void program_analysis_report(PPROGRAM_ANALYSIS analysis);
+
+void program_analysis_free(PPROGRAM_ANALYSIS analysis);
+
+//
+// Stream a binary program file through the program analysis and
+// report it.
+//
+int analyze_binary_file(char* fileName, unsigned long fifo_depth, double loader_rate);
+
 //
 // Seek stream in block array
 //
@@ -711,10 +1155,53 @@ void* block_array_get_next_entry(PBLOCK_ARRAY ba);
 
 void initialize_assembler_context(PASSEMBLER_CONTEXT context);
 
+//
+// Free the string arena of a context when assembly is done.
+//
+void free_assembler_context(PASSEMBLER_CONTEXT context);
+
 int process_assembler_line(PASSEMBLER_CONTEXT context, char* s);
 
+//
+// Compare the fixed point pulse_rate and pulse_width conversions
+// with known values and with the double implementation.
+//
+// verbose prints each value where they differ by rounding.
+//
+// Returns 0 on success, EINVAL on failure.
+//
+int pulse_timing_conformance_test(int verbose);
+
 PBLOCK_ARRAY block_array_allocate(int entry_size, int array_size, int array_increment_size);
 
+//
+// block_array_allocate() with a BLOCK_ARRAY_BACKING_* backing store.
+//
+PBLOCK_ARRAY
+block_array_allocate_backed(
+    int entry_size,
+    int array_size,
+    int array_increment_size,
+    int backing
+    );
+
+//
+// Backing store used by block_array_allocate(), the default is
+// BLOCK_ARRAY_BACKING_MALLOC.
+//
+void block_array_set_default_backing(int backing);
+
+//
+// Grow the capacity to at least array_capacity entries.
+//
+int block_array_reserve(PBLOCK_ARRAY ba, int array_capacity);
+
+//
+// Capacity for a block array to hold the program from a source file
+// of file_size bytes, see ASSEMBLER_SOURCE_BYTES_PER_BLOCK.
+//
+int block_array_capacity_hint(unsigned long file_size, int bytes_per_block);
+
 void block_array_free(PBLOCK_ARRAY ba);
 
 void* block_array_get_entry(PBLOCK_ARRAY ba, int index);
@@ -727,5 +1214,14 @@ int block_array_get_array_size(PBLOCK_ARRAY ba);
 //
 // Returns the newly allocated entry index.
 //
+// Fails with NULL on a mapped block array.
+//
 void* block_array_push_entry(PBLOCK_ARRAY ba, void* entry, int entry_size);
 
+//
+// Append all entries of src to dst.
+//
+// Returns EINVAL if the entry sizes differ, EBADF for a mapped dst.
+//
+int block_array_append(PBLOCK_ARRAY dst, PBLOCK_ARRAY src);
+
@@ -0,0 +1,1972 @@
+//
+// menlo_cnc_gcode.c - G-code compiler for menlo_cnc, FPGA based machine tool controller.
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// https://github.com/menloparkinnovation/openpux/tree/master/menlocnc
+//
+// 06/25/2018
+//
+
+//
+//   menlo_cnc - A Menlo Park Innovation LLC Creation.
+//
+//   Copyright (C) 2018 Menlo Park Innovation LLC
+//
+//   menloparkinnovation.com
+//   menloparkinnovation@gmail.com
+//
+//   Snapshot License
+//
+//   This license is for a specific snapshot of a base work of
+//   Menlo Park Innovation LLC on a non-exclusive basis with no warranty
+//   or obligation for future updates. This work, any portion, or derivative
+//   of it may be made available under other license terms by
+//   Menlo Park Innovation LLC without notice or obligation to this license.
+//
+//   There is no warranty, statement of fitness, statement of
+//   fitness for any purpose, and no statements as to infringements
+//   on any patents.
+//
+//   Menlo Park Innovation has no obligation to offer support, updates,
+//   future revisions and improvements, source code, source code downloads,
+//   media, etc.
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//   This specific snapshot is made available under the following license:
+//
+//   The MIT license:
+//
+//   https://opensource.org/licenses/MIT
+//
+//   A copy has been provided here:
+//
+//   The MIT License (MIT)
+//   Copyright (c) 2018 Menlo Park Innovation LLC
+// 
+//   Permission is hereby granted, free of charge, to any person obtaining a
+//   copy of this software and associated documentation files (the "Software"),
+//   to deal in the Software without restriction, including without limitation
+//   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//   and/or sell copies of the Software, and to permit persons to whom the
+//   Software is furnished to do so, subject to the following conditions:
+// 
+//   The above copyright notice and this permission notice shall be included in
+//   all copies or substantial portions of the Software.
+// 
+//   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//   DEALINGS IN THE SOFTWARE.
+//
+//   This is taken from LinuxCNC and applies here:
+//
+//   https://github.com/LinuxCNC/linuxcnc/blob/master/README.md
+//
+//   THE AUTHORS OF THIS SOFTWARE ACCEPT ABSOLUTELY NO LIABILITY FOR ANY HARM OR LOSS RESULTING FROM ITS USE.
+// 
+//   IT IS EXTREMELY UNWISE TO RELY ON SOFTWARE ALONE FOR SAFETY.
+// 
+//   Any machinery capable of harming persons must have provisions for completely
+//   removing power from all motors, etc, before persons enter any danger area.
+// 
+//   All machinery must be designed to comply with local and national safety
+//   codes, and the authors of this software can not, and do not, take any
+//   responsibility for such compliance.
+// 
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h> // toupper
+#include <math.h>
+#include <limits.h> // LONG_MAX
+#include <sys/stat.h>
+
+#include "menlo_cnc.h"
+
+#include "menlo_cnc_asm.h"
+
+#include "menlo_cnc_gcode.h"
+
+#define GCODE_PLANNER_MASK (GCODE_PLANNER_SIZE - 1)
+
+// G and M codes on one line
+#define GCODE_MAX_CODES 8
+
+// G0 speed before the axis velocity limits are applied
+#define GCODE_RAPID_SPEED 1.0e9
+
+#define GCODE_MM_PER_INCH 25.4
+
+//
+// Largest magnitude of a word value. Coordinates, feed rates and
+// dwell times beyond it are errors, and G codes times 10 fit an int.
+//
+#define GCODE_MAXIMUM_WORD_VALUE 1.0e8
+
+//
+// Largest step position from the origin, so a move from one end
+// to the other still fits a long.
+//
+#define GCODE_MAXIMUM_STEP_POSITION ((double)(LONG_MAX / 2))
+
+//
+// Axis word letters by index
+//
+#define GCODE_AXIS_LETTERS "XYZA"
+
+//
+// An arc end point may differ in radius from its start point by this
+// plus GCODE_ARC_RADIUS_RELATIVE_ERROR of the radius, mm.
+//
+#define GCODE_ARC_RADIUS_ERROR          0.005
+#define GCODE_ARC_RADIUS_RELATIVE_ERROR 0.001
+
+//
+// Words present on a line
+//
+#define GCODE_WORD_X 0x0001
+#define GCODE_WORD_Y 0x0002
+#define GCODE_WORD_Z 0x0004
+#define GCODE_WORD_A 0x0008
+#define GCODE_WORD_I 0x0010
+#define GCODE_WORD_J 0x0020
+#define GCODE_WORD_K 0x0040
+#define GCODE_WORD_R 0x0080
+#define GCODE_WORD_F 0x0100
+#define GCODE_WORD_P 0x0200
+
+#define GCODE_WORD_AXIS (GCODE_WORD_X | GCODE_WORD_Y | GCODE_WORD_Z | GCODE_WORD_A)
+
+#define GCODE_WORD_OFFSET (GCODE_WORD_I | GCODE_WORD_J | GCODE_WORD_K)
+
+//
+// One parsed line.
+//
+// G codes are held as 10 times their value so G91.1 is 911.
+//
+typedef struct _GCODE_LINE {
+
+  int g_count;
+  int g[GCODE_MAX_CODES];
+
+  int m_count;
+  int m[GCODE_MAX_CODES];
+
+  unsigned long words;
+
+  double axis[GCODE_AXIS_COUNT];
+
+  double i;
+  double j;
+  double k;
+  double r;
+  double f;
+  double p;
+
+} GCODE_LINE, *PGCODE_LINE;
+
+//
+// Trapezoidal velocity profile of the block being emitted.
+//
+typedef struct _GCODE_PROFILE {
+
+  double entry_speed;
+  double peak_speed;
+  double acceleration;
+
+  double accelerate_distance;
+  double accelerate_time;
+
+  double cruise_distance;
+  double cruise_time;
+
+} GCODE_PROFILE, *PGCODE_PROFILE;
+
+int gcode_parse_line(PGCODE_CONTEXT context, char* s, PGCODE_LINE line);
+
+int gcode_queue_line(PGCODE_CONTEXT context, double* target, double speed);
+
+int
+gcode_queue_arc(
+    PGCODE_CONTEXT context,
+    PGCODE_LINE line,
+    double* target,
+    int clockwise,
+    double speed
+    );
+
+int gcode_queue_dwell(PGCODE_CONTEXT context, double seconds);
+
+int gcode_planner_push(PGCODE_CONTEXT context);
+
+void gcode_planner_recalculate(PGCODE_CONTEXT context);
+
+int gcode_planner_emit(PGCODE_CONTEXT context);
+
+int
+gcode_emit_motion(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block,
+    double entry_speed,
+    double exit_speed
+    );
+
+double
+gcode_profile_time(
+    PGCODE_PROFILE profile,
+    double distance
+    );
+
+int
+gcode_emit_to(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block,
+    PGCODE_PROFILE profile,
+    double fraction
+    );
+
+int
+gcode_emit_segment(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block,
+    PGCODE_PROFILE profile,
+    long target
+    );
+
+int gcode_emit_dwell(PGCODE_CONTEXT context, PGCODE_PLANNER_BLOCK block);
+
+void
+gcode_machine_initialize(
+    PGCODE_MACHINE machine
+    )
+{
+  bzero(machine, sizeof(GCODE_MACHINE));
+
+  machine->steps_per_unit[GCODE_AXIS_X] = GCODE_DEFAULT_XY_STEPS_PER_UNIT;
+  machine->steps_per_unit[GCODE_AXIS_Y] = GCODE_DEFAULT_XY_STEPS_PER_UNIT;
+  machine->steps_per_unit[GCODE_AXIS_Z] = GCODE_DEFAULT_Z_STEPS_PER_UNIT;
+  machine->steps_per_unit[GCODE_AXIS_A] = GCODE_DEFAULT_A_STEPS_PER_UNIT;
+
+  machine->max_velocity[GCODE_AXIS_X] = GCODE_DEFAULT_XY_MAX_VELOCITY;
+  machine->max_velocity[GCODE_AXIS_Y] = GCODE_DEFAULT_XY_MAX_VELOCITY;
+  machine->max_velocity[GCODE_AXIS_Z] = GCODE_DEFAULT_Z_MAX_VELOCITY;
+  machine->max_velocity[GCODE_AXIS_A] = GCODE_DEFAULT_A_MAX_VELOCITY;
+
+  machine->max_acceleration[GCODE_AXIS_X] = GCODE_DEFAULT_XY_MAX_ACCELERATION;
+  machine->max_acceleration[GCODE_AXIS_Y] = GCODE_DEFAULT_XY_MAX_ACCELERATION;
+  machine->max_acceleration[GCODE_AXIS_Z] = GCODE_DEFAULT_Z_MAX_ACCELERATION;
+  machine->max_acceleration[GCODE_AXIS_A] = GCODE_DEFAULT_A_MAX_ACCELERATION;
+
+  machine->junction_deviation = GCODE_DEFAULT_JUNCTION_DEVIATION;
+
+  machine->arc_tolerance = GCODE_DEFAULT_ARC_TOLERANCE;
+
+  machine->segment_time = GCODE_DEFAULT_SEGMENT_TIME;
+
+  machine->default_feed_rate = GCODE_DEFAULT_FEED_RATE;
+
+  machine->pulse_width_nanoseconds = GCODE_DEFAULT_PULSE_WIDTH_NANOSECONDS;
+}
+
+int
+initialize_gcode_context(
+    PGCODE_CONTEXT context,
+    PGCODE_MACHINE machine
+    )
+{
+  int ret;
+  int index;
+  OPCODE_BLOCK_BINARY bin;
+
+  bzero(context, sizeof(GCODE_CONTEXT));
+
+  if (machine != NULL) {
+    context->machine = *machine;
+  }
+  else {
+    gcode_machine_initialize(&context->machine);
+  }
+
+  for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+    if ((context->machine.steps_per_unit[index] <= 0) ||
+        (context->machine.max_velocity[index] <= 0) ||
+        (context->machine.max_acceleration[index] <= 0)) {
+      printf("gcode: axis %d limits must be greater than 0\n", index);
+      return EINVAL;
+    }
+  }
+
+  if ((context->machine.arc_tolerance <= 0) ||
+      (context->machine.segment_time <= 0) ||
+      (context->machine.default_feed_rate <= 0)) {
+    printf("gcode: arc_tolerance, segment_time and default_feed_rate must be greater than 0\n");
+    return EINVAL;
+  }
+
+  ret = menlo_cnc_registers_calculate_pulse_width(
+      NULL,
+      context->machine.pulse_width_nanoseconds,
+      &context->pulse_width
+      );
+
+  if (ret != 0) {
+    printf("gcode: pulse_width %ld ns out of range for target hardware\n",
+      context->machine.pulse_width_nanoseconds);
+    return EINVAL;
+  }
+
+  // Dwell is counted in milliseconds
+  ret = menlo_cnc_registers_calculate_pulse_rate_by_hz(NULL, 1000.0, &context->dwell_pulse_rate);
+  if (ret != 0) {
+    return EINVAL;
+  }
+
+  context->lineNumber = 1;
+
+  context->motion_mode = 0;
+  context->absolute = 1;
+  context->plane = 17;
+  context->unit_scale = 1.0;
+  context->feed_rate = context->machine.default_feed_rate / 60.0;
+
+  context->compiled_binary = block_array_allocate(
+      sizeof(OPCODE_BLOCK_BINARY),
+      BLOCK_ARRAY_INITIAL_ALLOCATION,
+      BLOCK_ARRAY_INCREMENTAL_ALLOCATION
+      );
+
+  if (context->compiled_binary == NULL) {
+    return ENOMEM;
+  }
+
+  //
+  // The stream starts with the info block as an assembled program.
+  //
+  // HEADER machine_version 1, CONFIG number_of_axis 4.
+  //
+
+  bzero(&bin, sizeof(bin));
+
+  bin.x.instruction = OPCODE_HEADER;
+  bin.x.pulse_rate = 1;
+
+  bin.y.instruction = OPCODE_CONFIG;
+  bin.y.pulse_rate = GCODE_AXIS_COUNT;
+
+  bin.z.instruction = OPCODE_CONFIG;
+  bin.a.instruction = OPCODE_CONFIG;
+
+  if (block_array_push_entry(context->compiled_binary, &bin, sizeof(bin)) == NULL) {
+    block_array_free(context->compiled_binary);
+    context->compiled_binary = NULL;
+    return ENOMEM;
+  }
+
+  return 0;
+}
+
+int
+finish_gcode_context(
+    PGCODE_CONTEXT context
+    )
+{
+  int ret;
+
+  while (context->planner_tail != context->planner_head) {
+    ret = gcode_planner_emit(context);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+int
+compile_gcode_file(
+    char* fileName,
+    PGCODE_MACHINE machine,
+    PBLOCK_ARRAY* binary,
+    PGCODE_STATISTICS statistics
+    )
+{
+  int ret;
+  FILE *file;
+  size_t len;
+  char *line;
+  struct stat st;
+  PGCODE_CONTEXT context;
+
+  file = fopen(fileName, "r");
+  if (file == NULL) {
+    return errno;
+  }
+
+  context = (PGCODE_CONTEXT)malloc(sizeof(GCODE_CONTEXT));
+  if (context == NULL) {
+    fclose(file);
+    return ENOMEM;
+  }
+
+  ret = initialize_gcode_context(context, machine);
+  if (ret != 0) {
+    free(context);
+    fclose(file);
+    return ret;
+  }
+
+  // Size the block array for the program from the source size
+  if (fstat(fileno(file), &st) == 0) {
+
+    ret = block_array_reserve(
+        context->compiled_binary,
+        block_array_capacity_hint(st.st_size, GCODE_SOURCE_BYTES_PER_BLOCK)
+        );
+
+    if (ret != 0) {
+      block_array_free(context->compiled_binary);
+      free(context);
+      fclose(file);
+      return ret;
+    }
+  }
+
+  line = NULL;
+  len = 0;
+
+  while (getline(&line, &len, file) != -1) {
+
+    ret = process_gcode_line(context, line);
+    if (ret != 0) {
+      break;
+    }
+
+    context->lineNumber++;
+  }
+
+  free(line);
+
+  fclose(file);
+
+  if (ret == 0) {
+    ret = finish_gcode_context(context);
+  }
+
+  if (ret != 0) {
+    block_array_free(context->compiled_binary);
+    free(context);
+    return ret;
+  }
+
+  *binary = context->compiled_binary;
+
+  if (statistics != NULL) {
+    *statistics = context->statistics;
+  }
+
+  free(context);
+
+  return 0;
+}
+
+//
+// Split a line into its words.
+//
+int
+gcode_parse_line(
+    PGCODE_CONTEXT context,
+    char* s,
+    PGCODE_LINE line
+    )
+{
+  char letter;
+  char* end;
+  double value;
+
+  line->g_count = 0;
+  line->m_count = 0;
+  line->words = 0;
+
+  while (*s != '\0') {
+
+    if ((*s == ' ') || (*s == '\t') || (*s == '\r') || (*s == '\n')) {
+      s++;
+      continue;
+    }
+
+    if ((*s == ';') || (*s == '%')) {
+      break;
+    }
+
+    if (*s == '(') {
+      s = strchr(s, ')');
+      if (s == NULL) {
+        printf("gcode line %d: unterminated comment\n", context->lineNumber);
+        return EBADF;
+      }
+      s++;
+      continue;
+    }
+
+    // Block delete is not selected
+    if (*s == '/') {
+      s++;
+      continue;
+    }
+
+    letter = toupper(*s);
+    s++;
+
+    value = strtod(s, &end);
+    if (end == s) {
+      printf("gcode line %d: %c requires a value\n", context->lineNumber, letter);
+      return EBADF;
+    }
+
+    // strtod() accepts inf and nan, and overflows to HUGE_VAL
+    if (!isfinite(value) || (fabs(value) > GCODE_MAXIMUM_WORD_VALUE)) {
+      printf("gcode line %d: %c value out of range\n", context->lineNumber, letter);
+      return EBADF;
+    }
+
+    s = end;
+
+    switch (letter) {
+
+    case 'G':
+      if (line->g_count == GCODE_MAX_CODES) {
+        printf("gcode line %d: too many G codes\n", context->lineNumber);
+        return EBADF;
+      }
+      line->g[line->g_count++] = (int)lround(value * 10.0);
+      break;
+
+    case 'M':
+      if (line->m_count == GCODE_MAX_CODES) {
+        printf("gcode line %d: too many M codes\n", context->lineNumber);
+        return EBADF;
+      }
+      line->m[line->m_count++] = (int)lround(value);
+      break;
+
+    case 'X':
+      line->axis[GCODE_AXIS_X] = value;
+      line->words |= GCODE_WORD_X;
+      break;
+
+    case 'Y':
+      line->axis[GCODE_AXIS_Y] = value;
+      line->words |= GCODE_WORD_Y;
+      break;
+
+    case 'Z':
+      line->axis[GCODE_AXIS_Z] = value;
+      line->words |= GCODE_WORD_Z;
+      break;
+
+    case 'A':
+      line->axis[GCODE_AXIS_A] = value;
+      line->words |= GCODE_WORD_A;
+      break;
+
+    case 'I':
+      line->i = value;
+      line->words |= GCODE_WORD_I;
+      break;
+
+    case 'J':
+      line->j = value;
+      line->words |= GCODE_WORD_J;
+      break;
+
+    case 'K':
+      line->k = value;
+      line->words |= GCODE_WORD_K;
+      break;
+
+    case 'R':
+      line->r = value;
+      line->words |= GCODE_WORD_R;
+      break;
+
+    case 'F':
+      line->f = value;
+      line->words |= GCODE_WORD_F;
+      break;
+
+    case 'P':
+      line->p = value;
+      line->words |= GCODE_WORD_P;
+      break;
+
+    //
+    // Line number, spindle speed, tool, and tool offset
+    // numbers have no effect on motion.
+    //
+    case 'N':
+    case 'S':
+    case 'T':
+    case 'D':
+    case 'H':
+      break;
+
+    default:
+      printf("gcode line %d: %c word not supported\n", context->lineNumber, letter);
+      return ENOTSUP;
+    }
+  }
+
+  return 0;
+}
+
+int
+process_gcode_line(
+    PGCODE_CONTEXT context,
+    char* s
+    )
+{
+  int ret;
+  int index;
+  int dwell;
+  int motion;
+  int program_end;
+  double speed;
+  double target[GCODE_AXIS_COUNT];
+  GCODE_LINE line;
+
+  context->statistics.lines++;
+
+  // Anything after M2 or M30 is not executed
+  if (context->program_end) {
+    return 0;
+  }
+
+  ret = gcode_parse_line(context, s, &line);
+  if (ret != 0) {
+    return ret;
+  }
+
+  dwell = 0;
+  motion = -1;
+  program_end = 0;
+
+  for (index = 0; index < line.g_count; index++) {
+
+    switch (line.g[index]) {
+
+    case 0:
+    case 10:
+    case 20:
+    case 30:
+      motion = line.g[index] / 10;
+      break;
+
+    case 40:
+      dwell = 1;
+      break;
+
+    case 170:
+    case 180:
+    case 190:
+      context->plane = line.g[index] / 10;
+      break;
+
+    case 200:
+      context->unit_scale = GCODE_MM_PER_INCH;
+      break;
+
+    case 210:
+      context->unit_scale = 1.0;
+      break;
+
+    case 900:
+      context->absolute = 1;
+      break;
+
+    case 910:
+      context->absolute = 0;
+      break;
+
+    //
+    // Cutter and tool length compensation off, work offsets,
+    // path control, canned cycle cancel, units per minute feed,
+    // and incremental arc centers are the only modes supported.
+    //
+    case 400:
+    case 490:
+    case 540:
+    case 550:
+    case 560:
+    case 570:
+    case 580:
+    case 590:
+    case 610:
+    case 611:
+    case 640:
+    case 800:
+    case 911:
+    case 940:
+      break;
+
+    default:
+      printf("gcode line %d: G%g not supported\n", context->lineNumber, line.g[index] / 10.0);
+      return ENOTSUP;
+    }
+  }
+
+  for (index = 0; index < line.m_count; index++) {
+
+    switch (line.m[index]) {
+
+    case 2:
+    case 30:
+      program_end = 1;
+      break;
+
+    //
+    // Spindle, tool change and coolant are not timing
+    // generator resources.
+    //
+    case 3:
+    case 4:
+    case 5:
+    case 6:
+    case 7:
+    case 8:
+    case 9:
+      break;
+
+    default:
+      printf("gcode line %d: M%d not supported\n", context->lineNumber, line.m[index]);
+      return ENOTSUP;
+    }
+  }
+
+  if (line.words & GCODE_WORD_F) {
+
+    if (line.f <= 0) {
+      printf("gcode line %d: feed rate must be greater than 0\n", context->lineNumber);
+      return EBADF;
+    }
+
+    context->feed_rate = (line.f * context->unit_scale) / 60.0;
+  }
+
+  if (dwell) {
+
+    if ((line.words & GCODE_WORD_P) == 0) {
+      printf("gcode line %d: G4 requires P\n", context->lineNumber);
+      return EBADF;
+    }
+
+    ret = gcode_queue_dwell(context, line.p);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  if (motion != -1) {
+    context->motion_mode = motion;
+  }
+
+  if ((line.words & GCODE_WORD_AXIS) != 0) {
+
+    if (dwell) {
+      printf("gcode line %d: axis words not allowed with G4\n", context->lineNumber);
+      return EBADF;
+    }
+
+    for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+
+      target[index] = context->position[index];
+
+      if ((line.words & (GCODE_WORD_X << index)) == 0) {
+        continue;
+      }
+
+      // A is in degrees in either unit system
+      if (index == GCODE_AXIS_A) {
+        target[index] = line.axis[index];
+      }
+      else {
+        target[index] = line.axis[index] * context->unit_scale;
+      }
+
+      if (!context->absolute) {
+        target[index] += context->position[index];
+      }
+    }
+
+    if (context->motion_mode == 0) {
+      speed = GCODE_RAPID_SPEED;
+    }
+    else {
+      speed = context->feed_rate;
+    }
+
+    if ((context->motion_mode == 2) || (context->motion_mode == 3)) {
+      ret = gcode_queue_arc(context, &line, target, (context->motion_mode == 2), speed);
+    }
+    else {
+      ret = gcode_queue_line(context, target, speed);
+    }
+
+    if (ret != 0) {
+      return ret;
+    }
+
+    memcpy(context->position, target, sizeof(context->position));
+  }
+  else if ((line.words & (GCODE_WORD_OFFSET | GCODE_WORD_R)) != 0) {
+    printf("gcode line %d: arc requires an end point\n", context->lineNumber);
+    return EBADF;
+  }
+
+  if (program_end) {
+
+    context->program_end = 1;
+
+    return finish_gcode_context(context);
+  }
+
+  return 0;
+}
+
+//
+// Queue a linear move from the current position to target at speed
+// in units per second.
+//
+int
+gcode_queue_line(
+    PGCODE_CONTEXT context,
+    double* target,
+    double speed
+    )
+{
+  int index;
+  long steps;
+  long target_steps[GCODE_AXIS_COUNT];
+  long dominant_steps;
+  double position;
+  double delta;
+  double length;
+  double limit;
+  double inverse;
+  double cos_theta;
+  double sin_theta_d2;
+  double junction_speed;
+  PGCODE_PLANNER_BLOCK block;
+
+  block = &context->planner[context->planner_head & GCODE_PLANNER_MASK];
+
+  dominant_steps = 0;
+  block->dominant_axis = 0;
+
+  for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+
+    position = target[index] * context->machine.steps_per_unit[index];
+
+    if (fabs(position) > GCODE_MAXIMUM_STEP_POSITION) {
+      printf("gcode line %d: %c position out of range\n",
+        context->lineNumber, GCODE_AXIS_LETTERS[index]);
+      return ERANGE;
+    }
+
+    //
+    // Rounding the absolute position rather than each move keeps
+    // the machine within half a step of the program.
+    //
+    target_steps[index] = lround(position);
+
+    steps = target_steps[index] - context->step_position[index];
+
+    block->steps[index] = steps;
+
+    if (labs(steps) > dominant_steps) {
+      dominant_steps = labs(steps);
+      block->dominant_axis = index;
+    }
+  }
+
+  // Less than a step
+  if (dominant_steps == 0) {
+    return 0;
+  }
+
+  //
+  // Length is along X, Y, Z. A rotary only move uses degrees.
+  //
+  length = 0;
+
+  for (index = 0; index < GCODE_AXIS_A; index++) {
+    delta = block->steps[index] / context->machine.steps_per_unit[index];
+    length += delta * delta;
+  }
+
+  if (length > 0) {
+    length = sqrt(length);
+  }
+  else {
+    length = fabs(block->steps[GCODE_AXIS_A] / context->machine.steps_per_unit[GCODE_AXIS_A]);
+  }
+
+  block->length = length;
+  block->dwell = 0;
+  block->lineNumber = context->lineNumber;
+
+  block->nominal_speed = speed;
+  block->acceleration = GCODE_RAPID_SPEED;
+
+  //
+  // The move is limited by the axis which reaches its
+  // limit first along the move.
+  //
+  for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+
+    delta = block->steps[index] / context->machine.steps_per_unit[index];
+
+    block->unit_vector[index] = delta / length;
+
+    if (block->steps[index] == 0) {
+      continue;
+    }
+
+    inverse = fabs(length / delta);
+
+    limit = context->machine.max_velocity[index] * inverse;
+    if (limit < block->nominal_speed) {
+      block->nominal_speed = limit;
+    }
+
+    limit = context->machine.max_acceleration[index] * inverse;
+    if (limit < block->acceleration) {
+      block->acceleration = limit;
+    }
+  }
+
+  //
+  // Junction deviation.
+  //
+  // The speed at which the centripetal acceleration around a circle
+  // tangent to both moves, and junction_deviation from the corner,
+  // equals the acceleration limit.
+  //
+  if (context->have_previous) {
+
+    cos_theta = 0;
+
+    for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+      cos_theta -= context->previous_unit_vector[index] * block->unit_vector[index];
+    }
+
+    if (cos_theta > 0.999999) {
+      // Reversal
+      junction_speed = 0;
+    }
+    else if (cos_theta < -0.999999) {
+      // Straight through
+      junction_speed = GCODE_RAPID_SPEED;
+    }
+    else {
+      sin_theta_d2 = sqrt(0.5 * (1.0 - cos_theta));
+
+      junction_speed = sqrt(
+          (block->acceleration * context->machine.junction_deviation * sin_theta_d2) /
+          (1.0 - sin_theta_d2)
+          );
+    }
+
+    if (junction_speed > block->nominal_speed) {
+      junction_speed = block->nominal_speed;
+    }
+
+    if (junction_speed > context->previous_nominal_speed) {
+      junction_speed = context->previous_nominal_speed;
+    }
+  }
+  else {
+    junction_speed = 0;
+  }
+
+  block->max_entry_speed = junction_speed;
+
+  context->have_previous = 1;
+
+  memcpy(context->previous_unit_vector, block->unit_vector, sizeof(block->unit_vector));
+
+  context->previous_nominal_speed = block->nominal_speed;
+
+  memcpy(context->step_position, target_steps, sizeof(target_steps));
+
+  context->statistics.moves++;
+
+  return gcode_planner_push(context);
+}
+
+//
+// Queue an arc in the current plane from the current position to
+// target as linear moves within arc_tolerance of the arc.
+//
+int
+gcode_queue_arc(
+    PGCODE_CONTEXT context,
+    PGCODE_LINE line,
+    double* target,
+    int clockwise,
+    double speed
+    )
+{
+  int ret;
+  int index;
+  int axis0;
+  int axis1;
+  unsigned long segment;
+  unsigned long segments;
+  double offset0;
+  double offset1;
+  double center0;
+  double center1;
+  double x;
+  double y;
+  double h;
+  double h2;
+  double radius;
+  double end_radius;
+  double angle_start;
+  double angle_end;
+  double sweep;
+  double theta;
+  double angle;
+  double fraction;
+  double point[GCODE_AXIS_COUNT];
+  double* start;
+
+  start = context->position;
+
+  switch (context->plane) {
+
+  case 18:
+    axis0 = GCODE_AXIS_Z;
+    axis1 = GCODE_AXIS_X;
+    offset0 = line->k;
+    offset1 = line->i;
+    break;
+
+  case 19:
+    axis0 = GCODE_AXIS_Y;
+    axis1 = GCODE_AXIS_Z;
+    offset0 = line->j;
+    offset1 = line->k;
+    break;
+
+  default:
+    axis0 = GCODE_AXIS_X;
+    axis1 = GCODE_AXIS_Y;
+    offset0 = line->i;
+    offset1 = line->j;
+    break;
+  }
+
+  x = target[axis0] - start[axis0];
+  y = target[axis1] - start[axis1];
+
+  if (line->words & GCODE_WORD_R) {
+
+    radius = line->r * context->unit_scale;
+
+    if ((x == 0) && (y == 0)) {
+      printf("gcode line %d: R form arc can't be a full circle\n", context->lineNumber);
+      return EBADF;
+    }
+
+    //
+    // Center is on the perpendicular bisector of the chord,
+    // h from the chord midpoint. Negative R is the larger arc.
+    //
+    h2 = (4.0 * radius * radius) - (x * x) - (y * y);
+
+    if (h2 < 0) {
+
+      // End point just beyond the diameter from rounding
+      if (-h2 > (4.0 * radius * radius * 1.0e-6)) {
+        printf("gcode line %d: arc radius too small for end point\n", context->lineNumber);
+        return EBADF;
+      }
+
+      h2 = 0;
+    }
+
+    h = -sqrt(h2) / sqrt((x * x) + (y * y));
+
+    if (!clockwise) {
+      h = -h;
+    }
+
+    if (radius < 0) {
+      h = -h;
+      radius = -radius;
+    }
+
+    center0 = start[axis0] + (0.5 * (x - (y * h)));
+    center1 = start[axis1] + (0.5 * (y + (x * h)));
+  }
+  else if (line->words & GCODE_WORD_OFFSET) {
+
+    center0 = start[axis0] + (offset0 * context->unit_scale);
+    center1 = start[axis1] + (offset1 * context->unit_scale);
+
+    radius = hypot(start[axis0] - center0, start[axis1] - center1);
+
+    end_radius = hypot(target[axis0] - center0, target[axis1] - center1);
+
+    if (fabs(end_radius - radius) >
+        (GCODE_ARC_RADIUS_ERROR + (radius * GCODE_ARC_RADIUS_RELATIVE_ERROR))) {
+      printf("gcode line %d: arc end radius %g differs from start radius %g\n",
+        context->lineNumber, end_radius, radius);
+      return EBADF;
+    }
+  }
+  else {
+    printf("gcode line %d: arc requires I, J, K or R\n", context->lineNumber);
+    return EBADF;
+  }
+
+  if (radius == 0) {
+    printf("gcode line %d: arc radius is 0\n", context->lineNumber);
+    return EBADF;
+  }
+
+  angle_start = atan2(start[axis1] - center1, start[axis0] - center0);
+  angle_end = atan2(target[axis1] - center1, target[axis0] - center0);
+
+  sweep = angle_end - angle_start;
+
+  //
+  // The same start and end point is a full circle.
+  //
+  if (clockwise) {
+    if (sweep >= -1.0e-9) {
+      sweep -= 2.0 * M_PI;
+    }
+  }
+  else {
+    if (sweep <= 1.0e-9) {
+      sweep += 2.0 * M_PI;
+    }
+  }
+
+  //
+  // Chord angle which deviates arc_tolerance from the arc.
+  //
+  if (radius > context->machine.arc_tolerance) {
+    theta = 2.0 * acos(1.0 - (context->machine.arc_tolerance / radius));
+  }
+  else {
+    theta = M_PI / 2.0;
+  }
+
+  segments = (unsigned long)ceil(fabs(sweep) / theta);
+  if (segments == 0) {
+    segments = 1;
+  }
+
+  for (segment = 1; segment < segments; segment++) {
+
+    fraction = (double)segment / (double)segments;
+
+    angle = angle_start + (sweep * fraction);
+
+    // Helical and A axis move linearly with the arc
+    for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+      point[index] = start[index] + ((target[index] - start[index]) * fraction);
+    }
+
+    point[axis0] = center0 + (radius * cos(angle));
+    point[axis1] = center1 + (radius * sin(angle));
+
+    ret = gcode_queue_line(context, point, speed);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  context->statistics.arcs++;
+
+  return gcode_queue_line(context, target, speed);
+}
+
+//
+// Queue a G4 dwell. Motion comes to a stop before it.
+//
+int
+gcode_queue_dwell(
+    PGCODE_CONTEXT context,
+    double seconds
+    )
+{
+  PGCODE_PLANNER_BLOCK block;
+
+  if (seconds < 0) {
+    printf("gcode line %d: dwell must not be negative\n", context->lineNumber);
+    return EBADF;
+  }
+
+  block = &context->planner[context->planner_head & GCODE_PLANNER_MASK];
+
+  bzero(block, sizeof(GCODE_PLANNER_BLOCK));
+
+  block->dwell = seconds;
+  block->lineNumber = context->lineNumber;
+
+  // Next move starts from a stop
+  context->have_previous = 0;
+
+  return gcode_planner_push(context);
+}
+
+//
+// Add the block at planner_head and replan.
+//
+// The oldest block is emitted once the lookahead is full.
+//
+int
+gcode_planner_push(
+    PGCODE_CONTEXT context
+    )
+{
+  double speed;
+  PGCODE_PLANNER_BLOCK block;
+
+  block = &context->planner[context->planner_head & GCODE_PLANNER_MASK];
+
+  if (context->planner_head == context->planner_tail) {
+
+    // Follows the last emitted block
+    block->entry_speed = context->exit_speed;
+  }
+  else {
+
+    // Newest block must be able to stop
+    speed = sqrt(2.0 * block->acceleration * block->length);
+
+    block->entry_speed = speed;
+
+    if (block->entry_speed > block->max_entry_speed) {
+      block->entry_speed = block->max_entry_speed;
+    }
+  }
+
+  context->planner_head++;
+
+  gcode_planner_recalculate(context);
+
+  if ((context->planner_head - context->planner_tail) == GCODE_PLANNER_SIZE) {
+    return gcode_planner_emit(context);
+  }
+
+  return 0;
+}
+
+//
+// Backward pass.
+//
+// Adding a block raises the speed the previous newest block may
+// exit at from 0, which may raise the entry speeds before it. A block
+// already at its max_entry_speed can't be raised, so no block before
+// it changes and the pass stops there.
+//
+// The oldest block's entry_speed is final and is not changed.
+//
+void
+gcode_planner_recalculate(
+    PGCODE_CONTEXT context
+    )
+{
+  unsigned long index;
+  double next_entry_speed;
+  double speed;
+  PGCODE_PLANNER_BLOCK block;
+
+  if ((context->planner_head - context->planner_tail) < 2) {
+    return;
+  }
+
+  next_entry_speed = context->planner[(context->planner_head - 1) & GCODE_PLANNER_MASK].entry_speed;
+
+  for (index = context->planner_head - 2; index != context->planner_tail; index--) {
+
+    block = &context->planner[index & GCODE_PLANNER_MASK];
+
+    if (block->entry_speed == block->max_entry_speed) {
+      break;
+    }
+
+    speed = sqrt((next_entry_speed * next_entry_speed) +
+                 (2.0 * block->acceleration * block->length));
+
+    if (speed > block->max_entry_speed) {
+      speed = block->max_entry_speed;
+    }
+
+    block->entry_speed = speed;
+
+    next_entry_speed = speed;
+  }
+}
+
+//
+// Forward pass and emit the oldest block.
+//
+// Its exit speed is the next block's entry speed limited by what it
+// can accelerate to from its own entry speed. That becomes the final
+// entry speed of the next block.
+//
+int
+gcode_planner_emit(
+    PGCODE_CONTEXT context
+    )
+{
+  int ret;
+  double exit_speed;
+  double speed;
+  PGCODE_PLANNER_BLOCK block;
+  PGCODE_PLANNER_BLOCK next;
+
+  block = &context->planner[context->planner_tail & GCODE_PLANNER_MASK];
+
+  if (block->length == 0) {
+    ret = gcode_emit_dwell(context, block);
+    exit_speed = 0;
+  }
+  else {
+
+    exit_speed = 0;
+
+    if ((context->planner_tail + 1) != context->planner_head) {
+
+      next = &context->planner[(context->planner_tail + 1) & GCODE_PLANNER_MASK];
+
+      speed = sqrt((block->entry_speed * block->entry_speed) +
+                   (2.0 * block->acceleration * block->length));
+
+      exit_speed = next->entry_speed;
+
+      if (exit_speed > speed) {
+        exit_speed = speed;
+      }
+
+      next->entry_speed = exit_speed;
+    }
+
+    ret = gcode_emit_motion(context, block, block->entry_speed, exit_speed);
+  }
+
+  context->exit_speed = exit_speed;
+
+  context->planner_tail++;
+
+  return ret;
+}
+
+//
+// Emit a move as a trapezoidal velocity profile.
+//
+// The acceleration and deceleration ramps are divided into equal time
+// instruction blocks of at most segment_time, the cruise is one block
+// unless gcode_emit_to() splits it.
+//
+int
+gcode_emit_motion(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block,
+    double entry_speed,
+    double exit_speed
+    )
+{
+  int ret;
+  unsigned long segment;
+  unsigned long segments;
+  double a;
+  double d;
+  double peak_speed;
+  double decelerate_time;
+  double t;
+  double s;
+  GCODE_PROFILE profile;
+
+  a = block->acceleration;
+  d = block->length;
+
+  //
+  // Peak speed where the acceleration and deceleration ramps
+  // meet, limited to the nominal speed.
+  //
+  peak_speed = sqrt(((2.0 * a * d) + (entry_speed * entry_speed) + (exit_speed * exit_speed)) / 2.0);
+
+  if (peak_speed > block->nominal_speed) {
+    peak_speed = block->nominal_speed;
+  }
+
+  if (peak_speed < entry_speed) {
+    peak_speed = entry_speed;
+  }
+
+  if (peak_speed < exit_speed) {
+    peak_speed = exit_speed;
+  }
+
+  profile.entry_speed = entry_speed;
+  profile.peak_speed = peak_speed;
+  profile.acceleration = a;
+
+  profile.accelerate_distance = ((peak_speed * peak_speed) - (entry_speed * entry_speed)) / (2.0 * a);
+  profile.accelerate_time = (peak_speed - entry_speed) / a;
+
+  profile.cruise_distance = d - profile.accelerate_distance -
+      (((peak_speed * peak_speed) - (exit_speed * exit_speed)) / (2.0 * a));
+
+  if (profile.cruise_distance < 0) {
+    profile.cruise_distance = 0;
+  }
+
+  profile.cruise_time = profile.cruise_distance / peak_speed;
+
+  decelerate_time = (peak_speed - exit_speed) / a;
+
+  bzero(context->emitted_steps, sizeof(context->emitted_steps));
+  context->emitted_time = 0;
+
+  segments = (unsigned long)ceil(profile.accelerate_time / context->machine.segment_time);
+
+  for (segment = 1; segment <= segments; segment++) {
+
+    t = (profile.accelerate_time * segment) / segments;
+    s = (entry_speed * t) + (0.5 * a * t * t);
+
+    ret = gcode_emit_to(context, block, &profile, s / d);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  if (profile.cruise_time > 0) {
+
+    s = profile.accelerate_distance + profile.cruise_distance;
+
+    ret = gcode_emit_to(context, block, &profile, s / d);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  segments = (unsigned long)ceil(decelerate_time / context->machine.segment_time);
+
+  for (segment = 1; segment < segments; segment++) {
+
+    t = (decelerate_time * segment) / segments;
+    s = profile.accelerate_distance + profile.cruise_distance + (peak_speed * t) - (0.5 * a * t * t);
+
+    ret = gcode_emit_to(context, block, &profile, s / d);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return gcode_emit_to(context, block, &profile, 1.0);
+}
+
+//
+// Time into the profile at which distance along the move is reached.
+//
+double
+gcode_profile_time(
+    PGCODE_PROFILE profile,
+    double distance
+    )
+{
+  double a;
+  double s;
+  double radicand;
+
+  a = profile->acceleration;
+
+  if (distance <= profile->accelerate_distance) {
+
+    // s = v0 t + a t^2 / 2
+    radicand = (profile->entry_speed * profile->entry_speed) + (2.0 * a * distance);
+
+    return (sqrt(radicand) - profile->entry_speed) / a;
+  }
+
+  s = distance - profile->accelerate_distance;
+
+  if (s <= profile->cruise_distance) {
+    return profile->accelerate_time + (s / profile->peak_speed);
+  }
+
+  s -= profile->cruise_distance;
+
+  // s = vp t - a t^2 / 2
+  radicand = (profile->peak_speed * profile->peak_speed) - (2.0 * a * s);
+  if (radicand < 0) {
+    radicand = 0;
+  }
+
+  return profile->accelerate_time + profile->cruise_time +
+         ((profile->peak_speed - sqrt(radicand)) / a);
+}
+
+//
+// Emit an instruction block moving each axis from the emitted position
+// to fraction of the move.
+//
+// fraction is moved to the nearest whole step of the axis with the
+// most steps and the block ends at the time the profile reaches it, so
+// that axis steps exactly on the profile. The other axis are rounded
+// to the nearest step.
+//
+// Nothing is emitted if the axis with the most steps has no whole step
+// to make, the time carries into the next instruction block.
+//
+// The timing generator counts at most TIMING_GENERATOR_MAXIMUM_PULSE_COUNT
+// pulses in an instruction block, so more steps of the axis with the
+// most steps, such as a long cruise, are emitted as several blocks.
+//
+int
+gcode_emit_to(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block,
+    PGCODE_PROFILE profile,
+    double fraction
+    )
+{
+  int ret;
+  long dominant_steps;
+  long target;
+  long emitted;
+
+  dominant_steps = labs(block->steps[block->dominant_axis]);
+
+  if (fraction > 1.0) {
+    fraction = 1.0;
+  }
+
+  target = lround(fraction * dominant_steps);
+
+  emitted = context->emitted_steps[block->dominant_axis];
+
+  if (target <= emitted) {
+    return 0;
+  }
+
+  while ((unsigned long)(target - emitted) > TIMING_GENERATOR_MAXIMUM_PULSE_COUNT) {
+
+    emitted += TIMING_GENERATOR_MAXIMUM_PULSE_COUNT;
+
+    ret = gcode_emit_segment(context, block, profile, emitted);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return gcode_emit_segment(context, block, profile, target);
+}
+
+//
+// Emit an instruction block moving the axis with the most steps to
+// the whole step target, see gcode_emit_to().
+//
+int
+gcode_emit_segment(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block,
+    PGCODE_PROFILE profile,
+    long target
+    )
+{
+  int index;
+  long steps[GCODE_AXIS_COUNT];
+  long dominant_steps;
+  double fraction;
+  double time;
+  double clocks;
+  double rate;
+  unsigned long pulse_rate;
+  unsigned long pulse_width;
+  unsigned long long duration;
+  unsigned long long block_clocks;
+  OPCODE_BLOCK_BINARY bin;
+  PAXIS_OPCODE_BINARY axis[GCODE_AXIS_COUNT];
+
+  dominant_steps = labs(block->steps[block->dominant_axis]);
+
+  fraction = (double)target / (double)dominant_steps;
+
+  for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+
+    steps[index] = lround(fraction * labs(block->steps[index])) - context->emitted_steps[index];
+
+    if (steps[index] < 0) {
+      steps[index] = 0;
+    }
+  }
+
+  time = gcode_profile_time(profile, fraction * block->length);
+
+  bzero(&bin, sizeof(bin));
+
+  bin.begin.instruction = OPCODE_BEGIN_BLOCK;
+  bin.end.instruction = OPCODE_END_BLOCK;
+
+  axis[GCODE_AXIS_X] = &bin.x;
+  axis[GCODE_AXIS_Y] = &bin.y;
+  axis[GCODE_AXIS_Z] = &bin.z;
+  axis[GCODE_AXIS_A] = &bin.a;
+
+  clocks = (time - context->emitted_time) * (double)TIMING_GENERATOR_BASE_CLOCK_RATE;
+
+  block_clocks = 0;
+
+  for (index = 0; index < GCODE_AXIS_COUNT; index++) {
+
+    // NOP
+    if (steps[index] == 0) {
+      continue;
+    }
+
+    if ((unsigned long)steps[index] > TIMING_GENERATOR_MAXIMUM_PULSE_COUNT) {
+      printf("gcode line %d: step count too large for target hardware\n", block->lineNumber);
+      return ERANGE;
+    }
+
+    rate = clocks / ((double)TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR * steps[index]);
+
+    if (rate >= (double)TIMING_GENERATOR_MAXIMUM_CLOCK_PERIOD_COUNT) {
+      printf("gcode line %d: step rate too low for target hardware\n", block->lineNumber);
+      return ERANGE;
+    }
+
+    pulse_rate = (unsigned long)(rate + 0.5);
+    if (pulse_rate == 0) {
+      pulse_rate = 1;
+    }
+
+    // Pulse must end within its period
+    pulse_width = context->pulse_width;
+    if (pulse_width > ((pulse_rate * TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR) / 2)) {
+      pulse_width = (pulse_rate * TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR) / 2;
+    }
+
+    if (block->steps[index] > 0) {
+      axis[index]->instruction = OPCODE_MOTION_CW;
+    }
+    else {
+      axis[index]->instruction = OPCODE_MOTION_CCW;
+    }
+
+    axis[index]->pulse_rate = pulse_rate;
+    axis[index]->pulse_count = steps[index];
+    axis[index]->pulse_width = pulse_width;
+
+    duration = (unsigned long long)pulse_rate * TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR * steps[index];
+    if (duration > block_clocks) {
+      block_clocks = duration;
+    }
+
+    context->emitted_steps[index] += steps[index];
+  }
+
+  if (block_array_push_entry(context->compiled_binary, &bin, sizeof(bin)) == NULL) {
+    return ENOMEM;
+  }
+
+  context->emitted_time = time;
+
+  context->statistics.blocks++;
+  context->statistics.program_clocks += block_clocks;
+
+  return 0;
+}
+
+//
+// Emit a dwell as a millisecond DWELL on X.
+//
+int
+gcode_emit_dwell(
+    PGCODE_CONTEXT context,
+    PGCODE_PLANNER_BLOCK block
+    )
+{
+  unsigned long count;
+  double milliseconds;
+  OPCODE_BLOCK_BINARY bin;
+
+  milliseconds = block->dwell * 1000.0;
+
+  if (milliseconds > (double)TIMING_GENERATOR_MAXIMUM_PULSE_COUNT) {
+    printf("gcode line %d: dwell %g seconds too long\n", block->lineNumber, block->dwell);
+    return ERANGE;
+  }
+
+  count = (unsigned long)lround(milliseconds);
+  if (count == 0) {
+    return 0;
+  }
+
+  bzero(&bin, sizeof(bin));
+
+  bin.begin.instruction = OPCODE_BEGIN_BLOCK;
+  bin.end.instruction = OPCODE_END_BLOCK;
+
+  bin.x.instruction = OPCODE_DWELL;
+  bin.x.pulse_rate = context->dwell_pulse_rate;
+  bin.x.pulse_count = count;
+
+  if (block_array_push_entry(context->compiled_binary, &bin, sizeof(bin)) == NULL) {
+    return ENOMEM;
+  }
+
+  context->statistics.blocks++;
+  context->statistics.program_clocks +=
+      (unsigned long long)context->dwell_pulse_rate * TIMING_GENERATOR_PULSE_RATE_SCALE_FACTOR * count;
+
+  return 0;
+}
+
+//
+// G-code conformance test.
+//
+// Each program is compiled with the default machine from lines
+// separated by '\n'.
+//
+
+typedef struct _GCODE_TEST_VALUE {
+
+  char* source;
+
+  int expected;
+
+} GCODE_TEST_VALUE, *PGCODE_TEST_VALUE;
+
+GCODE_TEST_VALUE gcode_test_values[] = {
+
+  { "G1 X10 F100", 0 },
+  { "G1 X10 Y10 F600\nG2 X20 Y0 I10 J0", 0 },
+  { "G4 P0.5", 0 },
+  { "G4 P5000000", ERANGE },
+
+  // Word values
+  { "G1 X1e400 F100", EBADF },
+  { "G1 X-1e400 F100", EBADF },
+  { "G1 Xnan F100", EBADF },
+  { "G1 Xinf F100", EBADF },
+  { "G1 X100000001 F100", EBADF },
+  { "G1 X10 F1e400", EBADF },
+  { "G1 X10 Fnan", EBADF },
+  { "G1 X10 F0", EBADF },
+  { "G1 X10 F-100", EBADF },
+  { "G1 X10\nG1 Y10 Finf", EBADF },
+  { "G4 Pnan", EBADF },
+  { "G1e10 X10", EBADF },
+
+  { NULL, 0 }
+};
+
+//
+// Single moves of X by steps, at and past the timing generator pulse
+// count limit. 8000000000 is G1 X100000000 at 80 steps per mm.
+//
+double gcode_test_move_steps[] = {
+  (double)TIMING_GENERATOR_MAXIMUM_PULSE_COUNT,
+  (double)TIMING_GENERATOR_MAXIMUM_PULSE_COUNT + 1.0,
+  8000000000.0,
+  0
+};
+
+//
+// Compile source and return the binary on success.
+//
+int
+gcode_test_compile(
+    char* source,
+    PBLOCK_ARRAY* binary
+    )
+{
+  int ret;
+  char* line;
+  char* next;
+  char* buffer;
+  PGCODE_CONTEXT context;
+
+  buffer = strdup(source);
+  if (buffer == NULL) {
+    return ENOMEM;
+  }
+
+  context = (PGCODE_CONTEXT)malloc(sizeof(GCODE_CONTEXT));
+  if (context == NULL) {
+    free(buffer);
+    return ENOMEM;
+  }
+
+  ret = initialize_gcode_context(context, NULL);
+  if (ret != 0) {
+    free(context);
+    free(buffer);
+    return ret;
+  }
+
+  for (line = buffer; line != NULL; line = next) {
+
+    next = strchr(line, '\n');
+    if (next != NULL) {
+      *next++ = '\0';
+    }
+
+    ret = process_gcode_line(context, line);
+    if (ret != 0) {
+      break;
+    }
+
+    context->lineNumber++;
+  }
+
+  if (ret == 0) {
+    ret = finish_gcode_context(context);
+  }
+
+  if (ret != 0) {
+    block_array_free(context->compiled_binary);
+  }
+  else {
+    *binary = context->compiled_binary;
+  }
+
+  free(context);
+  free(buffer);
+
+  return ret;
+}
+
+int
+gcode_conformance_test(int verbose)
+{
+  int ret;
+  int index;
+  int entry;
+  int count;
+  int expected;
+  int failures;
+  unsigned long max_pulse_count;
+  double steps;
+  double x_steps;
+  char buffer[128];
+  PBLOCK_ARRAY binary;
+  POPCODE_BLOCK_BINARY bin;
+  PGCODE_TEST_VALUE test;
+
+  failures = 0;
+  count = 0;
+
+  for (test = gcode_test_values; test->source != NULL; test++) {
+
+    binary = NULL;
+
+    ret = gcode_test_compile(test->source, &binary);
+
+    if (verbose) {
+      printf("gcode \"%s\": ret %d\n", test->source, ret);
+    }
+
+    if (ret != test->expected) {
+      printf("gcode \"%s\": ret %d expected %d\n", test->source, ret, test->expected);
+      failures++;
+    }
+
+    if (binary != NULL) {
+      block_array_free(binary);
+    }
+
+    count++;
+  }
+
+  for (index = 0; gcode_test_move_steps[index] != 0; index++) {
+
+    steps = gcode_test_move_steps[index];
+
+    sprintf(buffer, "G1 X%.4f F6000", steps / GCODE_DEFAULT_XY_STEPS_PER_UNIT);
+
+    // Moves that don't fit a long are rejected, the others are split
+    if (steps > GCODE_MAXIMUM_STEP_POSITION) {
+      expected = ERANGE;
+    }
+    else {
+      expected = 0;
+    }
+
+    binary = NULL;
+
+    ret = gcode_test_compile(buffer, &binary);
+
+    count++;
+
+    if (ret != expected) {
+      printf("gcode \"%s\": ret %d expected %d\n", buffer, ret, expected);
+      failures++;
+      continue;
+    }
+
+    if (binary == NULL) {
+      continue;
+    }
+
+    //
+    // Every block within the pulse count limit, and no steps lost.
+    //
+    x_steps = 0;
+    max_pulse_count = 0;
+
+    for (entry = 1; entry < block_array_get_array_size(binary); entry++) {
+
+      bin = (POPCODE_BLOCK_BINARY)block_array_get_entry(binary, entry);
+
+      x_steps += bin->x.pulse_count;
+
+      if (bin->x.pulse_count > max_pulse_count) {
+        max_pulse_count = bin->x.pulse_count;
+      }
+    }
+
+    if (verbose) {
+      printf("gcode \"%s\": %d blocks, %g steps, max pulse count %lu\n",
+        buffer, block_array_get_array_size(binary) - 1, x_steps, max_pulse_count);
+    }
+
+    if ((x_steps != steps) || (max_pulse_count > TIMING_GENERATOR_MAXIMUM_PULSE_COUNT)) {
+      printf("gcode \"%s\": %g steps expected %g, max pulse count %lu\n",
+        buffer, x_steps, steps, max_pulse_count);
+      failures++;
+    }
+
+    block_array_free(binary);
+  }
+
+  printf("gcode conformance: %d programs, %d failures\n", count, failures);
+
+  if (failures != 0) {
+    return EINVAL;
+  }
+
+  return 0;
+}
@@ -0,0 +1,305 @@
+//
+// menlo_cnc_gcode.h - G-code compiler for menlo_cnc, FPGA based machine tool controller.
+//
+// Copyright (c) 2018 Menlo Park Innovation LLC
+//
+// https://github.com/menloparkinnovation/openpux/tree/master/menlocnc
+//
+// 06/25/2018
+//
+
+//
+// Compiles RS274/NGC G-code into the same OPCODE_BLOCK_BINARY
+// instruction block stream produced by the assembler, so the existing
+// loaders, binary files and disassembler work on cut programs.
+//
+// Supported:
+//
+//   G0, G1        rapid and feed rate linear motion
+//   G2, G3        clockwise and counter clockwise arcs, I J K or R form,
+//                 helical in the third axis, linearized to arc_tolerance
+//   G4 P          dwell in seconds
+//   G17 G18 G19   arc plane
+//   G20 G21       inch, mm
+//   G90 G91       absolute, incremental
+//   M2 M30        program end
+//   F             feed rate in units per minute
+//
+// Axis words X Y Z A. A is in degrees and is not scaled by G20.
+//
+// Codes with no meaning for the four axis timing generator such as
+// spindle, coolant, tool and work offset selections are accepted and
+// ignored. Other codes are an error.
+//
+// Motion planning:
+//
+// Moves are queued in a lookahead planner of GCODE_PLANNER_SIZE blocks.
+// The speed at each junction is limited by the junction deviation
+// model and by what each block can reach or stop from with its
+// acceleration limit. A backward pass is made as each block is queued,
+// stopping early at blocks already at their maximum entry speed, so
+// the cost per block is small and does not depend on the lookahead
+// depth for typical programs. The forward pass is made as the oldest
+// block leaves the planner.
+//
+// Each block is then executed as a trapezoidal velocity profile. The
+// timing generator runs each axis at a constant pulse rate within an
+// instruction block, so acceleration and deceleration ramps are split
+// into instruction blocks of segment_time and the cruise is a single
+// block, or more if it has over TIMING_GENERATOR_MAXIMUM_PULSE_COUNT
+// steps. Each instruction block ends on a whole step of the axis with
+// the most steps at the time the profile reaches it, the other axis
+// are rounded from the cumulative position along the move so no steps
+// are lost to rounding.
+//
+// Positive motion is CW, negative is CCW.
+//
+
+#ifndef MENLO_CNC_GCODE_H
+#define MENLO_CNC_GCODE_H
+
+//
+// Include menlo_cnc_asm.h first.
+//
+
+//
+// X, Y, Z, A
+//
+#define GCODE_AXIS_COUNT 4
+
+#define GCODE_AXIS_X     0
+#define GCODE_AXIS_Y     1
+#define GCODE_AXIS_Z     2
+#define GCODE_AXIS_A     3
+
+//
+// Lookahead depth in moves, must be a power of 2.
+//
+#define GCODE_PLANNER_SIZE 128
+
+//
+// Default machine.
+//
+// A 20 tooth GT2 belt at 16 microsteps for X and Y, a 2mm lead screw
+// for Z, and a 16 microstep rotary A.
+//
+// Linear units are mm, rotary units are degrees.
+//
+#define GCODE_DEFAULT_XY_STEPS_PER_UNIT       80.0
+#define GCODE_DEFAULT_Z_STEPS_PER_UNIT        1600.0
+#define GCODE_DEFAULT_A_STEPS_PER_UNIT        (3200.0 / 360.0)
+
+// Per second
+#define GCODE_DEFAULT_XY_MAX_VELOCITY         150.0
+#define GCODE_DEFAULT_Z_MAX_VELOCITY          15.0
+#define GCODE_DEFAULT_A_MAX_VELOCITY          360.0
+
+// Per second per second
+#define GCODE_DEFAULT_XY_MAX_ACCELERATION     1500.0
+#define GCODE_DEFAULT_Z_MAX_ACCELERATION      150.0
+#define GCODE_DEFAULT_A_MAX_ACCELERATION      3600.0
+
+// mm
+#define GCODE_DEFAULT_JUNCTION_DEVIATION      0.01
+
+// Maximum chord error of a linearized arc, mm
+#define GCODE_DEFAULT_ARC_TOLERANCE           0.002
+
+// Duration of each instruction block in a velocity ramp, seconds
+#define GCODE_DEFAULT_SEGMENT_TIME            0.002
+
+// Feed rate before an F word, units per minute
+#define GCODE_DEFAULT_FEED_RATE               600.0
+
+#define GCODE_DEFAULT_PULSE_WIDTH_NANOSECONDS 2000
+
+typedef struct _GCODE_MACHINE {
+
+  double steps_per_unit[GCODE_AXIS_COUNT];
+
+  double max_velocity[GCODE_AXIS_COUNT];
+
+  double max_acceleration[GCODE_AXIS_COUNT];
+
+  double junction_deviation;
+
+  double arc_tolerance;
+
+  double segment_time;
+
+  // Units per minute
+  double default_feed_rate;
+
+  unsigned long pulse_width_nanoseconds;
+
+} GCODE_MACHINE, *PGCODE_MACHINE;
+
+typedef struct _GCODE_STATISTICS {
+
+  unsigned long lines;
+
+  // Linear moves queued, including arc segments
+  unsigned long moves;
+
+  unsigned long arcs;
+
+  // Instruction blocks emitted, not including the info block
+  unsigned long blocks;
+
+  // Run time of the emitted instruction blocks in timing generator clocks
+  unsigned long long program_clocks;
+
+} GCODE_STATISTICS, *PGCODE_STATISTICS;
+
+//
+// A move in the planner.
+//
+typedef struct _GCODE_PLANNER_BLOCK {
+
+  // Signed step counts
+  long steps[GCODE_AXIS_COUNT];
+
+  // Index of the axis with the most steps
+  int dominant_axis;
+
+  // In units, 0 for a dwell
+  double length;
+
+  double unit_vector[GCODE_AXIS_COUNT];
+
+  // Units per second
+  double nominal_speed;
+
+  // Units per second per second along the move
+  double acceleration;
+
+  double max_entry_speed;
+
+  double entry_speed;
+
+  // Seconds, for G4
+  double dwell;
+
+  // Source line, errors found when the block is emitted report it
+  int lineNumber;
+
+} GCODE_PLANNER_BLOCK, *PGCODE_PLANNER_BLOCK;
+
+typedef struct _GCODE_CONTEXT {
+
+  GCODE_MACHINE machine;
+
+  GCODE_STATISTICS statistics;
+
+  int lineNumber;
+
+  //
+  // Modal state
+  //
+
+  // 0, 1, 2, 3 for G0 - G3
+  int motion_mode;
+
+  int absolute;
+
+  // 17, 18, 19
+  int plane;
+
+  // mm per program unit
+  double unit_scale;
+
+  // Units per second
+  double feed_rate;
+
+  // Program end seen
+  int program_end;
+
+  // Programmed position in units
+  double position[GCODE_AXIS_COUNT];
+
+  // Position at the end of the last queued move in steps
+  long step_position[GCODE_AXIS_COUNT];
+
+  //
+  // Planner
+  //
+
+  GCODE_PLANNER_BLOCK planner[GCODE_PLANNER_SIZE];
+
+  // Next free entry, producer
+  unsigned long planner_head;
+
+  // Oldest queued entry, its entry_speed is final
+  unsigned long planner_tail;
+
+  // Last queued move for the junction speed
+  int have_previous;
+  double previous_unit_vector[GCODE_AXIS_COUNT];
+  double previous_nominal_speed;
+
+  // Exit speed of the last emitted block
+  double exit_speed;
+
+  // Emitted position within the current block, see gcode_emit_motion()
+  long emitted_steps[GCODE_AXIS_COUNT];
+  double emitted_time;
+
+  // Constant instruction fields computed once
+  unsigned long pulse_width;
+  unsigned long dwell_pulse_rate;
+
+  //
+  // Dynamic block array for compiled binary opcode blocks.
+  //
+  PBLOCK_ARRAY compiled_binary;
+
+} GCODE_CONTEXT, *PGCODE_CONTEXT;
+
+//
+// API Contracts
+//
+
+//
+// Load the default machine above.
+//
+void gcode_machine_initialize(PGCODE_MACHINE machine);
+
+//
+// Open and compile the specified G-code file and return the
+// binary instructions in memory.
+//
+// machine may be NULL for the default machine.
+//
+// statistics is optional and may be NULL.
+//
+int
+compile_gcode_file(
+    char* fileName,
+    PGCODE_MACHINE machine,
+    PBLOCK_ARRAY* binary,
+    PGCODE_STATISTICS statistics
+    );
+
+//
+// Lower level
+//
+// initialize_gcode_context() allocates the block array and emits the
+// info block. process_gcode_line() may queue moves in the planner,
+// finish_gcode_context() flushes them.
+//
+
+int initialize_gcode_context(PGCODE_CONTEXT context, PGCODE_MACHINE machine);
+
+int process_gcode_line(PGCODE_CONTEXT context, char* line);
+
+int finish_gcode_context(PGCODE_CONTEXT context);
+
+//
+// Compile known programs and check the errors and emitted
+// instruction blocks.
+//
+// Returns 0 if all pass.
+//
+int gcode_conformance_test(int verbose);
+
+#endif // MENLO_CNC_GCODE_H